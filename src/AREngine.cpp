@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include "NDS.h"
 #include "DSi.h"
 #include "AREngine.h"
@@ -29,196 +30,474 @@ namespace melonDS
 using Platform::Log;
 using Platform::LogLevel;
 
+enum
+{
+    ARop_End = 0,
+
+    ARop_Write32,           // 0x: u32[a+offset] = b
+    ARop_Write16,           // 1x: u16[a+offset] = b
+    ARop_Write8,            // 2x: u8[a+offset] = b
+    ARop_IfGreater32,       // 3x: IF b > u32[a]
+    ARop_IfLess32,          // 4x: IF b < u32[a]
+    ARop_IfEqual32,         // 5x: IF b == u32[a]
+    ARop_IfNotEqual32,      // 6x: IF b != u32[a]
+    ARop_IfGreater16,       // 7x: IF b.l > ((~b.h) & u16[a])
+    ARop_IfLess16,          // 8x: IF b.l < ((~b.h) & u16[a])
+    ARop_IfEqual16,         // 9x: IF b.l == ((~b.h) & u16[a])
+    ARop_IfNotEqual16,      // Ax: IF b.l != ((~b.h) & u16[a])
+    ARop_LoadOffset,        // Bx: offset = u32[a+offset]
+    ARop_For,               // C0: FOR 0..b
+    ARop_OffsetToCode,      // C4: offset = pointer to C4000000 opcode
+    ARop_Count,             // C5: count++ / IF (count & b.l) == b.h
+    ARop_StoreOffset,       // C6: u32[b] = offset
+    ARop_EndIf,             // D0
+    ARop_Next,              // D1
+    ARop_NextFlush,         // D2
+    ARop_SetOffset,         // D3: offset = b
+    ARop_AddData,           // D4: datareg += b
+    ARop_SetData,           // D5: datareg = b
+    ARop_StoreData32,       // D6: u32[b+offset] = datareg / offset += 4
+    ARop_StoreData16,       // D7: u16[b+offset] = datareg / offset += 2
+    ARop_StoreData8,        // D8: u8[b+offset] = datareg / offset += 1
+    ARop_LoadData32,        // D9: datareg = u32[b+offset]
+    ARop_LoadData16,        // DA: datareg = u16[b+offset]
+    ARop_LoadData8,         // DB: datareg = u8[b+offset]
+    ARop_AddOffset,         // DC: offset += b
+    ARop_CopyData,          // Ex: copy b param bytes to address a+offset
+    ARop_CopyMem,           // Fx: copy b bytes from address offset to address a
+    ARop_Bad,
+};
+
+enum
+{
+    ARmode_Offset = 0,  // bus access at Addr + offset
+    ARmode_Bus,         // bus access at Addr
+    ARmode_MainRAM,     // direct access to main RAM at Addr
+};
+
 AREngine::AREngine(melonDS::NDS& nds) : NDS(nds)
 {
 }
 
-#define case16(x) \
-    case ((x)+0x00): case ((x)+0x01): case ((x)+0x02): case ((x)+0x03): \
-    case ((x)+0x04): case ((x)+0x05): case ((x)+0x06): case ((x)+0x07): \
-    case ((x)+0x08): case ((x)+0x09): case ((x)+0x0A): case ((x)+0x0B): \
-    case ((x)+0x0C): case ((x)+0x0D): case ((x)+0x0E): case ((x)+0x0F)
+void AREngine::SetCheats(const std::vector<ARCode>& cheats)
+{
+    Program.clear();
+    ProgramData.clear();
+    CheatStarts.clear();
+
+    for (const ARCode& code : cheats)
+    {
+        if (code.Enabled)
+            CompileCheat(code);
+    }
+}
 
-void AREngine::RunCheat(const ARCode& arcode)
+void AREngine::CompileCheat(const ARCode& arcode)
 {
-    const u32* code = &arcode.Code[0];
+    const std::vector<u32>& src = arcode.Code;
+    std::vector<ARInstr> code;
 
-    u32 offset = 0;
-    u32 datareg = 0;
-    u32 cond = 1;
-    u32 condstack = 0;
+    size_t pos = 0;
+    while (pos < src.size())
+    {
+        u32 a = src[pos];
+        u32 b = (pos + 1 < src.size()) ? src[pos + 1] : 0;
+        pos += 2;
 
-    const u32* loopstart = code;
-    u32 loopcount = 0;
-    u32 loopcond = 1;
-    u32 loopcondstack = 0;
+        u8 op = a >> 24;
 
-    // TODO: does anything reset this??
-    u32 c5count = 0;
+        ARInstr instr {};
+        instr.Gated = ((op < 0xD0 && op != 0xC5) || op > 0xD2) ? 1 : 0;
+        instr.Mode = ARmode_Offset;
+        instr.Val = b;
 
-    for (;;)
-    {
-        if (code > &arcode.Code[arcode.Code.size() - 1])
-            // If the instruction pointer is past the end of the cheat code...
+        switch (op >> 4)
+        {
+        case 0x0: instr.Op = ARop_Write32; instr.Addr = a & 0x0FFFFFFF; break;
+        case 0x1: instr.Op = ARop_Write16; instr.Addr = a & 0x0FFFFFFF; instr.Val &= 0xFFFF; break;
+        case 0x2: instr.Op = ARop_Write8; instr.Addr = a & 0x0FFFFFFF; instr.Val &= 0xFF; break;
+
+        case 0x3: case 0x4: case 0x5: case 0x6:
+        case 0x7: case 0x8: case 0x9: case 0xA:
+            instr.Op = ARop_IfGreater32 + ((op >> 4) - 0x3);
+            // the address is only relative to the offset if it's zero
+            instr.Addr = a & 0x0FFFFFFF;
+            if (instr.Addr) instr.Mode = ARmode_Bus;
             break;
 
-        u32 a = *code++;
-        u32 b = *code++;
+        case 0xB: instr.Op = ARop_LoadOffset; instr.Addr = a & 0x0FFFFFFF; break;
 
-        u8 op = a >> 24;
+        case 0xC:
+            switch (op)
+            {
+            case 0xC0: instr.Op = ARop_For; break;
+            case 0xC4: instr.Op = ARop_OffsetToCode; break;
+            case 0xC5: instr.Op = ARop_Count; break;
+            case 0xC6: instr.Op = ARop_StoreOffset; instr.Addr = b; instr.Mode = ARmode_Bus; break;
+            default: instr.Op = ARop_Bad; instr.Addr = a; break;
+            }
+            break;
 
-        if ((op < 0xD0 && op != 0xC5) || op > 0xD2)
-        {
-            if (!cond)
+        case 0xD:
+            switch (op)
+            {
+            case 0xD0: instr.Op = ARop_EndIf; break;
+            case 0xD1: instr.Op = ARop_Next; break;
+            case 0xD2: instr.Op = ARop_NextFlush; break;
+            case 0xD3: instr.Op = ARop_SetOffset; break;
+            case 0xD4: instr.Op = ARop_AddData; break;
+            case 0xD5: instr.Op = ARop_SetData; break;
+            case 0xD6: instr.Op = ARop_StoreData32; instr.Addr = b; break;
+            case 0xD7: instr.Op = ARop_StoreData16; instr.Addr = b; break;
+            case 0xD8: instr.Op = ARop_StoreData8; instr.Addr = b; break;
+            case 0xD9: instr.Op = ARop_LoadData32; instr.Addr = b; break;
+            case 0xDA: instr.Op = ARop_LoadData16; instr.Addr = b; break;
+            case 0xDB: instr.Op = ARop_LoadData8; instr.Addr = b; break;
+            case 0xDC: instr.Op = ARop_AddOffset; break;
+            default: instr.Op = ARop_Bad; instr.Addr = a; break;
+            }
+            break;
+
+        case 0xE:
             {
-                if ((op & 0xF0) == 0xE0)
+                instr.Op = ARop_CopyData;
+                instr.Addr = a & 0x0FFFFFFF;
+                instr.Data = ProgramData.size();
+
+                // the data is padded to a whole number of opcodes
+                // and may not run past the end of the code
+                u64 len = (((u64)b + 7) / 8) * 2;
+                u64 avail = src.size() - std::min(pos, src.size());
+                if (len > avail)
                 {
-                    for (u32 i = 0; i < b; i += 8)
-                        code += 2;
+                    len = avail;
+                    instr.Val = len * 4;
                 }
 
-                continue;
+                if (len > 0)
+                    ProgramData.insert(ProgramData.end(), src.begin() + pos, src.begin() + pos + len);
+                ProgramData.insert(ProgramData.end(), 2, 0);
+                pos += len;
             }
+            break;
+
+        case 0xF: instr.Op = ARop_CopyMem; instr.Addr = a & 0x0FFFFFFF; instr.Mode = ARmode_Bus; break;
         }
 
-        switch (op)
+        code.push_back(instr);
+    }
+
+    code.push_back({ARop_End, ARmode_Offset, 0, 0, 0, 0});
+
+    FoldOffsets(code);
+
+    CheatStarts.push_back(Program.size());
+    Program.insert(Program.end(), code.begin(), code.end());
+}
+
+void AREngine::FoldOffsets(std::vector<ARInstr>& code)
+{
+    // figure out where the offset register has the same value whichever way
+    // the code gets there, so addresses relative to it can be resolved now
+    struct State
+    {
+        bool Reached;
+        bool Known;     // whether Offset is the value of the offset register
+        bool CondSet;   // whether the condition is known to be true
+        u32 Offset;
+    };
+
+    const u32 len = code.size();
+    std::vector<State> states(len, State{false, false, false, 0});
+    std::vector<u32> pending;
+    std::vector<u32> loopstarts;
+
+    for (u32 i = 0; i < len; i++)
+    {
+        if (code[i].Op == ARop_For)
+            loopstarts.push_back(i + 1);
+    }
+
+    auto merge = [&](u32 i, bool known, u32 offset, bool condset)
+    {
+        if (i >= len) return;
+
+        State& state = states[i];
+        if (!state.Reached)
+        {
+            state = {true, known, condset, offset};
+            pending.push_back(i);
+            return;
+        }
+
+        bool newknown = state.Known && known && (state.Offset == offset);
+        bool newcondset = state.CondSet && condset;
+        if (newknown != state.Known || newcondset != state.CondSet)
+        {
+            state.Known = newknown;
+            state.CondSet = newcondset;
+            pending.push_back(i);
+        }
+    };
+
+    merge(0, true, 0, true);
+    while (!pending.empty())
+    {
+        u32 i = pending.back();
+        pending.pop_back();
+
+        const ARInstr& instr = code[i];
+        State in = states[i];
+        State out = in;
+
+        // a gated opcode might not run at all
+        if (instr.Gated && !in.CondSet)
+            merge(i + 1, in.Known, in.Offset, in.CondSet);
+
+        switch (instr.Op)
         {
-        case16(0x00): // 32-bit write
-            NDS.ARM7Write32((a & 0x0FFFFFFF) + offset, b);
+        case ARop_End:
+        case ARop_OffsetToCode:
+        case ARop_Bad:
+            continue;
+
+        case ARop_IfGreater32: case ARop_IfLess32: case ARop_IfEqual32: case ARop_IfNotEqual32:
+        case ARop_IfGreater16: case ARop_IfLess16: case ARop_IfEqual16: case ARop_IfNotEqual16:
+        case ARop_Count:
+        case ARop_EndIf:
+            out.CondSet = false;
             break;
 
-        case16(0x10): // 16-bit write
-            NDS.ARM7Write16((a & 0x0FFFFFFF) + offset, b & 0xFFFF);
+        case ARop_LoadOffset:
+            out.Known = false;
             break;
 
-        case16(0x20): // 8-bit write
-            NDS.ARM7Write8((a & 0x0FFFFFFF) + offset, b & 0xFF);
+        case ARop_SetOffset:
+            out.Known = true;
+            out.Offset = instr.Val;
             break;
 
-        case16(0x30): // IF b > u32[a]
-            {
-                condstack <<= 1;
-                condstack |= cond;
+        case ARop_AddOffset: out.Offset += instr.Val; break;
+        case ARop_StoreData32: out.Offset += 4; break;
+        case ARop_StoreData16: out.Offset += 2; break;
+        case ARop_StoreData8: out.Offset += 1; break;
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u32 chk = NDS.ARM7Read32(addr);
+        case ARop_Next:
+            for (u32 start : loopstarts)
+                merge(start, in.Known, in.Offset, in.CondSet);
+            out.CondSet = false;
+            break;
 
-                cond = (b > chk) ? 1:0;
-            }
+        case ARop_NextFlush:
+            for (u32 start : loopstarts)
+                merge(start, in.Known, in.Offset, in.CondSet);
+            out.Known = true;
+            out.Offset = 0;
+            out.CondSet = true;
             break;
+        }
 
-        case16(0x40): // IF b < u32[a]
-            {
-                condstack <<= 1;
-                condstack |= cond;
+        merge(i + 1, out.Known, out.Offset, out.CondSet);
+    }
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u32 chk = NDS.ARM7Read32(addr);
+    for (u32 i = 0; i < len; i++)
+    {
+        ARInstr& instr = code[i];
+        const State& state = states[i];
+        if (!state.Reached || !state.Known || instr.Mode != ARmode_Offset)
+            continue;
 
-                cond = (b < chk) ? 1:0;
-            }
+        u32 size;
+        switch (instr.Op)
+        {
+        case ARop_Write32: case ARop_LoadOffset:
+        case ARop_IfGreater32: case ARop_IfLess32: case ARop_IfEqual32: case ARop_IfNotEqual32:
+        case ARop_StoreData32: case ARop_LoadData32:
+            size = 4;
             break;
 
-        case16(0x50): // IF b == u32[a]
-            {
-                condstack <<= 1;
-                condstack |= cond;
-
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u32 chk = NDS.ARM7Read32(addr);
+        case ARop_Write16:
+        case ARop_IfGreater16: case ARop_IfLess16: case ARop_IfEqual16: case ARop_IfNotEqual16:
+        case ARop_StoreData16: case ARop_LoadData16:
+            size = 2;
+            break;
 
-                cond = (b == chk) ? 1:0;
-            }
+        case ARop_Write8: case ARop_StoreData8: case ARop_LoadData8:
+            size = 1;
             break;
 
-        case16(0x60): // IF b != u32[a]
-            {
-                condstack <<= 1;
-                condstack |= cond;
+        case ARop_CopyData:
+            // may span several regions, so it keeps going through the bus
+            instr.Addr += state.Offset;
+            instr.Mode = ARmode_Bus;
+            continue;
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u32 chk = NDS.ARM7Read32(addr);
+        default:
+            continue;
+        }
 
-                cond = (b != chk) ? 1:0;
-            }
+        instr.Addr += state.Offset;
+        instr.Mode = ARmode_Bus;
+        if ((instr.Addr & 0xFF000000) == 0x02000000)
+        {
+            instr.Addr &= ~(size - 1);
+            instr.Mode = ARmode_MainRAM;
+        }
+    }
+
+    // addresses that never depended on the offset can also go to main RAM directly
+    for (ARInstr& instr : code)
+    {
+        if (instr.Mode != ARmode_Bus || (instr.Addr & 0xFF000000) != 0x02000000)
+            continue;
+
+        switch (instr.Op)
+        {
+        case ARop_IfGreater32: case ARop_IfLess32: case ARop_IfEqual32: case ARop_IfNotEqual32:
+        case ARop_StoreOffset:
+            instr.Addr &= ~0x3;
+            instr.Mode = ARmode_MainRAM;
             break;
 
-        case16(0x70): // IF b.l > ((~b.h) & u16[a])
-            {
-                condstack <<= 1;
-                condstack |= cond;
+        case ARop_IfGreater16: case ARop_IfLess16: case ARop_IfEqual16: case ARop_IfNotEqual16:
+            instr.Addr &= ~0x1;
+            instr.Mode = ARmode_MainRAM;
+            break;
+        }
+    }
+}
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u16 val = NDS.ARM7Read16(addr);
-                u16 chk = ~(b >> 16);
-                chk &= val;
+template <typename T>
+T AREngine::Read(const ARInstr& instr, u32 offset)
+{
+    if (instr.Mode == ARmode_MainRAM)
+        return *(T*)&NDS.MainRAM[instr.Addr & NDS.MainRAMMask];
 
-                cond = ((b & 0xFFFF) > chk) ? 1:0;
-            }
+    u32 addr = (instr.Mode == ARmode_Offset) ? (instr.Addr + offset) : instr.Addr;
+    if constexpr (sizeof(T) == 4) return NDS.ARM7Read32(addr);
+    else if constexpr (sizeof(T) == 2) return NDS.ARM7Read16(addr);
+    else return NDS.ARM7Read8(addr);
+}
+
+template <typename T>
+void AREngine::Write(const ARInstr& instr, u32 offset, T val)
+{
+    if (instr.Mode == ARmode_MainRAM)
+    {
+        NDS.JIT.CheckAndInvalidate<1, ARMJIT_Memory::memregion_MainRAM>(instr.Addr);
+        *(T*)&NDS.MainRAM[instr.Addr & NDS.MainRAMMask] = val;
+        return;
+    }
+
+    u32 addr = (instr.Mode == ARmode_Offset) ? (instr.Addr + offset) : instr.Addr;
+    if constexpr (sizeof(T) == 4) NDS.ARM7Write32(addr, val);
+    else if constexpr (sizeof(T) == 2) NDS.ARM7Write16(addr, val);
+    else NDS.ARM7Write8(addr, val);
+}
+
+void AREngine::RunCheat(const ARInstr* code)
+{
+    u32 offset = 0;
+    u32 datareg = 0;
+    u32 cond = 1;
+    u32 condstack = 0;
+
+    const ARInstr* loopstart = code;
+    u32 loopcount = 0;
+    u32 loopcond = 1;
+    u32 loopcondstack = 0;
+
+    // TODO: does anything reset this??
+    u32 c5count = 0;
+
+    for (;;)
+    {
+        const ARInstr& instr = *code++;
+
+        if (!cond && instr.Gated)
+            continue;
+
+        switch (instr.Op)
+        {
+        case ARop_End:
+            return;
+
+        case ARop_Write32:
+            Write<u32>(instr, offset, instr.Val);
             break;
 
-        case16(0x80): // IF b.l < ((~b.h) & u16[a])
-            {
-                condstack <<= 1;
-                condstack |= cond;
+        case ARop_Write16:
+            Write<u16>(instr, offset, instr.Val);
+            break;
+
+        case ARop_Write8:
+            Write<u8>(instr, offset, instr.Val);
+            break;
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u16 val = NDS.ARM7Read16(addr);
-                u16 chk = ~(b >> 16);
-                chk &= val;
+        case ARop_IfGreater32:
+            condstack = (condstack << 1) | cond;
+            cond = (instr.Val > Read<u32>(instr, offset)) ? 1:0;
+            break;
 
-                cond = ((b & 0xFFFF) < chk) ? 1:0;
-            }
+        case ARop_IfLess32:
+            condstack = (condstack << 1) | cond;
+            cond = (instr.Val < Read<u32>(instr, offset)) ? 1:0;
             break;
 
-        case16(0x90): // IF b.l == ((~b.h) & u16[a])
-            {
-                condstack <<= 1;
-                condstack |= cond;
+        case ARop_IfEqual32:
+            condstack = (condstack << 1) | cond;
+            cond = (instr.Val == Read<u32>(instr, offset)) ? 1:0;
+            break;
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u16 val = NDS.ARM7Read16(addr);
-                u16 chk = ~(b >> 16);
-                chk &= val;
+        case ARop_IfNotEqual32:
+            condstack = (condstack << 1) | cond;
+            cond = (instr.Val != Read<u32>(instr, offset)) ? 1:0;
+            break;
 
-                cond = ((b & 0xFFFF) == chk) ? 1:0;
+        case ARop_IfGreater16:
+            {
+                condstack = (condstack << 1) | cond;
+                u16 chk = ~(instr.Val >> 16) & Read<u16>(instr, offset);
+                cond = ((instr.Val & 0xFFFF) > chk) ? 1:0;
             }
             break;
 
-        case16(0xA0): // IF b.l != ((~b.h) & u16[a])
+        case ARop_IfLess16:
             {
-                condstack <<= 1;
-                condstack |= cond;
+                condstack = (condstack << 1) | cond;
+                u16 chk = ~(instr.Val >> 16) & Read<u16>(instr, offset);
+                cond = ((instr.Val & 0xFFFF) < chk) ? 1:0;
+            }
+            break;
 
-                u32 addr = a & 0x0FFFFFFF;
-                if (!addr) addr = offset;
-                u16 val = NDS.ARM7Read16(addr);
-                u16 chk = ~(b >> 16);
-                chk &= val;
+        case ARop_IfEqual16:
+            {
+                condstack = (condstack << 1) | cond;
+                u16 chk = ~(instr.Val >> 16) & Read<u16>(instr, offset);
+                cond = ((instr.Val & 0xFFFF) == chk) ? 1:0;
+            }
+            break;
 
-                cond = ((b & 0xFFFF) != chk) ? 1:0;
+        case ARop_IfNotEqual16:
+            {
+                condstack = (condstack << 1) | cond;
+                u16 chk = ~(instr.Val >> 16) & Read<u16>(instr, offset);
+                cond = ((instr.Val & 0xFFFF) != chk) ? 1:0;
             }
             break;
 
-        case16(0xB0): // offset = u32[a + offset]
-            offset = NDS.ARM7Read32((a & 0x0FFFFFFF) + offset);
+        case ARop_LoadOffset:
+            offset = Read<u32>(instr, offset);
             break;
 
-        case 0xC0: // FOR 0..b
+        case ARop_For:
             loopstart = code; // points to the first opcode after the FOR
-            loopcount = b;
+            loopcount = instr.Val;
             loopcond = cond;           // checkme
             loopcondstack = condstack; // (GBAtek is not very clear there)
             break;
 
-        case 0xC4: // offset = pointer to C4000000 opcode
+        case ARop_OffsetToCode:
             // theoretically used for safe storage, by accessing [offset+4]
             // in practice could be used for a self-modifying AR code
             // could be implemented with some hackery, but, does anything even
@@ -226,7 +505,7 @@ void AREngine::RunCheat(const ARCode& arcode)
             Log(LogLevel::Error, "AR: !! THE FUCKING C4000000 OPCODE. TELL ARISOTURA.\n");
             return;
 
-        case 0xC5: // count++ / IF (count & b.l) == b.h
+        case ARop_Count:
             {
                 // with weird condition checking, apparently
                 // oh well
@@ -234,26 +513,25 @@ void AREngine::RunCheat(const ARCode& arcode)
                 c5count++;
                 if (!cond) break;
 
-                condstack <<= 1;
-                condstack |= cond;
+                condstack = (condstack << 1) | cond;
 
-                u16 mask = b & 0xFFFF;
-                u16 chk = b >> 16;
+                u16 mask = instr.Val & 0xFFFF;
+                u16 chk = instr.Val >> 16;
 
                 cond = ((c5count & mask) == chk) ? 1:0;
             }
             break;
 
-        case 0xC6: // u32[b] = offset
-            NDS.ARM7Write32(b, offset);
+        case ARop_StoreOffset:
+            Write<u32>(instr, offset, offset);
             break;
 
-        case 0xD0: // ENDIF
+        case ARop_EndIf:
             cond = condstack & 0x1;
             condstack >>= 1;
             break;
 
-        case 0xD1: // NEXT
+        case ARop_Next:
             if (loopcount > 0)
             {
                 loopcount--;
@@ -266,7 +544,7 @@ void AREngine::RunCheat(const ARCode& arcode)
             }
             break;
 
-        case 0xD2: // NEXT+FLUSH
+        case ARop_NextFlush:
             if (loopcount > 0)
             {
                 loopcount--;
@@ -281,68 +559,68 @@ void AREngine::RunCheat(const ARCode& arcode)
             }
             break;
 
-        case 0xD3: // offset = b
-            offset = b;
+        case ARop_SetOffset:
+            offset = instr.Val;
             break;
 
-        case 0xD4: // datareg += b
-            datareg += b;
+        case ARop_AddData:
+            datareg += instr.Val;
             break;
 
-        case 0xD5: // datareg = b
-            datareg = b;
+        case ARop_SetData:
+            datareg = instr.Val;
             break;
 
-        case 0xD6: // u32[b+offset] = datareg / offset += 4
-            NDS.ARM7Write32(b + offset, datareg);
+        case ARop_StoreData32:
+            Write<u32>(instr, offset, datareg);
             offset += 4;
             break;
 
-        case 0xD7: // u16[b+offset] = datareg / offset += 2
-            NDS.ARM7Write16(b + offset, datareg & 0xFFFF);
+        case ARop_StoreData16:
+            Write<u16>(instr, offset, datareg & 0xFFFF);
             offset += 2;
             break;
 
-        case 0xD8: // u8[b+offset] = datareg / offset += 1
-            NDS.ARM7Write8(b + offset, datareg & 0xFF);
+        case ARop_StoreData8:
+            Write<u8>(instr, offset, datareg & 0xFF);
             offset += 1;
             break;
 
-        case 0xD9: // datareg = u32[b+offset]
-            datareg = NDS.ARM7Read32(b + offset);
+        case ARop_LoadData32:
+            datareg = Read<u32>(instr, offset);
             break;
 
-        case 0xDA: // datareg = u16[b+offset]
-            datareg = NDS.ARM7Read16(b + offset);
+        case ARop_LoadData16:
+            datareg = Read<u16>(instr, offset);
             break;
 
-        case 0xDB: // datareg = u8[b+offset]
-            datareg = NDS.ARM7Read8(b + offset);
+        case ARop_LoadData8:
+            datareg = Read<u8>(instr, offset);
             break;
 
-        case 0xDC: // offset += b
-            offset += b;
+        case ARop_AddOffset:
+            offset += instr.Val;
             break;
 
-        case16(0xE0): // copy b param bytes to address a+offset
+        case ARop_CopyData:
             {
                 // TODO: check for bad alignment of dstaddr
 
-                u32 dstaddr = (a & 0x0FFFFFFF) + offset;
-                u32 bytesleft = b;
+                const u32* data = &ProgramData[instr.Data];
+                u32 dstaddr = (instr.Mode == ARmode_Offset) ? (instr.Addr + offset) : instr.Addr;
+                u32 bytesleft = instr.Val;
                 while (bytesleft >= 8)
                 {
-                    NDS.ARM7Write32(dstaddr, *code++); dstaddr += 4;
-                    NDS.ARM7Write32(dstaddr, *code++); dstaddr += 4;
+                    NDS.ARM7Write32(dstaddr, *data++); dstaddr += 4;
+                    NDS.ARM7Write32(dstaddr, *data++); dstaddr += 4;
                     bytesleft -= 8;
                 }
                 if (bytesleft > 0)
                 {
-                    u8* leftover = (u8*)code;
-                    code += 2;
+                    const u8* leftover = (const u8*)data;
                     if (bytesleft >= 4)
                     {
-                        NDS.ARM7Write32(dstaddr, *(u32*)leftover); dstaddr += 4;
+                        NDS.ARM7Write32(dstaddr, *(const u32*)leftover); dstaddr += 4;
                         leftover += 4;
                         bytesleft -= 4;
                     }
@@ -355,13 +633,13 @@ void AREngine::RunCheat(const ARCode& arcode)
             }
             break;
 
-        case16(0xF0): // copy b bytes from address offset to address a
+        case ARop_CopyMem:
             {
                 // TODO: check for bad alignment of srcaddr/dstaddr
 
                 u32 srcaddr = offset;
-                u32 dstaddr = (a & 0x0FFFFFFF);
-                u32 bytesleft = b;
+                u32 dstaddr = instr.Addr;
+                u32 bytesleft = instr.Val;
                 while (bytesleft >= 4)
                 {
                     NDS.ARM7Write32(dstaddr, NDS.ARM7Read32(srcaddr));
@@ -379,8 +657,8 @@ void AREngine::RunCheat(const ARCode& arcode)
             }
             break;
 
-        default:
-            Log(LogLevel::Warn, "!! bad AR opcode %08X %08X\n", a, b);
+        case ARop_Bad:
+            Log(LogLevel::Warn, "!! bad AR opcode %08X %08X\n", instr.Addr, instr.Val);
             return;
         }
     }
@@ -388,12 +666,9 @@ void AREngine::RunCheat(const ARCode& arcode)
 
 void AREngine::RunCheats()
 {
-    if (Cheats.empty()) return;
+    if (CheatStarts.empty()) return;
 
-    for (const ARCode& code : Cheats)
-    {
-        if (code.Enabled)
-            RunCheat(code);
-    }
+    for (u32 start : CheatStarts)
+        RunCheat(&Program[start]);
 }
 }
@@ -30,11 +30,36 @@ class AREngine
 public:
     AREngine(melonDS::NDS& nds);
 
-    std::vector<ARCode> Cheats {};
-private:
-    friend class ARM;
+    // replaces the running codes with the enabled ones in the given list,
+    // compiling them to a form that's quicker to run every frame
+    void SetCheats(const std::vector<ARCode>& cheats);
+
+    // runs the codes once, the ARM7 does this every frame
     void RunCheats();
-    void RunCheat(const ARCode& arcode);
+private:
+
+    // a compiled AR code is a flat list of these, one per opcode,
+    // with the data of E-type opcodes kept in a separate pool
+    struct ARInstr
+    {
+        u8 Op;
+        u8 Mode;    // how Addr is accessed
+        u8 Gated;   // skipped while the condition is false
+        u32 Addr;
+        u32 Val;
+        u32 Data;   // E-type data index
+    };
+
+    void CompileCheat(const ARCode& arcode);
+    void FoldOffsets(std::vector<ARInstr>& code);
+    void RunCheat(const ARInstr* code);
+
+    template <typename T> T Read(const ARInstr& instr, u32 offset);
+    template <typename T> void Write(const ARInstr& instr, u32 offset, T val);
+
+    std::vector<ARInstr> Program;
+    std::vector<u32> ProgramData;
+    std::vector<u32> CheatStarts;
 
     melonDS::NDS& NDS;
 };
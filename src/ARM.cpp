@@ -23,6 +23,7 @@
 #include "DSi.h"
 #include "ARM.h"
 #include "ARMInterpreter.h"
+#include "ARM_InstrInfo.h"
 #include "AREngine.h"
 #include "ARMJIT.h"
 #include "Platform.h"
@@ -159,6 +160,10 @@ void ARM::Reset()
     Cycles = 0;
     Halted = 0;
 
+    for (IdleLoopEntry& entry : IdleLoopCache)
+        entry.Key = 0xFFFFFFFF;
+    IdleLoopSkippedCycles = 0;
+
     IRQ = 0;
 
     for (int i = 0; i < 16; i++)
@@ -589,6 +594,409 @@ void ARM::CheckGdbIncoming()
     GdbCheckA();
 }
 
+bool ARM::AnalyseIdleLoop(u32 branchAddr, u32 target, bool thumb, IdleLoopEntry& entry)
+{
+    u32 instrSize = thumb ? 2 : 4;
+    u32 length = (branchAddr - target) / instrSize + 1;
+    u32 key = branchAddr | (thumb ? 1 : 0);
+
+    u32 instrs[IdleLoopMaxLength];
+    for (u32 i = 0; i < length; i++)
+        instrs[i] = FetchIdleLoopInstr(target + i * instrSize, thumb);
+
+    // the code may have been overwritten since it was last analysed
+    if (entry.Key == key && entry.Length == length &&
+        !memcmp(entry.Instrs, instrs, length * sizeof(u32)))
+        return entry.Idle;
+
+    ARMInstrInfo::Info infos[IdleLoopMaxLength];
+    for (u32 i = 0; i < length; i++)
+        infos[i] = ARMInstrInfo::Decode(thumb, Num, instrs[i], false);
+
+    // like the JIT, only consider loops closed by a conditional branch
+    u32 branch = instrs[length - 1];
+    bool condbranch = thumb
+        ? infos[length - 1].Kind == ARMInstrInfo::tk_BCOND
+        : (infos[length - 1].Kind == ARMInstrInfo::ak_B && (branch >> 28) < 0xE);
+
+    entry.Key = key;
+    entry.Length = length;
+    entry.Idle = condbranch && ARMInstrInfo::IsIdleLoop(thumb, infos, length);
+    memcpy(entry.Instrs, instrs, length * sizeof(u32));
+    return entry.Idle;
+}
+
+ARM::CachedBlock* ARM::LookUpCachedBlock(u32 addr, bool thumb, const u8* mem, u32 avail)
+{
+    // keep the block and what it prefetches within one page, there's no telling what's mapped after it
+    avail = std::min(avail, 0x1000 - (addr & 0xFFC));
+
+    if (!CachedBlocks)
+        CachedBlocks = std::make_unique<CachedBlock[]>(CachedBlockCacheSize);
+
+    u32 key = addr | (thumb ? 1 : 0);
+    CachedBlock& block = CachedBlocks[(addr >> 1) & (CachedBlockCacheSize - 1)];
+    if (block.Key != key || !block.Length || block.CodeWords * 4 > avail ||
+        !block.Matches(mem))
+    {
+        if (!BuildCachedBlock(block, addr, thumb, mem, avail))
+            return nullptr;
+    }
+
+    // the pipeline was filled before the block was looked up, it has to hold the same instructions
+    u32 mask = thumb ? 0xFFFF : 0xFFFFFFFF;
+    if ((NextInstr[0] & mask) != block.Instrs[0].Instr ||
+        (block.Length > 1 && (NextInstr[1] & mask) != block.Instrs[1].Instr))
+        return nullptr;
+
+    return &block;
+}
+
+bool ARM::BuildCachedBlock(CachedBlock& block, u32 addr, bool thumb, const u8* mem, u32 avail)
+{
+    u32 instrSize = thumb ? 2 : 4;
+    u32 codeStart = addr & ~3;
+    u32 codeEnd = codeStart;
+    u32 length = 0;
+    bool canRepeat = true;
+
+    while (length < CachedBlockMaxLength)
+    {
+        u32 instrAddr = addr + length * instrSize;
+
+        // every instruction prefetches the one two instructions ahead
+        u32 fetchEnd = ((instrAddr + 2 * instrSize) & ~3) + 4;
+        if (fetchEnd - codeStart > avail)
+            break;
+
+        u32 instr = thumb ? *(u16*)&mem[instrAddr - codeStart] : *(u32*)&mem[instrAddr - codeStart];
+        ARMInstrInfo::Info info = ARMInstrInfo::Decode(thumb, Num, instr, false);
+
+        CachedInstr& cached = block.Instrs[length++];
+        cached.Instr = instr;
+        cached.Handler = RunCachedInterpreter;
+        if (thumb)
+        {
+            cached.Interpreter = ARMInterpreter::THUMBInstrTable[(instr >> 6) & 0x3FF];
+            cached.Cond = 0xE;
+        }
+        else if (Num == 0 && (instr & 0xFE000000) == 0xFA000000)
+        {
+            cached.Interpreter = ARMInterpreter::A_BLX_IMM;
+            cached.Cond = 0xE;
+        }
+        else
+        {
+            cached.Interpreter = ARMInterpreter::ARMInstrTable[((instr >> 4) & 0xF) | ((instr >> 16) & 0xFF0)];
+            cached.Cond = instr >> 28;
+            if (Num == 0)
+                DecodeCachedInstr<ARMv5>(cached);
+            else
+                DecodeCachedInstr<ARMv4>(cached);
+        }
+        codeEnd = fetchEnd;
+
+        if (info.SpecialKind == ARMInstrInfo::special_WriteMem ||
+            (!thumb && info.Kind >= ARMInstrInfo::ak_MSR_IMM && info.Kind <= ARMInstrInfo::ak_MRC))
+            canRepeat = false;
+
+        // coprocessor accesses can remap the memory the rest of the block is in,
+        // and stores can overwrite it, then the code has to be checked again before going on
+        if (info.EndBlock || info.Kind == ARMInstrInfo::ak_MCR || info.Kind == ARMInstrInfo::ak_MRC ||
+            info.SpecialKind == ARMInstrInfo::special_WriteMem)
+            break;
+    }
+
+    if (!length)
+    {
+        block.Length = 0;
+        return false;
+    }
+
+    block.Key = addr | (thumb ? 1 : 0);
+    block.Length = length;
+    block.CodeStart = codeStart;
+    block.CodeWords = (codeEnd - codeStart) / 4;
+    block.CanRepeat = canRepeat;
+    memcpy(block.Code, mem, codeEnd - codeStart);
+    return true;
+}
+
+void ARM::RunCachedInterpreter(ARM* cpu, const CachedInstr& instr)
+{
+    instr.Interpreter(cpu);
+}
+
+// the handlers below do exactly what the interpreter's would, but with the operands
+// decoded beforehand and calling the CPU's own functions directly.
+// form is 0 for an immediate, 1 for a register shifted left and 2 for other shifts
+template <typename CPU, u32 op, u32 form>
+void ARM::RunCachedALU(ARM* arm, const CachedInstr& instr)
+{
+    CPU* cpu = static_cast<CPU*>(arm);
+
+    u32 b;
+    if constexpr (form == 0)
+    {
+        b = instr.Operand;
+    }
+    else if constexpr (form == 1)
+    {
+        b = cpu->R[instr.Rm] << instr.ShiftAmount;
+    }
+    else
+    {
+        b = cpu->R[instr.Rm];
+        switch (instr.ShiftType)
+        {
+        case 1: b >>= instr.ShiftAmount; break;
+        case 2: b = ((s32)b) >> instr.ShiftAmount; break;
+        case 3: b = ROR(b, instr.ShiftAmount); break;
+        }
+    }
+    u32 a = cpu->R[instr.Rn];
+    u32 carry = (cpu->CPSR >> 29) & 1;
+
+    cpu->CPU::AddCycles_C();
+    u32 res;
+    if constexpr (op == 0x0) res = a & b;
+    else if constexpr (op == 0x1) res = a ^ b;
+    else if constexpr (op == 0x2 || op == 0xA) res = a - b;
+    else if constexpr (op == 0x3) res = b - a;
+    else if constexpr (op == 0x4 || op == 0xB) res = a + b;
+    else if constexpr (op == 0x5) res = a + b + carry;
+    else if constexpr (op == 0x6) res = a - b - (carry ^ 1);
+    else if constexpr (op == 0x7) res = b - a - (carry ^ 1);
+    else if constexpr (op == 0x8) res = a & b;
+    else if constexpr (op == 0xC) res = a | b;
+    else if constexpr (op == 0xD) res = b;
+    else if constexpr (op == 0xE) res = a & ~b;
+    else res = ~b;
+
+    if constexpr (op == 0x8)
+        cpu->SetNZ(res & 0x80000000, !res);
+    else if constexpr (op == 0xA)
+        cpu->SetNZCV(res & 0x80000000, !res, a >= b, (a ^ b) & (a ^ res) & 0x80000000);
+    else if constexpr (op == 0xB)
+        cpu->SetNZCV(res & 0x80000000, !res, res < a, ~(a ^ b) & (a ^ res) & 0x80000000);
+    else
+        cpu->R[instr.Rd] = res;
+}
+
+// indexing is 0 for post-indexed, 1 for pre-indexed and 2 for pre-indexed with writeback
+template <typename CPU, bool load, u32 indexing>
+void ARM::RunCachedLoadStore(ARM* arm, const CachedInstr& instr)
+{
+    CPU* cpu = static_cast<CPU*>(arm);
+
+    u32 addr = cpu->R[instr.Rn];
+    if constexpr (indexing != 0)
+        addr += instr.Operand;
+
+    u32 val;
+    if constexpr (load)
+        cpu->CPU::DataRead32(addr, &val);
+    else
+        cpu->CPU::DataWrite32(addr, cpu->R[instr.Rd]);
+
+    if constexpr (indexing == 0)
+        cpu->R[instr.Rn] += instr.Operand;
+    else if constexpr (indexing == 2)
+        cpu->R[instr.Rn] = addr;
+
+    if constexpr (load)
+    {
+        cpu->CPU::AddCycles_CDI();
+        cpu->R[instr.Rd] = ROR(val, (addr & 0x3) << 3);
+    }
+    else
+    {
+        cpu->CPU::AddCycles_CD();
+    }
+}
+
+template <typename CPU, bool link>
+void ARM::RunCachedBranch(ARM* arm, const CachedInstr& instr)
+{
+    CPU* cpu = static_cast<CPU*>(arm);
+
+    if constexpr (link)
+        cpu->R[14] = cpu->R[15] - 4;
+    cpu->CPU::JumpTo(cpu->R[15] + instr.Operand);
+}
+
+// picks a specialised handler for data processing with an immediate or a register shifted by
+// an immediate, word loads and stores with an immediate offset, and branches
+template <typename CPU>
+void ARM::DecodeCachedInstr(CachedInstr& cached)
+{
+#define CACHED_ALU(op) { RunCachedALU<CPU, op, 0>, RunCachedALU<CPU, op, 1>, RunCachedALU<CPU, op, 2> }
+    static constexpr CachedHandler aluHandlers[16][3] =
+    {
+        CACHED_ALU(0x0), CACHED_ALU(0x1), CACHED_ALU(0x2), CACHED_ALU(0x3),
+        CACHED_ALU(0x4), CACHED_ALU(0x5), CACHED_ALU(0x6), CACHED_ALU(0x7),
+        CACHED_ALU(0x8), {}, CACHED_ALU(0xA), CACHED_ALU(0xB),
+        CACHED_ALU(0xC), CACHED_ALU(0xD), CACHED_ALU(0xE), CACHED_ALU(0xF),
+    };
+#undef CACHED_ALU
+
+    u32 instr = cached.Instr;
+    u32 rd = (instr >> 12) & 0xF;
+
+    if ((instr & 0x0C000000) == 0 && ((instr & (1<<25)) || !(instr & (1<<4))))
+    {
+        u32 op = (instr >> 21) & 0xF;
+        bool setflags = instr & (1<<20);
+        u32 form;
+        bool shifterCarry;
+
+        if (instr & (1<<25))
+        {
+            form = 0;
+            cached.Operand = ROR(instr & 0xFF, (instr >> 7) & 0x1E);
+            shifterCarry = (instr & 0xF00) != 0;
+        }
+        else
+        {
+            cached.Rm = instr & 0xF;
+            cached.ShiftType = (instr >> 5) & 0x3;
+            cached.ShiftAmount = (instr >> 7) & 0x1F;
+            form = cached.ShiftType ? 2 : 1;
+            shifterCarry = cached.ShiftAmount != 0;
+
+            // LSR #32, ASR #32 and RRX
+            if (cached.ShiftType && !cached.ShiftAmount)
+                return;
+        }
+
+        if (op >= 0x8 && op <= 0xB)
+        {
+            // without S these are MRS/MSR. TST and TEQ take the carry from the shifter,
+            // only worth having TST without it
+            if (!setflags || op == 0x9 || (op == 0x8 && shifterCarry))
+                return;
+        }
+        else if (setflags || rd == 15)
+            return;
+
+        cached.Handler = aluHandlers[op][form];
+        cached.Rd = rd;
+        cached.Rn = (instr >> 16) & 0xF;
+    }
+    else if ((instr & 0x0E400000) == 0x04000000)
+    {
+        bool preindex = instr & (1<<24);
+        bool writeback = instr & (1<<21);
+
+        // post-indexed with W set is LDRT/STRT
+        if (rd == 15 || (!preindex && writeback))
+            return;
+
+        if (instr & (1<<20))
+            cached.Handler = !preindex ? RunCachedLoadStore<CPU, true, 0>
+                : writeback ? RunCachedLoadStore<CPU, true, 2> : RunCachedLoadStore<CPU, true, 1>;
+        else
+            cached.Handler = !preindex ? RunCachedLoadStore<CPU, false, 0>
+                : writeback ? RunCachedLoadStore<CPU, false, 2> : RunCachedLoadStore<CPU, false, 1>;
+        cached.Rd = rd;
+        cached.Rn = (instr >> 16) & 0xF;
+        cached.Operand = (instr & (1<<23)) ? (instr & 0xFFF) : -(instr & 0xFFF);
+    }
+    else if ((instr & 0x0E000000) == 0x0A000000)
+    {
+        cached.Handler = (instr & (1<<24)) ? RunCachedBranch<CPU, true> : RunCachedBranch<CPU, false>;
+        cached.Operand = (s32)(instr << 8) >> 6;
+    }
+}
+
+ARM::CachedBlock* ARMv5::LookUpCachedBlock(bool thumb)
+{
+    u32 addr = R[15] - (thumb ? 2 : 4);
+    u32 codeStart = addr & ~3;
+
+    // same sources as CodeRead32, anything going through the bus is left to the interpreter
+    if (codeStart < ITCMSize)
+    {
+        u32 offset = codeStart & (ITCMPhysicalSize - 1);
+        return ARM::LookUpCachedBlock(addr, thumb, &ITCM[offset],
+            std::min(ITCMSize - codeStart, ITCMPhysicalSize - offset));
+    }
+    if (CodeMem.Mem)
+    {
+        u32 offset = codeStart & CodeMem.Mask;
+        return ARM::LookUpCachedBlock(addr, thumb, &CodeMem.Mem[offset], CodeMem.Mask + 1 - offset);
+    }
+    return nullptr;
+}
+
+template <bool thumb>
+bool ARMv5::RunCachedBlock(const CachedBlock& block, u32& execR15)
+{
+    for (u32 i = 0;;)
+    {
+        const CachedInstr& instr = block.Instrs[i];
+        execR15 = R[15] + (thumb ? 2 : 4);
+
+        // prefetch, exactly like the interpreter but out of the block's copy of the code
+        R[15] += thumb ? 2 : 4;
+        CurInstr = NextInstr[0];
+        NextInstr[0] = NextInstr[1];
+        if (thumb && (R[15] & 0x2))
+        {
+            NextInstr[1] >>= 16;
+            CodeCycles = 0;
+        }
+        else
+        {
+            NextInstr[1] = block.Code[(R[15] - block.CodeStart) >> 2];
+            if (R[15] < ITCMSize)
+                CodeCycles = 1;
+            else if (RegionCodeCycles != 0xFF)
+                CodeCycles = RegionCodeCycles;
+            else
+                CodeCycles = (R[15] & 0x1F) ? 1 : kCodeCacheTiming;
+        }
+
+        if (!CheckCondition(instr.Cond))
+            AddCycles_C();
+        else if (thumb)
+            instr.Interpreter(this);
+        else
+            instr.Handler(this, instr);
+
+        // anything out of the ordinary is handled by Execute
+        if (Halted || IRQ || (bool)(CPSR & 0x20) != thumb)
+            return false;
+
+        if (++i == block.Length || R[15] != execR15)
+        {
+            if (!block.CanRepeat || R[15] != (block.Key & ~1) + (thumb ? 2 : 4))
+                return false;
+
+            // jumped back to the start, the pipeline was refilled from the same code
+            if (IdleLoopSkipping && R[15] < execR15 &&
+                CheckIdleLoop(execR15 - (thumb ? 4 : 8), R[15] - (thumb ? 2 : 4), thumb))
+            {
+                NDS.ARM9Timestamp += Cycles;
+                Cycles = 0;
+                if (NDS.ARM9Timestamp < NDS.ARM9Target)
+                {
+                    IdleLoopSkippedCycles += NDS.ARM9Target - NDS.ARM9Timestamp;
+                    NDS.ARM9Timestamp = NDS.ARM9Target;
+                }
+                return true;
+            }
+
+            i = 0;
+        }
+
+        NDS.ARM9Timestamp += Cycles;
+        Cycles = 0;
+        if (NDS.ARM9Timestamp >= NDS.ARM9Target)
+            return false;
+    }
+}
+
 template <CPUExecuteMode mode>
 void ARMv5::Execute()
 {
@@ -632,7 +1040,10 @@ void ARMv5::Execute()
             JitBlockEntry block = NDS.JIT.LookUpBlock(0, FastBlockLookup,
                 instrAddr - FastBlockLookupStart, instrAddr);
             if (block)
+            {
+                PROFILE_COUNT(NDS.Profiler.CountBlockExecuted(0));
                 ARM_Dispatch(this, block);
+            }
             else
                 NDS.JIT.CompileBlock(this);
 
@@ -657,7 +1068,20 @@ void ARMv5::Execute()
         else
 #endif
         {
-            if (CPSR & 0x20) // THUMB
+            bool thumb = CPSR & 0x20;
+            u32 execR15 = R[15] + (thumb ? 2 : 4);
+
+            CachedBlock* block = nullptr;
+            if constexpr (mode == CPUExecuteMode::CachedInterpreter)
+                block = LookUpCachedBlock(thumb);
+
+            if (block)
+            {
+                // returns true when it fast-forwarded through an idle loop
+                if (thumb ? RunCachedBlock<true>(*block, execR15) : RunCachedBlock<false>(*block, execR15))
+                    break;
+            }
+            else if (thumb)
             {
                 if constexpr (mode == CPUExecuteMode::InterpreterGDB)
                     GdbCheckC();
@@ -707,6 +1131,22 @@ void ARMv5::Execute()
                 }
                 break;
             }
+
+            // jumped back into an idle loop: nothing will change until the next event
+            if (R[15] < execR15 && !IRQ && IdleLoopSkipping && (bool)(CPSR & 0x20) == thumb)
+            {
+                if (CheckIdleLoop(execR15 - (thumb ? 4 : 8), R[15] - (thumb ? 2 : 4), thumb))
+                {
+                    NDS.ARM9Timestamp += Cycles;
+                    Cycles = 0;
+                    if (NDS.ARM9Timestamp < NDS.ARM9Target)
+                    {
+                        IdleLoopSkippedCycles += NDS.ARM9Target - NDS.ARM9Timestamp;
+                        NDS.ARM9Timestamp = NDS.ARM9Target;
+                    }
+                    break;
+                }
+            }
             /*if (NDS::IF[0] & NDS::IE[0])
             {
                 if (NDS::IME[0] & 0x1)
@@ -725,10 +1165,88 @@ void ARMv5::Execute()
 }
 template void ARMv5::Execute<CPUExecuteMode::Interpreter>();
 template void ARMv5::Execute<CPUExecuteMode::InterpreterGDB>();
+template void ARMv5::Execute<CPUExecuteMode::CachedInterpreter>();
 #ifdef JIT_ENABLED
 template void ARMv5::Execute<CPUExecuteMode::JIT>();
 #endif
 
+ARM::CachedBlock* ARMv4::LookUpCachedBlock(bool thumb)
+{
+    u32 addr = R[15] - (thumb ? 2 : 4);
+    u32 codeStart = addr & ~3;
+
+    MemRegion region;
+    if (!NDS.ARM7GetMemRegion(codeStart, false, &region))
+    {
+        // the JIT leaves out shared WRAM, as its mapping can change under it
+        // here it's fine, the code is checked every time
+        if (NDS.ConsoleType != 0 || (codeStart & 0xFF800000) != 0x03000000 || !NDS.SWRAM_ARM7.Mem)
+            return nullptr;
+        region = NDS.SWRAM_ARM7;
+    }
+
+    u32 offset = codeStart & region.Mask;
+    return ARM::LookUpCachedBlock(addr, thumb, &region.Mem[offset], region.Mask + 1 - offset);
+}
+
+template <bool thumb>
+bool ARMv4::RunCachedBlock(const CachedBlock& block, u32& execR15)
+{
+    const u8* code = (const u8*)block.Code;
+    for (u32 i = 0;;)
+    {
+        const CachedInstr& instr = block.Instrs[i];
+        execR15 = R[15] + (thumb ? 2 : 4);
+
+        // prefetch, exactly like the interpreter but out of the block's copy of the code
+        R[15] += thumb ? 2 : 4;
+        CurInstr = NextInstr[0];
+        NextInstr[0] = NextInstr[1];
+        if (thumb)
+            NextInstr[1] = *(u16*)&code[R[15] - block.CodeStart];
+        else
+            NextInstr[1] = *(u32*)&code[R[15] - block.CodeStart];
+
+        if (!CheckCondition(instr.Cond))
+            AddCycles_C();
+        else if (thumb)
+            instr.Interpreter(this);
+        else
+            instr.Handler(this, instr);
+
+        // anything out of the ordinary is handled by Execute
+        if (Halted || IRQ || (bool)(CPSR & 0x20) != thumb)
+            return false;
+
+        if (++i == block.Length || R[15] != execR15)
+        {
+            if (!block.CanRepeat || R[15] != (block.Key & ~1) + (thumb ? 2 : 4))
+                return false;
+
+            // jumped back to the start, the pipeline was refilled from the same code
+            if (IdleLoopSkipping && R[15] < execR15 &&
+                CheckIdleLoop(execR15 - (thumb ? 4 : 8), R[15] - (thumb ? 2 : 4), thumb))
+            {
+                NDS.ARM7Timestamp += Cycles;
+                Cycles = 0;
+                if (NDS.ARM7Timestamp < NDS.ARM7Target)
+                {
+                    IdleLoopSkippedCycles += NDS.ARM7Target - NDS.ARM7Timestamp;
+                    NDS.ARM7Timestamp = NDS.ARM7Target;
+                }
+                return true;
+            }
+
+            i = 0;
+        }
+
+        NDS.ARM7Timestamp += Cycles;
+        Cycles = 0;
+        if (NDS.ARM7Timestamp >= NDS.ARM7Target)
+            return false;
+    }
+}
+
 template <CPUExecuteMode mode>
 void ARMv4::Execute()
 {
@@ -772,7 +1290,10 @@ void ARMv4::Execute()
             JitBlockEntry block = NDS.JIT.LookUpBlock(1, FastBlockLookup,
                 instrAddr - FastBlockLookupStart, instrAddr);
             if (block)
+            {
+                PROFILE_COUNT(NDS.Profiler.CountBlockExecuted(1));
                 ARM_Dispatch(this, block);
+            }
             else
                 NDS.JIT.CompileBlock(this);
 
@@ -796,7 +1317,20 @@ void ARMv4::Execute()
         else
 #endif
         {
-            if (CPSR & 0x20) // THUMB
+            bool thumb = CPSR & 0x20;
+            u32 execR15 = R[15] + (thumb ? 2 : 4);
+
+            CachedBlock* block = nullptr;
+            if constexpr (mode == CPUExecuteMode::CachedInterpreter)
+                block = LookUpCachedBlock(thumb);
+
+            if (block)
+            {
+                // returns true when it fast-forwarded through an idle loop
+                if (thumb ? RunCachedBlock<true>(*block, execR15) : RunCachedBlock<false>(*block, execR15))
+                    break;
+            }
+            else if (thumb)
             {
                 if constexpr (mode == CPUExecuteMode::InterpreterGDB)
                     GdbCheckC();
@@ -841,6 +1375,22 @@ void ARMv4::Execute()
                 }
                 break;
             }
+
+            // jumped back into an idle loop: nothing will change until the next event
+            if (R[15] < execR15 && !IRQ && IdleLoopSkipping && (bool)(CPSR & 0x20) == thumb)
+            {
+                if (CheckIdleLoop(execR15 - (thumb ? 4 : 8), R[15] - (thumb ? 2 : 4), thumb))
+                {
+                    NDS.ARM7Timestamp += Cycles;
+                    Cycles = 0;
+                    if (NDS.ARM7Timestamp < NDS.ARM7Target)
+                    {
+                        IdleLoopSkippedCycles += NDS.ARM7Target - NDS.ARM7Timestamp;
+                        NDS.ARM7Timestamp = NDS.ARM7Target;
+                    }
+                    break;
+                }
+            }
             /*if (NDS::IF[1] & NDS::IE[1])
             {
                 if (NDS::IME[1] & 0x1)
@@ -867,6 +1417,7 @@ void ARMv4::Execute()
 
 template void ARMv4::Execute<CPUExecuteMode::Interpreter>();
 template void ARMv4::Execute<CPUExecuteMode::InterpreterGDB>();
+template void ARMv4::Execute<CPUExecuteMode::CachedInterpreter>();
 #ifdef JIT_ENABLED
 template void ARMv4::Execute<CPUExecuteMode::JIT>();
 #endif
@@ -1248,63 +1799,96 @@ void ARMv4::AddCycles_CD()
     }
 }
 
+// main RAM and WRAM are accessed straight through the fastmem arena when possible
+// the DTCM is mapped in there too, but it isn't on the bus
+
 u8 ARMv5::BusRead8(u32 addr)
 {
+    u8 val;
+    if ((addr & DTCMMask) != DTCMBase && NDS.JIT.Memory.DirectRead(0, addr, val))
+        return val;
     return NDS.ARM9Read8(addr);
 }
 
 u16 ARMv5::BusRead16(u32 addr)
 {
+    u16 val;
+    if ((addr & DTCMMask) != DTCMBase && NDS.JIT.Memory.DirectRead(0, addr, val))
+        return val;
     return NDS.ARM9Read16(addr);
 }
 
 u32 ARMv5::BusRead32(u32 addr)
 {
+    u32 val;
+    if ((addr & DTCMMask) != DTCMBase && NDS.JIT.Memory.DirectRead(0, addr, val))
+        return val;
     return NDS.ARM9Read32(addr);
 }
 
 void ARMv5::BusWrite8(u32 addr, u8 val)
 {
+    if ((addr & DTCMMask) != DTCMBase && NDS.JIT.Memory.DirectWrite(0, addr, val))
+        return;
     NDS.ARM9Write8(addr, val);
 }
 
 void ARMv5::BusWrite16(u32 addr, u16 val)
 {
+    if ((addr & DTCMMask) != DTCMBase && NDS.JIT.Memory.DirectWrite(0, addr, val))
+        return;
     NDS.ARM9Write16(addr, val);
 }
 
 void ARMv5::BusWrite32(u32 addr, u32 val)
 {
+    if ((addr & DTCMMask) != DTCMBase && NDS.JIT.Memory.DirectWrite(0, addr, val))
+        return;
     NDS.ARM9Write32(addr, val);
 }
 
 u8 ARMv4::BusRead8(u32 addr)
 {
+    u8 val;
+    if (NDS.JIT.Memory.DirectRead(1, addr, val))
+        return val;
     return NDS.ARM7Read8(addr);
 }
 
 u16 ARMv4::BusRead16(u32 addr)
 {
+    u16 val;
+    if (NDS.JIT.Memory.DirectRead(1, addr, val))
+        return val;
     return NDS.ARM7Read16(addr);
 }
 
 u32 ARMv4::BusRead32(u32 addr)
 {
+    u32 val;
+    if (NDS.JIT.Memory.DirectRead(1, addr, val))
+        return val;
     return NDS.ARM7Read32(addr);
 }
 
 void ARMv4::BusWrite8(u32 addr, u8 val)
 {
+    if (NDS.JIT.Memory.DirectWrite(1, addr, val))
+        return;
     NDS.ARM7Write8(addr, val);
 }
 
 void ARMv4::BusWrite16(u32 addr, u16 val)
 {
+    if (NDS.JIT.Memory.DirectWrite(1, addr, val))
+        return;
     NDS.ARM7Write16(addr, val);
 }
 
 void ARMv4::BusWrite32(u32 addr, u32 val)
 {
+    if (NDS.JIT.Memory.DirectWrite(1, addr, val))
+        return;
     NDS.ARM7Write32(addr, val);
 }
 }
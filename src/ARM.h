@@ -20,6 +20,7 @@
 #define ARM_H
 
 #include <algorithm>
+#include <memory>
 #include <optional>
 
 #include "types.h"
@@ -47,6 +48,7 @@ enum class CPUExecuteMode : u32
 {
     Interpreter,
     InterpreterGDB,
+    CachedInterpreter,
 #ifdef JIT_ENABLED
     JIT
 #endif
@@ -195,8 +197,101 @@ public:
     Gdb::GdbStub GdbStub;
 #endif
 
+    /// Whether the interpreter fast-forwards through idle loops the way the JIT does.
+    /// Loops polling a value that changes without a scheduler event (eg. a timer counter)
+    /// may exit later than they would on hardware, so this is off unless the frontend enables it.
+    bool IdleLoopSkipping = false;
+    /// Cycles skipped by the interpreter's idle loop fast-forwarding, in this CPU's clock.
+    u64 IdleLoopSkippedCycles = 0;
+
     melonDS::NDS& NDS;
 protected:
+    // the interpreter doesn't know where loops are until it runs them,
+    // so remember which backwards branches form idle loops
+    static constexpr int IdleLoopCacheSize = 64;
+    static constexpr u32 IdleLoopMaxLength = 16;
+    struct IdleLoopEntry
+    {
+        u32 Key; // address of the branch, bit 0 set for THUMB
+        u32 Length;
+        bool Idle;
+        u32 Instrs[IdleLoopMaxLength];
+    };
+    IdleLoopEntry IdleLoopCache[IdleLoopCacheSize];
+
+    bool CheckIdleLoop(u32 branchAddr, u32 target, bool thumb)
+    {
+        if (target > branchAddr || (branchAddr - target) >= IdleLoopMaxLength * (thumb ? 2 : 4))
+            return false;
+
+        // busy loops are the common case, don't bother checking whether they changed
+        IdleLoopEntry& entry = IdleLoopCache[(branchAddr >> 1) & (IdleLoopCacheSize - 1)];
+        if (entry.Key == (branchAddr | (thumb ? 1 : 0)) && !entry.Idle)
+            return false;
+
+        return AnalyseIdleLoop(branchAddr, target, thumb, entry);
+    }
+    bool AnalyseIdleLoop(u32 branchAddr, u32 target, bool thumb, IdleLoopEntry& entry);
+    // reads an instruction without affecting the timing
+    virtual u32 FetchIdleLoopInstr(u32 addr, bool thumb) = 0;
+
+    // the cached interpreter decodes runs of straight-line code once, and keeps
+    // a copy of the code to check it wasn't overwritten every time it enters them.
+    // blocks end after every store, so nothing runs past a write without being checked
+    static constexpr int CachedBlockCacheSize = 2048;
+    static constexpr u32 CachedBlockMaxLength = 32;
+    struct CachedInstr;
+    using CachedHandler = void (*)(ARM* cpu, const CachedInstr& instr);
+    struct CachedInstr
+    {
+        // the interpreter's handler, THUMB blocks call it directly
+        void (*Interpreter)(ARM* cpu);
+        // ARM blocks call this instead. the common forms have their own handlers
+        // with the operands decoded below, the rest go to the interpreter's handler
+        CachedHandler Handler;
+        u32 Instr;
+        // the rotated immediate, the signed load/store offset or the branch offset
+        u32 Operand;
+        u8 Cond;
+        u8 Rd, Rn, Rm;
+        u8 ShiftType, ShiftAmount;
+    };
+    struct CachedBlock
+    {
+        u32 Key; // address of the first instruction, bit 0 set for THUMB
+        u32 Length;
+        u32 CodeStart;
+        u32 CodeWords;
+        // nothing in the block can change the code, so it can loop on itself without being checked again
+        bool CanRepeat;
+        CachedInstr Instrs[CachedBlockMaxLength];
+        // the instructions and everything they prefetch
+        u32 Code[CachedBlockMaxLength + 3];
+
+        // blocks are mostly a few words long, not worth a call to memcmp
+        bool Matches(const u8* mem) const
+        {
+            u32 diff = 0;
+            for (u32 i = 0; i < CodeWords; i++)
+                diff |= Code[i] ^ ((const u32*)mem)[i];
+            return !diff;
+        }
+    };
+    std::unique_ptr<CachedBlock[]> CachedBlocks;
+
+    // mem points to the code at addr & ~3, of which avail bytes can be read
+    CachedBlock* LookUpCachedBlock(u32 addr, bool thumb, const u8* mem, u32 avail);
+    bool BuildCachedBlock(CachedBlock& block, u32 addr, bool thumb, const u8* mem, u32 avail);
+    template <typename CPU>
+    static void DecodeCachedInstr(CachedInstr& cached);
+    static void RunCachedInterpreter(ARM* cpu, const CachedInstr& instr);
+    template <typename CPU, u32 op, u32 form>
+    static void RunCachedALU(ARM* cpu, const CachedInstr& instr);
+    template <typename CPU, bool load, u32 indexing>
+    static void RunCachedLoadStore(ARM* cpu, const CachedInstr& instr);
+    template <typename CPU, bool link>
+    static void RunCachedBranch(ARM* cpu, const CachedInstr& instr);
+
     virtual u8 BusRead8(u32 addr) = 0;
     virtual u16 BusRead16(u32 addr) = 0;
     virtual u32 BusRead32(u32 addr) = 0;
@@ -229,6 +324,14 @@ protected:
     void GdbCheckC();
 };
 
+// access timing for cached regions
+// this would be an average between cache hits and cache misses
+// this was measured to be close to hardware average
+// a value of 1 would represent a perfect cache, but that causes
+// games to run too fast, causing a number of issues
+const int kDataCacheTiming = 3;//2;
+const int kCodeCacheTiming = 3;//5;
+
 class ARMv5 : public ARM
 {
 public:
@@ -253,6 +356,7 @@ public:
 
     // all code accesses are forced nonseq 32bit
     u32 CodeRead32(u32 addr, bool branch);
+    u32 FetchIdleLoopInstr(u32 addr, bool thumb) override;
 
     void DataRead8(u32 addr, u32* val) override;
     void DataRead16(u32 addr, u32* val) override;
@@ -378,6 +482,10 @@ protected:
     void BusWrite8(u32 addr, u8 val) override;
     void BusWrite16(u32 addr, u16 val) override;
     void BusWrite32(u32 addr, u32 val) override;
+
+    CachedBlock* LookUpCachedBlock(bool thumb);
+    template <bool thumb>
+    bool RunCachedBlock(const CachedBlock& block, u32& execR15);
 };
 
 class ARMv4 : public ARM
@@ -402,6 +510,12 @@ public:
         return BusRead32(addr);
     }
 
+    u32 FetchIdleLoopInstr(u32 addr, bool thumb) override
+    {
+        return thumb ? CodeRead16(addr) : CodeRead32(addr);
+    }
+
+
     void DataRead8(u32 addr, u32* val) override;
     void DataRead16(u32 addr, u32* val) override;
     void DataRead32(u32 addr, u32* val) override;
@@ -421,6 +535,10 @@ protected:
     void BusWrite8(u32 addr, u8 val) override;
     void BusWrite16(u32 addr, u16 val) override;
     void BusWrite32(u32 addr, u32 val) override;
+
+    CachedBlock* LookUpCachedBlock(bool thumb);
+    template <bool thumb>
+    bool RunCachedBlock(const CachedBlock& block, u32& execR15);
 };
 
 namespace ARMInterpreter
@@ -352,33 +352,14 @@ bool DecodeBranch(bool thumb, const FetchedInstr& instr, u32& cond, bool hasLink
 
 bool IsIdleLoop(bool thumb, FetchedInstr* instrs, int instrsCount)
 {
-    // see https://github.com/dolphin-emu/dolphin/blob/master/Source/Core/Core/PowerPC/PPCAnalyst.cpp#L678
-    // it basically checks if one iteration of a loop depends on another
-    // the rules are quite simple
-
     JIT_DEBUGPRINT("checking potential idle loop\n");
-    u16 regsWrittenTo = 0;
-    u16 regsDisallowedToWrite = 0;
+
+    // blocks are never longer than 32 instructions
+    ARMInstrInfo::Info infos[32];
     for (int i = 0; i < instrsCount; i++)
-    {
-        JIT_DEBUGPRINT("instr %d %08x regs(%x %x) %x %x\n", i, instrs[i].Instr, instrs[i].Info.DstRegs, instrs[i].Info.SrcRegs, regsWrittenTo, regsDisallowedToWrite);
-        if (instrs[i].Info.SpecialKind == ARMInstrInfo::special_WriteMem)
-            return false;
-        if (!thumb && instrs[i].Info.Kind >= ARMInstrInfo::ak_MSR_IMM && instrs[i].Info.Kind <= ARMInstrInfo::ak_MRC)
-            return false;
-        if (i < instrsCount - 1 && instrs[i].Info.Branches())
-            return false;
-
-        u16 srcRegs = instrs[i].Info.SrcRegs & ~(1 << 15);
-        u16 dstRegs = instrs[i].Info.DstRegs & ~(1 << 15);
-
-        regsDisallowedToWrite |= srcRegs & ~regsWrittenTo;
-
-        if (dstRegs & regsDisallowedToWrite)
-            return false;
-        regsWrittenTo |= dstRegs;
-    }
-    return true;
+        infos[i] = instrs[i].Info;
+
+    return ARMInstrInfo::IsIdleLoop(thumb, infos, instrsCount);
 }
 
 typedef void (*InterpreterFunc)(ARM* cpu);
@@ -531,6 +512,9 @@ void ARMJIT::SetFastMemory(bool enabled) noexcept
 
 void ARMJIT::CompileBlock(ARM* cpu) noexcept
 {
+    PROFILE_SCOPE(NDS.Profiler, Section_JITCompile);
+    PROFILE_COUNT(NDS.Profiler.CountBlockCompiled(cpu->Num));
+
     bool thumb = cpu->CPSR & 0x20;
 
     u32 blockAddr = cpu->R[15] - (thumb ? 2 : 4);
@@ -271,14 +271,6 @@ const u32 OffsetsPerRegion[ARMJIT_Memory::memregions_Count] =
     MemBlockNWRAM_COffset
 };
 
-enum
-{
-    memstate_Unmapped,
-    memstate_MappedRW,
-    // on Switch this is unmapped as well
-    memstate_MappedProtected,
-};
-
 #define CHECK_ALIGNED(value) assert(((value) & (PageSize-1)) == 0)
 
 bool ARMJIT_Memory::MapIntoRange(u32 addr, u32 num, u32 offset, u32 size) noexcept
@@ -629,10 +621,8 @@ void ARMJIT_Memory::RemapSWRAM() noexcept
     Mappings[memregion_SharedWRAM].Clear();
 }
 
-bool ARMJIT_Memory::MapAtAddress(u32 addr) noexcept
+bool ARMJIT_Memory::MapAtAddress(u32 addr, u32 num) noexcept
 {
-    u32 num = NDS.CurCPU;
-
     int region = num == 0
         ? ClassifyAddress9(addr)
         : ClassifyAddress7(addr);
@@ -738,6 +728,25 @@ bool ARMJIT_Memory::MapAtAddress(u32 addr) noexcept
     return true;
 }
 
+bool ARMJIT_Memory::MapForDirectAccess(u32 num, u32 addr) noexcept
+{
+    // IO is accessed a lot, don't go through the whole classification for it
+    switch (addr & 0xFF000000)
+    {
+    case 0x02000000:
+    case 0x03000000:
+        break;
+    case 0x0C000000:
+        if (NDS.ConsoleType == 1)
+            break;
+        return false;
+    default:
+        return false;
+    }
+
+    return MapAtAddress(addr, num);
+}
+
 u32 ARMJIT_Memory::PageSize = 0;
 u32 ARMJIT_Memory::PageShift = 0;
 
@@ -827,7 +836,7 @@ bool ARMJIT_Memory::FaultHandler(FaultDescription& faultDesc, melonDS::NDS& nds)
         u8* memStatus = nds.CurCPU == 0 ? nds.JIT.Memory.MappingStatus9 : nds.JIT.Memory.MappingStatus7;
 
         if (memStatus[faultDesc.EmulatedFaultAddr >> PageShift] == memstate_Unmapped)
-            rewriteToSlowPath = !nds.JIT.Memory.MapAtAddress(faultDesc.EmulatedFaultAddr);
+            rewriteToSlowPath = !nds.JIT.Memory.MapAtAddress(faultDesc.EmulatedFaultAddr, nds.CurCPU);
 
         if (rewriteToSlowPath)
         {
@@ -137,7 +137,40 @@ public:
     u32 LocaliseAddress(int region, u32 num, u32 addr) const noexcept;
     bool IsFastmemCompatible(int region) const noexcept;
     void* GetFuncForAddr(ARM* cpu, u32 addr, bool store, int size) const noexcept;
-    bool MapAtAddress(u32 addr) noexcept;
+    bool MapAtAddress(u32 addr, u32 num) noexcept;
+
+    /// Whether code outside of the JIT (the interpreter and DMA) accesses memory through the fastmem arena.
+    /// Off until the frontend enables it.
+    [[nodiscard]] bool IsDirectAccessEnabled() const noexcept { return DirectAccess; }
+    void SetDirectAccess(bool enabled) noexcept { DirectAccess = enabled && IsFastMemSupported(); }
+
+    /// Reads from the given CPU's address space through the fastmem arena.
+    /// For the ARM9, the DTCM is mapped into the arena, the caller has to check for it.
+    /// @returns \c false if the address can't be accessed directly,
+    /// in which case the access has to go through the regular memory handlers.
+    template <typename T>
+    bool DirectRead(u32 num, u32 addr, T& val) noexcept
+    {
+        u8* ptr = GetDirectAccessPtr<false>(num, addr & ~(sizeof(T) - 1));
+        if (!ptr)
+            return false;
+        val = *(T*)ptr;
+        return true;
+    }
+
+    /// Writes to the given CPU's address space through the fastmem arena.
+    /// Pages holding JIT code are never written directly,
+    /// the regular memory handlers invalidate the code.
+    /// @returns \c false if the address can't be accessed directly.
+    template <typename T>
+    bool DirectWrite(u32 num, u32 addr, T val) noexcept
+    {
+        u8* ptr = GetDirectAccessPtr<true>(num, addr & ~(sizeof(T) - 1));
+        if (!ptr)
+            return false;
+        *(T*)ptr = val;
+        return true;
+    }
 
     static bool IsFastMemSupported();
 
@@ -163,6 +196,42 @@ private:
         u8* FaultPC;
     };
     static bool FaultHandler(FaultDescription& faultDesc, melonDS::NDS& nds);
+
+    enum
+    {
+        memstate_Unmapped,
+        memstate_MappedRW,
+        // on Switch this is unmapped as well
+        memstate_MappedProtected,
+    };
+
+    template <bool write>
+    u8* GetDirectAccessPtr(u32 num, u32 addr) noexcept
+    {
+        if (!DirectAccess)
+            return nullptr;
+
+        const u8* states = num == 0 ? MappingStatus9 : MappingStatus7;
+        u8 state = states[addr >> PageShift];
+        if (state == memstate_Unmapped)
+        {
+            // like the JIT, map the whole mirror on the first access
+            if (!MapForDirectAccess(num, addr))
+                return nullptr;
+            state = states[addr >> PageShift];
+        }
+
+#ifdef __SWITCH__
+        bool readable = state == memstate_MappedRW;
+#else
+        bool readable = state != memstate_Unmapped;
+#endif
+        if (write ? state != memstate_MappedRW : !readable)
+            return nullptr;
+
+        return (u8*)(num == 0 ? FastMem9Start : FastMem7Start) + addr;
+    }
+    bool MapForDirectAccess(u32 num, u32 addr) noexcept;
     bool MapIntoRange(u32 addr, u32 num, u32 offset, u32 size) noexcept;
     bool UnmapFromRange(u32 addr, u32 num, u32 offset, u32 size) noexcept;
     void SetCodeProtectionRange(u32 addr, u32 size, u32 num, int protection) noexcept;
@@ -193,6 +262,8 @@ private:
 #ifdef ANDROID
     Platform::DynamicLibrary* Libandroid = nullptr;
 #endif
+    bool DirectAccess = false;
+
     u8 MappingStatus9[1 << (32-12)] {};
     u8 MappingStatus7[1 << (32-12)] {};
     TinyVector<Mapping> Mappings[memregions_Count] {};
@@ -211,6 +282,13 @@ public:
     void RemapNWRAM(int num) noexcept {}
     void SetCodeProtection(int region, u32 offset, bool protect) noexcept {}
 
+    [[nodiscard]] bool IsDirectAccessEnabled() const noexcept { return false; }
+    void SetDirectAccess(bool enabled) noexcept {}
+    template <typename T>
+    bool DirectRead(u32 num, u32 addr, T& val) noexcept { return false; }
+    template <typename T>
+    bool DirectWrite(u32 num, u32 addr, T val) noexcept { return false; }
+
     [[nodiscard]] u8* GetMainRAM() noexcept { return MainRAM.data(); }
     [[nodiscard]] const u8* GetMainRAM() const noexcept { return MainRAM.data(); }
 
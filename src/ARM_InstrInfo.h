@@ -276,6 +276,11 @@ struct Info
 
 Info Decode(bool thumb, u32 num, u32 instr, bool literaloptimizations);
 
+// checks whether a loop only waits for something external to happen
+// ie. no iteration depends on the previous one and nothing is written to memory
+// the last instruction is the branch back to the start of the loop
+bool IsIdleLoop(bool thumb, const Info* instrs, int instrsCount);
+
 }
 
 #endif
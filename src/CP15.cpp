@@ -30,15 +30,6 @@ namespace melonDS
 using Platform::Log;
 using Platform::LogLevel;
 
-// access timing for cached regions
-// this would be an average between cache hits and cache misses
-// this was measured to be close to hardware average
-// a value of 1 would represent a perfect cache, but that causes
-// games to run too fast, causing a number of issues
-const int kDataCacheTiming = 3;//2;
-const int kCodeCacheTiming = 3;//5;
-
-
 void ARMv5::CP15Reset()
 {
     CP15Control = 0x2078; // dunno
@@ -814,6 +805,15 @@ u32 ARMv5::CodeRead32(u32 addr, bool branch)
     return BusRead32(addr);
 }
 
+u32 ARMv5::FetchIdleLoopInstr(u32 addr, bool thumb)
+{
+    // don't disturb the timing of the instruction fetches
+    s32 codecycles = CodeCycles;
+    u32 val = CodeRead32(addr & ~3, false);
+    CodeCycles = codecycles;
+    return thumb ? ((val >> ((addr & 2) * 8)) & 0xFFFF) : val;
+}
+
 
 void ARMv5::DataRead8(u32 addr, u32* val)
 {
@@ -196,6 +196,37 @@ void DMA::Start()
     NDS.StopCPU(CPU, 1<<Num);
 }
 
+bool DMA::IsCartWordFeed() const noexcept
+{
+    u32 countmask;
+    if (CPU == 0)
+        countmask = 0x001FFFFF;
+    else
+        countmask = (Num==3 ? 0x0000FFFF : 0x00003FFF);
+
+    // 32-bit, repeating, one unit per trigger, no IRQ, from the fixed data port
+    return IsInMode(CPU ? 0x12 : 0x05) && !Running && !InProgress &&
+           (Cnt & (1<<26)) && (Cnt & (1<<25)) && !(Cnt & (1<<30)) &&
+           (Cnt & countmask) == 1 &&
+           SrcAddrInc == 0 && CurSrcAddr == 0x04100010;
+}
+
+void DMA::FeedWords(const u8* data, u32 len)
+{
+    for (u32 i = 0; i < len; i += 4)
+    {
+        if ((Cnt & 0x00600000) == 0x00600000)
+            CurDstAddr = DstAddr;
+
+        if (CPU == 0)
+            BusWrite<0, u32>(CurDstAddr, *(u32*)&data[i]);
+        else
+            BusWrite<1, u32>(CurDstAddr, *(u32*)&data[i]);
+
+        CurDstAddr += DstAddrInc<<2;
+    }
+}
+
 u32 DMA::UnitTimings9_16(bool burststart)
 {
     u32 src_id = CurSrcAddr >> 14;
@@ -550,6 +581,39 @@ u32 DMA::UnitTimings7_32(bool burststart)
     }
 }
 
+template <u32 cpu, typename T>
+T DMA::BusRead(u32 addr)
+{
+    // main RAM and WRAM go straight through the fastmem arena
+    // the ARM9's DTCM is mapped there as well, but DMA doesn't see it
+    T val;
+    if ((cpu == 1 || (addr & NDS.ARM9.DTCMMask) != NDS.ARM9.DTCMBase) && NDS.JIT.Memory.DirectRead(cpu, addr, val))
+        return val;
+
+    if constexpr (cpu == 0)
+        return sizeof(T) == 2 ? NDS.ARM9Read16(addr) : NDS.ARM9Read32(addr);
+    else
+        return sizeof(T) == 2 ? NDS.ARM7Read16(addr) : NDS.ARM7Read32(addr);
+}
+
+template <u32 cpu, typename T>
+void DMA::BusWrite(u32 addr, T val)
+{
+    if ((cpu == 1 || (addr & NDS.ARM9.DTCMMask) != NDS.ARM9.DTCMBase) && NDS.JIT.Memory.DirectWrite(cpu, addr, val))
+        return;
+
+    if constexpr (cpu == 0)
+    {
+        if constexpr (sizeof(T) == 2) NDS.ARM9Write16(addr, val);
+        else                          NDS.ARM9Write32(addr, val);
+    }
+    else
+    {
+        if constexpr (sizeof(T) == 2) NDS.ARM7Write16(addr, val);
+        else                          NDS.ARM7Write32(addr, val);
+    }
+}
+
 void DMA::Run9()
 {
     if (NDS.ARM9Timestamp >= NDS.ARM9Target) return;
@@ -567,7 +631,7 @@ void DMA::Run9()
             NDS.ARM9Timestamp += (UnitTimings9_16(burststart) << NDS.ARM9ClockShift);
             burststart = false;
 
-            NDS.ARM9Write16(CurDstAddr, NDS.ARM9Read16(CurSrcAddr));
+            BusWrite<0, u16>(CurDstAddr, BusRead<0, u16>(CurSrcAddr));
 
             CurSrcAddr += SrcAddrInc<<1;
             CurDstAddr += DstAddrInc<<1;
@@ -584,7 +648,7 @@ void DMA::Run9()
             NDS.ARM9Timestamp += (UnitTimings9_32(burststart) << NDS.ARM9ClockShift);
             burststart = false;
 
-            NDS.ARM9Write32(CurDstAddr, NDS.ARM9Read32(CurSrcAddr));
+            BusWrite<0, u32>(CurDstAddr, BusRead<0, u32>(CurSrcAddr));
 
             CurSrcAddr += SrcAddrInc<<2;
             CurDstAddr += DstAddrInc<<2;
@@ -640,7 +704,7 @@ void DMA::Run7()
             NDS.ARM7Timestamp += UnitTimings7_16(burststart);
             burststart = false;
 
-            NDS.ARM7Write16(CurDstAddr, NDS.ARM7Read16(CurSrcAddr));
+            BusWrite<1, u16>(CurDstAddr, BusRead<1, u16>(CurSrcAddr));
 
             CurSrcAddr += SrcAddrInc<<1;
             CurDstAddr += DstAddrInc<<1;
@@ -657,7 +721,7 @@ void DMA::Run7()
             NDS.ARM7Timestamp += UnitTimings7_32(burststart);
             burststart = false;
 
-            NDS.ARM7Write32(CurDstAddr, NDS.ARM7Read32(CurSrcAddr));
+            BusWrite<1, u32>(CurDstAddr, BusRead<1, u32>(CurSrcAddr));
 
             CurSrcAddr += SrcAddrInc<<2;
             CurDstAddr += DstAddrInc<<2;
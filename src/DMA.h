@@ -73,6 +73,14 @@ public:
         if (Executing) Stall = true;
     }
 
+    /// Whether the channel moves one word from the cart ROM data port per data-ready trigger,
+    /// which is how games read the cart.
+    bool IsCartWordFeed() const noexcept;
+
+    /// Does the writes of one trigger of a cart word feed per word of the given data at once,
+    /// without the timing of the individual transfers.
+    void FeedWords(const u8* data, u32 len);
+
     u32 SrcAddr {};
     u32 DstAddr {};
     u32 Cnt {};
@@ -101,6 +109,11 @@ private:
 
     u32 MRAMBurstCount {};
     std::array<u8, 256> MRAMBurstTable;
+
+    template <u32 cpu, typename T>
+    T BusRead(u32 addr);
+    template <u32 cpu, typename T>
+    void BusWrite(u32 addr, T val);
 };
 
 }
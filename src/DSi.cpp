@@ -1066,6 +1066,15 @@ void DSi::CheckDMAs(u32 cpu, u32 mode)
 
     CheckNDMAs(cpu, NDMAModes[mode]);
 }
+
+DMA* DSi::GetCartWordFeed(u32 cpu)
+{
+    // the cart data may be going to an NDMA channel instead
+    if (NDMAsInMode(cpu, NDMAModes[cpu ? 0x12 : 0x05]))
+        return nullptr;
+
+    return NDS::GetCartWordFeed(cpu);
+}
 // new WRAM mapping
 // TODO: find out what happens upon overlapping slots!!
 
@@ -164,6 +164,7 @@ public:
     bool DMAsRunning(u32 cpu) const override;
     void StopDMAs(u32 cpu, u32 mode) override;
     void CheckDMAs(u32 cpu, u32 mode) override;
+    DMA* GetCartWordFeed(u32 cpu) override;
     u16 SCFG_Clock7;
     u32 SCFG_MC;
     u16 SCFG_RST;
@@ -35,11 +35,13 @@ using namespace melonDS::Platform;
 namespace melonDS::DSi_NAND
 {
 
-NANDImage::NANDImage(Platform::FileHandle* nandfile, const DSiKey& es_keyY) noexcept : NANDImage(nandfile, es_keyY.data())
+NANDImage::NANDImage(Platform::FileHandle* nandfile, const DSiKey& es_keyY, u32 cachesectors) noexcept :
+    NANDImage(nandfile, es_keyY.data(), cachesectors)
 {
 }
 
-NANDImage::NANDImage(Platform::FileHandle* nandfile, const u8* es_keyY) noexcept
+NANDImage::NANDImage(Platform::FileHandle* nandfile, const u8* es_keyY, u32 cachesectors) noexcept :
+    Cache(cachesectors)
 {
     if (!nandfile)
         return;
@@ -108,10 +110,12 @@ NANDImage::NANDImage(Platform::FileHandle* nandfile, const u8* es_keyY) noexcept
     Bswap128(ESKey.data(), tmp);
 
     CurFile = nandfile;
+    Cache.SetFile(CurFile, Length);
 }
 
 NANDImage::~NANDImage()
 {
+    Cache.SetFile(nullptr, 0);
     if (CurFile) CloseFile(CurFile);
     CurFile = nullptr;
 }
@@ -123,7 +127,8 @@ NANDImage::NANDImage(NANDImage&& other) noexcept :
     FATIV(other.FATIV),
     FATKey(other.FATKey),
     ESKey(other.ESKey),
-    Length(other.Length)
+    Length(other.Length),
+    Cache(std::move(other.Cache))
 {
     other.CurFile = nullptr;
 }
@@ -132,6 +137,7 @@ NANDImage& NANDImage::operator=(NANDImage&& other) noexcept
 {
     if (this != &other)
     {
+        Cache.SetFile(nullptr, 0);
         if (CurFile)
             CloseFile(CurFile);
 
@@ -142,6 +148,7 @@ NANDImage& NANDImage::operator=(NANDImage&& other) noexcept
         FATKey = other.FATKey;
         ESKey = other.ESKey;
         Length = other.Length;
+        Cache = std::move(other.Cache);
 
         other.CurFile = nullptr;
     }
@@ -213,9 +220,7 @@ u32 NANDImage::ReadFATBlock(u64 addr, u32 len, u8* buf)
     AES_ctx ctx;
     SetupFATCrypto(&ctx, ctr);
 
-    FileSeek(CurFile, addr, FileSeekOrigin::Start);
-    u32 res = FileRead(buf, len, 1, CurFile);
-    if (!res) return 0;
+    if (Cache.ReadBytes(addr, len, buf) < len) return 0;
 
     for (u32 i = 0; i < len; i += 16)
     {
@@ -235,8 +240,6 @@ u32 NANDImage::WriteFATBlock(u64 addr, u32 len, const u8* buf)
     AES_ctx ctx;
     SetupFATCrypto(&ctx, ctr);
 
-    FileSeek(CurFile, addr, FileSeekOrigin::Start);
-
     for (u32 s = 0; s < len; s += 0x200)
     {
         u8 tempbuf[0x200];
@@ -249,8 +252,7 @@ u32 NANDImage::WriteFATBlock(u64 addr, u32 len, const u8* buf)
             Bswap128(&tempbuf[i], tmp);
         }
 
-        u32 res = FileWrite(tempbuf, sizeof(tempbuf), 1, CurFile);
-        if (!res) return 0;
+        if (Cache.WriteBytes(addr + s, sizeof(tempbuf), tempbuf) < sizeof(tempbuf)) return 0;
     }
 
     return len;
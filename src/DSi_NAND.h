@@ -24,6 +24,7 @@
 #include "NDS_Header.h"
 #include "DSi_TMD.h"
 #include "SPI_Firmware.h"
+#include "SectorCache.h"
 #include <array>
 #include <memory>
 #include <vector>
@@ -49,8 +50,9 @@ using DSiKey = std::array<u8, 16>;
 class NANDImage
 {
 public:
-    explicit NANDImage(Platform::FileHandle* nandfile, const DSiKey& es_keyY) noexcept;
-    explicit NANDImage(Platform::FileHandle* nandfile, const u8* es_keyY) noexcept;
+    /// @param cachesectors Number of sectors of the image kept in memory, 0 to disable caching.
+    explicit NANDImage(Platform::FileHandle* nandfile, const DSiKey& es_keyY, u32 cachesectors = SectorCache::DefaultCapacity) noexcept;
+    explicit NANDImage(Platform::FileHandle* nandfile, const u8* es_keyY, u32 cachesectors = SectorCache::DefaultCapacity) noexcept;
     ~NANDImage();
     NANDImage(const NANDImage&) = delete;
     NANDImage& operator=(const NANDImage&) = delete;
@@ -58,7 +60,17 @@ public:
     NANDImage(NANDImage&& other) noexcept;
     NANDImage& operator=(NANDImage&& other) noexcept;
 
-    Platform::FileHandle* GetFile() { return CurFile; }
+    /// Writes back and drops the cached sectors, as the caller accesses the file directly.
+    Platform::FileHandle* GetFile() { Cache.SetFile(CurFile, CurFile ? Length : 0); return CurFile; }
+
+    /// Reads or writes the raw (encrypted) image, through the sector cache.
+    u32 ReadRaw(u64 addr, u32 len, u8* data) { return Cache.ReadBytes(addr, len, data); }
+    u32 WriteRaw(u64 addr, u32 len, const u8* data) { return Cache.WriteBytes(addr, len, data); }
+
+    /// Writes the sectors still held in the cache back to the image.
+    void Flush() { Cache.Flush(); }
+    /// Same, if nothing was written since the previous call. Meant to be called once per frame.
+    void FlushIfIdle() { Cache.FlushIfIdle(); }
 
     [[nodiscard]] const DSiKey& GetEMMCID() const noexcept { return eMMC_CID; }
     [[nodiscard]] u64 GetConsoleID() const noexcept { return ConsoleID; }
@@ -79,6 +91,7 @@ private:
     DSiKey FATKey;
     DSiKey ESKey;
     u64 Length;
+    SectorCache Cache;
 };
 
 class NANDMount
@@ -236,6 +236,12 @@ void DSi_SDHost::DoSavestate(Savestate* file)
     if (Ports[1]) Ports[1]->DoSavestate(file);
 }
 
+void DSi_SDHost::FlushIfIdle()
+{
+    if (Ports[0]) Ports[0]->FlushIfIdle();
+    if (Ports[1]) Ports[1]->FlushIfIdle();
+}
+
 
 void DSi_SDHost::UpdateData32IRQ()
 {
@@ -864,6 +870,24 @@ void DSi_MMCStorage::DoSavestate(Savestate* file)
     file->Var32(&RWCommand);
 
     // TODO: what about the file contents?
+    // at least make sure the image is up to date with the state
+    Flush();
+}
+
+void DSi_MMCStorage::Flush()
+{
+    if (auto* sd = get_if<FATStorage>(&Storage))
+        sd->Flush();
+    else if (auto* nand = get_if<DSi_NAND::NANDImage>(&Storage))
+        nand->Flush();
+}
+
+void DSi_MMCStorage::FlushIfIdle()
+{
+    if (auto* sd = get_if<FATStorage>(&Storage))
+        sd->FlushIfIdle();
+    else if (auto* nand = get_if<DSi_NAND::NANDImage>(&Storage))
+        nand->FlushIfIdle();
 }
 
 void DSi_MMCStorage::SendCMD(u8 cmd, u32 param)
@@ -942,8 +966,6 @@ void DSi_MMCStorage::SendCMD(u8 cmd, u32 param)
 
     case 12: // stop operation
         SetState(0x04);
-        if (auto* nand = get_if<DSi_NAND::NANDImage>(&Storage))
-            FileFlush(nand->GetFile());
         RWCommand = 0;
         Host->SendResponse(CSR, true);
         return;
@@ -1076,8 +1098,7 @@ u32 DSi_MMCStorage::ReadBlock(u64 addr)
     }
     else if (auto* nand = std::get_if<DSi_NAND::NANDImage>(&Storage))
     {
-        FileSeek(nand->GetFile(), addr, FileSeekOrigin::Start);
-        FileRead(&data[addr & 0x1FF], 1, len, nand->GetFile());
+        nand->ReadRaw(addr, len, &data[addr & 0x1FF]);
     }
 
     return Host->DataRX(&data[addr & 0x1FF], len);
@@ -1106,8 +1127,7 @@ u32 DSi_MMCStorage::WriteBlock(u64 addr)
             }
             else if (auto* nand = get_if<DSi_NAND::NANDImage>(&Storage))
             {
-                FileSeek(nand->GetFile(), addr, FileSeekOrigin::Start);
-                FileWrite(&data[addr & 0x1FF], 1, len, nand->GetFile());
+                nand->WriteRaw(addr, len, &data[addr & 0x1FF]);
             }
         }
     }
@@ -48,6 +48,9 @@ public:
 
     void DoSavestate(Savestate* file);
 
+    /// Writes back the storage sectors cached by the devices, if they're not being written to.
+    void FlushIfIdle();
+
     void FinishRX(u32 param);
     void FinishTX(u32 param);
     void SendResponse(u32 val, bool last);
@@ -131,6 +134,8 @@ public:
 
     virtual void DoSavestate(Savestate* file) = 0;
 
+    virtual void FlushIfIdle() {}
+
     virtual void SendCMD(u8 cmd, u32 param) = 0;
     virtual void ContinueTransfer() = 0;
 
@@ -181,6 +186,9 @@ public:
 
     void DoSavestate(Savestate* file) override;
 
+    void Flush();
+    void FlushIfIdle() override;
+
     void SetCID(const u8* cid) { memcpy(CID, cid, sizeof(CID)); }
 
     void SendCMD(u8 cmd, u32 param) override;
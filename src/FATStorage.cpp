@@ -31,20 +31,22 @@ namespace fs = std::filesystem;
 using namespace Platform;
 using std::string;
 
-FATStorage::FATStorage(const std::string& filename, u64 size, bool readonly, const std::optional<string>& sourcedir) :
-    FATStorage(FATStorageArgs { filename, size, readonly, sourcedir })
+FATStorage::FATStorage(const std::string& filename, u64 size, bool readonly, const std::optional<string>& sourcedir, bool virtualfolder) :
+    FATStorage(FATStorageArgs { filename, size, readonly, sourcedir, virtualfolder })
 {
 }
 
 FATStorage::FATStorage(const FATStorageArgs& args) noexcept :
-    FATStorage(args.Filename, args.Size, args.ReadOnly, args.SourceDir)
+    FATStorage(FATStorageArgs(args))
 {
 }
 
 FATStorage::FATStorage(FATStorageArgs&& args) noexcept :
     FilePath(std::move(args.Filename)),
     FileSize(args.Size),
+    Cache(args.CacheSectors),
     ReadOnly(args.ReadOnly),
+    VirtualFolder(args.VirtualFolder),
     SourceDir(std::move(args.SourceDir))
 {
     Load(FilePath, FileSize, SourceDir);
@@ -56,8 +58,11 @@ FATStorage::FATStorage(FATStorage&& other) noexcept
     IndexPath = std::move(other.IndexPath);
     SourceDir = std::move(other.SourceDir);
     ReadOnly = other.ReadOnly;
+    VirtualFolder = other.VirtualFolder;
     File = other.File;
     FileSize = other.FileSize;
+    Cache = std::move(other.Cache);
+    Virtual = std::move(other.Virtual);
     DirIndex = std::move(other.DirIndex);
     FileIndex = std::move(other.FileIndex);
 
@@ -68,18 +73,22 @@ FATStorage& FATStorage::operator=(FATStorage&& other) noexcept
 {
     if (this != &other)
     {
-        if (File)
+        if (File || Virtual)
         { // Sync this file's contents to the host (if applicable) before closing it
             if (!ReadOnly) Save();
-            CloseFile(File);
+            Cache.SetFile(nullptr, 0);
+            if (File) CloseFile(File);
         }
 
         FilePath = std::move(other.FilePath);
         IndexPath = std::move(other.IndexPath);
         SourceDir = std::move(other.SourceDir);
         ReadOnly = other.ReadOnly;
+        VirtualFolder = other.VirtualFolder;
         File = other.File;
         FileSize = other.FileSize;
+        Cache = std::move(other.Cache);
+        Virtual = std::move(other.Virtual);
         DirIndex = std::move(other.DirIndex);
         FileIndex = std::move(other.FileIndex);
 
@@ -94,15 +103,16 @@ FATStorage::~FATStorage()
 {
     if (!ReadOnly) Save();
 
+    Cache.SetFile(nullptr, 0);
     if (File) CloseFile(File);
     File = nullptr;
 }
 
 bool FATStorage::InjectFile(const std::string& path, u8* data, u32 len)
 {
-    if (!File) return false;
+    if (!File && !Virtual) return false;
 
-    ff_disk_open(FF_ReadStorage(), FF_WriteStorage(), (LBA_t)(FileSize>>9));
+    ff_disk_open(FF_ReadStorage(), FF_WriteStorage(), (LBA_t)GetSectorCount());
 
     FRESULT res;
     FATFS fs;
@@ -137,9 +147,9 @@ bool FATStorage::InjectFile(const std::string& path, u8* data, u32 len)
 
 u32 FATStorage::ReadFile(const std::string& path, u32 start, u32 len, u8* data)
 {
-    if (!File) return false;
+    if (!File && !Virtual) return false;
 
-    ff_disk_open(FF_ReadStorage(), FF_WriteStorage(), (LBA_t)(FileSize>>9));
+    ff_disk_open(FF_ReadStorage(), FF_WriteStorage(), (LBA_t)GetSectorCount());
 
     FRESULT res;
     FATFS fs;
@@ -175,85 +185,49 @@ u32 FATStorage::ReadFile(const std::string& path, u32 start, u32 len, u8* data)
 
 u32 FATStorage::ReadSectors(u32 start, u32 num, u8* data) const
 {
-    return ReadSectorsInternal(File, FileSize, start, num, data);
+    if (Virtual) return Virtual->ReadSectors(start, num, data);
+    return Cache.Read(start, num, data);
 }
 
 u32 FATStorage::WriteSectors(u32 start, u32 num, const u8* data)
 {
     if (ReadOnly) return 0;
-    return WriteSectorsInternal(File, FileSize, start, num, data);
+    if (Virtual) return Virtual->WriteSectors(start, num, data);
+    return Cache.Write(start, num, data);
+}
+
+void FATStorage::Flush()
+{
+    Cache.Flush();
+}
+
+void FATStorage::FlushIfIdle()
+{
+    Cache.FlushIfIdle();
 }
 
 u64 FATStorage::GetSectorCount() const
 {
+    if (Virtual) return Virtual->GetSectorCount();
     return FileSize / 0x200;
 }
 
 ff_disk_read_cb FATStorage::FF_ReadStorage() const noexcept
 {
     return [this](BYTE* buf, LBA_t sector, UINT num) {
-        return ReadSectorsInternal(File, FileSize, sector, num, buf);
+        return ReadSectors(sector, num, buf);
     };
 }
 
 ff_disk_write_cb FATStorage::FF_WriteStorage() const noexcept
 {
     return [this](const BYTE* buf, LBA_t sector, UINT num) {
-        return WriteSectorsInternal(File, FileSize, sector, num, buf);
+        if (Virtual) return Virtual->WriteSectors(sector, num, buf);
+        return Cache.Write(sector, num, buf);
     };
 }
 
 
-u32 FATStorage::ReadSectorsInternal(FileHandle* file, u64 filelen, u32 start, u32 num, u8* data)
-{
-    if (!file) return 0;
-
-    u64 addr = start * 0x200ULL;
-    u32 len = num * 0x200;
-
-    if ((addr+len) > filelen)
-    {
-        if (addr >= filelen) return 0;
-        len = filelen - addr;
-        num = len >> 9;
-    }
-
-    FileSeek(file, addr, FileSeekOrigin::Start);
-
-    u32 res = FileRead(data, 0x200, num, file);
-    if (res < num)
-    {
-        if (IsEndOfFile(file))
-        {
-            memset(&data[0x200*res], 0, 0x200*(num-res));
-            return num;
-        }
-    }
-
-    return res;
-}
-
-u32 FATStorage::WriteSectorsInternal(FileHandle* file, u64 filelen, u32 start, u32 num, const u8* data)
-{
-    if (!file) return 0;
-
-    u64 addr = start * 0x200ULL;
-    u32 len = num * 0x200;
-
-    if ((addr+len) > filelen)
-    {
-        if (addr >= filelen) return 0;
-        len = filelen - addr;
-        num = len >> 9;
-    }
-
-    FileSeek(file, addr, FileSeekOrigin::Start);
-
-    u32 res = Platform::FileWrite(data, 0x200, num, file);
-    return res;
-}
-
-
 void FATStorage::LoadIndex()
 {
     DirIndex.clear();
@@ -1015,6 +989,17 @@ bool FATStorage::Load(const std::string& filename, u64 size, const std::optional
         }
     }
 
+    if (hasdir && VirtualFolder)
+    {
+        // no image: the volume is built from the directory, which is only scanned
+        // if that fails, fall back to importing the directory into the image
+        Virtual = std::make_unique<VirtualFAT>(*sourcedir, filename + ".vfat", size, ReadOnly);
+        if (Virtual->IsValid())
+            return true;
+
+        Virtual = nullptr;
+    }
+
     // 'auto' size management: (size=0)
     // * if an index exists: the size from the index is used
     // * if no index, and an image file exists: the file size is used
@@ -1042,6 +1027,7 @@ bool FATStorage::Load(const std::string& filename, u64 size, const std::optional
             FileSize = FileLength(File);
         }
     }
+    Cache.SetFile(File, FileSize);
 
     bool needformat = false;
     FATFS fs;
@@ -1090,6 +1076,7 @@ bool FATStorage::Load(const std::string& filename, u64 size, const std::optional
         }
 
         ff_disk_close();
+        Cache.SetFile(File, FileSize);
         ff_disk_open(FF_ReadStorage(), FF_WriteStorage(), (LBA_t)(FileSize>>9));
 
         DirIndex.clear();
@@ -1128,11 +1115,17 @@ bool FATStorage::Load(const std::string& filename, u64 size, const std::optional
 
     ff_disk_close();
 
+    Cache.Flush();
     return true;
 }
 
 bool FATStorage::Save()
 {
+    if (Virtual)
+        return Virtual->Sync();
+
+    Cache.Flush();
+
     if (!SourceDir)
     { // If we're not syncing the SD card image to a host directory...
         return true; // Not an error.
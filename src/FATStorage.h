@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <string>
 #include <map>
+#include <memory>
 #include <optional>
 #include <filesystem>
 
@@ -29,6 +30,8 @@
 #include "types.h"
 #include "fatfs/ff.h"
 #include "FATIO.h"
+#include "FATVirtual.h"
+#include "SectorCache.h"
 
 namespace melonDS
 {
@@ -45,12 +48,20 @@ struct FATStorageArgs
     u64 Size;
     bool ReadOnly;
     std::optional<std::string> SourceDir;
+
+    /// If set, SourceDir is used directly as a virtual FAT volume
+    /// instead of being imported into the image file at startup.
+    /// The image file is left untouched, the volume's changes are applied to SourceDir on shutdown.
+    bool VirtualFolder = false;
+
+    /// Number of sectors of the image to cache in memory, 0 to disable the cache.
+    u32 CacheSectors = SectorCache::DefaultCapacity;
 };
 
 class FATStorage
 {
 public:
-    FATStorage(const std::string& filename, u64 size, bool readonly, const std::optional<std::string>& sourcedir = std::nullopt);
+    FATStorage(const std::string& filename, u64 size, bool readonly, const std::optional<std::string>& sourcedir = std::nullopt, bool virtualfolder = false);
     explicit FATStorage(const FATStorageArgs& args) noexcept;
     explicit FATStorage(FATStorageArgs&& args) noexcept;
     FATStorage(FATStorage&& other) noexcept;
@@ -65,6 +76,11 @@ public:
     u32 ReadSectors(u32 start, u32 num, u8* data) const;
     u32 WriteSectors(u32 start, u32 num, const u8* data);
 
+    /// Writes the sectors still held in the cache back to the image.
+    void Flush();
+    /// Same, if nothing was written since the previous call. Meant to be called once per frame.
+    void FlushIfIdle();
+
     [[nodiscard]] bool IsReadOnly() const noexcept { return ReadOnly; }
     u64 GetSectorCount() const;
 
@@ -73,16 +89,17 @@ private:
     std::string IndexPath;
     std::optional<std::string> SourceDir;
     bool ReadOnly;
+    bool VirtualFolder;
 
-    Platform::FileHandle* File;
+    Platform::FileHandle* File = nullptr;
     u64 FileSize;
+    mutable SectorCache Cache;
+
+    std::unique_ptr<VirtualFAT> Virtual;
 
     [[nodiscard]] ff_disk_read_cb FF_ReadStorage() const noexcept;
     [[nodiscard]] ff_disk_write_cb FF_WriteStorage() const noexcept;
 
-    static u32 ReadSectorsInternal(Platform::FileHandle* file, u64 filelen, u32 start, u32 num, u8* data);
-    static u32 WriteSectorsInternal(Platform::FileHandle* file, u64 filelen, u32 start, u32 num, const u8* data);
-
     void LoadIndex();
     void SaveIndex();
 
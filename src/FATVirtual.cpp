@@ -0,0 +1,1277 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "FATIO.h"
+#include "FATVirtual.h"
+
+namespace melonDS
+{
+namespace fs = std::filesystem;
+using namespace Platform;
+using std::string;
+
+// ClusterMap entries with this bit set hold a scratch file slot
+constexpr u32 ScratchCluster = 0x80000000;
+
+constexpr u32 FATEndOfChain = 0x0FFFFFFF;
+constexpr u32 ReservedSectors = 32;
+constexpr u32 MaxDirSlots = 65536;
+constexpr u32 MaxOpenFiles = 8;
+constexpr int MaxDepth = 32;
+
+// where the 13 UTF-16 characters of a long name entry are
+constexpr int LongNameCharPos[13] = {1, 3, 5, 7, 9, 14, 16, 18, 20, 22, 24, 28, 30};
+
+// 1GB at least, so that there are always enough clusters for the volume to be FAT32
+constexpr u64 MinVolumeSize = 0x40000000ULL;
+// sector numbers have to fit in 32 bits
+constexpr u64 MaxVolumeSize = 0x10000000000ULL;
+
+
+static bool DecodeUTF8(const string& in, std::u16string& out)
+{
+    out.clear();
+
+    size_t i = 0;
+    while (i < in.length())
+    {
+        u8 c = in[i];
+        u32 cp;
+        int len;
+        if (c < 0x80)      { cp = c;        len = 1; }
+        else if (c < 0xC0) return false;
+        else if (c < 0xE0) { cp = c & 0x1F; len = 2; }
+        else if (c < 0xF0) { cp = c & 0x0F; len = 3; }
+        else if (c < 0xF8) { cp = c & 0x07; len = 4; }
+        else return false;
+
+        if (i + len > in.length()) return false;
+        for (int j = 1; j < len; j++)
+        {
+            u8 cc = in[i+j];
+            if ((cc & 0xC0) != 0x80) return false;
+            cp = (cp << 6) | (cc & 0x3F);
+        }
+        i += len;
+
+        if (cp >= 0x10000)
+        {
+            if (cp > 0x10FFFF) return false;
+            cp -= 0x10000;
+            out.push_back((char16_t)(0xD800 | (cp >> 10)));
+            out.push_back((char16_t)(0xDC00 | (cp & 0x3FF)));
+        }
+        else
+            out.push_back((char16_t)cp);
+    }
+
+    return true;
+}
+
+static string EncodeUTF8(const std::u16string& in)
+{
+    string out;
+
+    for (size_t i = 0; i < in.length(); i++)
+    {
+        u32 cp = in[i];
+        if (cp >= 0xD800 && cp < 0xDC00 && (i + 1) < in.length() && in[i+1] >= 0xDC00 && in[i+1] < 0xE000)
+        {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (in[i+1] - 0xDC00);
+            i++;
+        }
+
+        if (cp < 0x80)
+            out += (char)cp;
+        else if (cp < 0x800)
+        {
+            out += (char)(0xC0 | (cp >> 6));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000)
+        {
+            out += (char)(0xE0 | (cp >> 12));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+        else
+        {
+            out += (char)(0xF0 | (cp >> 18));
+            out += (char)(0x80 | ((cp >> 12) & 0x3F));
+            out += (char)(0x80 | ((cp >> 6) & 0x3F));
+            out += (char)(0x80 | (cp & 0x3F));
+        }
+    }
+
+    return out;
+}
+
+static bool IsValidLongName(const std::u16string& name)
+{
+    if (name.empty() || name.length() > 255) return false;
+    if (name == u"." || name == u"..") return false;
+
+    // FAT drops trailing dots and spaces
+    char16_t last = name.back();
+    if (last == '.' || last == ' ') return false;
+
+    for (char16_t c : name)
+    {
+        if (c < 0x20) return false;
+        if (c < 0x80 && strchr("\"*/:<>?\\|", (char)c)) return false;
+    }
+
+    return true;
+}
+
+static bool IsShortNameChar(char c)
+{
+    if (c >= 'A' && c <= 'Z') return true;
+    if (c >= '0' && c <= '9') return true;
+    return c != '\0' && strchr("!#$%&'()-@^_`{}~", c);
+}
+
+static string MakeShortNamePart(const string& in, size_t maxlen)
+{
+    string out;
+    for (char c : in)
+    {
+        if (out.length() >= maxlen) break;
+        if (c == ' ' || c == '.') continue;
+
+        if (c >= 'a' && c <= 'z') c -= 0x20;
+        out += IsShortNameChar(c) ? c : '_';
+    }
+    return out;
+}
+
+// picks an 8.3 name for the given name, unique within the directory
+// returns whether the entry needs a long name
+static bool MakeShortName(const string& name, std::unordered_set<string>& used, std::unordered_map<string, u32>& nextalias, u8* out)
+{
+    size_t dot = name.rfind('.');
+    string base = name.substr(0, dot);
+    string ext = (dot == string::npos) ? "" : name.substr(dot+1);
+
+    bool exact = !base.empty() && base.length() <= 8 && ext.length() <= 3;
+    if (dot != string::npos && ext.empty()) exact = false;
+    for (char c : base + ext)
+    {
+        if (!IsShortNameChar(c)) exact = false;
+    }
+
+    string key;
+    if (exact)
+    {
+        key = base + string(8 - base.length(), ' ') + ext + string(3 - ext.length(), ' ');
+        if (used.insert(key).second)
+        {
+            memcpy(out, key.data(), 11);
+            return false;
+        }
+    }
+
+    // a numbered alias, as Windows would generate
+    // leading dots are skipped, so ".hidden" doesn't end up with an empty name
+    if (dot == 0)
+    {
+        base = name.substr(1);
+        ext = "";
+    }
+    base = MakeShortNamePart(base, 8);
+    ext = MakeShortNamePart(ext, 3);
+    if (base.empty()) base = "_";
+
+    // carry on from the last number given to the same name, so large directories don't take forever
+    u32& n = nextalias[base + "." + ext];
+    for (n = std::max(n, 1u); ; n++)
+    {
+        string tail = "~" + std::to_string(n);
+        string alias = base.substr(0, 8 - tail.length()) + tail;
+        key = alias + string(8 - alias.length(), ' ') + ext + string(3 - ext.length(), ' ');
+        if (used.insert(key).second)
+            break;
+    }
+
+    memcpy(out, key.data(), 11);
+    return true;
+}
+
+// turns the 8.3 name of a directory entry into the name it stands for
+static string ShortNameToString(const u8* entry)
+{
+    // lower case flags set by Windows NT and fatfs
+    const bool lowerbase = entry[12] & 0x08;
+    const bool lowerext = entry[12] & 0x10;
+
+    std::u16string name;
+    auto addpart = [&](const u8* part, int len, bool lower)
+    {
+        while (len > 0 && part[len-1] == ' ') len--;
+
+        for (int i = 0; i < len; i++)
+        {
+            u8 c = part[i];
+            if (c == 0x05 && part == entry && i == 0) c = 0xE5; // escaped 0xE5 first byte
+
+            if (c < 0x80)
+            {
+                if (lower && c >= 'A' && c <= 'Z') c += 0x20;
+                name += (char16_t)c;
+            }
+            else if ((i + 1) < len && ((c >= 0x81 && c <= 0x9F) || (c >= 0xE0 && c <= 0xFC)))
+            {
+                // Shift-JIS double byte character, the code page fatfs is configured for
+                name += (char16_t)ff_oem2uni((c << 8) | part[i+1], FF_CODE_PAGE);
+                i++;
+            }
+            else
+                name += (char16_t)ff_oem2uni(c, FF_CODE_PAGE);
+        }
+    };
+
+    addpart(&entry[0], 8, lowerbase);
+    if (entry[8] != ' ')
+    {
+        name += u'.';
+        addpart(&entry[8], 3, lowerext);
+    }
+
+    return EncodeUTF8(name);
+}
+
+static u8 ShortNameChecksum(const u8* name)
+{
+    u8 sum = 0;
+    for (int i = 0; i < 11; i++)
+        sum = ((sum & 1) << 7) + (sum >> 1) + name[i];
+    return sum;
+}
+
+static u32 NumLongNameSlots(const std::u16string& name)
+{
+    return (name.length() + 12) / 13;
+}
+
+static void GetFATTimestamp(const fs::file_time_type& filetime, u16& time, u16& date)
+{
+    // file_time_type's epoch is unspecified before C++20
+    auto systime = std::chrono::system_clock::now() +
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(filetime - fs::file_time_type::clock::now());
+    time_t timestamp = std::chrono::system_clock::to_time_t(systime);
+
+    struct tm timedata;
+#if defined(_MSC_VER)
+    localtime_s(&timedata, &timestamp);
+#else
+    localtime_r(&timestamp, &timedata);
+#endif
+
+    // FAT dates go from 1980 to 2107
+    if (timedata.tm_year < 80)
+    {
+        time = 0;
+        date = (1 << 5) | 1;
+        return;
+    }
+
+    int year = std::min(timedata.tm_year - 80, 127);
+    time = (timedata.tm_sec >> 1) | (timedata.tm_min << 5) | (timedata.tm_hour << 11);
+    date = timedata.tm_mday | ((timedata.tm_mon + 1) << 5) | (year << 9);
+}
+
+static void WriteShortEntry(u8* out, const u8* name, u8 attr, u32 cluster, u32 size, u16 time, u16 date)
+{
+    memset(out, 0, 32);
+    memcpy(&out[0], name, 11);
+    out[11] = attr;
+    memcpy(&out[14], &time, 2);
+    memcpy(&out[16], &date, 2);
+    memcpy(&out[18], &date, 2);
+    u16 hi = cluster >> 16, lo = cluster & 0xFFFF;
+    memcpy(&out[20], &hi, 2);
+    memcpy(&out[22], &time, 2);
+    memcpy(&out[24], &date, 2);
+    memcpy(&out[26], &lo, 2);
+    memcpy(&out[28], &size, 4);
+}
+
+static void WriteLongEntries(u8* out, const std::u16string& name, u8 checksum)
+{
+    // the entries are stored last part first
+    u32 num = NumLongNameSlots(name);
+    for (u32 i = 0; i < num; i++)
+    {
+        u32 part = num - 1 - i;
+        u8* entry = &out[i * 32];
+        memset(entry, 0, 32);
+
+        entry[0] = (part + 1) | ((i == 0) ? 0x40 : 0);
+        entry[11] = 0x0F;
+        entry[13] = checksum;
+
+        for (int j = 0; j < 13; j++)
+        {
+            size_t pos = part*13 + j;
+            u16 c;
+            if (pos < name.length()) c = name[pos];
+            else if (pos == name.length()) c = 0x0000;
+            else c = 0xFFFF;
+
+            memcpy(&entry[LongNameCharPos[j]], &c, 2);
+        }
+    }
+}
+
+static void ReadAt(FileHandle* file, u64 offset, u8* out, u32 len)
+{
+    u64 res = 0;
+    if (FileSeek(file, offset, FileSeekOrigin::Start))
+        res = FileRead(out, 1, len, file);
+
+    // past the end of the file
+    if (res < len)
+        memset(&out[res], 0, len - res);
+}
+
+static void WriteAt(FileHandle* file, u64 offset, const u8* in, u32 len)
+{
+    if (FileSeek(file, offset, FileSeekOrigin::Start))
+        FileWrite(in, 1, len, file);
+}
+
+
+VirtualFAT::VirtualFAT(const string& sourcedir, const string& scratchpath, u64 size, bool readonly) :
+    SourceDir(sourcedir),
+    ScratchPath(scratchpath),
+    ReadOnly(readonly)
+{
+    if (!Build(size))
+    {
+        if (Scratch) CloseFile(Scratch);
+        Scratch = nullptr;
+    }
+}
+
+VirtualFAT::~VirtualFAT()
+{
+    CloseHostFiles();
+
+    if (Scratch)
+    {
+        CloseFile(Scratch);
+
+        std::error_code err;
+        fs::remove(fs::u8path(GetLocalFilePath(ScratchPath)), err);
+    }
+}
+
+
+void VirtualFAT::ScanDirectory(u32 dir, int level)
+{
+    std::error_code err;
+    fs::directory_iterator it(fs::u8path(SourceDir + "/" + Dirs[dir].Path), err);
+    if (err) return;
+
+    std::unordered_set<string> shortnames;
+    std::unordered_map<string, u32> nextalias;
+    std::unordered_set<string> names;
+    std::vector<u32> subdirs;
+
+    // the root has no dot entries
+    u32 slots = (dir == 0) ? 0 : 2;
+
+    for (; it != fs::directory_iterator(); it.increment(err))
+    {
+        if (err) break;
+
+        string name = it->path().filename().u8string();
+        string fullpath = Dirs[dir].Path.empty() ? name : (Dirs[dir].Path + "/" + name);
+
+        Entry entry;
+        if (!DecodeUTF8(name, entry.LongName) || !IsValidLongName(entry.LongName))
+        {
+            Log(LogLevel::Warn, "VirtualFAT: skipping %s, name not valid on FAT\n", fullpath.c_str());
+            continue;
+        }
+
+        // FAT names aren't case sensitive
+        string foldedname = name;
+        for (char& c : foldedname)
+        {
+            if (c >= 'a' && c <= 'z') c -= 0x20;
+        }
+        if (!names.insert(foldedname).second)
+        {
+            Log(LogLevel::Warn, "VirtualFAT: skipping %s, name only differs in case from another file\n", fullpath.c_str());
+            continue;
+        }
+
+        bool isdir = it->is_directory(err);
+        bool isfile = !isdir && it->is_regular_file(err);
+        if (!isdir && !isfile) continue;
+        if (isdir && (level + 1) >= MaxDepth) continue;
+
+        u64 filesize = isfile ? it->file_size(err) : 0;
+        if (err) continue;
+        if (filesize > 0xFFFFFFFFULL)
+        {
+            Log(LogLevel::Warn, "VirtualFAT: skipping %s, too large for FAT32\n", fullpath.c_str());
+            continue;
+        }
+
+        bool needlongname = MakeShortName(name, shortnames, nextalias, entry.ShortName);
+        if (!needlongname) entry.LongName.clear();
+
+        u32 entryslots = 1 + NumLongNameSlots(entry.LongName);
+        if ((slots + entryslots) > MaxDirSlots)
+        {
+            Log(LogLevel::Warn, "VirtualFAT: skipping %s, too many files in the directory\n", fullpath.c_str());
+            continue;
+        }
+        slots += entryslots;
+
+        entry.Attr = isdir ? 0x10 : 0x20;
+        auto perms = it->status(err).permissions();
+        if (!err && (perms & fs::perms::owner_write) == fs::perms::none)
+            entry.Attr |= 0x01;
+
+        auto modtime = it->last_write_time(err);
+        GetFATTimestamp(err ? fs::file_time_type::clock::now() : modtime, entry.Time, entry.Date);
+
+        if (isdir)
+        {
+            entry.Index = Dirs.size();
+            subdirs.push_back(entry.Index);
+            Dirs.push_back({fullpath, dir, 0, 0, 0, entry.Time, entry.Date, {}});
+        }
+        else
+        {
+            entry.Index = Files.size();
+            Files.push_back({fullpath, filesize, 0, 0});
+        }
+
+        Dirs[dir].Entries.push_back(std::move(entry));
+    }
+
+    Dirs[dir].NumSlots = slots;
+
+    for (u32 sub : subdirs)
+        ScanDirectory(sub, level + 1);
+}
+
+void VirtualFAT::SetupGeometry(u64 size)
+{
+    // same cluster sizes as Windows picks for FAT32
+    if (size < 0x200000000ULL)       ClusterSize = 0x1000;
+    else if (size < 0x400000000ULL)  ClusterSize = 0x2000;
+    else if (size < 0x800000000ULL)  ClusterSize = 0x4000;
+    else                             ClusterSize = 0x8000;
+
+    TotalSectors = (u32)(size >> 9);
+    SectorsPerCluster = ClusterSize >> 9;
+
+    // a slight overestimate, as it counts the FAT's own sectors as clusters
+    u32 maxclusters = (TotalSectors - ReservedSectors) / SectorsPerCluster;
+    FATSectors = ((maxclusters + 2) * 4 + 0x1FF) >> 9;
+
+    DataStart = ReservedSectors + FATSectors;
+    NumClusters = std::min((TotalSectors - DataStart) / SectorsPerCluster, 0x0FFFFFF5u);
+}
+
+u64 VirtualFAT::CountClusters() const
+{
+    u64 ret = 0;
+
+    for (const DirNode& dir : Dirs)
+        ret += std::max(1u, (dir.NumSlots * 32 + ClusterSize - 1) / ClusterSize);
+
+    for (const HostFile& file : Files)
+        ret += (file.Size + ClusterSize - 1) / ClusterSize;
+
+    return ret;
+}
+
+bool VirtualFAT::Build(u64 size)
+{
+    Dirs.clear();
+    Files.clear();
+
+    Dirs.push_back({"", 0, 0, 0, 0, 0, (1 << 5) | 1, {}});
+    ScanDirectory(0, 0);
+
+    if (size == 0)
+    {
+        // like FATStorage, leave 128MB for the software to use, and round up to a power of two
+        // the free space doesn't cost anything until it's written to
+        size = 0x8000000ULL;
+        for (const HostFile& file : Files)
+            size += (file.Size + 0xFFF) & ~0xFFFULL;
+        size += Dirs.size() * 0x1000;
+
+        size--;
+        size |= (size >> 1);
+        size |= (size >> 2);
+        size |= (size >> 4);
+        size |= (size >> 8);
+        size |= (size >> 16);
+        size |= (size >> 32);
+        size++;
+    }
+    size = std::clamp(size, MinVolumeSize, MaxVolumeSize);
+
+    for (;;)
+    {
+        SetupGeometry(size);
+        if (CountClusters() <= NumClusters)
+            break;
+
+        if (size >= MaxVolumeSize)
+        {
+            Log(LogLevel::Error, "VirtualFAT: %s doesn't fit in a FAT32 volume\n", SourceDir.c_str());
+            return false;
+        }
+        size = std::min(size * 2, MaxVolumeSize);
+    }
+
+    Scratch = OpenLocalFile(ScratchPath, FileMode::ReadWrite);
+    if (!Scratch)
+    {
+        Log(LogLevel::Error, "VirtualFAT: can't create scratch file %s\n", ScratchPath.c_str());
+        return false;
+    }
+
+    FAT.assign(NumClusters + 2, 0);
+    ClusterMap.assign(NumClusters + 2, 0);
+    FAT[0] = 0x0FFFFFF8;
+    FAT[1] = FATEndOfChain;
+
+    // directories first, the root has to be at cluster 2
+    // their clusters are laid out in order in the scratch file, so scratch slots and clusters match
+    u32 next = 2;
+    for (DirNode& dir : Dirs)
+    {
+        dir.FirstCluster = next;
+        dir.NumClusters = std::max(1u, (dir.NumSlots * 32 + ClusterSize - 1) / ClusterSize);
+        next += dir.NumClusters;
+    }
+
+    for (HostFile& file : Files)
+    {
+        file.NumClusters = (file.Size + ClusterSize - 1) / ClusterSize;
+        file.FirstCluster = file.NumClusters ? next : 0;
+        next += file.NumClusters;
+    }
+
+    std::vector<u8> dirdata;
+    for (DirNode& dir : Dirs)
+    {
+        dirdata.assign(dir.NumClusters * ClusterSize, 0);
+        WriteDirectory(dir, dirdata.data());
+        WriteAt(Scratch, (u64)NumScratchSlots * ClusterSize, dirdata.data(), dirdata.size());
+
+        for (u32 i = 0; i < dir.NumClusters; i++)
+        {
+            u32 c = dir.FirstCluster + i;
+            FAT[c] = (i == dir.NumClusters-1) ? FATEndOfChain : (c + 1);
+            ClusterMap[c] = ScratchCluster | NumScratchSlots++;
+        }
+
+        dir.Entries.clear();
+        dir.Entries.shrink_to_fit();
+    }
+
+    for (u32 f = 0; f < Files.size(); f++)
+    {
+        const HostFile& file = Files[f];
+        for (u32 i = 0; i < file.NumClusters; i++)
+        {
+            u32 c = file.FirstCluster + i;
+            FAT[c] = (i == file.NumClusters-1) ? FATEndOfChain : (c + 1);
+            ClusterMap[c] = f + 1;
+        }
+    }
+
+    WriteReservedSectors();
+
+    Log(LogLevel::Info, "VirtualFAT: %s, %u directories, %u files, %u MB volume\n",
+        SourceDir.c_str(), (u32)Dirs.size(), (u32)Files.size(), TotalSectors >> 11);
+    return true;
+}
+
+void VirtualFAT::WriteDirectory(const DirNode& dir, u8* out) const
+{
+    u32 pos = 0;
+
+    if (&dir != &Dirs[0])
+    {
+        // the parent cluster is 0 for the root
+        u32 parentcluster = (dir.Parent == 0) ? 0 : Dirs[dir.Parent].FirstCluster;
+
+        WriteShortEntry(&out[pos], (const u8*)".          ", 0x10, dir.FirstCluster, 0, dir.Time, dir.Date);
+        pos += 32;
+        WriteShortEntry(&out[pos], (const u8*)"..         ", 0x10, parentcluster, 0, dir.Time, dir.Date);
+        pos += 32;
+    }
+
+    for (const Entry& entry : dir.Entries)
+    {
+        if (!entry.LongName.empty())
+        {
+            WriteLongEntries(&out[pos], entry.LongName, ShortNameChecksum(entry.ShortName));
+            pos += NumLongNameSlots(entry.LongName) * 32;
+        }
+
+        u32 cluster, size;
+        if (entry.Attr & 0x10)
+        {
+            cluster = Dirs[entry.Index].FirstCluster;
+            size = 0;
+        }
+        else
+        {
+            cluster = Files[entry.Index].FirstCluster;
+            size = (u32)Files[entry.Index].Size;
+        }
+
+        WriteShortEntry(&out[pos], entry.ShortName, entry.Attr, cluster, size, entry.Time, entry.Date);
+        pos += 32;
+    }
+}
+
+void VirtualFAT::WriteReservedSectors()
+{
+    Reserved.assign(ReservedSectors * 0x200, 0);
+
+    u8* boot = &Reserved[0];
+    auto write16 = [](u8* dst, u16 val) { memcpy(dst, &val, 2); };
+    auto write32 = [](u8* dst, u32 val) { memcpy(dst, &val, 4); };
+
+    boot[0] = 0xEB; boot[1] = 0x58; boot[2] = 0x90;
+    memcpy(&boot[3], "MELONDS ", 8);
+    write16(&boot[11], 0x200);
+    boot[13] = SectorsPerCluster;
+    write16(&boot[14], ReservedSectors);
+    boot[16] = 1; // number of FATs
+    boot[21] = 0xF8; // fixed disk
+    write16(&boot[24], 63); // sectors per track
+    write16(&boot[26], 255); // heads
+    write32(&boot[32], TotalSectors);
+    write32(&boot[36], FATSectors);
+    write32(&boot[44], 2); // root directory cluster
+    write16(&boot[48], 1); // FS info sector
+    write16(&boot[50], 6); // backup boot sector
+    boot[64] = 0x80;
+    boot[66] = 0x29;
+    write32(&boot[67], TotalSectors ^ 0x6D656C6E);
+    memcpy(&boot[71], "NO NAME    ", 11);
+    memcpy(&boot[82], "FAT32   ", 8);
+    boot[510] = 0x55; boot[511] = 0xAA;
+
+    u32 used = 0, firstfree = 0;
+    for (u32 c = 2; c < NumClusters + 2; c++)
+    {
+        if (FAT[c]) used++;
+        else if (!firstfree) firstfree = c;
+    }
+
+    u8* fsinfo = &Reserved[0x200];
+    write32(&fsinfo[0], 0x41615252);
+    write32(&fsinfo[484], 0x61417272);
+    write32(&fsinfo[488], NumClusters - used);
+    write32(&fsinfo[492], firstfree ? firstfree : 0xFFFFFFFF);
+    write32(&fsinfo[508], 0xAA550000);
+
+    memcpy(&Reserved[6 * 0x200], &Reserved[0], 0x400);
+}
+
+
+void VirtualFAT::ReadFATSector(u32 sector, u8* out) const
+{
+    u32 base = sector * 128;
+    for (u32 i = 0; i < 128; i++)
+    {
+        u32 val = ((base + i) < FAT.size()) ? FAT[base + i] : 0;
+        memcpy(&out[i * 4], &val, 4);
+    }
+}
+
+void VirtualFAT::WriteFATSector(u32 sector, const u8* in)
+{
+    u32 base = sector * 128;
+    for (u32 i = 0; i < 128 && (base + i) < FAT.size(); i++)
+    {
+        u32 val;
+        memcpy(&val, &in[i * 4], 4);
+
+        u32 c = base + i;
+        if ((FAT[c] & 0x0FFFFFFF) && !(val & 0x0FFFFFFF) && c >= 2)
+            ReleaseCluster(c);
+
+        FAT[c] = val;
+    }
+}
+
+void VirtualFAT::ReleaseCluster(u32 cluster)
+{
+    // whatever is written to a freed cluster next doesn't belong to the file it was part of
+    u32 owner = ClusterMap[cluster];
+    if (owner & ScratchCluster)
+        FreeScratchSlots.push_back(owner & ~ScratchCluster);
+
+    ClusterMap[cluster] = 0;
+}
+
+void VirtualFAT::ReadCluster(u32 cluster, u32 first, u32 count, u8* out)
+{
+    u32 len = count * 0x200;
+    u32 offset = first * 0x200;
+
+    u32 owner = (cluster < ClusterMap.size()) ? ClusterMap[cluster] : 0;
+    if (owner == 0)
+    {
+        memset(out, 0, len);
+    }
+    else if (owner & ScratchCluster)
+    {
+        ReadAt(Scratch, (u64)(owner & ~ScratchCluster) * ClusterSize + offset, out, len);
+    }
+    else
+    {
+        const HostFile& file = Files[owner - 1];
+        OpenHostFile* host = GetHostFile(owner - 1);
+        if (host)
+            ReadAt(host->Handle, (u64)(cluster - file.FirstCluster) * ClusterSize + offset, out, len);
+        else
+            memset(out, 0, len);
+    }
+}
+
+void VirtualFAT::WriteCluster(u32 cluster, u32 first, u32 count, const u8* in)
+{
+    if (cluster >= ClusterMap.size()) return;
+
+    u32 len = count * 0x200;
+    u32 offset = first * 0x200;
+
+    u32 owner = ClusterMap[cluster];
+    if (owner == 0)
+    {
+        u32 slot;
+        if (!FreeScratchSlots.empty())
+        {
+            slot = FreeScratchSlots.back();
+            FreeScratchSlots.pop_back();
+        }
+        else
+            slot = NumScratchSlots++;
+
+        owner = ScratchCluster | slot;
+        ClusterMap[cluster] = owner;
+    }
+
+    if (owner & ScratchCluster)
+    {
+        WriteAt(Scratch, (u64)(owner & ~ScratchCluster) * ClusterSize + offset, in, len);
+    }
+    else
+    {
+        const HostFile& file = Files[owner - 1];
+        OpenHostFile* host = GetHostFile(owner - 1);
+        if (host && host->Writable)
+            WriteAt(host->Handle, (u64)(cluster - file.FirstCluster) * ClusterSize + offset, in, len);
+    }
+}
+
+u32 VirtualFAT::ReadSectors(u32 start, u32 num, u8* data)
+{
+    if (start >= TotalSectors) return 0;
+    num = std::min(num, TotalSectors - start);
+
+    for (u32 done = 0; done < num; )
+    {
+        u32 sector = start + done;
+        u8* out = &data[done * 0x200];
+        u32 count = 1;
+
+        if (sector < ReservedSectors)
+        {
+            memcpy(out, &Reserved[sector * 0x200], 0x200);
+        }
+        else if (sector < DataStart)
+        {
+            ReadFATSector(sector - ReservedSectors, out);
+        }
+        else
+        {
+            u32 offset = sector - DataStart;
+            u32 first = offset % SectorsPerCluster;
+            count = std::min(num - done, SectorsPerCluster - first);
+            ReadCluster(2 + offset / SectorsPerCluster, first, count, out);
+        }
+
+        done += count;
+    }
+
+    return num;
+}
+
+u32 VirtualFAT::WriteSectors(u32 start, u32 num, const u8* data)
+{
+    if (ReadOnly) return 0;
+    if (start >= TotalSectors) return 0;
+    num = std::min(num, TotalSectors - start);
+
+    for (u32 done = 0; done < num; )
+    {
+        u32 sector = start + done;
+        const u8* in = &data[done * 0x200];
+        u32 count = 1;
+
+        if (sector < ReservedSectors)
+        {
+            memcpy(&Reserved[sector * 0x200], in, 0x200);
+        }
+        else if (sector < DataStart)
+        {
+            WriteFATSector(sector - ReservedSectors, in);
+        }
+        else
+        {
+            u32 offset = sector - DataStart;
+            u32 first = offset % SectorsPerCluster;
+            count = std::min(num - done, SectorsPerCluster - first);
+            WriteCluster(2 + offset / SectorsPerCluster, first, count, in);
+        }
+
+        done += count;
+    }
+
+    return num;
+}
+
+
+VirtualFAT::OpenHostFile* VirtualFAT::GetHostFile(u32 index)
+{
+    for (OpenHostFile& file : OpenFiles)
+    {
+        if (file.Index == index)
+            return &file;
+    }
+
+    string path = fs::u8path(SourceDir + "/" + Files[index].Path).u8string();
+
+    OpenHostFile file {index, nullptr, false};
+    if (!ReadOnly)
+    {
+        file.Handle = OpenFile(path, FileMode::ReadWriteExisting);
+        file.Writable = file.Handle != nullptr;
+    }
+    if (!file.Handle)
+        file.Handle = OpenFile(path, FileMode::Read);
+    if (!file.Handle)
+        return nullptr;
+
+    // only keep a few files open, replacing them in turn
+    if (OpenFiles.size() < MaxOpenFiles)
+    {
+        OpenFiles.push_back(file);
+        return &OpenFiles.back();
+    }
+
+    OpenHostFile& slot = OpenFiles[NextEvicted];
+    NextEvicted = (NextEvicted + 1) % MaxOpenFiles;
+
+    CloseFile(slot.Handle);
+    slot = file;
+    return &slot;
+}
+
+void VirtualFAT::CloseHostFiles()
+{
+    for (OpenHostFile& file : OpenFiles)
+        CloseFile(file.Handle);
+
+    OpenFiles.clear();
+    NextEvicted = 0;
+}
+
+
+void VirtualFAT::ListDirectory(u32 cluster, const string& path, int level, std::vector<GuestFile>& files, std::vector<string>& dirs)
+{
+    // the directories are parsed directly rather than through fatfs,
+    // as getting a file's first cluster from fatfs means looking the file up again
+    if (level >= MaxDepth) return;
+
+    std::vector<u8> data;
+    for (u32 c = cluster, n = 0; c >= 2 && c < FAT.size() && n < MaxDirSlots * 32 / ClusterSize; c = FAT[c] & 0x0FFFFFFF, n++)
+    {
+        data.resize(data.size() + ClusterSize);
+        ReadCluster(c, 0, SectorsPerCluster, &data[data.size() - ClusterSize]);
+    }
+
+    std::u16string longname;
+    u8 longsum = 0;
+    u32 longnext = 0; // next long name part expected, 0 once the name is complete
+    bool haslongname = false;
+
+    std::vector<std::pair<string, u32>> subdirlist;
+
+    for (size_t pos = 0; pos + 32 <= data.size(); pos += 32)
+    {
+        const u8* entry = &data[pos];
+        if (entry[0] == 0x00) break;
+
+        if (entry[0] == 0xE5)
+        {
+            haslongname = false;
+            longnext = 0;
+            continue;
+        }
+
+        u8 attr = entry[11];
+        if ((attr & 0x3F) == 0x0F)
+        {
+            u32 ord = entry[0] & 0x3F;
+            if (entry[0] & 0x40)
+            {
+                longname.assign(ord * 13, 0);
+                longsum = entry[13];
+                longnext = ord;
+            }
+
+            if (ord == 0 || ord != longnext || entry[13] != longsum)
+            {
+                haslongname = false;
+                longnext = 0;
+                continue;
+            }
+
+            for (int j = 0; j < 13; j++)
+            {
+                u16 c;
+                memcpy(&c, &entry[LongNameCharPos[j]], 2);
+                longname[(ord-1)*13 + j] = c;
+            }
+
+            longnext--;
+            haslongname = (longnext == 0);
+            continue;
+        }
+
+        bool uselongname = haslongname && longsum == ShortNameChecksum(entry);
+        haslongname = false;
+        longnext = 0;
+
+        // volume label and dot entries
+        if ((attr & 0x08) || entry[0] == '.') continue;
+
+        string name;
+        if (uselongname)
+        {
+            size_t len = longname.find(u'\0');
+            name = EncodeUTF8(longname.substr(0, len));
+        }
+        else
+            name = ShortNameToString(entry);
+
+        // don't let a corrupt name point outside the directory
+        if (name.empty() || name == "." || name == ".." || name.find_first_of("/\\") != string::npos)
+            continue;
+
+        u16 hi, lo;
+        u32 size;
+        memcpy(&hi, &entry[20], 2);
+        memcpy(&lo, &entry[26], 2);
+        memcpy(&size, &entry[28], 4);
+        u32 first = (hi << 16) | lo;
+
+        string innerpath = path + name;
+        if (attr & 0x10)
+        {
+            dirs.push_back(innerpath);
+            subdirlist.push_back({innerpath, first});
+        }
+        else
+            files.push_back({innerpath, size, first, (attr & 0x01) != 0});
+    }
+
+    for (auto& [subpath, subcluster] : subdirlist)
+    {
+        ListDirectory(subcluster, subpath+"/", level+1, files, dirs);
+    }
+}
+
+int VirtualFAT::FindHostFile(const GuestFile& file) const
+{
+    // a file is still in place if its cluster chain is the one its host file was given,
+    // and none of those clusters were released since, as everything written to them went to the host file
+    if (file.Size == 0) return -1;
+    if (file.FirstCluster < 2 || file.FirstCluster >= ClusterMap.size()) return -1;
+
+    u32 owner = ClusterMap[file.FirstCluster];
+    if (owner == 0 || (owner & ScratchCluster)) return -1;
+
+    const HostFile& host = Files[owner - 1];
+    if (host.FirstCluster != file.FirstCluster) return -1;
+
+    u32 count = (file.Size + ClusterSize - 1) / ClusterSize;
+    if (count > host.NumClusters) return -1;
+
+    u32 c = file.FirstCluster;
+    for (u32 i = 0; i < count; i++)
+    {
+        if (c != host.FirstCluster + i || ClusterMap[c] != owner)
+            return -1;
+
+        c = FAT[c] & 0x0FFFFFFF;
+    }
+
+    if (c < 0x0FFFFFF8) return -1;
+    return owner - 1;
+}
+
+string VirtualFAT::GetTempPath()
+{
+    for (;;)
+    {
+        string path = SourceDir + "/.melonDS-sync-" + std::to_string(NextTempFile++) + ".tmp";
+        if (!fs::exists(fs::u8path(path)))
+            return path;
+    }
+}
+
+bool VirtualFAT::Sync()
+{
+    if (ReadOnly || !Scratch) return true;
+
+    CloseHostFiles();
+
+    ff_disk_open([this](BYTE* buf, LBA_t sector, UINT num) { return ReadSectors(sector, num, buf); },
+                 [this](const BYTE* buf, LBA_t sector, UINT num) { return WriteSectors(sector, num, buf); },
+                 (LBA_t)TotalSectors);
+
+    FATFS fs;
+    FRESULT res = f_mount(&fs, "0:", 1);
+    if (res != FR_OK)
+    {
+        Log(LogLevel::Error, "VirtualFAT: volume is corrupt, not syncing it to %s\n", SourceDir.c_str());
+        f_unmount("0:");
+        ff_disk_close();
+        return false;
+    }
+
+    std::vector<GuestFile> guestfiles;
+    std::vector<string> guestdirs;
+    u32 rootcluster;
+    memcpy(&rootcluster, &Reserved[44], 4);
+    ListDirectory(rootcluster, "", 0, guestfiles, guestdirs);
+
+    std::vector<int> hostindex(guestfiles.size(), -1);
+    std::vector<bool> claimed(Files.size(), false);
+    for (u32 i = 0; i < guestfiles.size(); i++)
+    {
+        int h = FindHostFile(guestfiles[i]);
+        if (h >= 0 && !claimed[h])
+        {
+            claimed[h] = true;
+            hostindex[i] = h;
+        }
+    }
+
+    auto hostpath = [this](const string& path) { return fs::u8path(SourceDir + "/" + path); };
+    auto makewritable = [](const fs::path& path)
+    {
+        std::error_code err;
+        fs::permissions(path, fs::perms::owner_read | fs::perms::owner_write, fs::perm_options::add, err);
+    };
+
+    // files are first put aside under a temporary name, then moved to their place,
+    // so that files can swap names, or replace files that get deleted
+    struct Move
+    {
+        fs::path From, To;
+        u32 GuestFile;
+    };
+    std::vector<Move> moves;
+
+    // copy out the files whose data isn't where their host file is, before any host file is touched,
+    // as their clusters may still be read from the host files
+    std::vector<u8> buf(0x10000);
+    bool copyfailed = false;
+    for (u32 i = 0; i < guestfiles.size() && !copyfailed; i++)
+    {
+        if (hostindex[i] >= 0) continue;
+
+        const GuestFile& file = guestfiles[i];
+        string temppath = GetTempPath();
+
+        FF_FIL fin;
+        string inpath = "0:/" + file.Path;
+        if (f_open(&fin, inpath.c_str(), FA_OPEN_EXISTING | FA_READ) != FR_OK)
+        {
+            Log(LogLevel::Error, "VirtualFAT: can't read %s from the volume\n", file.Path.c_str());
+            copyfailed = true;
+            break;
+        }
+
+        FileHandle* fout = OpenFile(temppath, FileMode::Write);
+        if (!fout)
+        {
+            f_close(&fin);
+            Log(LogLevel::Error, "VirtualFAT: can't write %s\n", temppath.c_str());
+            copyfailed = true;
+            break;
+        }
+
+        for (;;)
+        {
+            UINT nread = 0;
+            if (f_read(&fin, buf.data(), buf.size(), &nread) != FR_OK)
+            {
+                Log(LogLevel::Error, "VirtualFAT: can't read %s from the volume\n", file.Path.c_str());
+                copyfailed = true;
+                break;
+            }
+            if (nread == 0)
+                break;
+
+            if (FileWrite(buf.data(), nread, 1, fout) != 1)
+            {
+                Log(LogLevel::Error, "VirtualFAT: can't write %s\n", temppath.c_str());
+                copyfailed = true;
+                break;
+            }
+        }
+
+        CloseFile(fout);
+        f_close(&fin);
+
+        moves.push_back({fs::u8path(temppath), hostpath(file.Path), i});
+    }
+
+    f_unmount("0:");
+    ff_disk_close();
+
+    std::error_code err;
+
+    // the host copies of those files would be deleted or replaced with nothing to take their place
+    if (copyfailed)
+    {
+        for (const Move& move : moves)
+            fs::remove(move.From, err);
+
+        Log(LogLevel::Error, "VirtualFAT: not syncing to %s, the host files are left as they were\n", SourceDir.c_str());
+        return false;
+    }
+
+    // host files that couldn't be moved stay where they are, nothing may overwrite them
+    std::vector<fs::path> stuck;
+    std::vector<bool> synced(guestfiles.size(), true);
+
+    for (u32 i = 0; i < guestfiles.size(); i++)
+    {
+        int h = hostindex[i];
+        if (h < 0 || Files[h].Path == guestfiles[i].Path) continue;
+
+        fs::path temppath = fs::u8path(GetTempPath());
+        fs::rename(hostpath(Files[h].Path), temppath, err);
+        if (err)
+        {
+            Log(LogLevel::Error, "VirtualFAT: can't move %s\n", Files[h].Path.c_str());
+            stuck.push_back(hostpath(Files[h].Path));
+            synced[i] = false;
+            continue;
+        }
+
+        moves.push_back({temppath, hostpath(guestfiles[i].Path), i});
+    }
+
+    // delete the files the software deleted, files that were skipped when building the volume stay
+    for (u32 h = 0; h < Files.size(); h++)
+    {
+        if (claimed[h]) continue;
+
+        fs::path path = hostpath(Files[h].Path);
+        makewritable(path);
+        fs::remove(path, err);
+    }
+
+    for (const string& dir : guestdirs)
+        fs::create_directories(hostpath(dir), err);
+
+    for (const Move& move : moves)
+    {
+        // the temporary file may be the only copy left of the data, so it's kept if it can't be moved
+        bool blocked = std::find(stuck.begin(), stuck.end(), move.To) != stuck.end();
+        if (!blocked)
+        {
+            if (fs::exists(move.To, err))
+                makewritable(move.To);
+
+            fs::rename(move.From, move.To, err);
+        }
+
+        if (blocked || err)
+        {
+            Log(LogLevel::Error, "VirtualFAT: can't write %s, its contents are in %s\n",
+                move.To.u8string().c_str(), move.From.u8string().c_str());
+            synced[move.GuestFile] = false;
+        }
+    }
+
+    for (u32 i = 0; i < guestfiles.size(); i++)
+    {
+        if (!synced[i]) continue;
+
+        const GuestFile& file = guestfiles[i];
+        fs::path path = hostpath(file.Path);
+
+        // writes past the end of a file went straight to it, and shrunk files keep their old data
+        if (hostindex[i] >= 0 && fs::file_size(path, err) != file.Size)
+            fs::resize_file(path, file.Size, err);
+
+        fs::permissions(path,
+                        fs::perms::owner_read | fs::perms::owner_write,
+                        file.ReadOnly ? fs::perm_options::remove : fs::perm_options::add,
+                        err);
+    }
+
+    // only empty directories are removed, again not to lose skipped files
+    std::unordered_set<string> keptdirs(guestdirs.begin(), guestdirs.end());
+    for (auto it = Dirs.rbegin(); it != Dirs.rend(); it++)
+    {
+        if (it->Path.empty() || keptdirs.count(it->Path)) continue;
+
+        fs::path path = hostpath(it->Path);
+        makewritable(path);
+        fs::remove(path, err);
+    }
+
+    return std::find(synced.begin(), synced.end(), false) == synced.end();
+}
+
+}
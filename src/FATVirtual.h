@@ -0,0 +1,160 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef FATVIRTUAL_H
+#define FATVIRTUAL_H
+
+#include <string>
+#include <vector>
+
+#include "Platform.h"
+#include "types.h"
+
+namespace melonDS
+{
+/// A FAT32 volume synthesized from a host directory, so a folder can be used as an SD card
+/// without first copying it into an image.
+///
+/// Opening the volume only scans the host tree: the boot sector, the FAT and the directories
+/// are built in memory, and every host file gets a contiguous run of clusters whose sectors
+/// are read from the file when accessed. Writes to those clusters go straight to the host file.
+/// Clusters the emulated software allocates itself, as well as the directories,
+/// are stored in a scratch file next to the SD card image.
+///
+/// Sync() applies the changes the software made to the volume's structure to the host tree
+/// (new, deleted, moved and resized files and directories). Only files whose data doesn't
+/// sit in their original clusters anymore have to be copied out of the volume.
+class VirtualFAT
+{
+public:
+    /// @param sourcedir Host directory to expose.
+    /// @param scratchpath Local path of the scratch file, removed when the volume is destroyed.
+    /// @param size Desired volume size in bytes, or 0 to size it from the directory.
+    /// The volume is grown if the directory doesn't fit.
+    VirtualFAT(const std::string& sourcedir, const std::string& scratchpath, u64 size, bool readonly);
+    ~VirtualFAT();
+    VirtualFAT(const VirtualFAT&) = delete;
+    VirtualFAT& operator=(const VirtualFAT&) = delete;
+
+    /// Whether the volume could be built, if not it can't be used.
+    [[nodiscard]] bool IsValid() const noexcept { return Scratch != nullptr; }
+    [[nodiscard]] u64 GetSectorCount() const noexcept { return TotalSectors; }
+
+    u32 ReadSectors(u32 start, u32 num, u8* data);
+    u32 WriteSectors(u32 start, u32 num, const u8* data);
+
+    /// Reflects the volume's contents to the host directory.
+    /// The host tree no longer matches the volume afterwards, so this must only be called
+    /// once the volume isn't used anymore.
+    /// @return false if some files couldn't be synced; their host files are then left alone.
+    bool Sync();
+
+private:
+    struct Entry
+    {
+        std::u16string LongName; // empty if the short name is the actual name
+        u8 ShortName[11];
+        u8 Attr;
+        u16 Time, Date;
+        u32 Index; // in Dirs or Files, depending on Attr
+    };
+
+    struct DirNode
+    {
+        std::string Path; // relative to the source directory, empty for the root
+        u32 Parent;
+        u32 FirstCluster, NumClusters;
+        u32 NumSlots; // 32-byte directory entries
+        u16 Time, Date;
+        std::vector<Entry> Entries; // only kept while building the volume
+    };
+
+    struct HostFile
+    {
+        std::string Path;
+        u64 Size;
+        u32 FirstCluster, NumClusters;
+    };
+
+    struct OpenHostFile
+    {
+        u32 Index;
+        Platform::FileHandle* Handle;
+        bool Writable;
+    };
+
+    struct GuestFile
+    {
+        std::string Path;
+        u64 Size;
+        u32 FirstCluster;
+        bool ReadOnly;
+    };
+
+    bool Build(u64 size);
+    void ScanDirectory(u32 dir, int level);
+    void SetupGeometry(u64 size);
+    u64 CountClusters() const;
+    void WriteDirectory(const DirNode& dir, u8* out) const;
+    void WriteReservedSectors();
+
+    void ReadFATSector(u32 sector, u8* out) const;
+    void WriteFATSector(u32 sector, const u8* in);
+    void ReadCluster(u32 cluster, u32 first, u32 count, u8* out);
+    void WriteCluster(u32 cluster, u32 first, u32 count, const u8* in);
+    void ReleaseCluster(u32 cluster);
+
+    OpenHostFile* GetHostFile(u32 index);
+    void CloseHostFiles();
+
+    void ListDirectory(u32 cluster, const std::string& path, int level, std::vector<GuestFile>& files, std::vector<std::string>& dirs);
+    int FindHostFile(const GuestFile& file) const;
+    std::string GetTempPath();
+
+    std::string SourceDir;
+    std::string ScratchPath;
+    bool ReadOnly;
+
+    u32 TotalSectors = 0;
+    u32 FATSectors = 0;
+    u32 DataStart = 0;
+    u32 SectorsPerCluster = 0;
+    u32 ClusterSize = 0;
+    u32 NumClusters = 0;
+
+    std::vector<u8> Reserved; // boot sector, FS info and their backups
+    std::vector<u32> FAT;
+
+    // what backs each cluster: 0 if nothing (reads as zero), a scratch file slot if
+    // ScratchCluster is set, otherwise the index of a host file plus one
+    std::vector<u32> ClusterMap;
+
+    std::vector<DirNode> Dirs;
+    std::vector<HostFile> Files;
+
+    Platform::FileHandle* Scratch = nullptr;
+    u32 NumScratchSlots = 0;
+    std::vector<u32> FreeScratchSlots;
+
+    std::vector<OpenHostFile> OpenFiles;
+    u32 NextEvicted = 0;
+    u32 NextTempFile = 0;
+};
+
+}
+#endif // FATVIRTUAL_H
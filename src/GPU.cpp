@@ -17,6 +17,8 @@
 */
 
 #include <string.h>
+#include <algorithm>
+#include <thread>
 #include "NDS.h"
 #include "GPU.h"
 
@@ -85,6 +87,8 @@ GPU::~GPU() noexcept
 {
     // All unique_ptr fields are automatically cleaned up
 
+    StopRender2DThread();
+
     NDS.UnregisterEventFuncs(Event_LCD);
     NDS.UnregisterEventFuncs(Event_DisplayFIFO);
 }
@@ -105,10 +109,7 @@ void GPU::ResetVRAMCache() noexcept
     VRAMDirty_Texture.Reset();
     VRAMDirty_TexPal.Reset();
 
-    memset(VRAMFlat_ABG, 0, sizeof(VRAMFlat_ABG));
-    memset(VRAMFlat_BBG, 0, sizeof(VRAMFlat_BBG));
-    memset(VRAMFlat_AOBJ, 0, sizeof(VRAMFlat_AOBJ));
-    memset(VRAMFlat_BOBJ, 0, sizeof(VRAMFlat_BOBJ));
+    VRAMMem.Reset();
     memset(VRAMFlat_ABGExtPal, 0, sizeof(VRAMFlat_ABGExtPal));
     memset(VRAMFlat_BBGExtPal, 0, sizeof(VRAMFlat_BBGExtPal));
     memset(VRAMFlat_AOBJExtPal, 0, sizeof(VRAMFlat_AOBJExtPal));
@@ -119,10 +120,14 @@ void GPU::ResetVRAMCache() noexcept
 
 void GPU::Reset() noexcept
 {
+    SyncRender2D();
+
     VCount = 0;
     NextVCount = -1;
     TotalScanlines = 0;
 
+    ResetFrameSkip();
+
     DispStat[0] = 0;
     DispStat[1] = 0;
     VMatch[0] = 0;
@@ -173,15 +178,13 @@ void GPU::Reset() noexcept
     else
         fbsize = 256 * 192;
 
-    for (size_t i = 0; i < fbsize; i++)
-    {
-        Framebuffer[0][0][i] = 0xFFFFFFFF;
-        Framebuffer[1][0][i] = 0xFFFFFFFF;
-    }
-    for (size_t i = 0; i < fbsize; i++)
+    for (int buf = 0; buf < FramebufferSlots; buf++)
     {
-        Framebuffer[0][1][i] = 0xFFFFFFFF;
-        Framebuffer[1][1][i] = 0xFFFFFFFF;
+        for (size_t i = 0; i < fbsize; i++)
+        {
+            Framebuffer[buf][0][i] = 0xFFFFFFFF;
+            Framebuffer[buf][1][i] = 0xFFFFFFFF;
+        }
     }
 
     GPU2D_A.Reset();
@@ -198,18 +201,31 @@ void GPU::Reset() noexcept
     PaletteDirty = 0xF;
 }
 
+void GPU::ResetFrameSkip() noexcept
+{
+    FramesToSkip = 0;
+    SkipNextFrame = false;
+    FrameSkipped = false;
+    SkipUnits = 0;
+    SkipSprites = 0;
+    CapturedFrame = false;
+}
+
 void GPU::Stop() noexcept
 {
+    SyncRender2D();
+
     int fbsize;
     if (GPU3D.IsRendererAccelerated())
         fbsize = (256*3 + 1) * 192;
     else
         fbsize = 256 * 192;
 
-    memset(Framebuffer[0][0].get(), 0, fbsize*4);
-    memset(Framebuffer[0][1].get(), 0, fbsize*4);
-    memset(Framebuffer[1][0].get(), 0, fbsize*4);
-    memset(Framebuffer[1][1].get(), 0, fbsize*4);
+    for (int buf = 0; buf < FramebufferSlots; buf++)
+    {
+        memset(Framebuffer[buf][0].get(), 0, fbsize*4);
+        memset(Framebuffer[buf][1].get(), 0, fbsize*4);
+    }
 
     EnsureHiResSpriteBuffers(0, 0);
 
@@ -218,12 +234,18 @@ void GPU::Stop() noexcept
 
 void GPU::DoSavestate(Savestate* file) noexcept
 {
+    SyncRender2D();
+
     file->Section("GPUG");
 
     file->Var16(&VCount);
     file->Var32(&NextVCount);
     file->Var16(&TotalScanlines);
 
+    // frame skipping isn't part of the hardware state, start over with a rendered frame
+    if (!file->Saving)
+        ResetFrameSkip();
+
     file->Var16(&DispStat[0]);
     file->Var16(&DispStat[1]);
     file->Var16(&VMatch[0]);
@@ -285,7 +307,9 @@ void GPU::DoSavestate(Savestate* file) noexcept
 
 void GPU::AssignFramebuffers() noexcept
 {
-    int backbuf = FrontBuffer ? 0 : 1;
+    SyncRender2D();
+
+    int backbuf = BackBuffer;
     auto makeOverlaySurface = [&](int screen) -> GPU2D::SpriteOverlaySurface
     {
         GPU2D::SpriteOverlaySurface surface;
@@ -299,6 +323,7 @@ void GPU::AssignFramebuffers() noexcept
                 surface.Height = SpriteOverlayScreenHeight;
                 surface.ScaleX = SpriteOverlayScaleX;
                 surface.ScaleY = SpriteOverlayScaleY;
+                surface.Spans = SpriteOverlaySpans[backbuf][screen];
             }
         }
         return surface;
@@ -337,6 +362,7 @@ void GPU::EnsureHiResSpriteBuffers(u32 scaleX, u32 scaleY) noexcept
             for (auto& screen : perBuf)
                 screen.reset();
         }
+        ResetSpriteOverlayRects();
 
         SpriteOverlayStride = 0;
         SpriteOverlayScreenHeight = 0;
@@ -366,7 +392,7 @@ void GPU::EnsureHiResSpriteBuffers(u32 scaleX, u32 scaleY) noexcept
     bool needAllocate = overlayChanged;
     if (!needAllocate)
     {
-        for (int buf = 0; buf < 2 && !needAllocate; ++buf)
+        for (int buf = 0; buf < FramebufferSlots && !needAllocate; ++buf)
         {
             for (int screen = 0; screen < 2; ++screen)
             {
@@ -381,7 +407,7 @@ void GPU::EnsureHiResSpriteBuffers(u32 scaleX, u32 scaleY) noexcept
 
     if (needAllocate)
     {
-        for (int buf = 0; buf < 2; ++buf)
+        for (int buf = 0; buf < FramebufferSlots; ++buf)
         {
             for (int screen = 0; screen < 2; ++screen)
             {
@@ -389,6 +415,7 @@ void GPU::EnsureHiResSpriteBuffers(u32 scaleX, u32 scaleY) noexcept
                 memset(SpriteOverlay[buf][screen].get(), 0, bytesPerScreen);
             }
         }
+        ResetSpriteOverlayRects();
     }
 
     SpriteOverlayStride = newStride;
@@ -408,11 +435,12 @@ void GPU::EnsureHiResSpriteBuffers(u32 scaleX, u32 scaleY) noexcept
                 surface.Height = SpriteOverlayScreenHeight;
                 surface.ScaleX = SpriteOverlayScaleX;
                 surface.ScaleY = SpriteOverlayScaleY;
+                surface.Spans = SpriteOverlaySpans[bufIndex][screen];
             }
             return surface;
         };
 
-        int backbuf = FrontBuffer ? 0 : 1;
+        int backbuf = BackBuffer;
         GPU2D::SpriteOverlaySurface overlayA;
         GPU2D::SpriteOverlaySurface overlayB;
 
@@ -445,11 +473,69 @@ void GPU::ClearHiResSpriteBuffers() noexcept
                 memset(screen.get(), 0, bytesPerScreen);
         }
     }
+    ResetSpriteOverlayRects();
+}
+
+void GPU::ResetSpriteOverlayRects() noexcept
+{
+    for (int buf = 0; buf < FramebufferSlots; buf++)
+    {
+        for (int screen = 0; screen < 2; screen++)
+        {
+            for (GPU2D::SpriteOverlaySpan& span : SpriteOverlaySpans[buf][screen])
+                span = {};
+            SpriteOverlayRects[buf][screen].clear();
+        }
+    }
+}
+
+void GPU::UpdateSpriteOverlayRects() noexcept
+{
+    if (!HasSpriteOverlay())
+        return;
+
+    int backbuf = BackBuffer;
+    for (int screen = 0; screen < 2; screen++)
+    {
+        const GPU2D::SpriteOverlaySpan* spans = SpriteOverlaySpans[backbuf][screen];
+        std::vector<GPU2D::SpriteOverlayRect>& rects = SpriteOverlayRects[backbuf][screen];
+        rects.clear();
+
+        // consecutive scanlines whose spans overlap are merged into one rect
+        u32 top = 0, start = 0, end = 0;
+        bool open = false;
+        for (u32 line = 0; line <= 192; line++)
+        {
+            bool empty = (line == 192) || spans[line].Empty();
+            if (open && (empty || spans[line].Start > end || spans[line].End < start))
+            {
+                rects.push_back({start * SpriteOverlayScaleX, top * SpriteOverlayScaleY,
+                                 (end - start) * SpriteOverlayScaleX, (line - top) * SpriteOverlayScaleY});
+                open = false;
+            }
+
+            if (empty)
+                continue;
+
+            if (!open)
+            {
+                top = line;
+                start = spans[line].Start;
+                end = spans[line].End;
+                open = true;
+            }
+            else
+            {
+                start = std::min<u32>(start, spans[line].Start);
+                end = std::max<u32>(end, spans[line].End);
+            }
+        }
+    }
 }
 
 u8* GPU::GetSpriteOverlayBuffer(int buf, int screen) noexcept
 {
-    if (buf < 0 || buf > 1 || screen < 0 || screen > 1)
+    if (buf < 0 || buf >= FramebufferSlots || screen < 0 || screen > 1)
         return nullptr;
     if (!SpriteOverlay[buf][screen])
         return nullptr;
@@ -458,7 +544,7 @@ u8* GPU::GetSpriteOverlayBuffer(int buf, int screen) noexcept
 
 const u8* GPU::GetSpriteOverlayBuffer(int buf, int screen) const noexcept
 {
-    if (buf < 0 || buf > 1 || screen < 0 || screen > 1)
+    if (buf < 0 || buf >= FramebufferSlots || screen < 0 || screen > 1)
         return nullptr;
     if (!SpriteOverlay[buf][screen])
         return nullptr;
@@ -467,6 +553,8 @@ const u8* GPU::GetSpriteOverlayBuffer(int buf, int screen) const noexcept
 
 void GPU::SetRenderer3D(std::unique_ptr<Renderer3D>&& renderer) noexcept
 {
+    SyncRender2D();
+
     if (renderer == nullptr)
         GPU3D.SetCurrentRenderer(std::make_unique<SoftRenderer>());
     else
@@ -483,19 +571,49 @@ void GPU::InitFramebuffers() noexcept
     else
         fbsize = 256 * 192;
 
-    Framebuffer[0][0] = std::make_unique<u32[]>(fbsize);
-    Framebuffer[1][0] = std::make_unique<u32[]>(fbsize);
-    Framebuffer[0][1] = std::make_unique<u32[]>(fbsize);
-    Framebuffer[1][1] = std::make_unique<u32[]>(fbsize);
+    for (int buf = 0; buf < FramebufferSlots; buf++)
+    {
+        Framebuffer[buf][0] = std::make_unique<u32[]>(fbsize);
+        Framebuffer[buf][1] = std::make_unique<u32[]>(fbsize);
 
-    memset(Framebuffer[0][0].get(), 0, fbsize*4);
-    memset(Framebuffer[1][0].get(), 0, fbsize*4);
-    memset(Framebuffer[0][1].get(), 0, fbsize*4);
-    memset(Framebuffer[1][1].get(), 0, fbsize*4);
+        memset(Framebuffer[buf][0].get(), 0, fbsize*4);
+        memset(Framebuffer[buf][1].get(), 0, fbsize*4);
+    }
 
+    // the buffers were reallocated, so the presenter can't be holding on to any of them
+    ResetFramebufferSlots();
     AssignFramebuffers();
 }
 
+void GPU::ResetFramebufferSlots() noexcept
+{
+    BackBuffer = 0;
+    FrontBuffer = 1;
+    PresentState.store(1, std::memory_order_release);
+    PresentBuffer = 2;
+}
+
+void GPU::PublishBackBuffer() noexcept
+{
+    // swap the finished back buffer with the pending one
+    // if the presenter didn't pick up the pending frame yet, it is simply dropped,
+    // so the emulator never has to wait for the presenter
+    FrontBuffer = BackBuffer;
+    u8 prev = PresentState.exchange(BackBuffer | PresentStateNewFrame, std::memory_order_acq_rel);
+    BackBuffer = prev & PresentStateSlotMask;
+}
+
+int GPU::AcquirePresentBuffer() noexcept
+{
+    if (PresentState.load(std::memory_order_acquire) & PresentStateNewFrame)
+    {
+        u8 prev = PresentState.exchange(PresentBuffer, std::memory_order_acq_rel);
+        PresentBuffer = prev & PresentStateSlotMask;
+    }
+
+    return PresentBuffer;
+}
+
 
 // VRAM mapping notes
 //
@@ -551,6 +669,7 @@ const u8* GPU::GetUniqueBankPtr(u32 mask, u32 offset) const noexcept
 
 void GPU::MapVRAM_AB(u32 bank, u8 cnt) noexcept
 {
+    SyncRender2D();
     cnt &= 0x9B;
 
     u8 oldcnt = VRAMCNT[bank];
@@ -611,6 +730,7 @@ void GPU::MapVRAM_AB(u32 bank, u8 cnt) noexcept
 
 void GPU::MapVRAM_CD(u32 bank, u8 cnt) noexcept
 {
+    SyncRender2D();
     cnt &= 0x9F;
 
     u8 oldcnt = VRAMCNT[bank];
@@ -698,6 +818,7 @@ void GPU::MapVRAM_CD(u32 bank, u8 cnt) noexcept
 
 void GPU::MapVRAM_E(u32 bank, u8 cnt) noexcept
 {
+    SyncRender2D();
     cnt &= 0x87;
 
     u8 oldcnt = VRAMCNT[bank];
@@ -762,6 +883,7 @@ void GPU::MapVRAM_E(u32 bank, u8 cnt) noexcept
 
 void GPU::MapVRAM_FG(u32 bank, u8 cnt) noexcept
 {
+    SyncRender2D();
     cnt &= 0x9F;
 
     u8 oldcnt = VRAMCNT[bank];
@@ -862,6 +984,7 @@ void GPU::MapVRAM_FG(u32 bank, u8 cnt) noexcept
 
 void GPU::MapVRAM_H(u32 bank, u8 cnt) noexcept
 {
+    SyncRender2D();
     cnt &= 0x83;
 
     u8 oldcnt = VRAMCNT[bank];
@@ -924,6 +1047,7 @@ void GPU::MapVRAM_H(u32 bank, u8 cnt) noexcept
 
 void GPU::MapVRAM_I(u32 bank, u8 cnt) noexcept
 {
+    SyncRender2D();
     cnt &= 0x83;
 
     u8 oldcnt = VRAMCNT[bank];
@@ -1005,6 +1129,8 @@ void GPU::SetPowerCnt(u32 val) noexcept
 
     if (!(val & (1<<0))) Log(LogLevel::Warn, "!!! CLEARING POWCNT BIT0. DANGER\n");
 
+    SyncRender2D();
+
     GPU2D_A.SetEnabled(val & (1<<1));
     GPU2D_B.SetEnabled(val & (1<<9));
     GPU3D.SetEnabled(val & (1<<3), val & (1<<2));
@@ -1036,6 +1162,147 @@ void GPU::DisplayFIFO(u32 x) noexcept
         GPU2D_A.SampleFIFO(253, 3); // sample the remaining pixels
 }
 
+void GPU::SetThreaded2D(bool threaded) noexcept
+{
+    if (threaded == (Render2DThread != nullptr))
+        return;
+
+    if (threaded)
+    {
+        Sema_Render2DStart = Platform::Semaphore_Create();
+        Render2DThreadRunning = true;
+        Render2DThread = Platform::Thread_Create([this]() { Render2DThreadFunc(); });
+    }
+    else
+        StopRender2DThread();
+}
+
+void GPU::StopRender2DThread() noexcept
+{
+    if (!Render2DThread)
+        return;
+
+    SyncRender2D();
+
+    Render2DThreadRunning = false;
+    Platform::Semaphore_Post(Sema_Render2DStart);
+    Platform::Thread_Wait(Render2DThread);
+    Platform::Thread_Free(Render2DThread);
+    Render2DThread = nullptr;
+
+    Platform::Semaphore_Free(Sema_Render2DStart);
+    Sema_Render2DStart = nullptr;
+}
+
+void GPU::Render2DThreadFunc() noexcept
+{
+    for (;;)
+    {
+        u32 pos = Render2DDone.load(std::memory_order_relaxed);
+        if (pos == Render2DQueued.load(std::memory_order_acquire))
+        {
+            // out of work, sleep until more is queued
+            // the queue is checked again after raising the flag, as the emulation thread
+            // only wakes us up if it sees the flag after queueing something
+            Render2DThreadIdle = true;
+            if (pos == Render2DQueued.load())
+                Platform::Semaphore_Wait(Sema_Render2DStart);
+            Render2DThreadIdle = false;
+
+            if (!Render2DThreadRunning) return;
+            continue;
+        }
+
+        RunRender2DJob(Render2DJobs[pos % Render2DQueueSize]);
+        Render2DDone.store(pos + 1, std::memory_order_release);
+    }
+}
+
+void GPU::WaitForRender2D() const noexcept
+{
+    PROFILE_SCOPE(NDS.Profiler, Section_Render2D);
+
+    // the render thread is rarely more than a few scanlines behind,
+    // so yielding is cheaper than going to sleep on a semaphore
+    while (Render2DDone.load(std::memory_order_acquire) != Render2DQueued.load(std::memory_order_relaxed))
+        std::this_thread::yield();
+}
+
+void GPU::QueueRender2D(u8 type, u32 line, u8 skip) noexcept
+{
+    bool threaded = Render2DThread && !GPU3D.IsRendererAccelerated();
+    u32 pos = Render2DQueued.load(std::memory_order_relaxed);
+    if (threaded && pos - Render2DDone.load(std::memory_order_acquire) >= Render2DQueueSize)
+        WaitForRender2D();
+
+    // the renderer reads the VCount and the registers at the time the job was queued,
+    // so they can be written to without waiting for the render thread.
+    // without the thread the queue is empty, and the slot is free to use
+    Render2DJob& job = Render2DJobs[pos % Render2DQueueSize];
+    job.Type = type;
+    job.Skip = skip;
+    job.Line = line;
+    job.VCount = VCount;
+    job.Regs[0] = GPU2D_A;
+    job.Regs[0].Layer3DXPos = GPU3D.GetRenderXPos();
+    job.Regs[1] = GPU2D_B;
+    GPU2D_A.BGRefReload = 0;
+    GPU2D_B.BGRefReload = 0;
+
+    if (!threaded)
+    {
+        PROFILE_SCOPE(NDS.Profiler, Section_Render2D);
+        RunRender2DJob(job);
+        return;
+    }
+
+    Render2DQueued = pos + 1;
+    if (Render2DThreadIdle)
+        Platform::Semaphore_Post(Sema_Render2DStart);
+}
+
+void GPU::RunRender2DJob(const Render2DJob& job) noexcept
+{
+    GPU2D_A.SetRenderRegisters(job.Regs[0]);
+    GPU2D_B.SetRenderRegisters(job.Regs[1]);
+
+    switch (job.Type)
+    {
+    case Render2DJob_Scanline:
+        if (job.Line < 192)
+        {
+            if (!(job.Skip & 0x1))
+                GPU2D_Renderer->DrawScanline(job.Line, job.VCount, &GPU2D_A);
+            else if (!GPU3D.IsRendererAccelerated())
+                GPU3D.GetLine(job.Line, 0); // keep in step with a threaded 3D renderer
+
+            if (!(job.Skip & 0x2))
+                GPU2D_Renderer->DrawScanline(job.Line, job.VCount, &GPU2D_B);
+        }
+
+        // sprites are pre-rendered one scanline in advance
+        if (job.Line < 191)
+        {
+            if (!(job.Skip & 0x1)) GPU2D_Renderer->DrawSprites(job.Line+1, &GPU2D_A);
+            if (!(job.Skip & 0x2)) GPU2D_Renderer->DrawSprites(job.Line+1, &GPU2D_B);
+        }
+        break;
+
+    case Render2DJob_Sprites:
+        if (!(job.Skip & 0x1)) GPU2D_Renderer->DrawSprites(job.Line, &GPU2D_A);
+        if (!(job.Skip & 0x2)) GPU2D_Renderer->DrawSprites(job.Line, &GPU2D_B);
+        break;
+
+    case Render2DJob_VBlankEnd:
+        if (job.Skip != 0x3)
+            GPU2D_Renderer->VBlankEnd((job.Skip & 0x1) ? nullptr : &GPU2D_A,
+                                      (job.Skip & 0x2) ? nullptr : &GPU2D_B);
+        GPU2D_A.VBlankEnd();
+        GPU2D_B.VBlankEnd();
+        break;
+    }
+}
+
 void GPU::StartFrame() noexcept
 {
     // only run the display FIFO if needed:
@@ -1056,29 +1323,21 @@ void GPU::StartHBlank(u32 line) noexcept
     {
         // draw
         // note: this should start 48 cycles after the scanline start
-        if (line < 192)
-        {
-            GPU2D_Renderer->DrawScanline(line, &GPU2D_A);
-            GPU2D_Renderer->DrawScanline(line, &GPU2D_B);
-        }
-
-        // sprites are pre-rendered one scanline in advance
-        if (line < 191)
-        {
-            GPU2D_Renderer->DrawSprites(line+1, &GPU2D_A);
-            GPU2D_Renderer->DrawSprites(line+1, &GPU2D_B);
-        }
+        QueueRender2D(Render2DJob_Scanline, line, SkipUnits);
 
         NDS.CheckDMAs(0, 0x02);
     }
     else if (VCount == 215)
     {
-        GPU3D.VCount215(*this);
+        // display capture may need the 3D scene even if the frame isn't shown
+        // games capturing this frame are likely to capture the next one too
+        bool capture = (GPU2D_A.CaptureCnt & (1<<31)) || CapturedFrame;
+        GPU3D.VCount215(*this, SkipNextFrame && !capture);
     }
     else if (VCount == 262)
     {
-        GPU2D_Renderer->DrawSprites(0, &GPU2D_A);
-        GPU2D_Renderer->DrawSprites(0, &GPU2D_B);
+        SkipSprites = SkipNextFrame ? GetSkippedUnits() : 0;
+        QueueRender2D(Render2DJob_Sprites, 0, SkipSprites);
     }
 
     if (DispStat[0] & (1<<4)) NDS.SetIRQ(0, IRQ_HBlank);
@@ -1092,8 +1351,13 @@ void GPU::StartHBlank(u32 line) noexcept
 
 void GPU::FinishFrame(u32 lines) noexcept
 {
-    FrontBuffer = FrontBuffer ? 0 : 1;
-    AssignFramebuffers();
+    SyncRender2D();
+
+    if (!FrameSkipped)
+    {
+        PublishBackBuffer();
+        AssignFramebuffers();
+    }
 
     TotalScanlines = lines;
 
@@ -1106,7 +1370,9 @@ void GPU::FinishFrame(u32 lines) noexcept
 
 void GPU::BlankFrame() noexcept
 {
-    int backbuf = FrontBuffer ? 0 : 1;
+    SyncRender2D();
+
+    int backbuf = BackBuffer;
     int fbsize;
     if (GPU3D.IsRendererAccelerated())
         fbsize = (256*3 + 1) * 192;
@@ -1116,7 +1382,7 @@ void GPU::BlankFrame() noexcept
     memset(Framebuffer[backbuf][0].get(), 0, fbsize*4);
     memset(Framebuffer[backbuf][1].get(), 0, fbsize*4);
 
-    FrontBuffer = backbuf;
+    PublishBackBuffer();
     AssignFramebuffers();
 
     TotalScanlines = 263;
@@ -1166,9 +1432,15 @@ void GPU::StartScanline(u32 line) noexcept
     {
         if (line == 0)
         {
-            GPU2D_Renderer->VBlankEnd(&GPU2D_A, &GPU2D_B);
-            GPU2D_A.VBlankEnd();
-            GPU2D_B.VBlankEnd();
+            FrameSkipped = SkipNextFrame;
+            SkipUnits = FrameSkipped ? GetSkippedUnits() : 0;
+
+            // display capture was enabled after the sprites were skipped
+            if (SkipSprites & ~SkipUnits)
+                QueueRender2D(Render2DJob_Sprites, 0, 0x3 & ~(SkipSprites & ~SkipUnits));
+            SkipSprites = 0;
+
+            QueueRender2D(Render2DJob_VBlankEnd, 0, SkipUnits);
         }
 
         if (RunFIFO)
@@ -1192,6 +1464,9 @@ void GPU::StartScanline(u32 line) noexcept
             // texture memory anyway and only update it before the start
             //of the next frame.
             // So we can give the rasteriser a bit more headroom
+            // The 2D renderer has to be done with the frame too,
+            // before the 3D renderer moves on to the next one.
+            SyncRender2D();
             GPU3D.VCount144(*this);
 
             // VBlank
@@ -1206,13 +1481,32 @@ void GPU::StartScanline(u32 line) noexcept
             if (DispStat[0] & (1<<3)) NDS.SetIRQ(0, IRQ_VBlank);
             if (DispStat[1] & (1<<3)) NDS.SetIRQ(1, IRQ_VBlank);
 
+            CapturedFrame = GPU2D_A.CaptureLatch;
             GPU2D_A.VBlank();
             GPU2D_B.VBlank();
             GPU3D.VBlank();
 
-            // Need a better way to identify the openGL renderer in particular
-            if (GPU3D.IsRendererAccelerated())
-                GPU3D.Blit(*this);
+            if (!FrameSkipped)
+            {
+                UpdateSpriteOverlayRects();
+
+                // Need a better way to identify the openGL renderer in particular
+                if (GPU3D.IsRendererAccelerated())
+                    GPU3D.Blit(*this);
+            }
+
+            // decide whether the next frame is rendered
+            FramesToSkip = std::min(FramesToSkip, FrameSkip);
+            if (FramesToSkip > 0)
+            {
+                SkipNextFrame = true;
+                FramesToSkip--;
+            }
+            else
+            {
+                SkipNextFrame = false;
+                FramesToSkip = FrameSkip;
+            }
         }
     }
 
@@ -1231,6 +1525,8 @@ void GPU::SetDispStat(u32 cpu, u16 val) noexcept
 
 void GPU::SetVCount(u16 val) noexcept
 {
+    SyncRender2D();
+
     // VCount write is delayed until the next scanline
 
     // TODO: how does the 3D engine react to VCount writes while it's rendering?
@@ -1325,20 +1621,20 @@ bool GPU::MakeVRAMFlat_TexPalCoherent(NonStupidBitField<128*1024/VRAMDirtyGranul
 
 bool GPU::MakeVRAMFlat_ABGCoherent(NonStupidBitField<512*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_ABG, VRAMMap_ABG, dirty, &GPU::ReadVRAM_ABG<u64>);
+    return AliasLinearVRAM(VRAMMemory::View_ABG, VRAMMap_ABG, dirty, &GPU::ReadVRAM_ABG<u64>);
 }
 bool GPU::MakeVRAMFlat_BBGCoherent(NonStupidBitField<128*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_BBG, VRAMMap_BBG, dirty, &GPU::ReadVRAM_BBG<u64>);
+    return AliasLinearVRAM(VRAMMemory::View_BBG, VRAMMap_BBG, dirty, &GPU::ReadVRAM_BBG<u64>);
 }
 
 bool GPU::MakeVRAMFlat_AOBJCoherent(NonStupidBitField<256*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_AOBJ, VRAMMap_AOBJ, dirty, &GPU::ReadVRAM_AOBJ<u64>);
+    return AliasLinearVRAM(VRAMMemory::View_AOBJ, VRAMMap_AOBJ, dirty, &GPU::ReadVRAM_AOBJ<u64>);
 }
 bool GPU::MakeVRAMFlat_BOBJCoherent(NonStupidBitField<128*1024/VRAMDirtyGranularity>& dirty) noexcept
 {
-    return CopyLinearVRAM<16*1024>(VRAMFlat_BOBJ, VRAMMap_BOBJ, dirty, &GPU::ReadVRAM_BOBJ<u64>);
+    return AliasLinearVRAM(VRAMMemory::View_BOBJ, VRAMMap_BOBJ, dirty, &GPU::ReadVRAM_BOBJ<u64>);
 }
 
 bool GPU::MakeVRAMFlat_ABGExtPalCoherent(NonStupidBitField<32*1024/VRAMDirtyGranularity>& dirty) noexcept
@@ -19,11 +19,15 @@
 #ifndef GPU_H
 #define GPU_H
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include "GPU2D.h"
 #include "GPU3D.h"
+#include "GPU_VRAMMemory.h"
 #include "NonStupidBitfield.h"
+#include "Platform.h"
 
 namespace melonDS
 {
@@ -31,6 +35,10 @@ class GPU3D;
 class ARMJIT;
 
 static constexpr u32 VRAMDirtyGranularity = 512;
+
+// framebuffers are triple-buffered: at any time one slot is being rendered to,
+// one is being displayed by the frontend and one holds the newest finished frame
+static constexpr int FramebufferSlots = 3;
 class GPU;
 
 template <u32 Size, u32 MappingGranularity>
@@ -72,10 +80,32 @@ public:
     u8* GetUniqueBankPtr(u32 mask, u32 offset) noexcept;
     const u8* GetUniqueBankPtr(u32 mask, u32 offset) const noexcept;
 
-    void SetRenderer2D(std::unique_ptr<GPU2D::Renderer2D>&& renderer) noexcept { GPU2D_Renderer = std::move(renderer); }
+    void SetRenderer2D(std::unique_ptr<GPU2D::Renderer2D>&& renderer) noexcept
+    {
+        SyncRender2D();
+        GPU2D_Renderer = std::move(renderer);
+    }
     [[nodiscard]] const GPU2D::Renderer2D& GetRenderer2D() const noexcept { return *GPU2D_Renderer; }
     [[nodiscard]] GPU2D::Renderer2D& GetRenderer2D() noexcept { return *GPU2D_Renderer; }
 
+    /// Runs the 2D engines on a separate thread, which renders the scanlines queued
+    /// by the emulation thread while the latter moves on.
+    /// The 2D registers are copied into each queued job, so writing them doesn't wait.
+    /// Any other access to the state the 2D renderer depends on (VRAM, palette, OAM, mapping,
+    /// capture) waits for the queued scanlines to be rendered first, so the output is identical.
+    /// Not used with an accelerated 3D renderer, which needs its GL context on the emulation thread.
+    void SetThreaded2D(bool threaded) noexcept;
+    [[nodiscard]] bool IsThreaded2D() const noexcept { return Render2DThread != nullptr; }
+
+    /// Waits for the 2D render thread to finish all queued work.
+    /// Must be called before modifying anything the 2D renderer reads,
+    /// or reading anything it writes, outside of the accessors which already do it.
+    void SyncRender2D() const noexcept
+    {
+        if (Render2DQueued.load(std::memory_order_relaxed) != Render2DDone.load(std::memory_order_acquire))
+            WaitForRender2D();
+    }
+
     void EnsureHiResSpriteBuffers(u32 scaleX, u32 scaleY) noexcept;
     void ClearHiResSpriteBuffers() noexcept;
     [[nodiscard]] u8* GetSpriteOverlayBuffer(int buf, int screen) noexcept;
@@ -86,6 +116,42 @@ public:
     [[nodiscard]] u32 GetSpriteOverlayScaleY() const noexcept { return SpriteOverlayScaleY; }
     [[nodiscard]] bool HasSpriteOverlay() const noexcept { return SpriteOverlayStride != 0 && SpriteOverlayScreenHeight != 0; }
 
+    /// Returns the regions of the given sprite overlay screen that may hold sprite pixels.
+    /// The overlay is transparent everywhere else.
+    /// Updated at the start of VBlank, when the overlay is complete.
+    [[nodiscard]] const std::vector<GPU2D::SpriteOverlayRect>& GetSpriteOverlayRects(int buf, int screen) const noexcept
+    {
+        return SpriteOverlayRects[buf][screen];
+    }
+
+    /// Returns the framebuffer slot the emulator is currently rendering to.
+    /// Only meaningful on the emulation thread.
+    [[nodiscard]] int GetBackBuffer() const noexcept { return BackBuffer; }
+
+    /// Returns the framebuffer slot holding the frame the emulator finished last.
+    /// Only meaningful on the emulation thread, where the slot is guaranteed
+    /// to stay untouched until the next frame is finished.
+    [[nodiscard]] int GetFrontBuffer() const noexcept { return FrontBuffer; }
+
+    /// Hands the newest finished frame over to the presenter and returns its slot.
+    /// If no new frame was finished since the last call, the previous slot is returned again.
+    /// The returned slot is never written to by the emulator until the next call,
+    /// so the presenter can read from it directly without copying or locking.
+    /// Must only be called from one thread (the presenter).
+    int AcquirePresentBuffer() noexcept;
+
+    /// Returns whether a frame was finished since the last call to AcquirePresentBuffer().
+    [[nodiscard]] bool HasNewFrame() const noexcept { return PresentState.load(std::memory_order_acquire) & PresentStateNewFrame; }
+
+    /// Only renders one out of every skip+1 frames, e.g. when fast-forwarding.
+    /// Skipped frames are neither drawn nor handed over to the presenter,
+    /// but everything games can observe still happens: display capture is rendered
+    /// along with the 3D scene it needs, and VRAM, the geometry engine and the timings
+    /// behave the same as for a rendered frame.
+    /// Takes effect from the next frame on. 0 renders every frame.
+    void SetFrameSkip(u32 skip) noexcept { FrameSkip = skip; }
+    [[nodiscard]] u32 GetFrameSkip() const noexcept { return FrameSkip; }
+
     void MapVRAM_AB(u32 bank, u8 cnt) noexcept;
     void MapVRAM_CD(u32 bank, u8 cnt) noexcept;
     void MapVRAM_E(u32 bank, u8 cnt) noexcept;
@@ -96,6 +162,9 @@ public:
     template<typename T>
     T ReadVRAM_LCDC(u32 addr) const noexcept
     {
+        // display capture writes to LCDC banks
+        SyncRender2D();
+
         int bank;
 
         switch (addr & 0xFF8FC000)
@@ -161,6 +230,7 @@ public:
     template<typename T>
     void WriteVRAM_LCDC(u32 addr, T val)
     {
+        SyncRender2D();
         int bank;
 
         switch (addr & 0xFF8FC000)
@@ -249,6 +319,7 @@ public:
     template<typename T>
     void WriteVRAM_ABG(u32 addr, T val)
     {
+        SyncRender2D();
         u32 mask = VRAMMap_ABG[(addr >> 14) & 0x1F];
 
         if (mask & (1<<0))
@@ -310,6 +381,7 @@ public:
     template<typename T>
     void WriteVRAM_AOBJ(u32 addr, T val)
     {
+        SyncRender2D();
         u32 mask = VRAMMap_AOBJ[(addr >> 14) & 0xF];
 
         if (mask & (1<<0))
@@ -359,6 +431,7 @@ public:
     template<typename T>
     void WriteVRAM_BBG(u32 addr, T val)
     {
+        SyncRender2D();
         u32 mask = VRAMMap_BBG[(addr >> 14) & 0x7];
 
         if (mask & (1<<2))
@@ -397,6 +470,7 @@ public:
     template<typename T>
     void WriteVRAM_BOBJ(u32 addr, T val)
     {
+        SyncRender2D();
         u32 mask = VRAMMap_BOBJ[(addr >> 14) & 0x7];
 
         if (mask & (1<<3))
@@ -426,6 +500,7 @@ public:
     template<typename T>
     void WriteVRAM_ARM7(u32 addr, T val)
     {
+        SyncRender2D();
         u32 mask = VRAMMap_ARM7[(addr >> 17) & 0x1];
 
         if (mask & (1<<2)) *(T*)&VRAM_C[addr & 0x1FFFF] = val;
@@ -488,6 +563,7 @@ public:
     template<typename T>
     void WritePalette(u32 addr, T val)
     {
+        SyncRender2D();
         addr &= 0x7FF;
 
         *(T*)&Palette[addr] = val;
@@ -503,6 +579,7 @@ public:
     template<typename T>
     void WriteOAM(u32 addr, T val)
     {
+        SyncRender2D();
         addr &= 0x7FF;
 
         *(T*)&OAM[addr] = val;
@@ -560,15 +637,18 @@ public:
     alignas(u64) u8 Palette[2*1024] {};
     alignas(u64) u8 OAM[2*1024] {};
 
-    alignas(u64) u8 VRAM_A[128*1024] {};
-    alignas(u64) u8 VRAM_B[128*1024] {};
-    alignas(u64) u8 VRAM_C[128*1024] {};
-    alignas(u64) u8 VRAM_D[128*1024] {};
-    alignas(u64) u8 VRAM_E[ 64*1024] {};
-    alignas(u64) u8 VRAM_F[ 16*1024] {};
-    alignas(u64) u8 VRAM_G[ 16*1024] {};
-    alignas(u64) u8 VRAM_H[ 32*1024] {};
-    alignas(u64) u8 VRAM_I[ 16*1024] {};
+    // holds the banks and the BG/OBJ flat views, must come before them
+    VRAMMemory VRAMMem;
+
+    u8* const VRAM_A = VRAMMem.GetBank(0);
+    u8* const VRAM_B = VRAMMem.GetBank(1);
+    u8* const VRAM_C = VRAMMem.GetBank(2);
+    u8* const VRAM_D = VRAMMem.GetBank(3);
+    u8* const VRAM_E = VRAMMem.GetBank(4);
+    u8* const VRAM_F = VRAMMem.GetBank(5);
+    u8* const VRAM_G = VRAMMem.GetBank(6);
+    u8* const VRAM_H = VRAMMem.GetBank(7);
+    u8* const VRAM_I = VRAMMem.GetBank(8);
 
     u8* const VRAM[9]     = {VRAM_A,  VRAM_B,  VRAM_C,  VRAM_D,  VRAM_E, VRAM_F, VRAM_G, VRAM_H, VRAM_I};
     u32 const VRAMMask[9] = {0x1FFFF, 0x1FFFF, 0x1FFFF, 0x1FFFF, 0xFFFF, 0x3FFF, 0x3FFF, 0x7FFF, 0x3FFF};
@@ -591,13 +671,14 @@ public:
     u8* VRAMPtr_BBG[0x8] {};
     u8* VRAMPtr_BOBJ[0x8] {};
 
-    int FrontBuffer = 0;
-    std::unique_ptr<u32[]> Framebuffer[2][2] {};
-    std::unique_ptr<u8[]> SpriteOverlay[2][2] {};
+    std::unique_ptr<u32[]> Framebuffer[FramebufferSlots][2] {};
+    std::unique_ptr<u8[]> SpriteOverlay[FramebufferSlots][2] {};
     u32 SpriteOverlayStride = 0;
     u32 SpriteOverlayScreenHeight = 0;
     u32 SpriteOverlayScaleX = 1;
     u32 SpriteOverlayScaleY = 1;
+    GPU2D::SpriteOverlaySpan SpriteOverlaySpans[FramebufferSlots][2][192] {};
+    std::vector<GPU2D::SpriteOverlayRect> SpriteOverlayRects[FramebufferSlots][2];
 
     GPU2D::Unit GPU2D_A;
     GPU2D::Unit GPU2D_B;
@@ -617,10 +698,10 @@ public:
     VRAMTrackingSet<512*1024, 128*1024> VRAMDirty_Texture {};
     VRAMTrackingSet<128*1024, 16*1024> VRAMDirty_TexPal {};
 
-    u8 VRAMFlat_ABG[512*1024] {};
-    u8 VRAMFlat_BBG[128*1024] {};
-    u8 VRAMFlat_AOBJ[256*1024] {};
-    u8 VRAMFlat_BOBJ[128*1024] {};
+    u8* const VRAMFlat_ABG = VRAMMem.GetView(VRAMMemory::View_ABG);
+    u8* const VRAMFlat_BBG = VRAMMem.GetView(VRAMMemory::View_BBG);
+    u8* const VRAMFlat_AOBJ = VRAMMem.GetView(VRAMMemory::View_AOBJ);
+    u8* const VRAMFlat_BOBJ = VRAMMem.GetView(VRAMMemory::View_BOBJ);
 
     alignas(u16) u8 VRAMFlat_ABGExtPal[32*1024] {};
     alignas(u16) u8 VRAMFlat_BBGExtPal[32*1024] {};
@@ -633,7 +714,23 @@ public:
 private:
     void ResetVRAMCache() noexcept;
     void AssignFramebuffers() noexcept;
+    void ResetSpriteOverlayRects() noexcept;
+    void UpdateSpriteOverlayRects() noexcept;
     void InitFramebuffers() noexcept;
+    void ResetFramebufferSlots() noexcept;
+    void PublishBackBuffer() noexcept;
+
+    static constexpr u8 PresentStateSlotMask = 0x3;
+    static constexpr u8 PresentStateNewFrame = 0x80;
+
+    // slot owned by the emulator
+    int BackBuffer = 0;
+    // slot of the frame last finished by the emulator
+    int FrontBuffer = 1;
+    // slot owned by the presenter
+    int PresentBuffer = 2;
+    // slot of the newest finished frame, plus a flag telling whether it was presented yet
+    std::atomic<u8> PresentState = 1;
     template<typename T>
     T ReadVRAM_ABGExtPal(u32 addr) const noexcept
     {
@@ -709,10 +806,97 @@ private:
         return change;
     }
 
+    template <u32 Size>
+    bool AliasLinearVRAM(u32 view, const u32* mappings, NonStupidBitField<Size>& dirty, u64 (GPU::* const slowAccess)(u32) const noexcept) noexcept
+    {
+        constexpr u32 VRAMBitsPerMapping = VRAMMemory::SlotSize / VRAMDirtyGranularity;
+
+        u8* flat = VRAMMem.GetView(view);
+        if (!VRAMMem.IsAliasing())
+            return CopyLinearVRAM<VRAMMemory::SlotSize>(flat, mappings, dirty, slowAccess);
+
+        // slots backed by a single bank are mapped onto it, and never need to be copied
+        for (u32 i = 0; i < Size / VRAMBitsPerMapping; i++)
+        {
+            u32 mask = mappings[i];
+            int bank = (mask && !(mask & (mask - 1))) ? __builtin_ctz(mask) : -1;
+            if (bank != VRAMMem.GetSlotBank(view, i))
+                VRAMMem.MapSlot(view, i, bank, bank >= 0 ? ((i * VRAMMemory::SlotSize) & VRAMMask[bank]) : 0);
+        }
+
+        bool change = false;
+
+        typename NonStupidBitField<Size>::Iterator it = dirty.Begin();
+        while (it != dirty.End())
+        {
+            if (VRAMMem.GetSlotBank(view, *it / VRAMBitsPerMapping) < 0)
+            {
+                u32 offset = *it * VRAMDirtyGranularity;
+                for (u32 i = 0; i < VRAMDirtyGranularity; i += 8)
+                    *(u64*)&flat[offset + i] = (this->*slowAccess)(offset + i);
+            }
+            change = true;
+            it++;
+        }
+        return change;
+    }
+
+    enum Render2DJobType : u8
+    {
+        Render2DJob_Scanline,
+        Render2DJob_Sprites,
+        Render2DJob_VBlankEnd,
+    };
+
+    struct Render2DJob
+    {
+        u8 Type;
+        u8 Skip; // engines that aren't drawn (bit 0: A, bit 1: B)
+        u16 Line;
+        u16 VCount;
+        // both engines' registers when the job was queued
+        GPU2D::UnitRegisters Regs[2];
+    };
+
+    // a frame queues at most 194 jobs before the emulation thread waits at VBlank
+    static constexpr u32 Render2DQueueSize = 256;
+
+    void RunRender2DJob(const Render2DJob& job) noexcept;
+    void QueueRender2D(u8 type, u32 line, u8 skip) noexcept;
+    void WaitForRender2D() const noexcept;
+    void Render2DThreadFunc() noexcept;
+    void StopRender2DThread() noexcept;
+
+    Platform::Thread* Render2DThread = nullptr;
+    Platform::Semaphore* Sema_Render2DStart = nullptr;
+    std::atomic_bool Render2DThreadRunning = false;
+    // set while the render thread is asleep, waiting for jobs
+    std::atomic_bool Render2DThreadIdle = false;
+    Render2DJob Render2DJobs[Render2DQueueSize] {};
+    // both only ever increase, the queue is empty when they're equal
+    std::atomic<u32> Render2DQueued = 0;
+    std::atomic<u32> Render2DDone = 0;
+
     u32 NextVCount = 0;
 
     bool RunFIFO = false;
 
+    u32 FrameSkip = 0;
+    // frames left to skip before the next rendered one
+    u32 FramesToSkip = 0;
+    // decided at VBlank, as the 3D scene is rendered one frame in advance
+    bool SkipNextFrame = false;
+    bool FrameSkipped = false;
+    // engines that aren't drawn this frame, same as Render2DJob::Skip
+    u8 SkipUnits = 0;
+    // engines whose sprites for the next frame's first scanline weren't drawn
+    u8 SkipSprites = 0;
+    bool CapturedFrame = false;
+
+    void ResetFrameSkip() noexcept;
+    // display capture needs engine A to be drawn even in skipped frames
+    [[nodiscard]] u8 GetSkippedUnits() const noexcept { return (GPU2D_A.CaptureCnt & (1<<31)) ? 0x2 : 0x3; }
+
     u16 VMatch[2] {};
 
     std::unique_ptr<GPU2D::Renderer2D> GPU2D_Renderer = nullptr;
@@ -113,6 +113,9 @@ void Unit::Reset()
 
     Win0Active = 0;
     Win1Active = 0;
+    Win0ActiveY = 0;
+    Win1ActiveY = 0;
+    BGRefReload = 0;
 
     BGMosaicSize[0] = 0;
     BGMosaicSize[1] = 0;
@@ -139,12 +142,23 @@ void Unit::Reset()
     CaptureLatch = false;
 
     MasterBrightness = 0;
+
+    Layer3DXPos = 0;
+
+    RenderRegs = *this;
 }
 
 void Unit::DoSavestate(Savestate* file)
 {
     file->Section((char*)(Num ? "GP2B" : "GP2A"));
 
+    // the renderer is done with all jobs by now, bring its state up to date
+    if (file->Saving)
+    {
+        SetRenderRegisters(*this);
+        BGRefReload = 0;
+    }
+
     file->Var32(&DispCnt);
     file->VarArray(BGCnt, 4*2);
     file->VarArray(BGXPos, 4*2);
@@ -190,6 +204,14 @@ void Unit::DoSavestate(Savestate* file)
 
     file->Var32(&Win0Active);
     file->Var32(&Win1Active);
+
+    if (!file->Saving)
+    {
+        Win0ActiveY = Win0Active & 0x1;
+        Win1ActiveY = Win1Active & 0x1;
+        BGRefReload = 0;
+        RenderRegs = *this;
+    }
 }
 
 u8 Unit::Read8(u32 addr)
@@ -388,10 +410,12 @@ void Unit::Write16(u32 addr, u16 val)
         break;
 
     case 0x064:
+        GPU.SyncRender2D();
         CaptureCnt = (CaptureCnt & 0xFFFF0000) | (val & 0xEF3F1F1F);
         return;
 
     case 0x066:
+        GPU.SyncRender2D();
         CaptureCnt = (CaptureCnt & 0xFFFF) | ((val << 16) & 0xEF3F1F1F);
         return;
 
@@ -431,21 +455,21 @@ void Unit::Write16(u32 addr, u16 val)
     case 0x026: BGRotD[0] = val; return;
     case 0x028:
         BGXRef[0] = (BGXRef[0] & 0xFFFF0000) | val;
-        if (GPU.VCount < 192) BGXRefInternal[0] = BGXRef[0];
+        if (GPU.VCount < 192) BGRefReload |= 0x1;
         return;
     case 0x02A:
         if (val & 0x0800) val |= 0xF000;
         BGXRef[0] = (BGXRef[0] & 0xFFFF) | (val << 16);
-        if (GPU.VCount < 192) BGXRefInternal[0] = BGXRef[0];
+        if (GPU.VCount < 192) BGRefReload |= 0x1;
         return;
     case 0x02C:
         BGYRef[0] = (BGYRef[0] & 0xFFFF0000) | val;
-        if (GPU.VCount < 192) BGYRefInternal[0] = BGYRef[0];
+        if (GPU.VCount < 192) BGRefReload |= 0x2;
         return;
     case 0x02E:
         if (val & 0x0800) val |= 0xF000;
         BGYRef[0] = (BGYRef[0] & 0xFFFF) | (val << 16);
-        if (GPU.VCount < 192) BGYRefInternal[0] = BGYRef[0];
+        if (GPU.VCount < 192) BGRefReload |= 0x2;
         return;
 
     case 0x030: BGRotA[1] = val; return;
@@ -454,21 +478,21 @@ void Unit::Write16(u32 addr, u16 val)
     case 0x036: BGRotD[1] = val; return;
     case 0x038:
         BGXRef[1] = (BGXRef[1] & 0xFFFF0000) | val;
-        if (GPU.VCount < 192) BGXRefInternal[1] = BGXRef[1];
+        if (GPU.VCount < 192) BGRefReload |= 0x4;
         return;
     case 0x03A:
         if (val & 0x0800) val |= 0xF000;
         BGXRef[1] = (BGXRef[1] & 0xFFFF) | (val << 16);
-        if (GPU.VCount < 192) BGXRefInternal[1] = BGXRef[1];
+        if (GPU.VCount < 192) BGRefReload |= 0x4;
         return;
     case 0x03C:
         BGYRef[1] = (BGYRef[1] & 0xFFFF0000) | val;
-        if (GPU.VCount < 192) BGYRefInternal[1] = BGYRef[1];
+        if (GPU.VCount < 192) BGRefReload |= 0x8;
         return;
     case 0x03E:
         if (val & 0x0800) val |= 0xF000;
         BGYRef[1] = (BGYRef[1] & 0xFFFF) | (val << 16);
-        if (GPU.VCount < 192) BGYRefInternal[1] = BGYRef[1];
+        if (GPU.VCount < 192) BGRefReload |= 0x8;
         return;
 
     case 0x040:
@@ -532,6 +556,7 @@ void Unit::Write32(u32 addr, u32 val)
         return;
 
     case 0x064:
+        GPU.SyncRender2D();
         CaptureCnt = val & 0xEF3F1F1F;
         return;
 
@@ -550,23 +575,23 @@ void Unit::Write32(u32 addr, u32 val)
         case 0x028:
             if (val & 0x08000000) val |= 0xF0000000;
             BGXRef[0] = val;
-            if (GPU.VCount < 192) BGXRefInternal[0] = BGXRef[0];
+            if (GPU.VCount < 192) BGRefReload |= 0x1;
             return;
         case 0x02C:
             if (val & 0x08000000) val |= 0xF0000000;
             BGYRef[0] = val;
-            if (GPU.VCount < 192) BGYRefInternal[0] = BGYRef[0];
+            if (GPU.VCount < 192) BGRefReload |= 0x2;
             return;
 
         case 0x038:
             if (val & 0x08000000) val |= 0xF0000000;
             BGXRef[1] = val;
-            if (GPU.VCount < 192) BGXRefInternal[1] = BGXRef[1];
+            if (GPU.VCount < 192) BGRefReload |= 0x4;
             return;
         case 0x03C:
             if (val & 0x08000000) val |= 0xF0000000;
             BGYRef[1] = val;
-            if (GPU.VCount < 192) BGYRefInternal[1] = BGYRef[1];
+            if (GPU.VCount < 192) BGRefReload |= 0x8;
             return;
         }
     }
@@ -580,7 +605,7 @@ void Unit::UpdateMosaicCounters(u32 line)
     // Y mosaic uses incrementing 4-bit counters
     // the transformed Y position is updated every time the counter matches the MOSAIC register
 
-    if (OBJMosaicYCount == OBJMosaicSize[1])
+    if (OBJMosaicYCount == RenderRegs.OBJMosaicSize[1])
     {
         OBJMosaicYCount = 0;
         OBJMosaicY = line + 1;
@@ -607,13 +632,13 @@ void Unit::VBlank()
 void Unit::VBlankEnd()
 {
     // TODO: find out the exact time this happens
-    BGXRefInternal[0] = BGXRef[0];
-    BGXRefInternal[1] = BGXRef[1];
-    BGYRefInternal[0] = BGYRef[0];
-    BGYRefInternal[1] = BGYRef[1];
+    BGXRefInternal[0] = RenderRegs.BGXRef[0];
+    BGXRefInternal[1] = RenderRegs.BGXRef[1];
+    BGYRefInternal[0] = RenderRegs.BGYRef[0];
+    BGYRefInternal[1] = RenderRegs.BGYRef[1];
 
     BGMosaicY = 0;
-    BGMosaicYMax = BGMosaicSize[1];
+    BGMosaicYMax = RenderRegs.BGMosaicSize[1];
     //OBJMosaicY = 0;
     //OBJMosaicYMax = OBJMosaicSize[1];
     //OBJMosaicY = 0;
@@ -622,6 +647,8 @@ void Unit::VBlankEnd()
 
 void Unit::SampleFIFO(u32 offset, u32 num)
 {
+    GPU.SyncRender2D();
+
     for (u32 i = 0; i < num; i++)
     {
         u16 val = DispFIFO[DispFIFOReadPtr];
@@ -651,54 +678,68 @@ u16* Unit::GetOBJExtPal()
 void Unit::CheckWindows(u32 line)
 {
     line &= 0xFF;
-    if (line == Win0Coords[3])      Win0Active &= ~0x1;
-    else if (line == Win0Coords[2]) Win0Active |=  0x1;
-    if (line == Win1Coords[3])      Win1Active &= ~0x1;
-    else if (line == Win1Coords[2]) Win1Active |=  0x1;
+    if (line == Win0Coords[3])      Win0ActiveY = 0;
+    else if (line == Win0Coords[2]) Win0ActiveY = 1;
+    if (line == Win1Coords[3])      Win1ActiveY = 0;
+    else if (line == Win1Coords[2]) Win1ActiveY = 1;
+}
+
+void Unit::SetRenderRegisters(const UnitRegisters& regs)
+{
+    RenderRegs = regs;
+
+    if (regs.BGRefReload & 0x1) BGXRefInternal[0] = regs.BGXRef[0];
+    if (regs.BGRefReload & 0x2) BGYRefInternal[0] = regs.BGYRef[0];
+    if (regs.BGRefReload & 0x4) BGXRefInternal[1] = regs.BGXRef[1];
+    if (regs.BGRefReload & 0x8) BGYRefInternal[1] = regs.BGYRef[1];
+
+    // the renderer keeps track of the horizontal part
+    Win0Active = (Win0Active & 0x2) | regs.Win0ActiveY;
+    Win1Active = (Win1Active & 0x2) | regs.Win1ActiveY;
 }
 
 void Unit::CalculateWindowMask(u32 line, u8* windowMask, const u8* objWindow)
 {
     for (u32 i = 0; i < 256; i++)
-        windowMask[i] = WinCnt[2]; // window outside
+        windowMask[i] = RenderRegs.WinCnt[2]; // window outside
 
-    if (DispCnt & (1<<15))
+    if (RenderRegs.DispCnt & (1<<15))
     {
         // OBJ window
         for (int i = 0; i < 256; i++)
         {
             if (objWindow[i])
-                windowMask[i] = WinCnt[3];
+                windowMask[i] = RenderRegs.WinCnt[3];
         }
     }
 
-    if (DispCnt & (1<<14))
+    if (RenderRegs.DispCnt & (1<<14))
     {
         // window 1
-        u8 x1 = Win1Coords[0];
-        u8 x2 = Win1Coords[1];
+        u8 x1 = RenderRegs.Win1Coords[0];
+        u8 x2 = RenderRegs.Win1Coords[1];
 
         for (int i = 0; i < 256; i++)
         {
             if (i == x2)      Win1Active &= ~0x2;
             else if (i == x1) Win1Active |=  0x2;
 
-            if (Win1Active == 0x3) windowMask[i] = WinCnt[1];
+            if (Win1Active == 0x3) windowMask[i] = RenderRegs.WinCnt[1];
         }
     }
 
-    if (DispCnt & (1<<13))
+    if (RenderRegs.DispCnt & (1<<13))
     {
         // window 0
-        u8 x1 = Win0Coords[0];
-        u8 x2 = Win0Coords[1];
+        u8 x1 = RenderRegs.Win0Coords[0];
+        u8 x2 = RenderRegs.Win0Coords[1];
 
         for (int i = 0; i < 256; i++)
         {
             if (i == x2)      Win0Active &= ~0x2;
             else if (i == x1) Win0Active |=  0x2;
 
-            if (Win0Active == 0x3) windowMask[i] = WinCnt[0];
+            if (Win0Active == 0x3) windowMask[i] = RenderRegs.WinCnt[0];
         }
     }
 }
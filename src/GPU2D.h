@@ -29,7 +29,49 @@ class GPU;
 namespace GPU2D
 {
 
-class Unit
+/// The registers the 2D renderer reads. They're copied into every queued render job,
+/// so that they can be written to while the render thread is still catching up.
+struct UnitRegisters
+{
+    u32 DispCnt;
+    u16 BGCnt[4];
+
+    u16 BGXPos[4];
+    u16 BGYPos[4];
+
+    s32 BGXRef[2];
+    s32 BGYRef[2];
+    s16 BGRotA[2];
+    s16 BGRotB[2];
+    s16 BGRotC[2];
+    s16 BGRotD[2];
+    // reference points written while drawing, which the renderer has to reload
+    // bit 0: BG2 X, bit 1: BG2 Y, bit 2: BG3 X, bit 3: BG3 Y
+    u8 BGRefReload;
+
+    u8 Win0Coords[4];
+    u8 Win1Coords[4];
+    u8 WinCnt[4];
+    // whether the scanline is between the windows' top and bottom, bit 0 of Win0Active/Win1Active
+    u8 Win0ActiveY, Win1ActiveY;
+
+    u8 BGMosaicSize[2];
+    u8 OBJMosaicSize[2];
+
+    u16 BlendCnt;
+    u16 BlendAlpha;
+    u8 EVA, EVB;
+    u8 EVY;
+
+    u32 CaptureCnt;
+
+    u16 MasterBrightness;
+
+    // the 3D layer's X scroll, set when queueing engine A's jobs
+    u16 Layer3DXPos;
+};
+
+class Unit : public UnitRegisters
 {
 public:
     // take a reference to the GPU so we can access its state
@@ -78,6 +120,10 @@ public:
     void UpdateMosaicCounters(u32 line);
     void CalculateWindowMask(u32 line, u8* windowMask, const u8* objWindow);
 
+    /// Makes the registers copied into a render job the ones the renderer uses.
+    /// Called by the renderer's thread, before running the job.
+    void SetRenderRegisters(const UnitRegisters& regs);
+
     u32 Num;
     bool Enabled;
 
@@ -87,45 +133,40 @@ public:
 
     u16 DispFIFOBuffer[256];
 
-    u32 DispCnt;
-    u16 BGCnt[4];
-
-    u16 BGXPos[4];
-    u16 BGYPos[4];
+    // the registers inherited from UnitRegisters are the ones the emulated software sees,
+    // the renderer uses these and the state below
+    UnitRegisters RenderRegs;
 
-    s32 BGXRef[2];
-    s32 BGYRef[2];
     s32 BGXRefInternal[2];
     s32 BGYRefInternal[2];
-    s16 BGRotA[2];
-    s16 BGRotB[2];
-    s16 BGRotC[2];
-    s16 BGRotD[2];
 
-    u8 Win0Coords[4];
-    u8 Win1Coords[4];
-    u8 WinCnt[4];
     u32 Win0Active;
     u32 Win1Active;
 
-    u8 BGMosaicSize[2];
-    u8 OBJMosaicSize[2];
     u8 BGMosaicY, BGMosaicYMax;
     u8 OBJMosaicYCount, OBJMosaicY, OBJMosaicYMax;
 
-    u16 BlendCnt;
-    u16 BlendAlpha;
-    u8 EVA, EVB;
-    u8 EVY;
-
     bool CaptureLatch;
-    u32 CaptureCnt;
-
-    u16 MasterBrightness;
 private:
     melonDS::GPU& GPU;
 };
 
+/// Horizontal range of a sprite overlay scanline holding sprite pixels, in native pixels.
+struct SpriteOverlaySpan
+{
+    u16 Start = 256;
+    u16 End = 0;
+
+    [[nodiscard]] bool Empty() const noexcept { return Start >= End; }
+};
+
+/// Region of a sprite overlay screen holding sprite pixels, in overlay pixels.
+struct SpriteOverlayRect
+{
+    u32 X, Y;
+    u32 Width, Height;
+};
+
 struct SpriteOverlaySurface
 {
     u8* Pixels = nullptr;
@@ -133,6 +174,9 @@ struct SpriteOverlaySurface
     u32 Height = 0;
     u32 ScaleX = 1;
     u32 ScaleY = 1;
+    /// For each of the 192 scanlines, the range drawn to the last time this surface was used.
+    /// Only that range has to be cleared before drawing the scanline again.
+    SpriteOverlaySpan* Spans = nullptr;
 };
 
 class Renderer2D
@@ -140,7 +184,9 @@ class Renderer2D
 public:
     virtual ~Renderer2D() {}
 
-    virtual void DrawScanline(u32 line, Unit* unit) = 0;
+    /// Draws the given scanline, with the VCount the hardware had when it started drawing it.
+    /// The two differ when the VCount register was written to.
+    virtual void DrawScanline(u32 line, u32 vcount, Unit* unit) = 0;
     virtual void DrawSprites(u32 line, Unit* unit) = 0;
 
     virtual void VBlankEnd(Unit* unitA, Unit* unitB) = 0;
@@ -161,6 +207,8 @@ protected:
     SpriteOverlaySurface SpriteOverlay[2] {};
 
     Unit* CurUnit = nullptr;
+    // CurUnit's registers as of the job being run
+    const UnitRegisters* CurRegs = nullptr;
 };
 
 }
@@ -266,7 +266,7 @@ bool SoftRenderer::DecodeSpriteForDump(Unit& unit, u16 attr0, u16 attr1, u16 att
     u32 objvrammask;
     unit.GetOBJVRAM(objvram, objvrammask);
 
-    const u32 dispCnt = unit.DispCnt;
+    const u32 dispCnt = unit.RenderRegs.DispCnt;
     const bool useExtPal = (dispCnt & 0x80000000) != 0;
     u16* basePal = (u16*)&GPU.Palette[unit.Num ? 0x600 : 0x200];
     u16* extPal = useExtPal ? unit.GetOBJExtPal() : nullptr;
@@ -556,7 +556,7 @@ u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
     u32 flag1 = val1 >> 24;
     u32 flag2 = val2 >> 24;
 
-    u32 blendCnt = CurUnit->BlendCnt;
+    u32 blendCnt = CurRegs->BlendCnt;
 
     u32 target2;
     if      (flag2 & 0x80) target2 = 0x1000;
@@ -576,8 +576,8 @@ u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
         }
         else
         {
-            eva = CurUnit->EVA;
-            evb = CurUnit->EVB;
+            eva = CurRegs->EVA;
+            evb = CurRegs->EVB;
         }
     }
     else if ((flag1 & 0x40) && (blendCnt & target2))
@@ -599,8 +599,8 @@ u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
             {
                 if (blendCnt & target2)
                 {
-                    eva = CurUnit->EVA;
-                    evb = CurUnit->EVB;
+                    eva = CurRegs->EVA;
+                    evb = CurRegs->EVB;
                 }
                 else
                     coloreffect = 0;
@@ -612,23 +612,24 @@ u32 SoftRenderer::ColorComposite(int i, u32 val1, u32 val2) const
     {
     case 0: return val1;
     case 1: return ColorBlend4(val1, val2, eva, evb);
-    case 2: return ColorBrightnessUp(val1, CurUnit->EVY, 0x8);
-    case 3: return ColorBrightnessDown(val1, CurUnit->EVY, 0x7);
+    case 2: return ColorBrightnessUp(val1, CurRegs->EVY, 0x8);
+    case 3: return ColorBrightnessDown(val1, CurRegs->EVY, 0x7);
     case 4: return ColorBlend5(val1, val2);
     }
 
     return val1;
 }
 
-void SoftRenderer::DrawScanline(u32 line, Unit* unit)
+void SoftRenderer::DrawScanline(u32 line, u32 vcount, Unit* unit)
 {
     CurUnit = unit;
+    CurRegs = &unit->RenderRegs;
 
     int stride = GPU.GPU3D.IsRendererAccelerated() ? (256*3 + 1) : 256;
     u32* dst = &Framebuffer[CurUnit->Num][stride * line];
 
     int n3dline = line;
-    line = GPU.VCount;
+    line = vcount;
 
     if (CurUnit->Num == 0)
     {
@@ -659,16 +660,16 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
     // oddly that's not the case for GPU A
     if (CurUnit->Num && !CurUnit->Enabled) forceblank = true;
 
-    if (line == 0 && CurUnit->CaptureCnt & (1 << 31) && !forceblank)
+    if (line == 0 && CurRegs->CaptureCnt & (1 << 31) && !forceblank)
         CurUnit->CaptureLatch = true;
 
     if (CurUnit->Num == 0)
     {
         if (!GPU.GPU3D.IsRendererAccelerated())
-            _3DLine = GPU.GPU3D.GetLine(n3dline);
-        else if (CurUnit->CaptureLatch && (((CurUnit->CaptureCnt >> 29) & 0x3) != 1))
+            _3DLine = GPU.GPU3D.GetLine(n3dline, CurRegs->Layer3DXPos);
+        else if (CurUnit->CaptureLatch && (((CurRegs->CaptureCnt >> 29) & 0x3) != 1))
         {
-            _3DLine = GPU.GPU3D.GetLine(n3dline);
+            _3DLine = GPU.GPU3D.GetLine(n3dline, CurRegs->Layer3DXPos);
             //GPU3D::GLRenderer::PrepareCaptureFrame();
         }
     }
@@ -685,7 +686,7 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
         return;
     }
 
-    u32 dispmode = CurUnit->DispCnt >> 16;
+    u32 dispmode = CurRegs->DispCnt >> 16;
     dispmode &= (CurUnit->Num ? 0x1 : 0x3);
 
     // always render regular graphics
@@ -711,7 +712,7 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
 
     case 2: // VRAM display
         {
-            u32 vrambank = (CurUnit->DispCnt >> 18) & 0x3;
+            u32 vrambank = (CurRegs->DispCnt >> 18) & 0x3;
             if (GPU.VRAMMap_LCDC & (1<<vrambank))
             {
                 u16* vram = (u16*)GPU.VRAM[vrambank];
@@ -756,7 +757,7 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
     if ((CurUnit->Num == 0) && CurUnit->CaptureLatch)
     {
         u32 capwidth, capheight;
-        switch ((CurUnit->CaptureCnt >> 20) & 0x3)
+        switch ((CurRegs->CaptureCnt >> 20) & 0x3)
         {
         case 0: capwidth = 128; capheight = 128; break;
         case 1: capwidth = 256; capheight = 64;  break;
@@ -768,14 +769,14 @@ void SoftRenderer::DrawScanline(u32 line, Unit* unit)
             DoCapture(line, capwidth);
     }
 
-    u32 masterBrightness = CurUnit->MasterBrightness;
+    u32 masterBrightness = CurRegs->MasterBrightness;
 
     if (GPU.GPU3D.IsRendererAccelerated())
     {
-        u32 xpos = GPU.GPU3D.GetRenderXPos();
+        u32 xpos = CurRegs->Layer3DXPos;
 
         dst[256*3] = masterBrightness |
-                     (CurUnit->DispCnt & 0x30000) |
+                     (CurRegs->DispCnt & 0x30000) |
                      (xpos << 24) | ((xpos & 0x100) << 15);
         return;
     }
@@ -944,7 +945,7 @@ void SoftRenderer::VBlankEnd(Unit* unitA, Unit* unitB)
                 cacheKey.height = height;
                 cacheKey.format = (fmt == melonDS::sprites::ObjFmt::Pal16) ? 0u : 1u;
 
-                const u32 dispCnt = unit->DispCnt;
+                const u32 dispCnt = unit->RenderRegs.DispCnt;
                 const bool useExtPal = (dispCnt & 0x80000000) != 0;
                 if (fmt == melonDS::sprites::ObjFmt::Pal16)
                 {
@@ -1165,7 +1166,7 @@ void SoftRenderer::VBlankEnd(Unit* unitA, Unit* unitB)
 #ifdef OGLRENDERER_ENABLED
     if (Renderer3D& renderer3d = GPU.GPU3D.GetCurrentRenderer(); renderer3d.Accelerated)
     {
-        if (unitA && (unitA->CaptureCnt & (1<<31)) && (((unitA->CaptureCnt >> 29) & 0x3) != 1))
+        if (unitA && (unitA->RenderRegs.CaptureCnt & (1<<31)) && (((unitA->RenderRegs.CaptureCnt >> 29) & 0x3) != 1))
         {
             renderer3d.PrepareCaptureFrame();
         }
@@ -1256,6 +1257,7 @@ std::pair<u32, u32> SoftRenderer::DetermineOverlayScale() const
 void SoftRenderer::PrepareOverlayLine(u32 unitIdx, u32 line)
 {
     CurOverlayLine = nullptr;
+    CurOverlaySpan = nullptr;
     CurOverlayStride = 0;
     CurOverlayScaleX = 1;
     CurOverlayScaleY = 1;
@@ -1295,11 +1297,55 @@ void SoftRenderer::PrepareOverlayLine(u32 unitIdx, u32 line)
 
     const size_t rowsToClear = std::min<size_t>(CurOverlayScaleY, totalRows - startRow);
     u8* base = surface.Pixels + startRow * bytesPerRow;
-    std::memset(base, 0, rowsToClear * bytesPerRow);
+    if (surface.Spans)
+    {
+        // only clear what was drawn the last time this surface was used
+        SpriteOverlaySpan& span = surface.Spans[line];
+        if (!span.Empty())
+        {
+            const size_t clearStart = size_t(span.Start) * CurOverlayScaleX * 4;
+            const size_t clearEnd = std::min<size_t>(size_t(span.End) * CurOverlayScaleX * 4, bytesPerRow);
+            for (size_t row = 0; row < rowsToClear; ++row)
+                std::memset(base + row * bytesPerRow + clearStart, 0, clearEnd - clearStart);
+        }
+        span = {};
+        CurOverlaySpan = &span;
+    }
+    else
+        std::memset(base, 0, rowsToClear * bytesPerRow);
     CurOverlayLine = base;
 }
 
-void SoftRenderer::BlitOverlayPixel(const SpriteReplacementState& state, u32 localX, u32 localY, u32 screenX)
+template <u32 rep>
+static void ReplicateOverlayPixels(u32* dst, const u32* src, u32 count)
+{
+    // fixed replication factors, so the compiler can vectorise this
+    for (u32 i = 0; i < count; ++i)
+    {
+        for (u32 r = 0; r < rep; ++r)
+            dst[i * rep + r] = src[i];
+    }
+}
+
+static void ReplicateOverlayPixels(u32* dst, const u32* src, u32 count, u32 rep)
+{
+    switch (rep)
+    {
+    case 1: std::memcpy(dst, src, count * 4); break;
+    case 2: ReplicateOverlayPixels<2>(dst, src, count); break;
+    case 3: ReplicateOverlayPixels<3>(dst, src, count); break;
+    case 4: ReplicateOverlayPixels<4>(dst, src, count); break;
+    default:
+        for (u32 i = 0; i < count; ++i)
+        {
+            for (u32 r = 0; r < rep; ++r)
+                dst[i * rep + r] = src[i];
+        }
+        break;
+    }
+}
+
+void SoftRenderer::BlitOverlaySpan(const SpriteReplacementState& state, u32 localX, u32 localY, u32 screenX, u32 count)
 {
     if (!CurOverlayLine)
         return;
@@ -1319,9 +1365,6 @@ void SoftRenderer::BlitOverlayPixel(const SpriteReplacementState& state, u32 loc
     if ((CurOverlayScaleX % state.scaleX) != 0 || (CurOverlayScaleY % state.scaleY) != 0)
         return;
 
-    const size_t dstStrideBytes = size_t(CurOverlayStride) * 4;
-    const size_t srcStrideBytes = size_t(state.hiWidth) * 4;
-
     const size_t srcBaseX = size_t(localX) * state.scaleX;
     const size_t srcBaseY = size_t(localY) * state.scaleY;
     if ((srcBaseX + state.scaleX) > state.hiWidth || (srcBaseY + state.scaleY) > state.hiHeight)
@@ -1333,35 +1376,41 @@ void SoftRenderer::BlitOverlayPixel(const SpriteReplacementState& state, u32 loc
     if (repX == 0 || repY == 0)
         return;
 
-    const size_t totalDstWidth = size_t(state.scaleX) * repX;
-    const size_t totalDstHeight = size_t(state.scaleY) * repY;
-
-    if ((dstBaseX + totalDstWidth) > CurOverlayStride)
-        return;
-    if (totalDstHeight > CurOverlayScaleY)
+    // clip the span to the sprite, the hi-res image and the overlay
+    count = std::min<u32>(count, 256 - screenX);
+    count = std::min<u32>(count, state.baseWidth - localX);
+    count = std::min<u32>(count, (state.hiWidth - srcBaseX) / state.scaleX);
+    count = std::min<u32>(count, (CurOverlayStride - dstBaseX) / CurOverlayScaleX);
+    if (count == 0)
         return;
 
+    const size_t dstStrideBytes = size_t(CurOverlayStride) * 4;
+    const size_t srcStride = state.hiWidth;
+    const u32 srcPixels = count * state.scaleX;
+    const size_t dstRowBytes = size_t(srcPixels) * repX * 4;
+    const u32* src = (const u32*)state.rgba.data();
+
     for (u32 sy = 0; sy < state.scaleY; ++sy)
     {
-        const u8* srcRow = &state.rgba[(srcBaseY + sy) * srcStrideBytes + srcBaseX * 4];
-        for (u32 oy = 0; oy < repY; ++oy)
-        {
-            u8* dstRow = CurOverlayLine + ( (sy * repY + oy) * dstStrideBytes ) + dstBaseX * 4;
-            for (u32 sx = 0; sx < state.scaleX; ++sx)
-            {
-                const u8* srcPixel = &srcRow[sx * 4];
-                for (u32 ox = 0; ox < repX; ++ox)
-                {
-                    std::memcpy(dstRow + (sx * repX + ox) * 4, srcPixel, 4);
-                }
-            }
-        }
+        const u32* srcRow = &src[(srcBaseY + sy) * srcStride + srcBaseX];
+        u8* dstRow = CurOverlayLine + (sy * repY * dstStrideBytes) + dstBaseX * 4;
+
+        // replicate the row horizontally once, then copy it for the vertical replicas
+        ReplicateOverlayPixels((u32*)dstRow, srcRow, srcPixels, repX);
+        for (u32 oy = 1; oy < repY; ++oy)
+            std::memcpy(dstRow + oy * dstStrideBytes, dstRow, dstRowBytes);
+    }
+
+    if (CurOverlaySpan)
+    {
+        CurOverlaySpan->Start = std::min<u16>(CurOverlaySpan->Start, screenX);
+        CurOverlaySpan->End = std::max<u16>(CurOverlaySpan->End, screenX + count);
     }
 }
 
 void SoftRenderer::DoCapture(u32 line, u32 width)
 {
-    u32 captureCnt = CurUnit->CaptureCnt;
+    u32 captureCnt = CurRegs->CaptureCnt;
     u32 dstvram = (captureCnt >> 16) & 0x3;
 
     // TODO: confirm this
@@ -1453,11 +1502,11 @@ void SoftRenderer::DoCapture(u32 line, u32 width)
     }
     else
     {
-        u32 srcvram = (CurUnit->DispCnt >> 18) & 0x3;
+        u32 srcvram = (CurRegs->DispCnt >> 18) & 0x3;
         if (GPU.VRAMMap_LCDC & (1<<srcvram))
             srcB = (u16*)GPU.VRAM[srcvram];
 
-        if (((CurUnit->DispCnt >> 16) & 0x3) != 2)
+        if (((CurRegs->DispCnt >> 16) & 0x3) != 2)
             srcBaddr += ((captureCnt >> 26) & 0x3) << 14;
     }
 
@@ -1584,7 +1633,7 @@ void SoftRenderer::DoCapture(u32 line, u32 width)
 #define DoDrawBG(type, line, num) \
     do \
     { \
-        if ((bgCnt[num] & 0x0040) && (CurUnit->BGMosaicSize[0] > 0)) \
+        if ((bgCnt[num] & 0x0040) && (CurRegs->BGMosaicSize[0] > 0)) \
         { \
             if (GPU.GPU3D.IsRendererAccelerated()) DrawBG_##type<true, DrawPixel_Accel>(line, num); \
             else DrawBG_##type<true, DrawPixel_Normal>(line, num); \
@@ -1599,7 +1648,7 @@ void SoftRenderer::DoCapture(u32 line, u32 width)
 #define DoDrawBG_Large(line) \
     do \
     { \
-        if ((bgCnt[2] & 0x0040) && (CurUnit->BGMosaicSize[0] > 0)) \
+        if ((bgCnt[2] & 0x0040) && (CurRegs->BGMosaicSize[0] > 0)) \
         { \
             if (GPU.GPU3D.IsRendererAccelerated()) DrawBG_Large<true, DrawPixel_Accel>(line); \
             else DrawBG_Large<true, DrawPixel_Normal>(line); \
@@ -1617,8 +1666,8 @@ void SoftRenderer::DoCapture(u32 line, u32 width)
 template<u32 bgmode>
 void SoftRenderer::DrawScanlineBGMode(u32 line)
 {
-    u32 dispCnt = CurUnit->DispCnt;
-    u16* bgCnt = CurUnit->BGCnt;
+    u32 dispCnt = CurRegs->DispCnt;
+    const u16* bgCnt = CurRegs->BGCnt;
     for (int i = 3; i >= 0; i--)
     {
         if ((bgCnt[3] & 0x3) == i)
@@ -1672,8 +1721,8 @@ void SoftRenderer::DrawScanlineBGMode(u32 line)
 
 void SoftRenderer::DrawScanlineBGMode6(u32 line)
 {
-    u32 dispCnt = CurUnit->DispCnt;
-    u16* bgCnt = CurUnit->BGCnt;
+    u32 dispCnt = CurRegs->DispCnt;
+    const u16* bgCnt = CurRegs->BGCnt;
     for (int i = 3; i >= 0; i--)
     {
         if ((bgCnt[2] & 0x3) == i)
@@ -1700,8 +1749,8 @@ void SoftRenderer::DrawScanlineBGMode6(u32 line)
 
 void SoftRenderer::DrawScanlineBGMode7(u32 line)
 {
-    u32 dispCnt = CurUnit->DispCnt;
-    u16* bgCnt = CurUnit->BGCnt;
+    u32 dispCnt = CurRegs->DispCnt;
+    const u16* bgCnt = CurRegs->BGCnt;
     // mode 7 only has text-mode BG0 and BG1
 
     for (int i = 3; i >= 0; i--)
@@ -1733,7 +1782,7 @@ void SoftRenderer::DrawScanlineBGMode7(u32 line)
 void SoftRenderer::DrawScanline_BGOBJ(u32 line)
 {
     // forced blank disables BG/OBJ compositing
-    if (CurUnit->DispCnt & (1<<7))
+    if (CurRegs->DispCnt & (1<<7))
     {
         for (int i = 0; i < 256; i++)
             BGOBJLine[i] = 0xFF3F3F3F;
@@ -1757,15 +1806,15 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
             *(u64*)&BGOBJLine[i] = backdrop;
     }
 
-    if (CurUnit->DispCnt & 0xE000)
+    if (CurRegs->DispCnt & 0xE000)
         CurUnit->CalculateWindowMask(line, WindowMask, OBJWindow[CurUnit->Num]);
     else
         memset(WindowMask, 0xFF, 256);
 
     ApplySpriteMosaicX();
-    CurBGXMosaicTable = MosaicTable[CurUnit->BGMosaicSize[0]].data();
+    CurBGXMosaicTable = MosaicTable[CurRegs->BGMosaicSize[0]].data();
 
-    switch (CurUnit->DispCnt & 0x7)
+    switch (CurRegs->DispCnt & 0x7)
     {
     case 0: DrawScanlineBGMode<0>(line); break;
     case 1: DrawScanlineBGMode<1>(line); break;
@@ -1803,7 +1852,7 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
                 u32 flag1 = val1 >> 24;
                 u32 flag2 = val2 >> 24;
 
-                u32 bldcnteffect = (CurUnit->BlendCnt >> 6) & 0x3;
+                u32 bldcnteffect = (CurRegs->BlendCnt >> 6) & 0x3;
 
                 u32 target1;
                 if      (flag1 & 0x80) target1 = 0x0010;
@@ -1815,7 +1864,7 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
                 else if (flag2 & 0x40) target2 = 0x0100;
                 else                   target2 = flag2 << 8;
 
-                if (((flag1 & 0xC0) == 0x40) && (CurUnit->BlendCnt & target2))
+                if (((flag1 & 0xC0) == 0x40) && (CurRegs->BlendCnt & target2))
                 {
                     // 3D on top, blending
 
@@ -1828,14 +1877,14 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
                     // 3D on top, normal/fade
 
                     if (bldcnteffect == 1)             bldcnteffect = 0;
-                    if (!(CurUnit->BlendCnt & 0x0001)) bldcnteffect = 0;
+                    if (!(CurRegs->BlendCnt & 0x0001)) bldcnteffect = 0;
                     if (!(WindowMask[i] & 0x20))       bldcnteffect = 0;
 
                     BGOBJLine[i]     = val2;
                     BGOBJLine[256+i] = ColorComposite(i, val2, val3);
-                    BGOBJLine[512+i] = (bldcnteffect << 24) | (CurUnit->EVY << 8);
+                    BGOBJLine[512+i] = (bldcnteffect << 24) | (CurRegs->EVY << 8);
                 }
-                else if (((flag2 & 0xC0) == 0x40) && ((CurUnit->BlendCnt & 0x01C0) == 0x0140))
+                else if (((flag2 & 0xC0) == 0x40) && ((CurRegs->BlendCnt & 0x01C0) == 0x0140))
                 {
                     // 3D on bottom, blending
 
@@ -1845,18 +1894,18 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
                         eva = flag1 & 0x1F;
                         evb = 16 - eva;
                     }
-                    else if (((CurUnit->BlendCnt & target1) && (WindowMask[i] & 0x20)) ||
+                    else if (((CurRegs->BlendCnt & target1) && (WindowMask[i] & 0x20)) ||
                             ((flag1 & 0xC0) == 0x80))
                     {
-                        eva = CurUnit->EVA;
-                        evb = CurUnit->EVB;
+                        eva = CurRegs->EVA;
+                        evb = CurRegs->EVB;
                     }
                     else
                         bldcnteffect = 7;
 
                     BGOBJLine[i]     = val1;
                     BGOBJLine[256+i] = ColorComposite(i, val1, val3);
-                    BGOBJLine[512+i] = (bldcnteffect << 24) | (CurUnit->EVB << 16) | (CurUnit->EVA << 8);
+                    BGOBJLine[512+i] = (bldcnteffect << 24) | (CurRegs->EVB << 16) | (CurRegs->EVA << 8);
                 }
                 else
                 {
@@ -1885,7 +1934,7 @@ void SoftRenderer::DrawScanline_BGOBJ(u32 line)
     if (CurUnit->BGMosaicY >= CurUnit->BGMosaicYMax)
     {
         CurUnit->BGMosaicY = 0;
-        CurUnit->BGMosaicYMax = CurUnit->BGMosaicSize[1];
+        CurUnit->BGMosaicYMax = CurRegs->BGMosaicSize[1];
     }
     else
         CurUnit->BGMosaicY++;
@@ -1958,14 +2007,14 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
     // workaround for backgrounds missing on aarch64 with lto build
     asm volatile ("" : : : "memory");
 
-    u16 bgcnt = CurUnit->BGCnt[bgnum];
+    u16 bgcnt = CurRegs->BGCnt[bgnum];
 
     u32 tilesetaddr, tilemapaddr;
     u16* pal;
     u32 extpal, extpalslot;
 
-    u16 xoff = CurUnit->BGXPos[bgnum];
-    u16 yoff = CurUnit->BGYPos[bgnum] + line;
+    u16 xoff = CurRegs->BGXPos[bgnum];
+    u16 yoff = CurRegs->BGYPos[bgnum] + line;
 
     if (bgcnt & 0x0040)
     {
@@ -1975,7 +2024,7 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
 
     u32 widexmask = (bgcnt & 0x4000) ? 0x100 : 0;
 
-    extpal = (CurUnit->DispCnt & 0x40000000);
+    extpal = (CurRegs->DispCnt & 0x40000000);
     if (extpal) extpalslot = ((bgnum<2) && (bgcnt&0x2000)) ? (2+bgnum) : bgnum;
 
     u8* bgvram;
@@ -1990,8 +2039,8 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
     }
     else
     {
-        tilesetaddr = ((CurUnit->DispCnt & 0x07000000) >> 8) + ((bgcnt & 0x003C) << 12);
-        tilemapaddr = ((CurUnit->DispCnt & 0x38000000) >> 11) + ((bgcnt & 0x1F00) << 3);
+        tilesetaddr = ((CurRegs->DispCnt & 0x07000000) >> 8) + ((bgcnt & 0x003C) << 12);
+        tilemapaddr = ((CurRegs->DispCnt & 0x38000000) >> 11) + ((bgcnt & 0x1F00) << 3);
 
         pal = (u16*)&GPU.Palette[0];
     }
@@ -2122,7 +2171,7 @@ void SoftRenderer::DrawBG_Text(u32 line, u32 bgnum)
 template<bool mosaic, SoftRenderer::DrawPixel drawPixel>
 void SoftRenderer::DrawBG_Affine(u32 line, u32 bgnum)
 {
-    u16 bgcnt = CurUnit->BGCnt[bgnum];
+    u16 bgcnt = CurRegs->BGCnt[bgnum];
 
     u32 tilesetaddr, tilemapaddr;
     u16* pal;
@@ -2141,10 +2190,10 @@ void SoftRenderer::DrawBG_Affine(u32 line, u32 bgnum)
     if (bgcnt & 0x2000) overflowmask = 0;
     else                overflowmask = ~(coordmask | 0x7FF);
 
-    s16 rotA = CurUnit->BGRotA[bgnum-2];
-    s16 rotB = CurUnit->BGRotB[bgnum-2];
-    s16 rotC = CurUnit->BGRotC[bgnum-2];
-    s16 rotD = CurUnit->BGRotD[bgnum-2];
+    s16 rotA = CurRegs->BGRotA[bgnum-2];
+    s16 rotB = CurRegs->BGRotB[bgnum-2];
+    s16 rotC = CurRegs->BGRotC[bgnum-2];
+    s16 rotD = CurRegs->BGRotD[bgnum-2];
 
     s32 rotX = CurUnit->BGXRefInternal[bgnum-2];
     s32 rotY = CurUnit->BGYRefInternal[bgnum-2];
@@ -2169,8 +2218,8 @@ void SoftRenderer::DrawBG_Affine(u32 line, u32 bgnum)
     }
     else
     {
-        tilesetaddr = ((CurUnit->DispCnt & 0x07000000) >> 8) + ((bgcnt & 0x003C) << 12);
-        tilemapaddr = ((CurUnit->DispCnt & 0x38000000) >> 11) + ((bgcnt & 0x1F00) << 3);
+        tilesetaddr = ((CurRegs->DispCnt & 0x07000000) >> 8) + ((bgcnt & 0x003C) << 12);
+        tilemapaddr = ((CurRegs->DispCnt & 0x38000000) >> 11) + ((bgcnt & 0x1F00) << 3);
 
         pal = (u16*)&GPU.Palette[0];
     }
@@ -2223,7 +2272,7 @@ void SoftRenderer::DrawBG_Affine(u32 line, u32 bgnum)
 template<bool mosaic, SoftRenderer::DrawPixel drawPixel>
 void SoftRenderer::DrawBG_Extended(u32 line, u32 bgnum)
 {
-    u16 bgcnt = CurUnit->BGCnt[bgnum];
+    u16 bgcnt = CurRegs->BGCnt[bgnum];
 
     u32 tilesetaddr, tilemapaddr;
     u16* pal;
@@ -2233,12 +2282,12 @@ void SoftRenderer::DrawBG_Extended(u32 line, u32 bgnum)
     u32 bgvrammask;
     CurUnit->GetBGVRAM(bgvram, bgvrammask);
 
-    extpal = (CurUnit->DispCnt & 0x40000000);
+    extpal = (CurRegs->DispCnt & 0x40000000);
 
-    s16 rotA = CurUnit->BGRotA[bgnum-2];
-    s16 rotB = CurUnit->BGRotB[bgnum-2];
-    s16 rotC = CurUnit->BGRotC[bgnum-2];
-    s16 rotD = CurUnit->BGRotD[bgnum-2];
+    s16 rotA = CurRegs->BGRotA[bgnum-2];
+    s16 rotB = CurRegs->BGRotB[bgnum-2];
+    s16 rotC = CurRegs->BGRotC[bgnum-2];
+    s16 rotD = CurRegs->BGRotD[bgnum-2];
 
     s32 rotX = CurUnit->BGXRefInternal[bgnum-2];
     s32 rotY = CurUnit->BGYRefInternal[bgnum-2];
@@ -2382,8 +2431,8 @@ void SoftRenderer::DrawBG_Extended(u32 line, u32 bgnum)
         }
         else
         {
-            tilesetaddr = ((CurUnit->DispCnt & 0x07000000) >> 8) + ((bgcnt & 0x003C) << 12);
-            tilemapaddr = ((CurUnit->DispCnt & 0x38000000) >> 11) + ((bgcnt & 0x1F00) << 3);
+            tilesetaddr = ((CurRegs->DispCnt & 0x07000000) >> 8) + ((bgcnt & 0x003C) << 12);
+            tilemapaddr = ((CurRegs->DispCnt & 0x38000000) >> 11) + ((bgcnt & 0x1F00) << 3);
 
             pal = (u16*)&GPU.Palette[0];
         }
@@ -2444,7 +2493,7 @@ void SoftRenderer::DrawBG_Extended(u32 line, u32 bgnum)
 template<bool mosaic, SoftRenderer::DrawPixel drawPixel>
 void SoftRenderer::DrawBG_Large(u32 line) // BG is always BG2
 {
-    u16 bgcnt = CurUnit->BGCnt[2];
+    u16 bgcnt = CurRegs->BGCnt[2];
 
     u16* pal;
 
@@ -2475,10 +2524,10 @@ void SoftRenderer::DrawBG_Large(u32 line) // BG is always BG2
         ofymask = ~ymask;
     }
 
-    s16 rotA = CurUnit->BGRotA[0];
-    s16 rotB = CurUnit->BGRotB[0];
-    s16 rotC = CurUnit->BGRotC[0];
-    s16 rotD = CurUnit->BGRotD[0];
+    s16 rotA = CurRegs->BGRotA[0];
+    s16 rotB = CurRegs->BGRotB[0];
+    s16 rotC = CurRegs->BGRotC[0];
+    s16 rotD = CurRegs->BGRotD[0];
 
     s32 rotX = CurUnit->BGXRefInternal[0];
     s32 rotY = CurUnit->BGYRefInternal[0];
@@ -2547,11 +2596,11 @@ void SoftRenderer::ApplySpriteMosaicX()
     // apply X mosaic if needed
     // X mosaic for sprites is applied after all sprites are rendered
 
-    if (CurUnit->OBJMosaicSize[0] == 0) return;
+    if (CurRegs->OBJMosaicSize[0] == 0) return;
 
     u32* objLine = OBJLine[CurUnit->Num];
 
-    u8* curOBJXMosaicTable = MosaicTable[CurUnit->OBJMosaicSize[0]].data();
+    u8* curOBJXMosaicTable = MosaicTable[CurRegs->OBJMosaicSize[0]].data();
 
     u32 lastcolor = objLine[0];
 
@@ -2572,7 +2621,7 @@ void SoftRenderer::InterleaveSprites(u32 prio)
     u32* objLine = OBJLine[CurUnit->Num];
     u16* pal = (u16*)&GPU.Palette[CurUnit->Num ? 0x600 : 0x200];
 
-    if (CurUnit->DispCnt & 0x80000000)
+    if (CurRegs->DispCnt & 0x80000000)
     {
         u16* extpal = CurUnit->GetOBJExtPal();
 
@@ -2629,6 +2678,7 @@ void SoftRenderer::InterleaveSprites(u32 prio)
 void SoftRenderer::DrawSprites(u32 line, Unit* unit)
 {
     CurUnit = unit;
+    CurRegs = &unit->RenderRegs;
 
     PrepareOverlayLine(CurUnit->Num, line);
 
@@ -2666,7 +2716,7 @@ void SoftRenderer::DrawSprites(u32 line, Unit* unit)
     NumSprites[CurUnit->Num] = 0;
     memset(OBJLine[CurUnit->Num], 0, 256*4);
     memset(OBJWindow[CurUnit->Num], 0, 256);
-    if (!(CurUnit->DispCnt & 0x1000)) return;
+    if (!(CurRegs->DispCnt & 0x1000)) return;
 
     u16* oam = (u16*)&GPU.OAM[CurUnit->Num ? 0x400 : 0];
 
@@ -2824,9 +2874,9 @@ void SoftRenderer::DrawSprite_Rotscale(u32 num, u32 boundwidth, u32 boundheight,
         pixelattr |= (0xC0000000 | (alpha << 24));
 
         u32 pixelsaddr;
-        if (CurUnit->DispCnt & 0x40)
+        if (CurRegs->DispCnt & 0x40)
         {
-            if (CurUnit->DispCnt & 0x20)
+            if (CurRegs->DispCnt & 0x20)
             {
                 // 'reserved'
                 // draws nothing
@@ -2835,13 +2885,13 @@ void SoftRenderer::DrawSprite_Rotscale(u32 num, u32 boundwidth, u32 boundheight,
             }
             else
             {
-                pixelsaddr = tilenum << (7 + ((CurUnit->DispCnt >> 22) & 0x1));
+                pixelsaddr = tilenum << (7 + ((CurRegs->DispCnt >> 22) & 0x1));
                 ytilefactor = ((width >> 8) * 2);
             }
         }
         else
         {
-            if (CurUnit->DispCnt & 0x20)
+            if (CurRegs->DispCnt & 0x20)
             {
                 pixelsaddr = ((tilenum & 0x01F) << 4) + ((tilenum & 0x3E0) << 7);
                 ytilefactor = (256 * 2);
@@ -2880,9 +2930,9 @@ void SoftRenderer::DrawSprite_Rotscale(u32 num, u32 boundwidth, u32 boundheight,
     else
     {
         u32 pixelsaddr = tilenum;
-        if (CurUnit->DispCnt & 0x10)
+        if (CurRegs->DispCnt & 0x10)
         {
-            pixelsaddr <<= ((CurUnit->DispCnt >> 20) & 0x3);
+            pixelsaddr <<= ((CurRegs->DispCnt >> 20) & 0x3);
             ytilefactor = (width >> 11) << ((attrib[0] & 0x2000) ? 1:0);
         }
         else
@@ -2902,7 +2952,7 @@ void SoftRenderer::DrawSprite_Rotscale(u32 num, u32 boundwidth, u32 boundheight,
 
             if (!window)
             {
-                if (!(CurUnit->DispCnt & 0x80000000))
+                if (!(CurRegs->DispCnt & 0x80000000))
                     pixelattr |= 0x1000;
                 else
                     pixelattr |= ((attrib[2] & 0xF000) >> 4);
@@ -3009,7 +3059,7 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
     u32* objLine = OBJLine[CurUnit->Num];
     u8* objWindow = OBJWindow[CurUnit->Num];
 
-    const bool useExtPal = (CurUnit->DispCnt & 0x80000000);
+    const bool useExtPal = (CurRegs->DispCnt & 0x80000000);
     u16* basePal = (u16*)&GPU.Palette[CurUnit->Num ? 0x600 : 0x200];
     u16* extPal = useExtPal ? CurUnit->GetOBJExtPal() : nullptr;
     u32 palBank16 = (attrib[2] >> 12) & 0xF;
@@ -3058,9 +3108,9 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
         pixelattr |= (0xC0000000 | (alpha << 24));
 
         u32 pixelsaddr = tilenum;
-        if (CurUnit->DispCnt & 0x40)
+        if (CurRegs->DispCnt & 0x40)
         {
-            if (CurUnit->DispCnt & 0x20)
+            if (CurRegs->DispCnt & 0x20)
             {
                 // 'reserved'
                 // draws nothing
@@ -3069,13 +3119,13 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
             }
             else
             {
-                pixelsaddr <<= (7 + ((CurUnit->DispCnt >> 22) & 0x1));
+                pixelsaddr <<= (7 + ((CurRegs->DispCnt >> 22) & 0x1));
                 pixelsaddr += (ypos * width * 2);
             }
         }
         else
         {
-            if (CurUnit->DispCnt & 0x20)
+            if (CurRegs->DispCnt & 0x20)
             {
                 pixelsaddr = ((tilenum & 0x01F) << 4) + ((tilenum & 0x3E0) << 7);
                 pixelsaddr += (ypos * 256 * 2);
@@ -3101,6 +3151,9 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
             pixelstride = 2;
         }
 
+        if (replacement && !window)
+            BlitOverlaySpan(*replacement, xoff, ypos, xpos, xend - xoff);
+
         for (; xoff < xend;)
         {
             u32 localX = xoff;
@@ -3109,9 +3162,6 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
 
             pixelsaddr += pixelstride;
 
-            if (replacement && !window)
-                BlitOverlayPixel(*replacement, localX, localY, xpos);
-
             if (replacement)
             {
                 u16 replColor = sampleReplacement(localX, localY);
@@ -3140,9 +3190,9 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
     else
     {
         u32 pixelsaddr = tilenum;
-        if (CurUnit->DispCnt & 0x10)
+        if (CurRegs->DispCnt & 0x10)
         {
-            pixelsaddr <<= ((CurUnit->DispCnt >> 20) & 0x3);
+            pixelsaddr <<= ((CurRegs->DispCnt >> 20) & 0x3);
             pixelsaddr += ((ypos >> 3) * (width >> 3)) << ((attrib[0] & 0x2000) ? 1:0);
         }
         else
@@ -3162,7 +3212,7 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
 
             if (!window)
             {
-                if (!(CurUnit->DispCnt & 0x80000000))
+                if (!(CurRegs->DispCnt & 0x80000000))
                     pixelattr |= 0x1000;
                 else
                     pixelattr |= ((attrib[2] & 0xF000) >> 4);
@@ -3183,6 +3233,9 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
                 pixelstride = 1;
             }
 
+            if (replacement && !window)
+                BlitOverlaySpan(*replacement, xoff, ypos, xpos, xend - xoff);
+
             for (; xoff < xend;)
             {
                 u32 localX = xoff;
@@ -3191,9 +3244,6 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
 
                 pixelsaddr += pixelstride;
 
-                 if (replacement && !window)
-                     BlitOverlayPixel(*replacement, localX, localY, xpos);
-
                 if (replacement)
                 {
                     u16 replColor = sampleReplacement(localX, localY);
@@ -3261,6 +3311,9 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
                 pixelstride = 1;
             }
 
+            if (replacement && !window)
+                BlitOverlaySpan(*replacement, xoff, ypos, xpos, xend - xoff);
+
             for (; xoff < xend;)
             {
                 u32 localX = xoff;
@@ -3276,9 +3329,6 @@ void SoftRenderer::DrawSprite_Normal(u32 num, u32 width, u32 height, s32 xpos, s
                     else              color = objvram[pixelsaddr & objvrammask] & 0x0F;
                 }
 
-                if (replacement && !window)
-                    BlitOverlayPixel(*replacement, localX, localY, xpos);
-
                 if (replacement)
                 {
                     u16 replColor = sampleReplacement(localX, localY);
@@ -38,7 +38,7 @@ public:
     SoftRenderer(melonDS::GPU& gpu);
     ~SoftRenderer() override {}
 
-    void DrawScanline(u32 line, Unit* unit) override;
+    void DrawScanline(u32 line, u32 vcount, Unit* unit) override;
     void DrawSprites(u32 line, Unit* unit) override;
     void VBlankEnd(Unit* unitA, Unit* unitB) override;
     void SetSpriteOverlay(const SpriteOverlaySurface& unitA, const SpriteOverlaySurface& unitB) override;
@@ -171,9 +171,10 @@ private:
 
     std::pair<u32, u32> DetermineOverlayScale() const;
     void PrepareOverlayLine(u32 unitIdx, u32 line);
-    void BlitOverlayPixel(const SpriteReplacementState& state, u32 localX, u32 localY, u32 screenX);
+    void BlitOverlaySpan(const SpriteReplacementState& state, u32 localX, u32 localY, u32 screenX, u32 count);
 
     u8* CurOverlayLine = nullptr;
+    SpriteOverlaySpan* CurOverlaySpan = nullptr;
     u32 CurOverlayStride = 0;
     u32 CurOverlayScaleX = 1;
     u32 CurOverlayScaleY = 1;
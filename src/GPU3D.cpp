@@ -23,6 +23,7 @@
 #include "GPU.h"
 #include "FIFO.h"
 #include "GPU3D_Soft.h"
+#include "GPU3D_SoftHD.h"
 #include "Platform.h"
 #include "GPU3D.h"
 
@@ -256,6 +257,7 @@ void GPU3D::Reset() noexcept
     ResetRenderingState();
 
     AbortFrame = false;
+    RenderSkipped = false;
 
     Timestamp = 0;
 
@@ -319,6 +321,10 @@ void GPU3D::DoSavestate(Savestate* file) noexcept
         softRenderer->SetupRenderThread(NDS.GPU);
     }
 
+    // the upscaled frame may still be rendering from the polygon RAM we're about to replace
+    if (SoftHDRenderer* hdRenderer = dynamic_cast<SoftHDRenderer*>(CurrentRenderer.get()))
+        hdRenderer->FinishFrame();
+
     CmdFIFO.DoSavestate(file);
     CmdPIPE.DoSavestate(file);
 
@@ -556,6 +562,7 @@ void GPU3D::DoSavestate(Savestate* file) noexcept
     file->Var32(&TexParam);
     file->Var32(&TexPalette);
     RenderFrameIdentical = false;
+    RenderSkipped = false;
     if (softRenderer && softRenderer->IsThreaded())
     {
         softRenderer->EnableRenderThread();
@@ -2533,8 +2540,24 @@ void GPU3D::VBlank() noexcept
     }
 }
 
-void GPU3D::VCount215(GPU& gpu) noexcept
+void GPU3D::VCount215(GPU& gpu, bool skip) noexcept
 {
+    PROFILE_SCOPE(NDS.Profiler, Section_Render3D);
+
+    if (skip)
+    {
+        CurrentRenderer->SkipFrame(gpu);
+        RenderSkipped = true;
+        return;
+    }
+
+    // the renderer still holds whatever it rendered before the skipped frames
+    if (RenderSkipped)
+    {
+        RenderFrameIdentical = false;
+        RenderSkipped = false;
+    }
+
     CurrentRenderer->RenderFrame(gpu);
 }
 
@@ -2546,19 +2569,19 @@ void GPU3D::SetRenderXPos(u16 xpos) noexcept
 }
 
 
-u32* GPU3D::GetLine(int line) noexcept
+u32* GPU3D::GetLine(int line, u16 xpos) noexcept
 {
     if (!AbortFrame)
     {
         u32* rawline = CurrentRenderer->GetLine(line);
 
-        if (RenderXPos == 0) return rawline;
+        if (xpos == 0) return rawline;
 
         // apply X scroll
 
-        if (RenderXPos & 0x100)
+        if (xpos & 0x100)
         {
-            int i = 0, j = RenderXPos;
+            int i = 0, j = xpos;
             for (; j < 512; i++, j++)
                 ScrolledLine[i] = 0;
             for (j = 0; i < 256; i++, j++)
@@ -2566,7 +2589,7 @@ u32* GPU3D::GetLine(int line) noexcept
         }
         else
         {
-            int i = 0, j = RenderXPos;
+            int i = 0, j = xpos;
             for (; j < 256; i++, j++)
                 ScrolledLine[i] = rawline[j];
             for (; i < 256; i++)
@@ -105,14 +105,17 @@ public:
 
     void VCount144(GPU& gpu) noexcept;
     void VBlank() noexcept;
-    void VCount215(GPU& gpu) noexcept;
+    /// Renders the scene for the next frame, or lets the renderer skip it if the frame won't be shown.
+    void VCount215(GPU& gpu, bool skip) noexcept;
 
     void RestartFrame(GPU& gpu) noexcept;
     void Stop(const GPU& gpu) noexcept;
 
     void SetRenderXPos(u16 xpos) noexcept;
     [[nodiscard]] u16 GetRenderXPos() const noexcept { return RenderXPos; }
-    u32* GetLine(int line) noexcept;
+    /// Returns the line scrolled by xpos, which the 2D renderer takes from
+    /// the registers of the job it's running rather than from RenderXPos.
+    u32* GetLine(int line, u16 xpos) noexcept;
 
     void WriteToGXFIFO(u32 val) noexcept;
 
@@ -272,6 +275,7 @@ public:
     u32 RenderClearAttr2 = 0;
 
     bool RenderFrameIdentical = false; // not part of the hardware state, don't serialize
+    bool RenderSkipped = false; // ditto
 
     bool AbortFrame = false;
 
@@ -347,6 +351,8 @@ public:
     virtual void VCount144(GPU& gpu) {};
     virtual void Stop(const GPU& gpu) {}
     virtual void RenderFrame(GPU& gpu) = 0;
+    // called instead of RenderFrame() for frames that aren't shown
+    virtual void SkipFrame(GPU& gpu) {}
     virtual void RestartFrame(GPU& gpu) {};
     virtual u32* GetLine(int line) = 0;
     virtual void Blit(const GPU& gpu) {};
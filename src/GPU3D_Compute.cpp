@@ -612,6 +612,7 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
     {
         return;
     }
+    HiresScratch.Reset();
 
     int numYSpans = 0;
     int numSetupIndices = 0;
@@ -717,128 +718,15 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
                         {
                             u32 width = TextureWidth(polygon->TexParam);
                             u32 height = TextureHeight(polygon->TexParam);
-                            u32 addr = (polygon->TexParam & 0xFFFF) * 8;
-                            u32 palBaseLocal = polygon->TexPalette;
-                            u32 fmt = (polygon->TexParam >> 26) & 0x7;
 
-                            auto paletteInvariantHash = [&]() -> std::optional<uint64_t>
-                            {
-                                switch (fmt)
-                                {
-                                    case 1:
-                                    case 6:
-                                        return HashTextureVRAM(gpu, addr, width * height);
-                                    case 2:
-                                        return HashTextureVRAM(gpu, addr, (width * height) / 4);
-                                    case 3:
-                                        return HashTextureVRAM(gpu, addr, (width * height) / 2);
-                                    case 4:
-                                        return HashTextureVRAM(gpu, addr, width * height);
-                                    case 5:
-                                        return HashTextureVRAM(gpu, addr, (width * height) / 16 * 4);
-                                    default:
-                                        return std::nullopt;
-                                }
-                            }();
-
-                            std::optional<uint64_t> paletteHash;
-                            std::vector<uint32_t> paletteRGBA;
-                            u32 palAddrForDump = 0;
-                            u32 auxAddrForDump = 0;
-                            bool havePaletteIndices = false;
-
-                            std::vector<u32> rgba(width*height);
-                            if (fmt == 7)
-                            {
-                                ConvertBitmapTexture<outputFmt_RGBA8>(width, height, rgba.data(), addr, gpu);
-                            }
-                            else if (fmt == 5)
-                            {
-                                u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
-                                if (addr >= 0x40000)
-                                    slot1addr += 0x10000;
-                                u32 palAddr = palBaseLocal*16;
-                                ConvertCompressedTexture<outputFmt_RGBA8>(width, height, rgba.data(), addr, slot1addr, palAddr, gpu);
-                                paletteHash = BuildPaletteData(gpu, palAddr, 0x10000 / 2, false, paletteRGBA);
-                                palAddrForDump = palAddr;
-                                auxAddrForDump = slot1addr;
-                                havePaletteIndices = true;
-                            }
-                            else
-                            {
-                                u32 palAddr = palBaseLocal*16;
-                                u32 numPalEntries = 0;
-                                bool color0Transparent = (polygon->TexParam & (1 << 29));
-                                switch (fmt)
-                                {
-                                    case 1:
-                                        numPalEntries = 32;
-                                        ConvertAXIYTexture<outputFmt_RGBA8, 3, 5>(width, height, rgba.data(), addr, palAddr, gpu);
-                                        break;
-                                    case 6:
-                                        numPalEntries = 8;
-                                        ConvertAXIYTexture<outputFmt_RGBA8, 5, 3>(width, height, rgba.data(), addr, palAddr, gpu);
-                                        break;
-                                    case 2:
-                                        numPalEntries = 4;
-                                        palAddr >>= 1;
-                                        ConvertNColorsTexture<outputFmt_RGBA8, 2>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                                        break;
-                                    case 3:
-                                        numPalEntries = 16;
-                                        ConvertNColorsTexture<outputFmt_RGBA8, 4>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                                        break;
-                                    case 4:
-                                        numPalEntries = 256;
-                                        ConvertNColorsTexture<outputFmt_RGBA8, 8>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                                        break;
-                                    default: break;
-                                }
-                                if (numPalEntries)
-                                {
-                                    paletteHash = BuildPaletteData(gpu, palAddr, numPalEntries, color0Transparent, paletteRGBA);
-                                    palAddrForDump = palAddr;
-                                    havePaletteIndices = true;
-                                }
-                            }
-
-                            melonDS::hires::DsiTexFmt fmtTag = melonDS::hires::DsiTexFmt::Unknown;
-                            switch (fmt) {
-                                case 7: fmtTag = melonDS::hires::DsiTexFmt::Direct; break;
-                                case 5: fmtTag = melonDS::hires::DsiTexFmt::Tex4x4; break;
-                                case 6: fmtTag = melonDS::hires::DsiTexFmt::A5I3; break;
-                                case 1: fmtTag = melonDS::hires::DsiTexFmt::A3I5; break;
-                                case 2: fmtTag = melonDS::hires::DsiTexFmt::Pal4; break;
-                                case 3: fmtTag = melonDS::hires::DsiTexFmt::Pal16; break;
-                                case 4: fmtTag = melonDS::hires::DsiTexFmt::Pal256; break;
-                                default: break;
-                            }
-                            bool pal0Transparent = (fmt >= 2 && fmt <= 4) && (polygon->TexParam & (1<<29));
-                            const uint8_t* rgbaBytes = reinterpret_cast<const uint8_t*>(rgba.data());
-                            auto key = melonDS::hires::MakeKey(rgbaBytes, width, height, false,
-                                                               pal0Transparent, fmtTag, paletteInvariantHash);
-                            melonDS::hires::PaletteIndexGenerator paletteIndexGenerator;
-                            if (melonDS::hires::DumpEnabled() && paletteHash && havePaletteIndices) {
-                                paletteIndexGenerator = [fmt, width, height, addr, auxAddrForDump, palAddrForDump, &gpu]
-                                                         (std::vector<uint8_t>& data, std::string& format, std::string& encoding) {
-                                    return BuildPaletteIndexMap(gpu, fmt, width, height, addr, auxAddrForDump, palAddrForDump,
-                                                                data, format, encoding);
-                                };
-                            }
-                            melonDS::hires::DumpIfEnabled(key, rgbaBytes, width, height,
-                                                          paletteHash,
-                                                          paletteHash ? paletteRGBA.data() : nullptr,
-                                                          paletteHash ? static_cast<uint32_t>(paletteRGBA.size()) : 0,
-                                                          std::move(paletteIndexGenerator));
-
-                            std::vector<uint8_t> repl;
-                            u32 rw = width, rh = height;
+                            melonDS::hires::ReplacementImage& replImage = HiresRepl;
                             std::string usedFile;
-                            if (melonDS::hires::TryLoadReplacement(key, repl, rw, rh, paletteHash, &usedFile))
+                            if (LookupHiresReplacement(gpu, polygon->TexParam, polygon->TexPalette, true, HiresScratch, replImage, usedFile))
                             {
+                                u32 rw = replImage.width, rh = replImage.height;
                                 if ((rw % width) == 0 && (rh % height) == 0 && (rw/width) == (rh/height))
                                 {
-                                    std::string fname = usedFile.empty() ? melonDS::hires::KeyToFilename(key, false) : usedFile;
+                                    const std::string& fname = usedFile;
                                     GLuint texid = 0;
                                     auto it2 = HiresReplTex.find(fname);
                                     if (it2 != HiresReplTex.end())
@@ -847,6 +735,8 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
                                     }
                                     else
                                     {
+                                        // integer textures can't be block-compressed, decode those on the CPU
+                                        const std::vector<uint8_t>& repl = melonDS::hires::ReplacementRGBA(replImage, HiresReplRGBA);
                                         std::vector<uint8_t> packed;
                                         packed.resize(size_t(rw)*rh*4);
                                         for (size_t ii = 0, N = size_t(rw)*rh; ii < N; ++ii)
@@ -927,131 +817,17 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
 
                         if (HiresNoReplByTexParam.find(dsKey) == HiresNoReplByTexParam.end())
                         {
-                            // Decode DS texture to RGBA8 for key/dump
                             u32 width = TextureWidth(polygon->TexParam);
                             u32 height = TextureHeight(polygon->TexParam);
-                            u32 addr = (polygon->TexParam & 0xFFFF) * 8;
-                            u32 palBase = polygon->TexPalette;
-                            u32 fmt = (polygon->TexParam >> 26) & 0x7;
 
-                            auto paletteInvariantHash = [&]() -> std::optional<uint64_t>
-                            {
-                                switch (fmt)
-                                {
-                                    case 1:
-                                    case 6:
-                                        return HashTextureVRAM(gpu, addr, width * height);
-                                    case 2:
-                                        return HashTextureVRAM(gpu, addr, (width * height) / 4);
-                                    case 3:
-                                        return HashTextureVRAM(gpu, addr, (width * height) / 2);
-                                    case 4:
-                                        return HashTextureVRAM(gpu, addr, width * height);
-                                    case 5:
-                                        return HashTextureVRAM(gpu, addr, (width * height) / 16 * 4);
-                                    default:
-                                        return std::nullopt;
-                                }
-                            }();
-
-                            std::optional<uint64_t> paletteHash;
-                            std::vector<uint32_t> paletteRGBA;
-                            u32 palAddrForDump = 0;
-                            u32 auxAddrForDump = 0;
-                            bool havePaletteIndices = false;
-
-                            std::vector<u32> rgba(width*height);
-                            if (fmt == 7)
-                            {
-                                ConvertBitmapTexture<outputFmt_RGBA8>(width, height, rgba.data(), addr, gpu);
-                            }
-                            else if (fmt == 5)
-                            {
-                                u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
-                                if (addr >= 0x40000)
-                                    slot1addr += 0x10000;
-                                u32 palAddr = palBase*16;
-                                ConvertCompressedTexture<outputFmt_RGBA8>(width, height, rgba.data(), addr, slot1addr, palAddr, gpu);
-                                paletteHash = BuildPaletteData(gpu, palAddr, 0x10000 / 2, false, paletteRGBA);
-                                palAddrForDump = palAddr;
-                                auxAddrForDump = slot1addr;
-                                havePaletteIndices = true;
-                            }
-                            else
-                            {
-                                u32 palAddr = palBase*16;
-                                u32 numPalEntries = 0;
-                                bool color0Transparent = (polygon->TexParam & (1 << 29));
-                                switch (fmt)
-                                {
-                                    case 1:
-                                        numPalEntries = 32;
-                                        ConvertAXIYTexture<outputFmt_RGBA8, 3, 5>(width, height, rgba.data(), addr, palAddr, gpu);
-                                        break;
-                                    case 6:
-                                        numPalEntries = 8;
-                                        ConvertAXIYTexture<outputFmt_RGBA8, 5, 3>(width, height, rgba.data(), addr, palAddr, gpu);
-                                        break;
-                                    case 2:
-                                        numPalEntries = 4;
-                                        palAddr >>= 1;
-                                        ConvertNColorsTexture<outputFmt_RGBA8, 2>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                                        break;
-                                    case 3:
-                                        numPalEntries = 16;
-                                        ConvertNColorsTexture<outputFmt_RGBA8, 4>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                                        break;
-                                    case 4:
-                                        numPalEntries = 256;
-                                        ConvertNColorsTexture<outputFmt_RGBA8, 8>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                                        break;
-                                    default: break;
-                                }
-                                if (numPalEntries)
-                                {
-                                    paletteHash = BuildPaletteData(gpu, palAddr, numPalEntries, color0Transparent, paletteRGBA);
-                                    palAddrForDump = palAddr;
-                                    havePaletteIndices = true;
-                                }
-                            }
-
-                            melonDS::hires::DsiTexFmt fmtTag = melonDS::hires::DsiTexFmt::Unknown;
-                            switch (fmt) {
-                                case 7: fmtTag = melonDS::hires::DsiTexFmt::Direct; break;
-                                case 5: fmtTag = melonDS::hires::DsiTexFmt::Tex4x4; break;
-                                case 6: fmtTag = melonDS::hires::DsiTexFmt::A5I3; break;
-                                case 1: fmtTag = melonDS::hires::DsiTexFmt::A3I5; break;
-                                case 2: fmtTag = melonDS::hires::DsiTexFmt::Pal4; break;
-                                case 3: fmtTag = melonDS::hires::DsiTexFmt::Pal16; break;
-                                case 4: fmtTag = melonDS::hires::DsiTexFmt::Pal256; break;
-                                default: break;
-                            }
-                            bool pal0Transparent = (fmt >= 2 && fmt <= 4) && (polygon->TexParam & (1<<29));
-                            const uint8_t* rgbaBytes = reinterpret_cast<const uint8_t*>(rgba.data());
-                            auto key = melonDS::hires::MakeKey(rgbaBytes, width, height, false,
-                                                               pal0Transparent, fmtTag, paletteInvariantHash);
-                            melonDS::hires::PaletteIndexGenerator paletteIndexGenerator;
-                            if (melonDS::hires::DumpEnabled() && paletteHash && havePaletteIndices) {
-                                paletteIndexGenerator = [fmt, width, height, addr, auxAddrForDump, palAddrForDump, &gpu]
-                                                         (std::vector<uint8_t>& data, std::string& format, std::string& encoding) {
-                                    return BuildPaletteIndexMap(gpu, fmt, width, height, addr, auxAddrForDump, palAddrForDump,
-                                                                data, format, encoding);
-                                };
-                            }
-                            melonDS::hires::DumpIfEnabled(key, rgbaBytes, width, height,
-                                                          paletteHash,
-                                                          paletteHash ? paletteRGBA.data() : nullptr,
-                                                          paletteHash ? static_cast<uint32_t>(paletteRGBA.size()) : 0,
-                                                          std::move(paletteIndexGenerator));
-
-                            std::vector<uint8_t> repl;
-                            u32 rw=width, rh=height;
+                            melonDS::hires::ReplacementImage& replImage = HiresRepl;
                             std::string usedFile;
-                            if (melonDS::hires::TryLoadReplacement(key, repl, rw, rh, paletteHash, &usedFile))
+                            if (LookupHiresReplacement(gpu, polygon->TexParam, polygon->TexPalette, true, HiresScratch, replImage, usedFile))
                             {
+                                u32 rw = replImage.width, rh = replImage.height;
                                 if ((rw % width) == 0 && (rh % height) == 0 && (rw/width) == (rh/height))
                                 {
-                                    std::string fname = usedFile.empty() ? melonDS::hires::KeyToFilename(key, false) : usedFile;
+                                    const std::string& fname = usedFile;
                                     GLuint texid = 0;
                                     auto it = HiresReplTex.find(fname);
                                     if (it != HiresReplTex.end())
@@ -1060,6 +836,8 @@ void ComputeRenderer::RenderFrame(GPU& gpu)
                                     }
                                     else
                                     {
+                                        // integer textures can't be block-compressed, decode those on the CPU
+                                        const std::vector<uint8_t>& repl = melonDS::hires::ReplacementRGBA(replImage, HiresReplRGBA);
                                         std::vector<uint8_t> packed;
                                         packed.resize(size_t(rw)*rh*4);
                                         for (size_t ii = 0, N = size_t(rw)*rh; ii < N; ++ii)
@@ -63,6 +63,9 @@ public:
 
     bool NeedsShaderCompile() override { return ShaderStepIdx != 33; }
     void ShaderCompileStep(int& current, int& count) override;
+
+    /// How much work the texture cache invalidation did for the last frame.
+    const TexcacheStats& GetTexcacheStats() const { return Texcache.GetStats(); }
 private:
     ComputeRenderer(GLCompositor&& compositor);
 
@@ -245,6 +248,10 @@ private:
     std::unordered_map<std::string, GLuint> HiresReplTex;
     std::unordered_map<u64, GLuint> HiresReplByTexParam;
     std::unordered_set<u64> HiresNoReplByTexParam;
+    // Scratch memory of the replacement lookups, reset every frame
+    TexScratchArena HiresScratch;
+    melonDS::hires::ReplacementImage HiresRepl;
+    std::vector<u8> HiresReplRGBA;
 };
 
 }
@@ -29,6 +29,12 @@
 #include "GPU3D_Texcache.h"
 #include "video/hirez/TexDump.h"
 
+// from EXT_texture_compression_s3tc, which glad wasn't generated with
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 namespace melonDS
 {
 
@@ -115,6 +121,8 @@ std::unique_ptr<GLRenderer> GLRenderer::New() noexcept
     std::unique_ptr<GLRenderer> result = std::unique_ptr<GLRenderer>(new GLRenderer(std::move(*compositor)));
     compositor = std::nullopt;
 
+    result->SupportsS3TC = OpenGL::HasExtension("GL_EXT_texture_compression_s3tc");
+
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_STENCIL_TEST);
 
@@ -1350,6 +1358,7 @@ void GLRenderer::RenderFrame(GPU& gpu)
         // Only when texture mapping is enabled
         if (melonDS::hires::ReplaceEnabled())
         {
+            HiresScratch.Reset();
             for (int i = 0; i < NumFinalPolys; i++)
             {
                 RendererPolygon* rp = &PolygonList[i];
@@ -1362,9 +1371,7 @@ void GLRenderer::RenderFrame(GPU& gpu)
 
                 u32 width = 8u << ((attr >> 20) & 0x7);
                 u32 height = 8u << ((attr >> 23) & 0x7);
-                u32 addr = (attr & 0xFFFF) * 8u;
                 u32 palBase = poly->TexPalette;
-                u32 fmt = (attr >> 26) & 0x7;
 
                 u64 dsKey = (attr & ~0xC00F0000u) | (u64(palBase) << 32);
                 auto itCR = ClassicReplByTexParam.find(dsKey);
@@ -1379,127 +1386,15 @@ void GLRenderer::RenderFrame(GPU& gpu)
                     continue;
                 }
 
-                auto paletteInvariantHash = [&]() -> std::optional<uint64_t>
-                {
-                    switch (fmt)
-                    {
-                        case 1:
-                        case 6:
-                            return HashTextureVRAM(gpu, addr, width * height);
-                        case 2:
-                            return HashTextureVRAM(gpu, addr, (width * height) / 4);
-                        case 3:
-                            return HashTextureVRAM(gpu, addr, (width * height) / 2);
-                        case 4:
-                            return HashTextureVRAM(gpu, addr, width * height);
-                        default:
-                            return std::nullopt;
-                    }
-                }();
-
-                std::optional<uint64_t> paletteHash;
-                std::vector<uint32_t> paletteRGBA;
-                u32 palAddrForDump = 0;
-                u32 auxAddrForDump = 0;
-                bool havePaletteIndices = false;
-
-                // Decode to RGBA8 using the shared converters
-                std::vector<u32> rgba(width*height);
-                if (fmt == 7)
-                {
-                    ConvertBitmapTexture<outputFmt_RGBA8>(width, height, rgba.data(), addr, gpu);
-                }
-                else if (fmt == 5)
-                {
-                    u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
-                    if (addr >= 0x40000)
-                        slot1addr += 0x10000;
-                    u32 palAddr = palBase*16;
-                    ConvertCompressedTexture<outputFmt_RGBA8>(width, height, rgba.data(), addr, slot1addr, palAddr, gpu);
-                    auxAddrForDump = slot1addr;
-                    palAddrForDump = palAddr;
-                    havePaletteIndices = true;
-                    paletteHash = BuildPaletteData(gpu, palAddr, 0x10000 / 2, false, paletteRGBA);
-                }
-                else
-                {
-                    u32 palAddr = palBase*16;
-                    u32 numPalEntries = 0;
-                    bool color0Transparent = attr & (1 << 29);
-                    switch (fmt)
-                    {
-                        case 1:
-                            numPalEntries = 32;
-                            ConvertAXIYTexture<outputFmt_RGBA8, 3, 5>(width, height, rgba.data(), addr, palAddr, gpu);
-                            break;
-                        case 6:
-                            numPalEntries = 8;
-                            ConvertAXIYTexture<outputFmt_RGBA8, 5, 3>(width, height, rgba.data(), addr, palAddr, gpu);
-                            break;
-                        case 2:
-                            numPalEntries = 4;
-                            palAddr >>= 1;
-                            ConvertNColorsTexture<outputFmt_RGBA8, 2>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                            break;
-                        case 3:
-                            numPalEntries = 16;
-                            ConvertNColorsTexture<outputFmt_RGBA8, 4>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                            break;
-                        case 4:
-                            numPalEntries = 256;
-                            ConvertNColorsTexture<outputFmt_RGBA8, 8>(width, height, rgba.data(), addr, palAddr, color0Transparent, gpu);
-                            break;
-                        default: break;
-                    }
-                    if (numPalEntries)
-                    {
-                        paletteHash = BuildPaletteData(gpu, palAddr, numPalEntries, color0Transparent, paletteRGBA);
-                        palAddrForDump = palAddr;
-                        havePaletteIndices = true;
-                    }
-                }
-
-                // Map DS fmt to hires tag and flags
-                melonDS::hires::DsiTexFmt fmtTag = melonDS::hires::DsiTexFmt::Unknown;
-                switch (fmt) {
-                    case 7: fmtTag = melonDS::hires::DsiTexFmt::Direct; break;
-                    case 5: fmtTag = melonDS::hires::DsiTexFmt::Tex4x4; break;
-                    case 6: fmtTag = melonDS::hires::DsiTexFmt::A5I3; break;
-                    case 1: fmtTag = melonDS::hires::DsiTexFmt::A3I5; break;
-                    case 2: fmtTag = melonDS::hires::DsiTexFmt::Pal4; break;
-                    case 3: fmtTag = melonDS::hires::DsiTexFmt::Pal16; break;
-                    case 4: fmtTag = melonDS::hires::DsiTexFmt::Pal256; break;
-                    default: break;
-                }
-                bool pal0Transparent = (fmt >= 2 && fmt <= 4) && (attr & (1<<29));
-
-                // Dump and try replacement
-                const uint8_t* rgbaBytes = reinterpret_cast<const uint8_t*>(rgba.data());
-                auto key = melonDS::hires::MakeKey(rgbaBytes, width, height, false,
-                                                   pal0Transparent, fmtTag, paletteInvariantHash);
-                melonDS::hires::PaletteIndexGenerator paletteIndexGenerator;
-                if (melonDS::hires::DumpEnabled() && paletteHash && havePaletteIndices) {
-                    paletteIndexGenerator = [fmt, width, height, addr, auxAddrForDump, palAddrForDump, &gpu]
-                                             (std::vector<uint8_t>& data, std::string& format, std::string& encoding) {
-                        return BuildPaletteIndexMap(gpu, fmt, width, height, addr, auxAddrForDump, palAddrForDump,
-                                                     data, format, encoding);
-                    };
-                }
-                melonDS::hires::DumpIfEnabled(key, rgbaBytes, width, height,
-                                              paletteHash,
-                                              paletteHash ? paletteRGBA.data() : nullptr,
-                                              paletteHash ? static_cast<uint32_t>(paletteRGBA.size()) : 0,
-                                              std::move(paletteIndexGenerator));
-
-                std::vector<uint8_t> repl;
-                u32 rw=width, rh=height;
+                melonDS::hires::ReplacementImage& replImage = HiresRepl;
                 std::string usedFile;
-                if (melonDS::hires::TryLoadReplacement(key, repl, rw, rh, paletteHash, &usedFile))
+                if (LookupHiresReplacement(gpu, attr, palBase, false, HiresScratch, replImage, usedFile))
                 {
+                    u32 rw = replImage.width, rh = replImage.height;
                     // Accept only integer multiples
                     if (rw % width == 0 && rh % height == 0 && (rw/width) == (rh/height))
                     {
-                        std::string fname = usedFile.empty() ? melonDS::hires::KeyToFilename(key, false) : usedFile;
+                        const std::string& fname = usedFile;
                         GLuint texid = 0;
                         auto it = HiresTexCache.find(fname);
                         if (it != HiresTexCache.end())
@@ -1514,7 +1409,19 @@ void GLRenderer::RenderFrame(GPU& gpu)
                             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
                             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
                             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rw, rh, 0, GL_RGBA, GL_UNSIGNED_BYTE, repl.data());
+                            if (replImage.compressed && SupportsS3TC)
+                            {
+                                // .dds packs are uploaded without decoding them
+                                GLenum glFormat = replImage.format == melonDS::hires::BlockFormat::BC1
+                                    ? GL_COMPRESSED_RGBA_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+                                glCompressedTexImage2D(GL_TEXTURE_2D, 0, glFormat, rw, rh, 0,
+                                                       (GLsizei)replImage.data.size(), replImage.data.data());
+                            }
+                            else
+                            {
+                                const std::vector<uint8_t>& repl = melonDS::hires::ReplacementRGBA(replImage, HiresReplRGBA);
+                                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, rw, rh, 0, GL_RGBA, GL_UNSIGNED_BYTE, repl.data());
+                            }
                             HiresTexCache.emplace(fname, texid);
                         }
                         rp->ReplTexID = texid;
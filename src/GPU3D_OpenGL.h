@@ -22,6 +22,7 @@
 #include "GPU3D.h"
 #include "GPU_OpenGL.h"
 #include "OpenGLSupport.h"
+#include "GPU3D_Texcache.h"
 #include <unordered_map>
 #include <unordered_set>
 #include <string>
@@ -170,8 +171,14 @@ private:
 
     // Cache for GL textures created from replacement images
     std::unordered_map<std::string, GLuint> HiresTexCache;
+    // Whether BC1/BC3 replacements can be uploaded as is
+    bool SupportsS3TC = false;
     std::unordered_map<u64, GLuint> ClassicReplByTexParam;
     std::unordered_set<u64> ClassicNoReplByTexParam;
+    // Scratch memory of the replacement lookups, reset every frame
+    TexScratchArena HiresScratch;
+    melonDS::hires::ReplacementImage HiresRepl;
+    std::vector<u8> HiresReplRGBA;
 };
 }
 #endif
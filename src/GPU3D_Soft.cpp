@@ -1748,7 +1748,8 @@ void SoftRenderer::RenderFrame(GPU& gpu)
     bool textureChanged = gpu.MakeVRAMFlat_TextureCoherent(textureDirty);
     bool texPalChanged = gpu.MakeVRAMFlat_TexPalCoherent(texPalDirty);
 
-    FrameIdentical = !(textureChanged || texPalChanged) && gpu.GPU3D.RenderFrameIdentical;
+    TexturesChanged = textureChanged || texPalChanged;
+    FrameIdentical = !TexturesChanged && gpu.GPU3D.RenderFrameIdentical;
 
     if (RenderThreadRunning.load(std::memory_order_relaxed))
     {
@@ -1762,6 +1763,17 @@ void SoftRenderer::RenderFrame(GPU& gpu)
     }
 }
 
+void SoftRenderer::SkipFrame(GPU& gpu)
+{
+    if (RenderThreadRunning.load(std::memory_order_relaxed))
+    {
+        // the render thread still has to go through the motions
+        // so the 2D renderer and VCount144() don't wait for it forever
+        FrameIdentical = true;
+        Platform::Semaphore_Post(Sema_RenderStart);
+    }
+}
+
 void SoftRenderer::RestartFrame(GPU& gpu)
 {
     SetupRenderThread(gpu);
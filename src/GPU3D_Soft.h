@@ -38,12 +38,22 @@ public:
 
     void VCount144(GPU& gpu) override;
     void RenderFrame(GPU& gpu) override;
+    void SkipFrame(GPU& gpu) override;
     void RestartFrame(GPU& gpu) override;
     u32* GetLine(int line) override;
 
     void SetupRenderThread(GPU& gpu);
     void EnableRenderThread();
     void StopRenderThread();
+protected:
+    // set by RenderFrame, for renderers that build on this one
+    bool FrameIdentical = false;
+    bool TexturesChanged = true;
+
+    // the native frame, complete once VCount144() returns,
+    // or as soon as RenderFrame() returns when there's no render thread
+    [[nodiscard]] const u32* GetNativeLine(int line) const noexcept { return &ColorBuffer[(line * ScanlineWidth) + FirstPixelOffset]; }
+    [[nodiscard]] bool IsRenderThreadRunning() const noexcept { return RenderThreadRunning.load(std::memory_order_relaxed); }
 private:
     friend void GPU3D::DoSavestate(Savestate* file) noexcept;
     // Notes on the interpolator:
@@ -483,8 +493,6 @@ private:
 
     bool Enabled;
 
-    bool FrameIdentical;
-
     // threading
 
     bool Threaded = false;
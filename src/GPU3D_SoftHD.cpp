@@ -0,0 +1,947 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "GPU3D_SoftHD.h"
+
+#include <string.h>
+#include <math.h>
+
+#include <algorithm>
+
+#include "NDS.h"
+#include "GPU.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+using Platform::Log;
+using Platform::LogLevel;
+
+// The upscaled frame is rasterized with edge functions in 1/16 pixel units
+// (the precision of Vertex::HiresPosition), which are exact and follow a top-left
+// fill rule, so triangles sharing an edge never overlap or leave gaps.
+// Attributes are interpolated with perspective correction from barycentric weights.
+//
+// Each row of a triangle within a tile is handled as a span: its coverage is solved
+// for directly from the edge functions, then the attributes of the whole span are
+// interpolated in a loop without branches that the compiler turns into SIMD code,
+// before the pixels are shaded and blended one by one.
+
+enum
+{
+    DepthTest_LessThan,
+    DepthTest_LessThan_FrontFacing,
+    DepthTest_Equal_Z,
+    DepthTest_Equal_W,
+};
+
+static inline bool DepthTest(int mode, s32 dstz, s32 z, u32 dstattr)
+{
+    switch (mode)
+    {
+    case DepthTest_Equal_Z:
+        return (u32)((dstz - z) + 0x200) <= 0x400;
+    case DepthTest_Equal_W:
+        return (u32)((dstz - z) + 0xFF) <= 0x1FE;
+    case DepthTest_LessThan_FrontFacing:
+        if ((dstattr & 0x00400010) == 0x00000010) // opaque, back facing
+            return z <= dstz;
+        return z < dstz;
+    default:
+        return z < dstz;
+    }
+}
+
+static inline s64 FloorDiv(s64 a, s64 b)
+{
+    // b > 0
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+static inline u32 ConvertRGB5ToRGB6A5(u16 val, u32 alpha)
+{
+    u32 r = (val << 1) & 0x3E; if (r) r++;
+    u32 g = (val >> 4) & 0x3E; if (g) g++;
+    u32 b = (val >> 9) & 0x3E; if (b) b++;
+    return r | (g << 8) | (b << 16) | (alpha << 24);
+}
+
+SoftHDRenderer::SoftHDRenderer(int scale, int numThreads) noexcept
+    : SoftRenderer(),
+      Scale(std::clamp(scale, 1, MaxScale)),
+      OwnJobs(numThreads > 0 ? std::make_unique<JobSystem>(numThreads) : nullptr),
+      Jobs(OwnJobs ? *OwnJobs : JobSystem::Get()),
+      TileJobs(Jobs)
+{
+    Width = 256 * Scale;
+    Height = 192 * Scale;
+    TilesX = Width / TileSize;
+    TilesY = Height / TileSize;
+
+    ColorBuffers[0].assign(Width * Height, 0);
+    ColorBuffers[1].assign(Width * Height, 0);
+    DepthBuffer.assign(Width * Height, 0);
+    AttrBuffer.assign(Width * Height, 0);
+    TileBins.resize(TilesX * TilesY);
+}
+
+SoftHDRenderer::~SoftHDRenderer()
+{
+    FinishFrame();
+}
+
+void SoftHDRenderer::Reset(GPU& gpu)
+{
+    FinishFrame();
+    SoftRenderer::Reset(gpu);
+
+    for (auto& buffer : ColorBuffers)
+        std::fill(buffer.begin(), buffer.end(), 0);
+    FrontBuffer = 0;
+    HaveFrame = false;
+    NativeFallback = false;
+    UpscalePending = false;
+
+    Textures.clear();
+    ReplByTexParam.clear();
+    NoReplByTexParam.clear();
+    ReplTextures.clear();
+}
+
+void SoftHDRenderer::VCount144(GPU& gpu)
+{
+    SoftRenderer::VCount144(gpu);
+    FinishFrame();
+
+    if (UpscalePending && !gpu.GPU3D.AbortFrame)
+        UpscaleNativeFrame();
+    UpscalePending = false;
+}
+
+void SoftHDRenderer::Stop(const GPU& gpu)
+{
+    FinishFrame();
+    UpscalePending = false;
+    SoftRenderer::Stop(gpu);
+}
+
+void SoftHDRenderer::RenderFrame(GPU& gpu)
+{
+    FinishFrame();
+    SoftRenderer::RenderFrame(gpu);
+
+    if (TexturesChanged)
+    {
+        Textures.clear();
+        ReplByTexParam.clear();
+        NoReplByTexParam.clear();
+    }
+
+    if (FrameIdentical && HaveFrame)
+        return;
+
+    // edge marking and antialiasing depend on the exact native rasterization,
+    // showing the native frame is closer than leaving them out
+    bool fallback = gpu.GPU3D.RenderDispCnt & ((1<<4) | (1<<5));
+    if (fallback != NativeFallback)
+    {
+        NativeFallback = fallback;
+        if (fallback)
+            Log(LogLevel::Warn, "SoftHD: edge marking/antialiasing enabled, scaling up the native frame\n");
+        else
+            Log(LogLevel::Info, "SoftHD: back to rendering upscaled\n");
+    }
+    if (fallback)
+    {
+        if (IsRenderThreadRunning())
+            UpscalePending = true;
+        else
+            UpscaleNativeFrame();
+        return;
+    }
+
+    SetupFrame(gpu);
+
+    for (int tile = 0; tile < TilesX * TilesY; tile++)
+        TileJobs.Run([this, tile]() { RenderTile(tile); });
+    FrameInFlight = true;
+}
+
+void SoftHDRenderer::FinishFrame()
+{
+    if (!FrameInFlight)
+        return;
+
+    TileJobs.Wait();
+
+    FrontBuffer ^= 1;
+    FrameInFlight = false;
+    HaveFrame = true;
+}
+
+const u32* SoftHDRenderer::GetFramebuffer()
+{
+    FinishFrame();
+    return ColorBuffers[FrontBuffer].data();
+}
+
+void SoftHDRenderer::UpscaleNativeFrame()
+{
+    u32* colorBuffer = ColorBuffers[FrontBuffer ^ 1].data();
+
+    for (int y = 0; y < Height; y++)
+    {
+        const u32* src = GetNativeLine(y / Scale);
+        u32* dst = &colorBuffer[y * Width];
+        for (int x = 0; x < Width; x++)
+            dst[x] = src[x / Scale];
+    }
+
+    FrontBuffer ^= 1;
+    HaveFrame = true;
+}
+
+void SoftHDRenderer::SetupFrame(GPU& gpu)
+{
+    const GPU3D& gpu3d = gpu.GPU3D;
+
+    Frame.DispCnt = gpu3d.RenderDispCnt;
+    Frame.AlphaRef = gpu3d.RenderAlphaRef;
+    memcpy(Frame.ToonTable, gpu3d.RenderToonTable, sizeof(Frame.ToonTable));
+
+    Frame.FogColor = gpu3d.RenderFogColor;
+    Frame.FogOffset = gpu3d.RenderFogOffset;
+    Frame.FogShift = gpu3d.RenderFogShift;
+    memcpy(Frame.FogDensityTable, gpu3d.RenderFogDensityTable, sizeof(Frame.FogDensityTable));
+
+    Frame.ClearDepth = ((gpu3d.RenderClearAttr2 & 0x7FFF) * 0x200) + 0x1FF;
+    Frame.ClearAttr = gpu3d.RenderClearAttr1 & 0x3F008000; // opaque polygon ID and fog flag
+    Frame.ClearColor = ConvertRGB5ToRGB6A5(gpu3d.RenderClearAttr1, (gpu3d.RenderClearAttr1 >> 16) & 0x1F);
+    Frame.ClearBitmap = gpu3d.RenderDispCnt & (1<<14);
+
+    if (Frame.ClearBitmap)
+    {
+        // the rear-plane bitmap is read at native resolution and scaled up by the tiles
+        ClearColorBitmap.resize(256 * 192);
+        ClearDepthBitmap.resize(256 * 192);
+        ClearAttrBitmap.resize(256 * 192);
+
+        u8 yoff = (gpu3d.RenderClearAttr2 >> 24) & 0xFF;
+        for (int y = 0; y < 192; y++, yoff++)
+        {
+            u8 xoff = (gpu3d.RenderClearAttr2 >> 16) & 0xFF;
+            for (int x = 0; x < 256; x++, xoff++)
+            {
+                u16 val2 = gpu.ReadVRAMFlat_Texture<u16>(0x40000 + (yoff << 9) + (xoff << 1));
+                u16 val3 = gpu.ReadVRAMFlat_Texture<u16>(0x60000 + (yoff << 9) + (xoff << 1));
+
+                ClearColorBitmap[y*256 + x] = ConvertRGB5ToRGB6A5(val2, (val2 & 0x8000) ? 0x1F : 0);
+                ClearDepthBitmap[y*256 + x] = ((val3 & 0x7FFF) * 0x200) + 0x1FF;
+                ClearAttrBitmap[y*256 + x] = (Frame.ClearAttr & 0x3F000000) | (val3 & 0x8000);
+            }
+        }
+    }
+
+    HiresScratch.Reset();
+
+    Polygons.clear();
+    Triangles.clear();
+    for (auto& bin : TileBins)
+        bin.clear();
+
+    for (u32 i = 0; i < gpu3d.RenderNumPolygons; i++)
+    {
+        const Polygon* polygon = gpu3d.RenderPolygonRAM[i];
+
+        if (polygon->Degenerate)
+            continue;
+
+        PolygonState poly {};
+        poly.Attr = polygon->Attr;
+        poly.TexParam = polygon->TexParam;
+        poly.PolyAttr = polygon->Attr & 0x3F008000;
+        if (!polygon->FacingView) poly.PolyAttr |= (1<<4);
+        poly.WBuffer = polygon->WBuffer;
+        poly.Wireframe = ((polygon->Attr >> 16) & 0x1F) == 0;
+        poly.ShadowMask = polygon->IsShadowMask;
+        poly.Shadow = polygon->IsShadow;
+
+        // shadow masks only touch the stencil buffer
+        if (!poly.ShadowMask && (Frame.DispCnt & (1<<0)) && (((polygon->TexParam >> 26) & 0x7) != 0))
+        {
+            poly.Tex = GetTexture(gpu, polygon->TexParam, polygon->TexPalette);
+            poly.TexWidth = TextureWidth(polygon->TexParam);
+            poly.TexHeight = TextureHeight(polygon->TexParam);
+            poly.TexScale = poly.Tex->Width / poly.TexWidth;
+        }
+
+        Polygons.push_back(poly);
+        u32 polyIndex = Polygons.size() - 1;
+
+        if (polygon->Type == 1 || poly.Wireframe)
+        {
+            // only the edges are drawn
+            for (u32 j = 0; j < polygon->NumVertices; j++)
+                SetupLine(polygon, j, (j + 1) % polygon->NumVertices, polyIndex);
+        }
+        else
+        {
+            SetupVertex v0 = GetSetupVertex(polygon, 0);
+            for (u32 j = 1; j + 1 < polygon->NumVertices; j++)
+                SetupTriangle(v0, GetSetupVertex(polygon, j), GetSetupVertex(polygon, j + 1), polyIndex);
+        }
+    }
+
+    // bin the triangles, keeping them in drawing order within each tile
+    for (u32 i = 0; i < Triangles.size(); i++)
+    {
+        const Triangle& tri = Triangles[i];
+        for (int ty = tri.MinY / TileSize; ty <= tri.MaxY / TileSize; ty++)
+        {
+            for (int tx = tri.MinX / TileSize; tx <= tri.MaxX / TileSize; tx++)
+                TileBins[ty * TilesX + tx].push_back(i);
+        }
+    }
+}
+
+SoftHDRenderer::SetupVertex SoftHDRenderer::GetSetupVertex(const Polygon* polygon, int v) const
+{
+    const Vertex* vtx = polygon->Vertices[v];
+
+    SetupVertex ret;
+    ret.X = vtx->HiresPosition[0] * Scale;
+    ret.Y = vtx->HiresPosition[1] * Scale;
+    ret.W = polygon->FinalW[v];
+    ret.Depth = polygon->WBuffer ? polygon->FinalW[v] : polygon->FinalZ[v];
+    for (int k = 0; k < 3; k++)
+        ret.Color[k] = vtx->FinalColor[k];
+    ret.TexCoords[0] = vtx->TexCoords[0];
+    ret.TexCoords[1] = vtx->TexCoords[1];
+    return ret;
+}
+
+void SoftHDRenderer::SetupLine(const Polygon* polygon, int v0, int v1, u32 polyIndex)
+{
+    SetupVertex a = GetSetupVertex(polygon, v0);
+    SetupVertex b = GetSetupVertex(polygon, v1);
+
+    // the line is drawn as a quad one native pixel wide, along its minor axis,
+    // and extended by one native pixel to cover the pixel of its last vertex
+    const s32 width = 16 * Scale;
+    SetupVertex quad[4];
+    if (std::abs(b.X - a.X) >= std::abs(b.Y - a.Y))
+    {
+        if (b.X < a.X) std::swap(a, b);
+        b.X += width;
+        quad[0] = a; quad[1] = b; quad[2] = b; quad[3] = a;
+        quad[2].Y += width;
+        quad[3].Y += width;
+    }
+    else
+    {
+        if (b.Y < a.Y) std::swap(a, b);
+        b.Y += width;
+        quad[0] = a; quad[1] = b; quad[2] = b; quad[3] = a;
+        quad[2].X += width;
+        quad[3].X += width;
+    }
+
+    SetupTriangle(quad[0], quad[1], quad[2], polyIndex);
+    SetupTriangle(quad[0], quad[2], quad[3], polyIndex);
+}
+
+void SoftHDRenderer::SetupTriangle(const SetupVertex& v0, const SetupVertex& v1, const SetupVertex& v2, u32 polyIndex)
+{
+    const SetupVertex* vtx[3] = {&v0, &v1, &v2};
+    Triangle tri;
+
+    for (int k = 0; k < 3; k++)
+    {
+        tri.X[k] = vtx[k]->X;
+        tri.Y[k] = vtx[k]->Y;
+    }
+
+    s64 area = (s64)(tri.X[1] - tri.X[0]) * (tri.Y[2] - tri.Y[0])
+             - (s64)(tri.Y[1] - tri.Y[0]) * (tri.X[2] - tri.X[0]);
+    if (area == 0)
+        return;
+    if (area < 0)
+    {
+        std::swap(vtx[1], vtx[2]);
+        std::swap(tri.X[1], tri.X[2]);
+        std::swap(tri.Y[1], tri.Y[2]);
+        area = -area;
+    }
+
+    // edge k is the one opposite to vertex k, positive on the inside
+    for (int k = 0; k < 3; k++)
+    {
+        int a = (k + 1) % 3, b = (k + 2) % 3;
+        tri.EdgeA[k] = -(s64)(tri.Y[b] - tri.Y[a]);
+        tri.EdgeB[k] = (s64)(tri.X[b] - tri.X[a]);
+        tri.EdgeC[k] = -(tri.EdgeA[k] * tri.X[a] + tri.EdgeB[k] * tri.Y[a]);
+
+        // top-left rule: of two triangles sharing an edge, pixels exactly on it go to one only
+        bool topLeft = tri.EdgeA[k] > 0 || (tri.EdgeA[k] == 0 && tri.EdgeB[k] > 0);
+        tri.EdgeBias[k] = topLeft ? 0 : -1;
+    }
+
+    // pixel centers are at 8/16
+    s32 minX = std::min({tri.X[0], tri.X[1], tri.X[2]});
+    s32 maxX = std::max({tri.X[0], tri.X[1], tri.X[2]});
+    s32 minY = std::min({tri.Y[0], tri.Y[1], tri.Y[2]});
+    s32 maxY = std::max({tri.Y[0], tri.Y[1], tri.Y[2]});
+    tri.MinX = std::max<s32>((s32)FloorDiv(minX + 7, 16), 0);
+    tri.MaxX = std::min<s32>((s32)FloorDiv(maxX - 8, 16), Width - 1);
+    tri.MinY = std::max<s32>((s32)FloorDiv(minY + 7, 16), 0);
+    tri.MaxY = std::min<s32>((s32)FloorDiv(maxY - 8, 16), Height - 1);
+    if (tri.MinX > tri.MaxX || tri.MinY > tri.MaxY)
+        return;
+
+    tri.InvArea = 1.0f / (float)area;
+    for (int k = 0; k < 3; k++)
+    {
+        float invw = 1.0f / (float)std::max(vtx[k]->W, 1);
+
+        tri.InvW[k] = invw;
+        tri.Depth[k] = (float)vtx[k]->Depth;
+        tri.R[k] = vtx[k]->Color[0] * invw;
+        tri.G[k] = vtx[k]->Color[1] * invw;
+        tri.B[k] = vtx[k]->Color[2] * invw;
+        tri.S[k] = vtx[k]->TexCoords[0] * invw;
+        tri.T[k] = vtx[k]->TexCoords[1] * invw;
+    }
+    tri.Polygon = polyIndex;
+
+    Triangles.push_back(tri);
+}
+
+const SoftHDRenderer::Texture* SoftHDRenderer::GetTexture(GPU& gpu, u32 texParam, u32 texPalette)
+{
+    u32 fmt = (texParam >> 26) & 0x7;
+    u64 key = texParam & ~0xC00F0000;
+    if (fmt != 7)
+    {
+        key |= (u64)texPalette << 32;
+        if (fmt == 5)
+            key &= ~((u64)1 << 29);
+    }
+
+    u32 width = TextureWidth(texParam);
+    u32 height = TextureHeight(texParam);
+
+#ifdef OGLRENDERER_ENABLED
+    if (hires::DumpEnabled() || hires::ReplaceEnabled())
+    {
+        auto itRepl = ReplByTexParam.find(key);
+        if (itRepl != ReplByTexParam.end())
+            return itRepl->second;
+
+        if (NoReplByTexParam.find(key) == NoReplByTexParam.end())
+        {
+            std::string replFile;
+            const Texture* repl = nullptr;
+            if (LookupHiresReplacement(gpu, texParam, texPalette, true, HiresScratch, HiresRepl, replFile)
+                && (HiresRepl.width % width) == 0 && (HiresRepl.height % height) == 0
+                && (HiresRepl.width / width) == (HiresRepl.height / height))
+            {
+                auto itFile = ReplTextures.find(replFile);
+                if (itFile == ReplTextures.end())
+                {
+                    const std::vector<u8>& rgba = hires::ReplacementRGBA(HiresRepl, HiresReplRGBA);
+
+                    auto tex = std::make_unique<Texture>();
+                    tex->Width = HiresRepl.width;
+                    tex->Height = HiresRepl.height;
+                    tex->Texels.resize((size_t)tex->Width * tex->Height);
+                    for (size_t i = 0; i < tex->Texels.size(); i++)
+                    {
+                        u32 r = (rgba[i*4+0] * 63 + 127) / 255;
+                        u32 g = (rgba[i*4+1] * 63 + 127) / 255;
+                        u32 b = (rgba[i*4+2] * 63 + 127) / 255;
+                        u32 a = (rgba[i*4+3] * 31 + 127) / 255;
+                        tex->Texels[i] = r | (g << 8) | (b << 16) | (a << 24);
+                    }
+
+                    itFile = ReplTextures.emplace(replFile, std::move(tex)).first;
+                }
+                repl = itFile->second.get();
+            }
+
+            if (repl)
+            {
+                ReplByTexParam[key] = repl;
+                return repl;
+            }
+            NoReplByTexParam.insert(key);
+        }
+    }
+#endif
+
+    auto it = Textures.find(key);
+    if (it != Textures.end())
+        return it->second.get();
+
+    auto tex = std::make_unique<Texture>();
+    tex->Width = width;
+    tex->Height = height;
+    tex->Texels.resize(width * height);
+
+    u32 addr = (texParam & 0xFFFF) * 8;
+    u32* out = tex->Texels.data();
+
+    if (fmt == 7)
+        ConvertBitmapTexture<outputFmt_RGB6A5>(width, height, out, addr, gpu);
+    else if (fmt == 5)
+    {
+        u32 slot1addr = 0x20000 + ((addr & 0x1FFFC) >> 1);
+        if (addr >= 0x40000)
+            slot1addr += 0x10000;
+
+        ConvertCompressedTexture<outputFmt_RGB6A5>(width, height, out, addr, slot1addr, texPalette*16, gpu);
+    }
+    else
+    {
+        u32 palAddr = texPalette*16;
+        if (fmt == 2)
+            palAddr >>= 1;
+        bool color0Transparent = texParam & (1<<29);
+
+        switch (fmt)
+        {
+        case 1: ConvertAXIYTexture<outputFmt_RGB6A5, 3, 5>(width, height, out, addr, palAddr, gpu); break;
+        case 6: ConvertAXIYTexture<outputFmt_RGB6A5, 5, 3>(width, height, out, addr, palAddr, gpu); break;
+        case 2: ConvertNColorsTexture<outputFmt_RGB6A5, 2>(width, height, out, addr, palAddr, color0Transparent, gpu); break;
+        case 3: ConvertNColorsTexture<outputFmt_RGB6A5, 4>(width, height, out, addr, palAddr, color0Transparent, gpu); break;
+        case 4: ConvertNColorsTexture<outputFmt_RGB6A5, 8>(width, height, out, addr, palAddr, color0Transparent, gpu); break;
+        }
+    }
+
+    const Texture* ret = tex.get();
+    Textures.emplace(key, std::move(tex));
+    return ret;
+}
+
+void SoftHDRenderer::RenderTile(int tile)
+{
+    int x0 = (tile % TilesX) * TileSize;
+    int y0 = (tile / TilesX) * TileSize;
+    int x1 = x0 + TileSize - 1;
+    int y1 = y0 + TileSize - 1;
+
+    u32* colorBuffer = ColorBuffers[FrontBuffer ^ 1].data();
+
+    for (int y = y0; y <= y1; y++)
+    {
+        u32 pixel = y * Width + x0;
+        if (Frame.ClearBitmap)
+        {
+            const u32* srcColor = &ClearColorBitmap[(y / Scale) * 256];
+            const u32* srcDepth = &ClearDepthBitmap[(y / Scale) * 256];
+            const u32* srcAttr = &ClearAttrBitmap[(y / Scale) * 256];
+            for (int x = x0; x <= x1; x++, pixel++)
+            {
+                colorBuffer[pixel] = srcColor[x / Scale];
+                DepthBuffer[pixel] = srcDepth[x / Scale];
+                AttrBuffer[pixel] = srcAttr[x / Scale];
+            }
+        }
+        else
+        {
+            std::fill_n(&colorBuffer[pixel], TileSize, Frame.ClearColor);
+            std::fill_n(&DepthBuffer[pixel], TileSize, Frame.ClearDepth);
+            std::fill_n(&AttrBuffer[pixel], TileSize, Frame.ClearAttr);
+        }
+    }
+
+    // set by shadow masks where they're hidden, cleared by the first mask after other polygons
+    u8 stencil[TileSize * TileSize] {};
+    bool prevShadowMask = false;
+
+    for (u32 t : TileBins[tile])
+    {
+        const Triangle& tri = Triangles[t];
+        bool shadowMask = Polygons[tri.Polygon].ShadowMask;
+        if (shadowMask && !prevShadowMask)
+            memset(stencil, 0, sizeof(stencil));
+        prevShadowMask = shadowMask;
+
+        RasterizeTriangle(tri, x0, y0, x1, y1, stencil);
+    }
+
+    if (Frame.DispCnt & (1<<7))
+        ApplyFog(x0, y0, x1, y1);
+}
+
+u32 SoftHDRenderer::FogDensity(u32 z) const
+{
+    u32 densityid, densityfrac;
+
+    if (z < Frame.FogOffset)
+    {
+        densityid = 0;
+        densityfrac = 0;
+    }
+    else
+    {
+        // same as SoftRenderer::CalculateFogDensity(), including the wraparound with big shifts
+        z -= Frame.FogOffset;
+        z = (z >> 2) << Frame.FogShift;
+
+        densityid = z >> 17;
+        if (densityid >= 32)
+        {
+            densityid = 32;
+            densityfrac = 0;
+        }
+        else
+            densityfrac = z & 0x1FFFF;
+    }
+
+    u32 density =
+        ((Frame.FogDensityTable[densityid] * (0x20000-densityfrac)) +
+         (Frame.FogDensityTable[densityid+1] * densityfrac)) >> 17;
+    if (density >= 127) density = 128;
+
+    return density;
+}
+
+void SoftHDRenderer::ApplyFog(int tx0, int ty0, int tx1, int ty1)
+{
+    u32* colorBuffer = ColorBuffers[FrontBuffer ^ 1].data();
+
+    bool fogcolor = !(Frame.DispCnt & (1<<6));
+    u32 fogR = (Frame.FogColor << 1) & 0x3E; if (fogR) fogR++;
+    u32 fogG = (Frame.FogColor >> 4) & 0x3E; if (fogG) fogG++;
+    u32 fogB = (Frame.FogColor >> 9) & 0x3E; if (fogB) fogB++;
+    u32 fogA = (Frame.FogColor >> 16) & 0x1F;
+
+    for (int y = ty0; y <= ty1; y++)
+    {
+        u32 pixel = y * Width + tx0;
+        for (int x = tx0; x <= tx1; x++, pixel++)
+        {
+            if (!(AttrBuffer[pixel] & (1<<15)))
+                continue;
+
+            u32 density = FogDensity(DepthBuffer[pixel]);
+
+            u32 color = colorBuffer[pixel];
+            u32 r = color & 0x3F;
+            u32 g = (color >> 8) & 0x3F;
+            u32 b = (color >> 16) & 0x3F;
+            u32 a = (color >> 24) & 0x1F;
+
+            if (fogcolor)
+            {
+                r = ((fogR * density) + (r * (128-density))) >> 7;
+                g = ((fogG * density) + (g * (128-density))) >> 7;
+                b = ((fogB * density) + (b * (128-density))) >> 7;
+            }
+            a = ((fogA * density) + (a * (128-density))) >> 7;
+
+            colorBuffer[pixel] = r | (g << 8) | (b << 16) | (a << 24);
+        }
+    }
+}
+
+void SoftHDRenderer::RasterizeTriangle(const Triangle& tri, int tx0, int ty0, int tx1, int ty1, u8* stencil)
+{
+    const PolygonState& poly = Polygons[tri.Polygon];
+
+    // shadow masks are alpha tested as a whole
+    if (poly.ShadowMask && !poly.Wireframe && ((poly.Attr >> 16) & 0x1F) <= Frame.AlphaRef)
+        return;
+    u32* colorBuffer = ColorBuffers[FrontBuffer ^ 1].data();
+
+    int xs = std::max(tx0, tri.MinX), xe = std::min(tx1, tri.MaxX);
+    int ys = std::max(ty0, tri.MinY), ye = std::min(ty1, tri.MaxY);
+    if (xs > xe || ys > ye)
+        return;
+
+    int depthTest;
+    if (poly.Attr & (1<<14))
+        depthTest = poly.WBuffer ? DepthTest_Equal_W : DepthTest_Equal_Z;
+    else if (!(poly.PolyAttr & (1<<4)))
+        depthTest = DepthTest_LessThan_FrontFacing;
+    else
+        depthTest = DepthTest_LessThan;
+
+    const bool wbuffer = poly.WBuffer;
+    alignas(32) float spanZ[TileSize], spanR[TileSize], spanG[TileSize], spanB[TileSize];
+    alignas(32) float spanS[TileSize], spanT[TileSize];
+
+    for (int y = ys; y <= ye; y++)
+    {
+        // solve for the pixels of the row inside all three edges
+        s64 py = y * 16 + 8;
+        s64 px = xs * 16 + 8;
+        int lo = xs, hi = xe;
+        s64 e[3];
+        for (int k = 0; k < 3; k++)
+        {
+            e[k] = tri.EdgeA[k] * px + tri.EdgeB[k] * py + tri.EdgeC[k];
+
+            s64 val = e[k] + tri.EdgeBias[k];
+            s64 step = tri.EdgeA[k] * 16;
+            if (step > 0)
+            {
+                if (val < 0)
+                    lo = (int)std::max<s64>(lo, xs + (-val + step - 1) / step);
+            }
+            else if (step < 0)
+            {
+                if (val < 0)
+                    hi = xs - 1;
+                else
+                    hi = (int)std::min<s64>(hi, xs + val / -step);
+            }
+            else if (val < 0)
+                hi = xs - 1;
+        }
+        if (lo > hi)
+            continue;
+
+        const int n = hi - lo + 1;
+        float b0 = (float)(e[0] + tri.EdgeA[0] * 16 * (lo - xs)) * tri.InvArea;
+        float b1 = (float)(e[1] + tri.EdgeA[1] * 16 * (lo - xs)) * tri.InvArea;
+        float b2 = (float)(e[2] + tri.EdgeA[2] * 16 * (lo - xs)) * tri.InvArea;
+        const float db0 = (float)(tri.EdgeA[0] * 16) * tri.InvArea;
+        const float db1 = (float)(tri.EdgeA[1] * 16) * tri.InvArea;
+        const float db2 = (float)(tri.EdgeA[2] * 16) * tri.InvArea;
+
+        for (int i = 0; i < n; i++)
+        {
+            float fi = (float)i;
+            float w0 = b0 + db0 * fi;
+            float w1 = b1 + db1 * fi;
+            float w2 = b2 + db2 * fi;
+
+            float invw = w0 * tri.InvW[0] + w1 * tri.InvW[1] + w2 * tri.InvW[2];
+            float w = 1.0f / invw;
+            float z = w0 * tri.Depth[0] + w1 * tri.Depth[1] + w2 * tri.Depth[2];
+
+            spanZ[i] = wbuffer ? w : z;
+            spanR[i] = (w0 * tri.R[0] + w1 * tri.R[1] + w2 * tri.R[2]) * w;
+            spanG[i] = (w0 * tri.G[0] + w1 * tri.G[1] + w2 * tri.G[2]) * w;
+            spanB[i] = (w0 * tri.B[0] + w1 * tri.B[1] + w2 * tri.B[2]) * w;
+            spanS[i] = (w0 * tri.S[0] + w1 * tri.S[1] + w2 * tri.S[2]) * w;
+            spanT[i] = (w0 * tri.T[0] + w1 * tri.T[1] + w2 * tri.T[2]) * w;
+        }
+
+        u32 pixel = y * Width + lo;
+        u8* stencilRow = &stencil[(y - ty0) * TileSize + (lo - tx0)];
+        for (int i = 0; i < n; i++, pixel++)
+        {
+            s32 z = (s32)std::clamp(spanZ[i], 0.0f, 16777215.0f);
+            u32 dstattr = AttrBuffer[pixel];
+
+            if (poly.ShadowMask)
+            {
+                // draws nothing, marks where the mask is hidden
+                if (!DepthTest(depthTest, DepthBuffer[pixel], z, dstattr))
+                    stencilRow[i] = 1;
+                continue;
+            }
+            if (poly.Shadow && !stencilRow[i])
+                continue;
+
+            if (!DepthTest(depthTest, DepthBuffer[pixel], z, dstattr))
+                continue;
+
+            u32 vr = (u32)std::clamp(spanR[i], 0.0f, 511.0f) >> 3;
+            u32 vg = (u32)std::clamp(spanG[i], 0.0f, 511.0f) >> 3;
+            u32 vb = (u32)std::clamp(spanB[i], 0.0f, 511.0f) >> 3;
+            s32 s = (s32)floorf(spanS[i]);
+            s32 t = (s32)floorf(spanT[i]);
+
+            u32 color = ShadePixel(poly, vr, vg, vb, s, t);
+            u32 alpha = color >> 24;
+
+            // alpha test
+            if (alpha <= Frame.AlphaRef) continue;
+
+            if (alpha == 31)
+            {
+                DepthBuffer[pixel] = z;
+                colorBuffer[pixel] = color;
+                AttrBuffer[pixel] = poly.PolyAttr;
+                continue;
+            }
+
+            u32 attr = (poly.PolyAttr & 0xE0F0) | ((poly.PolyAttr >> 8) & 0xFF0000) | (1<<22) | (dstattr & 0xFF001F0F);
+
+            if (poly.Shadow && !(dstattr & (1<<22)))
+            {
+                // for shadows, opaque pixels are also checked
+                if ((dstattr & 0x3F000000) == (poly.PolyAttr & 0x3F000000))
+                    continue;
+            }
+            else if ((dstattr & 0x007F0000) == (attr & 0x007F0000))
+            {
+                // skip if translucent polygon IDs are equal
+                continue;
+            }
+
+            // fog flag
+            if (!(dstattr & (1<<15)))
+                attr &= ~(1<<15);
+
+            u32 dstcolor = colorBuffer[pixel];
+            u32 dstalpha = dstcolor >> 24;
+            if (dstalpha != 0)
+            {
+                if (Frame.DispCnt & (1<<3))
+                {
+                    u32 r = (((color & 0x3F) * (alpha+1)) + ((dstcolor & 0x3F) * (31-alpha))) >> 5;
+                    u32 g = ((((color >> 8) & 0x3F) * (alpha+1)) + (((dstcolor >> 8) & 0x3F) * (31-alpha))) >> 5;
+                    u32 b = ((((color >> 16) & 0x3F) * (alpha+1)) + (((dstcolor >> 16) & 0x3F) * (31-alpha))) >> 5;
+                    color = r | (g << 8) | (b << 16);
+                }
+                else
+                    color &= 0x3F3F3F;
+
+                color |= std::max(alpha, dstalpha) << 24;
+            }
+
+            if (poly.Attr & (1<<11))
+                DepthBuffer[pixel] = z;
+            colorBuffer[pixel] = color;
+            AttrBuffer[pixel] = attr;
+        }
+    }
+}
+
+u32 SoftHDRenderer::ShadePixel(const PolygonState& poly, u32 vr, u32 vg, u32 vb, s32 s, s32 t) const
+{
+    u32 r, g, b, a;
+
+    u32 blendmode = (poly.Attr >> 4) & 0x3;
+    u32 polyalpha = (poly.Attr >> 16) & 0x1F;
+
+    if (blendmode == 2)
+    {
+        if (Frame.DispCnt & (1<<1))
+        {
+            // highlight mode
+            vg = vr;
+            vb = vr;
+        }
+        else
+        {
+            // toon mode
+            u16 tooncolor = Frame.ToonTable[vr >> 1];
+
+            vr = (tooncolor << 1) & 0x3E; if (vr) vr++;
+            vg = (tooncolor >> 4) & 0x3E; if (vg) vg++;
+            vb = (tooncolor >> 9) & 0x3E; if (vb) vb++;
+        }
+    }
+
+    if (poly.Tex)
+    {
+        // texture wrapping, done in 1/16 texel units so it also works for upscaled replacements
+        s32 width = poly.TexWidth << 4;
+        s32 height = poly.TexHeight << 4;
+
+        if (poly.TexParam & (1<<16))
+        {
+            if ((poly.TexParam & (1<<18)) && (s & width))
+                s = (width-1) - (s & (width-1));
+            else
+                s &= width-1;
+        }
+        else
+            s = std::clamp(s, 0, width-1);
+
+        if (poly.TexParam & (1<<17))
+        {
+            if ((poly.TexParam & (1<<19)) && (t & height))
+                t = (height-1) - (t & (height-1));
+            else
+                t &= height-1;
+        }
+        else
+            t = std::clamp(t, 0, height-1);
+
+        u32 texel = poly.Tex->Texels[((t * poly.TexScale) >> 4) * poly.Tex->Width + ((s * poly.TexScale) >> 4)];
+        u32 tr = texel & 0x3F;
+        u32 tg = (texel >> 8) & 0x3F;
+        u32 tb = (texel >> 16) & 0x3F;
+        u32 talpha = texel >> 24;
+
+        if (blendmode & 0x1)
+        {
+            // decal
+            if (talpha == 0)
+            {
+                r = vr;
+                g = vg;
+                b = vb;
+            }
+            else if (talpha == 31)
+            {
+                r = tr;
+                g = tg;
+                b = tb;
+            }
+            else
+            {
+                r = ((tr * talpha) + (vr * (31-talpha))) >> 5;
+                g = ((tg * talpha) + (vg * (31-talpha))) >> 5;
+                b = ((tb * talpha) + (vb * (31-talpha))) >> 5;
+            }
+            a = polyalpha;
+        }
+        else
+        {
+            // modulate
+            r = ((tr+1) * (vr+1) - 1) >> 6;
+            g = ((tg+1) * (vg+1) - 1) >> 6;
+            b = ((tb+1) * (vb+1) - 1) >> 6;
+            a = ((talpha+1) * (polyalpha+1) - 1) >> 5;
+        }
+    }
+    else
+    {
+        r = vr;
+        g = vg;
+        b = vb;
+        a = polyalpha;
+    }
+
+    // checkme: can wireframe polygons use texture alpha?
+    if (poly.Wireframe) a = 31;
+
+    if ((blendmode == 2) && (Frame.DispCnt & (1<<1)))
+    {
+        u16 tooncolor = Frame.ToonTable[vr >> 1];
+
+        r += ((tooncolor << 1) & 0x3E) + (((tooncolor << 1) & 0x3E) ? 1 : 0);
+        g += ((tooncolor >> 4) & 0x3E) + (((tooncolor >> 4) & 0x3E) ? 1 : 0);
+        b += ((tooncolor >> 9) & 0x3E) + (((tooncolor >> 9) & 0x3E) ? 1 : 0);
+
+        r = std::min(r, 63u);
+        g = std::min(g, 63u);
+        b = std::min(b, 63u);
+    }
+
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+}
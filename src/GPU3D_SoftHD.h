@@ -0,0 +1,181 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#pragma once
+
+#include "GPU3D_Soft.h"
+#include "GPU3D_Texcache.h"
+#include "JobSystem.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace melonDS
+{
+
+/// Software renderer that additionally rasterizes each 3D frame at an integer multiple
+/// of the native resolution, for frontends without a GPU (e.g. headless upscaled capture).
+///
+/// The native output returned by GetLine(), which the 2D engines and display capture use,
+/// still comes from the SoftRenderer this extends, so it stays exact.
+/// The upscaled frame is rendered asynchronously between RenderFrame() and the next VCount144():
+/// polygons are binned into screen tiles, and every tile is a job of the JobSystem,
+/// so the workers never touch the same pixels.
+///
+/// The upscaled frame supports texturing (including hi-res replacement textures), all blending modes,
+/// depth test, alpha test and alpha blending, the rear-plane bitmap, shadows, fog,
+/// and wireframe and line polygons, whose edges are drawn one native pixel wide.
+/// Edge marking and antialiasing aren't supported: while they're enabled,
+/// the upscaled frame is the native frame scaled up instead.
+class SoftHDRenderer : public SoftRenderer
+{
+public:
+    static constexpr int MaxScale = 8;
+    static constexpr int TileSize = 32;
+
+    /// @param scale Resolution multiplier, from 1 to MaxScale.
+    /// @param numThreads Number of worker threads of a pool of its own, 0 uses the shared JobSystem.
+    explicit SoftHDRenderer(int scale = 2, int numThreads = 0) noexcept;
+    ~SoftHDRenderer() override;
+
+    void Reset(GPU& gpu) override;
+    void VCount144(GPU& gpu) override;
+    void Stop(const GPU& gpu) override;
+    void RenderFrame(GPU& gpu) override;
+
+    /// Waits for the frame being rendered by the worker threads, if there is one.
+    void FinishFrame();
+
+    [[nodiscard]] int GetScale() const noexcept { return Scale; }
+    [[nodiscard]] int GetWidth() const noexcept { return Width; }
+    [[nodiscard]] int GetHeight() const noexcept { return Height; }
+    [[nodiscard]] int GetNumThreads() const noexcept { return Jobs.GetNumWorkers(); }
+
+    /// Returns the last completed upscaled frame, GetWidth()*GetHeight() pixels
+    /// in the same 6-bit RGB and 5-bit alpha format as GetLine().
+    const u32* GetFramebuffer();
+
+private:
+    struct Texture
+    {
+        u32 Width, Height;
+        std::vector<u32> Texels; // RGB6A5
+    };
+
+    struct PolygonState
+    {
+        u32 Attr;
+        u32 TexParam;
+        u32 PolyAttr; // opaque polygon ID and facing, as in the attribute buffer
+        const Texture* Tex; // null if untextured
+        s32 TexWidth, TexHeight; // of the DS texture
+        u32 TexScale; // Tex->Width / TexWidth
+        bool WBuffer;
+        bool Wireframe;
+        bool ShadowMask;
+        bool Shadow;
+    };
+
+    struct SetupVertex
+    {
+        s32 X, Y; // 1/16 pixel units
+        s32 W, Depth;
+        s32 Color[3];
+        s16 TexCoords[2];
+    };
+
+    struct Triangle
+    {
+        s32 X[3], Y[3]; // 1/16 pixel units
+        s64 EdgeA[3], EdgeB[3], EdgeC[3];
+        s32 EdgeBias[3];
+        float InvArea;
+        float InvW[3];
+        float Depth[3];
+        float R[3], G[3], B[3], S[3], T[3]; // premultiplied by InvW
+        s32 MinX, MinY, MaxX, MaxY; // pixels, inclusive
+        u32 Polygon;
+    };
+
+    struct FrameState
+    {
+        u32 DispCnt;
+        u8 AlphaRef;
+        u16 ToonTable[32];
+        u32 ClearColor, ClearDepth, ClearAttr;
+        bool ClearBitmap;
+        u32 FogColor, FogOffset, FogShift;
+        u8 FogDensityTable[34];
+    };
+
+    void RenderTile(int tile);
+    void RasterizeTriangle(const Triangle& tri, int tx0, int ty0, int tx1, int ty1, u8* stencil);
+    u32 ShadePixel(const PolygonState& poly, u32 vr, u32 vg, u32 vb, s32 s, s32 t) const;
+    void ApplyFog(int tx0, int ty0, int tx1, int ty1);
+    u32 FogDensity(u32 z) const;
+
+    void SetupFrame(GPU& gpu);
+    const Texture* GetTexture(GPU& gpu, u32 texParam, u32 texPalette);
+    SetupVertex GetSetupVertex(const Polygon* polygon, int v) const;
+    void SetupTriangle(const SetupVertex& v0, const SetupVertex& v1, const SetupVertex& v2, u32 polyIndex);
+    void SetupLine(const Polygon* polygon, int v0, int v1, u32 polyIndex);
+    void UpscaleNativeFrame();
+
+    int Scale;
+    int Width, Height;
+    int TilesX, TilesY;
+
+    std::vector<u32> ColorBuffers[2];
+    std::vector<u32> DepthBuffer;
+    std::vector<u32> AttrBuffer;
+    int FrontBuffer = 0;
+
+    FrameState Frame {};
+    std::vector<u32> ClearColorBitmap, ClearDepthBitmap, ClearAttrBitmap; // native rear-plane bitmap
+    std::vector<PolygonState> Polygons;
+    std::vector<Triangle> Triangles;
+    std::vector<std::vector<u32>> TileBins;
+
+    // decoded DS textures, dropped whenever texture VRAM changes
+    std::unordered_map<u64, std::unique_ptr<Texture>> Textures;
+
+    // hi-res replacements, shared by all textures using the same file
+    std::unordered_map<std::string, std::unique_ptr<Texture>> ReplTextures;
+    std::unordered_map<u64, const Texture*> ReplByTexParam;
+    std::unordered_set<u64> NoReplByTexParam;
+    TexScratchArena HiresScratch;
+    hires::ReplacementImage HiresRepl;
+    std::vector<u8> HiresReplRGBA;
+
+    std::unique_ptr<JobSystem> OwnJobs;
+    JobSystem& Jobs;
+    TaskGroup TileJobs;
+    bool FrameInFlight = false;
+    bool HaveFrame = false;
+
+    // the frame uses features the upscaled renderer doesn't support
+    bool NativeFallback = false;
+    // with a render thread, the native frame can only be scaled up once VCount144() waited for it
+    bool UpscalePending = false;
+};
+
+}
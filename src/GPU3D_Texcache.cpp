@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "GPU3D_Texcache.h"
 
 namespace melonDS
@@ -18,11 +20,16 @@ uint64_t HashTextureVRAM(GPU& gpu, u32 addr, u32 size)
 }
 
 uint64_t BuildPaletteData(GPU& gpu, u32 palAddr, u32 count, bool color0Transparent, std::vector<uint32_t>& outRGBA)
+{
+    outRGBA.resize(count);
+    return BuildPaletteData(gpu, palAddr, count, color0Transparent, outRGBA.data());
+}
+
+uint64_t BuildPaletteData(GPU& gpu, u32 palAddr, u32 count, bool color0Transparent, uint32_t* outRGBA)
 {
     const uint64_t fnvOffset = 1469598103934665603ull;
     const uint64_t fnvPrime = 1099511628211ull;
     uint64_t hash = fnvOffset;
-    outRGBA.resize(count);
     for (u32 i = 0; i < count; ++i)
     {
         u16 color = gpu.ReadVRAMFlat_TexPal<u16>(palAddr + i * 2);
@@ -431,4 +438,142 @@ template void ConvertNColorsTexture<outputFmt_RGBA8, 2>(u32, u32, u32*, u32, u32
 template void ConvertNColorsTexture<outputFmt_RGBA8, 4>(u32, u32, u32*, u32, u32, bool, GPU&);
 template void ConvertNColorsTexture<outputFmt_RGBA8, 8>(u32, u32, u32*, u32, u32, bool, GPU&);
 
+void TexScratchArena::Reset()
+{
+    // if a frame needed more than one block, merge them so the next one fits in one
+    if (Blocks.size() > 1)
+    {
+        Blocks.clear();
+        Blocks.emplace_back(new u8[TotalSize]);
+        BlockSize = TotalSize;
+    }
+    Used = 0;
+}
+
+void TexScratchArena::Grow(size_t bytes)
+{
+    size_t size = std::max(bytes, std::max<size_t>(BlockSize * 2, 256 * 1024));
+    Blocks.emplace_back(new u8[size]);
+    BlockSize = size;
+    TotalSize += size;
+    Used = 0;
+}
+
+static hires::DsiTexFmt HiresFormatTag(u32 fmt)
+{
+    switch (fmt)
+    {
+    case 7: return hires::DsiTexFmt::Direct;
+    case 5: return hires::DsiTexFmt::Tex4x4;
+    case 6: return hires::DsiTexFmt::A5I3;
+    case 1: return hires::DsiTexFmt::A3I5;
+    case 2: return hires::DsiTexFmt::Pal4;
+    case 3: return hires::DsiTexFmt::Pal16;
+    case 4: return hires::DsiTexFmt::Pal256;
+    default: return hires::DsiTexFmt::Unknown;
+    }
+}
+
+bool LookupHiresReplacement(GPU& gpu, u32 texParam, u32 texPalette, bool tex4x4ByVRAM, TexScratchArena& scratch,
+                            hires::ReplacementImage& repl, std::string& replFile)
+{
+    u32 width = TextureWidth(texParam);
+    u32 height = TextureHeight(texParam);
+    u32 addr = (texParam & 0xFFFF) * 8;
+    u32 fmt = (texParam >> 26) & 0x7;
+    bool color0Transparent = texParam & (1 << 29);
+
+    // paletted textures are keyed by their texel data and palette, rather than their colors
+    std::optional<uint64_t> paletteInvariantHash;
+    switch (fmt)
+    {
+    case 1:
+    case 6:
+    case 4: paletteInvariantHash = HashTextureVRAM(gpu, addr, width * height); break;
+    case 2: paletteInvariantHash = HashTextureVRAM(gpu, addr, (width * height) / 4); break;
+    case 3: paletteInvariantHash = HashTextureVRAM(gpu, addr, (width * height) / 2); break;
+    case 5:
+        if (tex4x4ByVRAM || hires::VRAMKeysEnabled())
+            paletteInvariantHash = HashTextureVRAM(gpu, addr, (width * height) / 16 * 4);
+        break;
+    case 7:
+        if (hires::VRAMKeysEnabled())
+            paletteInvariantHash = HashTextureVRAM(gpu, addr, width * height * 2);
+        break;
+    }
+
+    std::optional<uint64_t> paletteHash;
+    uint32_t* paletteRGBA = nullptr;
+    u32 numPalEntries = 0;
+    u32 palAddr = texPalette * 16;
+    u32 auxAddr = 0;
+    switch (fmt)
+    {
+    case 1: numPalEntries = 32; break;
+    case 6: numPalEntries = 8; break;
+    case 2: numPalEntries = 4; palAddr >>= 1; break;
+    case 3: numPalEntries = 16; break;
+    case 4: numPalEntries = 256; break;
+    case 5:
+        numPalEntries = 0x10000 / 2;
+        color0Transparent = false;
+        auxAddr = 0x20000 + ((addr & 0x1FFFC) >> 1);
+        if (addr >= 0x40000)
+            auxAddr += 0x10000;
+        break;
+    }
+    if (numPalEntries)
+    {
+        paletteRGBA = scratch.Alloc<uint32_t>(numPalEntries);
+        paletteHash = BuildPaletteData(gpu, palAddr, numPalEntries, color0Transparent, paletteRGBA);
+    }
+
+    // only decode when the key needs the colors, or for dumping
+    bool dump = hires::DumpEnabled();
+    u32* rgba = nullptr;
+    if (dump || !paletteInvariantHash)
+    {
+        rgba = scratch.Alloc<u32>(width * height);
+        switch (fmt)
+        {
+        case 7: ConvertBitmapTexture<outputFmt_RGBA8>(width, height, rgba, addr, gpu); break;
+        case 5: ConvertCompressedTexture<outputFmt_RGBA8>(width, height, rgba, addr, auxAddr, palAddr, gpu); break;
+        case 1: ConvertAXIYTexture<outputFmt_RGBA8, 3, 5>(width, height, rgba, addr, palAddr, gpu); break;
+        case 6: ConvertAXIYTexture<outputFmt_RGBA8, 5, 3>(width, height, rgba, addr, palAddr, gpu); break;
+        case 2: ConvertNColorsTexture<outputFmt_RGBA8, 2>(width, height, rgba, addr, palAddr, color0Transparent, gpu); break;
+        case 3: ConvertNColorsTexture<outputFmt_RGBA8, 4>(width, height, rgba, addr, palAddr, color0Transparent, gpu); break;
+        case 4: ConvertNColorsTexture<outputFmt_RGBA8, 8>(width, height, rgba, addr, palAddr, color0Transparent, gpu); break;
+        }
+    }
+
+    bool pal0Transparent = (fmt >= 2 && fmt <= 4) && color0Transparent;
+    const uint8_t* rgbaBytes = reinterpret_cast<const uint8_t*>(rgba);
+    hires::TextureKey key = hires::MakeKey(rgbaBytes, width, height, false,
+                                           pal0Transparent, HiresFormatTag(fmt), paletteInvariantHash);
+
+    if (dump)
+    {
+        hires::PaletteIndexGenerator paletteIndexGenerator;
+        if (paletteHash)
+        {
+            paletteIndexGenerator = [fmt, width, height, addr, auxAddr, palAddr, &gpu]
+                                     (std::vector<uint8_t>& data, std::string& format, std::string& encoding) {
+                return BuildPaletteIndexMap(gpu, fmt, width, height, addr, auxAddr, palAddr,
+                                            data, format, encoding);
+            };
+        }
+        hires::DumpIfEnabled(key, rgbaBytes, width, height,
+                             paletteHash, paletteRGBA, numPalEntries,
+                             std::move(paletteIndexGenerator));
+    }
+
+    replFile.clear();
+    if (!hires::TryLoadReplacementImage(key, repl, paletteHash, &replFile))
+        return false;
+
+    if (replFile.empty())
+        replFile = hires::KeyToFilename(key, false);
+    return true;
+}
+
 }
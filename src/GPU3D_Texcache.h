@@ -5,6 +5,7 @@
 #include "GPU.h"
 
 #include <assert.h>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <optional>
@@ -21,6 +22,7 @@ namespace melonDS
 
 uint64_t HashTextureVRAM(GPU& gpu, u32 addr, u32 size);
 uint64_t BuildPaletteData(GPU& gpu, u32 palAddr, u32 count, bool color0Transparent, std::vector<uint32_t>& outRGBA);
+uint64_t BuildPaletteData(GPU& gpu, u32 palAddr, u32 count, bool color0Transparent, uint32_t* outRGBA);
 bool BuildPaletteIndexMap(GPU& gpu, u32 fmt, u32 width, u32 height,
                           u32 texAddr, u32 auxAddr, u32 palAddr,
                           std::vector<uint8_t>& outIndices,
@@ -53,6 +55,53 @@ void ConvertAXIYTexture(u32 width, u32 height, u32* output, u32 addr, u32 palAdd
 template <int outputFmt, int colorBits>
 void ConvertNColorsTexture(u32 width, u32 height, u32* output, u32 addr, u32 palAddr, bool color0Transparent, GPU& gpu);
 
+/// Bump allocator for the scratch buffers of the hi-res texture lookups.
+/// Everything allocated from it is released at once by Reset(), which the renderers call every frame.
+class TexScratchArena
+{
+public:
+    template <typename T>
+    T* Alloc(size_t count)
+    {
+        size_t bytes = (count * sizeof(T) + 15) & ~size_t(15);
+        if (Used + bytes > BlockSize)
+            Grow(bytes);
+        T* ret = reinterpret_cast<T*>(Blocks.back().get() + Used);
+        Used += bytes;
+        return ret;
+    }
+
+    void Reset();
+
+private:
+    std::vector<std::unique_ptr<u8[]>> Blocks;
+    size_t BlockSize = 0;
+    size_t Used = 0;
+    size_t TotalSize = 0;
+
+    void Grow(size_t bytes);
+};
+
+/// Builds the hi-res replacement key of the texture used with the given TEXIMAGE_PARAM and PLTT_BASE,
+/// dumps the texture if dumping is enabled, and loads its replacement if there is one.
+/// Textures keyed by their VRAM contents are only decoded to RGBA8 for dumping,
+/// which covers all paletted formats, and every format with hires::TexDumpConfig::vramKeys.
+/// @param tex4x4ByVRAM Whether 4x4 compressed textures are keyed by their VRAM contents
+/// rather than their decoded colors. Kept per renderer so existing texture packs still match.
+/// @param repl Receives the replacement, block-compressed if it comes from a .dds file.
+/// @param replFile Receives the file name of the replacement, to share its upload between textures.
+/// @returns \c true if a replacement was found.
+bool LookupHiresReplacement(GPU& gpu, u32 texParam, u32 texPalette, bool tex4x4ByVRAM, TexScratchArena& scratch,
+                            hires::ReplacementImage& repl, std::string& replFile);
+
+/// Counters of the last texture cache invalidation pass.
+struct TexcacheStats
+{
+    u32 Entries = 0;
+    u32 EntriesChecked = 0;
+    u32 EntriesInvalidated = 0;
+};
+
 template <typename TexLoaderT, typename TexHandleT>
 class Texcache
 {
@@ -113,41 +162,72 @@ public:
         bool textureChanged = gpu.MakeVRAMFlat_TextureCoherent(textureDirty);
         bool texPalChanged = gpu.MakeVRAMFlat_TexPalCoherent(texPalDirty);
 
+        LastStats = {};
+        LastStats.Entries = Cache.size();
+
         if (textureChanged || texPalChanged)
         {
-            //printf("check invalidation %d\n", TexCache.size());
-            for (auto it = Cache.begin(); it != Cache.end();)
+            // only look at the entries overlapping a dirty block
+            // each entry is only checked once, even if it covers several dirty blocks
+            CurCheckStamp++;
+            CheckList.clear();
+            auto collect = [&](std::vector<TexCacheEntry*>& blockEntries)
             {
-                TexCacheEntry& entry = it->second;
+                for (TexCacheEntry* entry : blockEntries)
+                {
+                    if (entry->CheckStamp != CurCheckStamp)
+                    {
+                        entry->CheckStamp = CurCheckStamp;
+                        CheckList.push_back(entry);
+                    }
+                }
+            };
+
+            if (textureChanged)
+            {
+                for (auto it = textureDirty.Begin(); it != textureDirty.End(); it++)
+                    collect(TextureBlockEntries[*it]);
+            }
+            if (texPalChanged)
+            {
+                for (auto it = texPalDirty.Begin(); it != texPalDirty.End(); it++)
+                    collect(TexPalBlockEntries[*it]);
+            }
+
+            for (TexCacheEntry* entry : CheckList)
+            {
+                LastStats.EntriesChecked++;
+
+                bool invalid = false;
                 if (textureChanged)
                 {
-                    for (u32 i = 0; i < 2; i++)
+                    for (u32 i = 0; i < 2 && !invalid; i++)
                     {
-                        if (CheckInvalid(entry.TextureRAMStart[i], entry.TextureRAMSize[i],
-                                entry.TextureHash[i],
+                        invalid = CheckInvalid(entry->TextureRAMStart[i], entry->TextureRAMSize[i],
+                                entry->TextureHash[i],
                                 textureDirty.Data,
-                                gpu.VRAMFlat_Texture, sizeof(gpu.VRAMFlat_Texture)))
-                            goto invalidate;
+                                gpu.VRAMFlat_Texture, sizeof(gpu.VRAMFlat_Texture));
                     }
                 }
 
-                if (texPalChanged && entry.TexPalSize > 0)
+                if (!invalid && texPalChanged && entry->TexPalSize > 0)
                 {
-                    if (CheckInvalid(entry.TexPalStart, entry.TexPalSize,
-                            entry.TexPalHash,
+                    invalid = CheckInvalid(entry->TexPalStart, entry->TexPalSize,
+                            entry->TexPalHash,
                             texPalDirty.Data,
-                            gpu.VRAMFlat_TexPal, sizeof(gpu.VRAMFlat_TexPal)))
-                        goto invalidate;
+                            gpu.VRAMFlat_TexPal, sizeof(gpu.VRAMFlat_TexPal));
                 }
 
-                it++;
-                continue;
-            invalidate:
-                FreeTextures[entry.WidthLog2][entry.HeightLog2].push_back(entry.Texture);
+                if (invalid)
+                {
+                    LastStats.EntriesInvalidated++;
+                    FreeTextures[entry->WidthLog2][entry->HeightLog2].push_back(entry->Texture);
 
-                //printf("invalidating texture %d\n", entry.ImageDescriptor);
+                    //printf("invalidating texture %d\n", entry->ImageDescriptor);
 
-                it = Cache.erase(it);
+                    UnindexEntry(entry);
+                    Cache.erase(entry->Key);
+                }
             }
 
             return true;
@@ -156,6 +236,9 @@ public:
         return false;
     }
 
+    /// Returns the counters of the last call to Update.
+    const TexcacheStats& GetStats() const { return LastStats; }
+
     void GetTexture(GPU& gpu, u32 texParam, u32 palBase, TexHandleT& textureHandle, u32& layer, u32*& helper)
     {
         // remove sampling and texcoord gen params
@@ -198,7 +281,11 @@ public:
 
         std::optional<uint64_t> paletteInvariantHash;
         std::optional<uint64_t> paletteHash;
-        std::vector<uint32_t> paletteRGBA;
+        uint32_t* paletteRGBA = nullptr;
+        u32 paletteCount = 0;
+        bool hires = melonDS::hires::DumpEnabled() || melonDS::hires::ReplaceEnabled();
+        if (hires)
+            HiresScratch.Reset();
 
         // apparently a new texture
         if (fmt == 7)
@@ -206,6 +293,8 @@ public:
             entry.TextureRAMSize[0] = width*height*2;
 
             ConvertBitmapTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, addr, gpu);
+            if (hires && melonDS::hires::VRAMKeysEnabled())
+                paletteInvariantHash = HashTextureVRAM(gpu, addr, entry.TextureRAMSize[0]);
         }
         else if (fmt == 5)
         {
@@ -220,8 +309,13 @@ public:
             entry.TexPalSize = 0x10000;
 
             ConvertCompressedTexture<outputFmt_RGB6A5>(width, height, DecodingBuffer, addr, slot1addr, entry.TexPalStart, gpu);
-            paletteInvariantHash = HashTextureVRAM(gpu, addr, entry.TextureRAMSize[0]);
-            paletteHash = BuildPaletteData(gpu, entry.TexPalStart, entry.TexPalSize / 2, false, paletteRGBA);
+            if (hires)
+            {
+                paletteInvariantHash = HashTextureVRAM(gpu, addr, entry.TextureRAMSize[0]);
+                paletteCount = entry.TexPalSize / 2;
+                paletteRGBA = HiresScratch.Alloc<uint32_t>(paletteCount);
+                paletteHash = BuildPaletteData(gpu, entry.TexPalStart, paletteCount, false, paletteRGBA);
+            }
         }
         else
         {
@@ -257,17 +351,23 @@ public:
             case 4: ConvertNColorsTexture<outputFmt_RGB6A5, 8>(width, height, DecodingBuffer, addr, palAddr, color0Transparent, gpu); break;
             }
 
-            paletteInvariantHash = HashTextureVRAM(gpu, addr, texSize);
-            paletteHash = BuildPaletteData(gpu, palAddr, numPalEntries, color0Transparent, paletteRGBA);
+            if (hires)
+            {
+                paletteInvariantHash = HashTextureVRAM(gpu, addr, texSize);
+                paletteCount = numPalEntries;
+                paletteRGBA = HiresScratch.Alloc<uint32_t>(paletteCount);
+                paletteHash = BuildPaletteData(gpu, palAddr, numPalEntries, color0Transparent, paletteRGBA);
+            }
         }
 
         // Hi-res texture dump & replacement (compute path integration)
         // Only do the conversion when dump or replacement is enabled.
-        if (melonDS::hires::DumpEnabled() || melonDS::hires::ReplaceEnabled()) {
-            std::vector<u8> hiresRGBA; // RGBA8 for hashing/dumping
-            hiresRGBA.resize(size_t(width)*height*4);
+        if (hires) {
+            // RGBA8 for hashing/dumping, paletted textures are keyed without it
+            const bool needRGBA = melonDS::hires::DumpEnabled() || !paletteInvariantHash;
+            u8* hiresRGBA = needRGBA ? HiresScratch.Alloc<u8>(size_t(width)*height*4) : nullptr;
             // Convert from packed RGB6A5 in DecodingBuffer to RGBA8 for hashing/dump
-            for (size_t i = 0, N = size_t(width)*height; i < N; ++i) {
+            for (size_t i = 0, N = needRGBA ? size_t(width)*height : 0; i < N; ++i) {
                 u32 p = DecodingBuffer[i];
                 u8 r6 = u8(p & 0xFF);
                 u8 g6 = u8((p >> 8) & 0xFF);
@@ -298,12 +398,12 @@ public:
             }
 
             bool pal0Transparent = (fmt >= 2 && fmt <= 4) && (texParam & (1<<29));
-            melonDS::hires::TextureKey key = melonDS::hires::MakeKey(hiresRGBA.data(), width, height,
+            melonDS::hires::TextureKey key = melonDS::hires::MakeKey(hiresRGBA, width, height,
                                                                      /*hasMips*/false, pal0Transparent, fmtTag,
                                                                      paletteInvariantHash);
 
             // Try load replacement (RGBA8). For compute path, we currently only support same-size replacement
-            std::vector<u8> replRGBA; u32 rw=width, rh=height;
+            std::vector<u8>& replRGBA = HiresReplRGBA; u32 rw=width, rh=height;
             if (melonDS::hires::TryLoadReplacement(key, replRGBA, rw, rh, paletteHash) && rw == width && rh == height) {
                 // Convert RGBA8 -> RGB6A5 packed (match DecodingBuffer format)
                 for (size_t i = 0, N = size_t(width)*height; i < N; ++i) {
@@ -317,12 +417,12 @@ public:
                     u8 a5 = u8((int(a8) * 31 + 127) / 255);
                     DecodingBuffer[i] = u32(r6) | (u32(g6) << 8) | (u32(b6) << 16) | (u32(a5) << 24);
                 }
-                hiresRGBA.swap(replRGBA); // dump the replacement image
+                hiresRGBA = replRGBA.data(); // dump the replacement image
             }
 
             // Async dump (final image: replacement if used, else original)
             melonDS::hires::PaletteIndexGenerator paletteIndexGenerator;
-            if (melonDS::hires::DumpEnabled() && paletteHash && !paletteRGBA.empty()) {
+            if (melonDS::hires::DumpEnabled() && paletteHash && paletteCount) {
                 u32 auxAddr = (fmt == 5) ? entry.TextureRAMStart[1] : 0u;
                 paletteIndexGenerator = [fmt, width, height, addr, auxAddr, palStart = entry.TexPalStart, &gpu]
                                          (std::vector<uint8_t>& data, std::string& format, std::string& encoding) {
@@ -331,10 +431,10 @@ public:
                     return false;
                 };
             }
-            melonDS::hires::DumpIfEnabled(key, hiresRGBA.data(), width, height,
+            melonDS::hires::DumpIfEnabled(key, hiresRGBA, width, height,
                                           paletteHash,
-                                          paletteHash ? paletteRGBA.data() : nullptr,
-                                          paletteHash ? static_cast<uint32_t>(paletteRGBA.size()) : 0,
+                                          paletteHash ? paletteRGBA : nullptr,
+                                          paletteHash ? paletteCount : 0,
                                           std::move(paletteIndexGenerator));
         }
 
@@ -378,7 +478,10 @@ public:
 
         textureHandle = storagePlace.TextureID;
         layer = storagePlace.Layer;
-        helper = &Cache.emplace(std::make_pair(key, entry)).first->second.LastVariant;
+        entry.Key = key;
+        TexCacheEntry& cached = Cache.emplace(std::make_pair(key, entry)).first->second;
+        IndexEntry(&cached);
+        helper = &cached.LastVariant;
     }
 
     void Reset()
@@ -394,6 +497,11 @@ public:
             }
         }
         Cache.clear();
+        for (auto& blockEntries : TextureBlockEntries)
+            blockEntries.clear();
+        for (auto& blockEntries : TexPalBlockEntries)
+            blockEntries.clear();
+        LastStats = {};
     }
 private:
     struct TexArrayEntry
@@ -413,9 +521,88 @@ private:
 
         u64 TextureHash[2];
         u64 TexPalHash;
+
+        u64 Key;
+        u32 CheckStamp;
     };
     std::unordered_map<u64, TexCacheEntry> Cache;
 
+    // scratch memory of the hi-res lookup of the texture being created
+    TexScratchArena HiresScratch;
+    std::vector<u8> HiresReplRGBA;
+
+    static constexpr u32 TextureBlocks = 512*1024 / VRAMDirtyGranularity;
+    static constexpr u32 TexPalBlocks = 128*1024 / VRAMDirtyGranularity;
+
+    // for every VRAM block, the cache entries covering it
+    // entries are never moved around by the unordered_map so pointing to them is safe
+    std::vector<TexCacheEntry*> TextureBlockEntries[TextureBlocks];
+    std::vector<TexCacheEntry*> TexPalBlockEntries[TexPalBlocks];
+
+    std::vector<TexCacheEntry*> CheckList;
+    u32 CurCheckStamp = 0;
+    TexcacheStats LastStats;
+
+    template <u32 numBlocks, typename F>
+    static void ForEachBlock(u32 start, u32 size, F&& func)
+    {
+        if (size == 0)
+            return;
+
+        // same range as checked by CheckInvalid, wrapping around the end of VRAM
+        u32 startBit = start / VRAMDirtyGranularity;
+        u32 bitsCount = ((start + size + VRAMDirtyGranularity - 1) / VRAMDirtyGranularity) - startBit;
+        bitsCount = std::min(bitsCount, numBlocks);
+        for (u32 i = 0; i < bitsCount; i++)
+            func((startBit + i) & (numBlocks - 1));
+    }
+
+    void IndexEntry(TexCacheEntry* entry)
+    {
+        for (u32 i = 0; i < 2; i++)
+        {
+            ForEachBlock<TextureBlocks>(entry->TextureRAMStart[i], entry->TextureRAMSize[i], [&](u32 block)
+            {
+                auto& blockEntries = TextureBlockEntries[block];
+                // both slots of a compressed texture never overlap, but be safe
+                if (blockEntries.empty() || blockEntries.back() != entry)
+                    blockEntries.push_back(entry);
+            });
+        }
+        ForEachBlock<TexPalBlocks>(entry->TexPalStart, entry->TexPalSize, [&](u32 block)
+        {
+            TexPalBlockEntries[block].push_back(entry);
+        });
+    }
+
+    static void RemoveFromBlock(std::vector<TexCacheEntry*>& blockEntries, TexCacheEntry* entry)
+    {
+        for (size_t i = 0; i < blockEntries.size(); i++)
+        {
+            if (blockEntries[i] == entry)
+            {
+                blockEntries[i] = blockEntries.back();
+                blockEntries.pop_back();
+                return;
+            }
+        }
+    }
+
+    void UnindexEntry(TexCacheEntry* entry)
+    {
+        for (u32 i = 0; i < 2; i++)
+        {
+            ForEachBlock<TextureBlocks>(entry->TextureRAMStart[i], entry->TextureRAMSize[i], [&](u32 block)
+            {
+                RemoveFromBlock(TextureBlockEntries[block], entry);
+            });
+        }
+        ForEachBlock<TexPalBlocks>(entry->TexPalStart, entry->TexPalSize, [&](u32 block)
+        {
+            RemoveFromBlock(TexPalBlockEntries[block], entry);
+        });
+    }
+
     TexLoaderT TexLoader;
 
     std::vector<TexArrayEntry> FreeTextures[8][8];
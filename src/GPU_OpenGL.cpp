@@ -175,7 +175,8 @@ GLCompositor::GLCompositor(GLCompositor&& other) noexcept :
     CompScreenOutputFB(other.CompScreenOutputFB),
     CompSpriteOverlayTex(other.CompSpriteOverlayTex),
     OverlayTexWidth(other.OverlayTexWidth),
-    OverlayTexHeight(other.OverlayTexHeight)
+    OverlayTexHeight(other.OverlayTexHeight),
+    OverlayTexRects{std::move(other.OverlayTexRects[0]), std::move(other.OverlayTexRects[1])}
 {
     other.CompScreenOutputFB = {};
     other.CompScreenInputTex = {};
@@ -225,6 +226,8 @@ GLCompositor& GLCompositor::operator=(GLCompositor&& other) noexcept
         CompSpriteOverlayTex = other.CompSpriteOverlayTex;
         OverlayTexWidth = other.OverlayTexWidth;
         OverlayTexHeight = other.OverlayTexHeight;
+        OverlayTexRects[0] = std::move(other.OverlayTexRects[0]);
+        OverlayTexRects[1] = std::move(other.OverlayTexRects[1]);
 
         other.CompScreenOutputFB = {};
         other.CompScreenInputTex = {};
@@ -250,7 +253,7 @@ void GLCompositor::SetScaleFactor(int scale) noexcept
     ScreenW = 256 * scale;
     ScreenH = (384+2) * scale;
 
-    for (int i = 0; i < 2; i++)
+    for (int i = 0; i < FramebufferSlots; i++)
     {
         glBindTexture(GL_TEXTURE_2D, CompScreenOutputTex[i]);
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ScreenW, ScreenH, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
@@ -270,10 +273,10 @@ void GLCompositor::SetScaleFactor(int scale) noexcept
 
 void GLCompositor::Stop(const GPU& gpu) noexcept
 {
-    for (int i = 0; i < 2; i++)
+    for (int i = 0; i < FramebufferSlots; i++)
     {
         glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, CompScreenOutputFB[gpu.FrontBuffer]);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, CompScreenOutputFB[i]);
 
         glClear(GL_COLOR_BUFFER_BIT);
     }
@@ -283,7 +286,7 @@ void GLCompositor::Stop(const GPU& gpu) noexcept
 
 void GLCompositor::RenderFrame(const GPU& gpu, Renderer3D& renderer) noexcept
 {
-    int backbuf = gpu.FrontBuffer ^ 1;
+    int backbuf = gpu.GetBackBuffer();
     glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
     glBindFramebuffer(GL_DRAW_FRAMEBUFFER, CompScreenOutputFB[backbuf]);
 
@@ -337,6 +340,7 @@ void GLCompositor::RenderFrame(const GPU& gpu, Renderer3D& renderer) noexcept
                 glUniform1i(CompSpriteScreenHeightLoc, overlayScreenHeight);
 
                 const int overlayHeightTotal = overlayScreenHeight * 2;
+                bool fullUpload = false;
                 if (overlayStride != OverlayTexWidth || overlayHeightTotal != OverlayTexHeight)
                 {
                     glActiveTexture(GL_TEXTURE2);
@@ -344,14 +348,37 @@ void GLCompositor::RenderFrame(const GPU& gpu, Renderer3D& renderer) noexcept
                     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, overlayStride, overlayHeightTotal, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
                     OverlayTexWidth = overlayStride;
                     OverlayTexHeight = overlayHeightTotal;
+                    fullUpload = true;
                 }
 
                 glActiveTexture(GL_TEXTURE2);
                 glBindTexture(GL_TEXTURE_2D, CompSpriteOverlayTex);
                 glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, overlayStride, overlayScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, overlayTop);
-                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, overlayScreenHeight, overlayStride, overlayScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, overlayBottom);
+                if (fullUpload)
+                {
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, overlayStride, overlayScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, overlayTop);
+                    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, overlayScreenHeight, overlayStride, overlayScreenHeight, GL_RGBA, GL_UNSIGNED_BYTE, overlayBottom);
+                }
+                else
+                {
+                    // the overlay is transparent outside of its rects, so only the regions
+                    // which have sprites now or had some in the last upload need to be updated
+                    glPixelStorei(GL_UNPACK_ROW_LENGTH, overlayStride);
+                    for (int screen = 0; screen < 2; screen++)
+                    {
+                        const u8* pixels = screen ? overlayBottom : overlayTop;
+                        int yoffset = screen * overlayScreenHeight;
+                        for (const GPU2D::SpriteOverlayRect& rect : OverlayTexRects[screen])
+                            UploadOverlayRect(pixels, overlayStride, yoffset, rect);
+                        for (const GPU2D::SpriteOverlayRect& rect : gpu.GetSpriteOverlayRects(backbuf, screen))
+                            UploadOverlayRect(pixels, overlayStride, yoffset, rect);
+                    }
+                    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+                }
                 glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+                for (int screen = 0; screen < 2; screen++)
+                    OverlayTexRects[screen] = gpu.GetSpriteOverlayRects(backbuf, screen);
             }
         }
     }
@@ -364,6 +391,15 @@ void GLCompositor::RenderFrame(const GPU& gpu, Renderer3D& renderer) noexcept
     glDrawArrays(GL_TRIANGLES, 0, 4*3);
 }
 
+void GLCompositor::UploadOverlayRect(const u8* pixels, int stride, int yoffset, const GPU2D::SpriteOverlayRect& rect) noexcept
+{
+    if (rect.Width == 0 || rect.Height == 0)
+        return;
+
+    const u8* src = pixels + (size_t(rect.Y) * stride + rect.X) * 4;
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.X, yoffset + rect.Y, rect.Width, rect.Height, GL_RGBA, GL_UNSIGNED_BYTE, src);
+}
+
 void GLCompositor::BindOutputTexture(int buf)
 {
     glBindTexture(GL_TEXTURE_2D, CompScreenOutputTex[buf]);
@@ -19,9 +19,11 @@
 #pragma once
 
 #include "OpenGLSupport.h"
+#include "GPU.h"
 
 #include <array>
 #include <optional>
+#include <vector>
 
 namespace melonDS
 {
@@ -68,12 +70,16 @@ private:
     std::array<CompVertex, 2*3*2> CompVertices {};
 
     GLuint CompScreenInputTex = 0;
-    std::array<GLuint, 2> CompScreenOutputTex {};
-    std::array<GLuint, 2> CompScreenOutputFB {};
+    std::array<GLuint, FramebufferSlots> CompScreenOutputTex {};
+    std::array<GLuint, FramebufferSlots> CompScreenOutputFB {};
     GLuint CompSpriteOverlayTex = 0;
 
     int OverlayTexWidth = 0;
     int OverlayTexHeight = 0;
+    // regions of each overlay screen uploaded last time, they need to be cleared on the next upload
+    std::vector<GPU2D::SpriteOverlayRect> OverlayTexRects[2];
+
+    void UploadOverlayRect(const u8* pixels, int stride, int yoffset, const GPU2D::SpriteOverlayRect& rect) noexcept;
 };
 
 }
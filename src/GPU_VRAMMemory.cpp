@@ -0,0 +1,280 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#if defined(__SWITCH__)
+// no aliasing, the views are copies
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#else
+#include <atomic>
+#include <stdio.h>
+#endif
+#endif
+
+#include <string.h>
+
+#include "GPU_VRAMMemory.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+using namespace Platform;
+
+#if defined(_WIN32) && !defined(__SWITCH__)
+using VirtualAlloc2Type = PVOID WINAPI (*)(HANDLE Process, PVOID BaseAddress, SIZE_T Size, ULONG AllocationType, ULONG PageProtection, MEM_EXTENDED_PARAMETER* ExtendedParameters, ULONG ParameterCount);
+using MapViewOfFile3Type = PVOID WINAPI (*)(HANDLE FileMapping, HANDLE Process, PVOID BaseAddress, ULONG64 Offset, SIZE_T ViewSize, ULONG AllocationType, ULONG PageProtection, MEM_EXTENDED_PARAMETER* ExtendedParameters, ULONG ParameterCount);
+
+static VirtualAlloc2Type virtualAlloc2Ptr;
+static MapViewOfFile3Type mapViewOfFile3Ptr;
+#endif
+
+VRAMMemory::VRAMMemory() noexcept
+{
+    memset(SlotBanks, -1, sizeof(SlotBanks));
+
+    if (!CreateAliases())
+    {
+        DestroyAliases();
+
+        Fallback = std::make_unique<u8[]>(TotalSize);
+        Base = Fallback.get();
+        Log(LogLevel::Debug, "VRAM: flat views are copies\n");
+    }
+}
+
+VRAMMemory::~VRAMMemory() noexcept
+{
+    DestroyAliases();
+}
+
+u8* VRAMMemory::GetView(u32 view) const noexcept
+{
+    if (ViewBase)
+        return ViewBase + ViewOffsets[view];
+
+    return Base + BanksSize + ViewOffsets[view];
+}
+
+void VRAMMemory::MapSlot(u32 view, u32 slot, int bank, u32 offset) noexcept
+{
+    u8* dst = ViewBase + ViewOffsets[view] + slot * SlotSize;
+    u32 ownoffset = BanksSize + ViewOffsets[view] + slot * SlotSize;
+
+    if (bank >= 0 && !MapPage(dst, BankOffsets[bank] + offset))
+    {
+        Log(LogLevel::Error, "VRAM: failed to map bank %d into view %d\n", bank, view);
+        bank = -1;
+    }
+    if (bank < 0 && !MapPage(dst, ownoffset))
+        Log(LogLevel::Error, "VRAM: failed to map view %d\n", view);
+
+    SlotBanks[view][slot] = bank;
+}
+
+void VRAMMemory::Reset() noexcept
+{
+    if (ViewBase)
+    {
+        for (u32 view = 0; view < View_Count; view++)
+        {
+            for (u32 slot = 0; slot < ViewSizes[view] / SlotSize; slot++)
+            {
+                if (SlotBanks[view][slot] != -1)
+                    MapSlot(view, slot, -1, 0);
+            }
+        }
+    }
+
+    memset(Base + BanksSize, 0, ViewsSize);
+}
+
+#if defined(__SWITCH__)
+
+bool VRAMMemory::CreateAliases() noexcept
+{
+    return false;
+}
+
+void VRAMMemory::DestroyAliases() noexcept
+{
+}
+
+bool VRAMMemory::MapPage(u8* dst, u32 offset) noexcept
+{
+    return false;
+}
+
+#elif defined(_WIN32)
+
+bool VRAMMemory::CreateAliases() noexcept
+{
+    if (!mapViewOfFile3Ptr)
+    {
+        HMODULE kernelbase = GetModuleHandleA("KernelBase.dll");
+        if (!kernelbase) return false;
+
+        virtualAlloc2Ptr = reinterpret_cast<VirtualAlloc2Type>(GetProcAddress(kernelbase, "VirtualAlloc2"));
+        mapViewOfFile3Ptr = reinterpret_cast<MapViewOfFile3Type>(GetProcAddress(kernelbase, "MapViewOfFile3"));
+        if (!virtualAlloc2Ptr || !mapViewOfFile3Ptr)
+        {
+            mapViewOfFile3Ptr = nullptr;
+            return false;
+        }
+    }
+
+    MemoryFile = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, TotalSize, nullptr);
+    if (!MemoryFile) return false;
+
+    Base = (u8*)MapViewOfFile(MemoryFile, FILE_MAP_ALL_ACCESS, 0, 0, TotalSize);
+    if (!Base) return false;
+
+    ViewBase = (u8*)virtualAlloc2Ptr(nullptr, nullptr, ViewsSize,
+        MEM_RESERVE | MEM_RESERVE_PLACEHOLDER, PAGE_NOACCESS, nullptr, 0);
+    if (!ViewBase) return false;
+
+    // split the reservation into one placeholder per slot, each holding a view of the file
+    for (u32 i = 0; i < ViewsSize; i += SlotSize)
+    {
+        if ((i + SlotSize) < ViewsSize)
+            VirtualFree(ViewBase + i, SlotSize, MEM_RELEASE | MEM_PRESERVE_PLACEHOLDER);
+
+        if (!mapViewOfFile3Ptr(MemoryFile, nullptr, ViewBase + i, BanksSize + i, SlotSize,
+                MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0))
+        {
+            // the remaining placeholders are released along with the mapped ones
+            for (u32 j = i; j < ViewsSize; j += SlotSize)
+                VirtualFree(ViewBase + j, 0, MEM_RELEASE);
+            for (u32 j = 0; j < i; j += SlotSize)
+            {
+                UnmapViewOfFileEx(ViewBase + j, MEM_PRESERVE_PLACEHOLDER);
+                VirtualFree(ViewBase + j, 0, MEM_RELEASE);
+            }
+            ViewBase = nullptr;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void VRAMMemory::DestroyAliases() noexcept
+{
+    if (ViewBase)
+    {
+        for (u32 i = 0; i < ViewsSize; i += SlotSize)
+        {
+            UnmapViewOfFileEx(ViewBase + i, MEM_PRESERVE_PLACEHOLDER);
+            VirtualFree(ViewBase + i, 0, MEM_RELEASE);
+        }
+        ViewBase = nullptr;
+    }
+
+    if (Base && !Fallback)
+        UnmapViewOfFile(Base);
+    Base = nullptr;
+
+    if (MemoryFile)
+    {
+        CloseHandle(MemoryFile);
+        MemoryFile = nullptr;
+    }
+}
+
+bool VRAMMemory::MapPage(u8* dst, u32 offset) noexcept
+{
+    if (!UnmapViewOfFileEx(dst, MEM_PRESERVE_PLACEHOLDER))
+        return false;
+
+    return mapViewOfFile3Ptr(MemoryFile, nullptr, dst, offset, SlotSize,
+        MEM_REPLACE_PLACEHOLDER, PAGE_READWRITE, nullptr, 0) != nullptr;
+}
+
+#else
+
+bool VRAMMemory::CreateAliases() noexcept
+{
+    long pagesize = sysconf(_SC_PAGESIZE);
+    if (pagesize <= 0 || (SlotSize % pagesize) != 0)
+        return false;
+
+#if defined(__linux__)
+    MemoryFile = syscall(SYS_memfd_create, "melondsvram", 0);
+#else
+    // every console instance needs its own
+    static std::atomic<u32> instance = 0;
+    char name[64];
+    snprintf(name, sizeof(name), "/melondsvram%d_%u", (int)getpid(), instance++);
+    MemoryFile = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (MemoryFile != -1)
+        shm_unlink(name);
+#endif
+    if (MemoryFile == -1)
+        return false;
+
+    if (ftruncate(MemoryFile, TotalSize) < 0)
+        return false;
+
+    void* base = mmap(nullptr, TotalSize, PROT_READ | PROT_WRITE, MAP_SHARED, MemoryFile, 0);
+    if (base == MAP_FAILED)
+        return false;
+    Base = (u8*)base;
+
+    void* viewbase = mmap(nullptr, ViewsSize, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
+    if (viewbase == MAP_FAILED)
+        return false;
+    ViewBase = (u8*)viewbase;
+
+    if (mmap(ViewBase, ViewsSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, MemoryFile, BanksSize) == MAP_FAILED)
+        return false;
+
+    return true;
+}
+
+void VRAMMemory::DestroyAliases() noexcept
+{
+    if (ViewBase)
+    {
+        munmap(ViewBase, ViewsSize);
+        ViewBase = nullptr;
+    }
+
+    if (Base && !Fallback)
+        munmap(Base, TotalSize);
+    Base = nullptr;
+
+    if (MemoryFile != -1)
+    {
+        close(MemoryFile);
+        MemoryFile = -1;
+    }
+}
+
+bool VRAMMemory::MapPage(u8* dst, u32 offset) noexcept
+{
+    return mmap(dst, SlotSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, MemoryFile, offset) != MAP_FAILED;
+}
+
+#endif
+
+}
@@ -0,0 +1,106 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef GPU_VRAMMEMORY_H
+#define GPU_VRAMMEMORY_H
+
+#include <memory>
+
+#include "types.h"
+
+namespace melonDS
+{
+/// Backing memory of the VRAM banks and of the flat views of the 2D engines' BG and OBJ VRAM.
+///
+/// Where the host allows it, the banks live in a shared memory object, and each 16KB slot
+/// of a flat view is a page mapping of either a bank or the view's own memory.
+/// A slot backed by a single bank can then be mapped onto it instead of being copied
+/// every time the bank is written to; only slots with overlapping banks need copying.
+/// Otherwise (or if creating the mappings fails) the views are plain buffers
+/// which always hold a copy of the banks.
+class VRAMMemory
+{
+public:
+    enum
+    {
+        View_ABG = 0,
+        View_BBG,
+        View_AOBJ,
+        View_BOBJ,
+        View_Count
+    };
+
+    /// The granularity of VRAM mappings, the host page size must not be larger.
+    static constexpr u32 SlotSize = 16*1024;
+
+    VRAMMemory() noexcept;
+    ~VRAMMemory() noexcept;
+    VRAMMemory(const VRAMMemory&) = delete;
+    VRAMMemory& operator=(const VRAMMemory&) = delete;
+
+    /// Whether the views are aliases of the banks rather than copies.
+    [[nodiscard]] bool IsAliasing() const noexcept { return ViewBase != nullptr; }
+
+    [[nodiscard]] u8* GetBank(u32 num) const noexcept { return Base + BankOffsets[num]; }
+    [[nodiscard]] u8* GetView(u32 view) const noexcept;
+
+    /// @return The bank the slot of the view is mapped onto, or -1 for the view's own memory.
+    [[nodiscard]] int GetSlotBank(u32 view, u32 slot) const noexcept { return SlotBanks[view][slot]; }
+
+    /// Maps a slot of a view onto the given offset of a bank, or onto the view's own memory if bank is -1.
+    /// Only valid if IsAliasing().
+    void MapSlot(u32 view, u32 slot, int bank, u32 offset) noexcept;
+
+    /// Maps every slot back onto the views' own memory, and clears it.
+    void Reset() noexcept;
+
+private:
+    static constexpr u32 BankOffsets[9] =
+    {
+        0x00000, 0x20000, 0x40000, 0x60000, // A-D
+        0x80000, 0x90000, 0x94000, 0x98000, 0xA0000 // E-I
+    };
+    static constexpr u32 BanksSize = 0xA4000;
+
+    static constexpr u32 ViewSizes[View_Count] = {512*1024, 128*1024, 256*1024, 128*1024};
+    static constexpr u32 ViewOffsets[View_Count] = {0, 512*1024, 640*1024, 896*1024};
+    static constexpr u32 ViewsSize = 1024*1024;
+
+    static constexpr u32 TotalSize = BanksSize + ViewsSize;
+
+    bool CreateAliases() noexcept;
+    void DestroyAliases() noexcept;
+    bool MapPage(u8* dst, u32 offset) noexcept;
+
+    // the banks, followed by the views' own memory
+    u8* Base = nullptr;
+    std::unique_ptr<u8[]> Fallback;
+
+    // the views when aliasing
+    u8* ViewBase = nullptr;
+#ifdef _WIN32
+    void* MemoryFile = nullptr;
+#else
+    int MemoryFile = -1;
+#endif
+
+    s8 SlotBanks[View_Count][512*1024 / SlotSize] {};
+};
+
+}
+#endif // GPU_VRAMMEMORY_H
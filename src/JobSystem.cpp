@@ -0,0 +1,292 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace melonDS
+{
+
+// the pool and index of the worker running on this thread, if any
+static thread_local const JobSystem* CurrentPool = nullptr;
+static thread_local int CurrentIndex = -1;
+
+// The deque follows "Correct and Efficient Work-Stealing for Weak Memory Models"
+// (Lê, Pop, Cohen, Zappa Nardelli, 2013), with a fixed capacity:
+// when a worker's deque is full, its jobs go to the shared queue instead.
+
+bool JobSystem::WorkDeque::Push(Job* job) noexcept
+{
+    s64 b = Bottom.load(std::memory_order_relaxed);
+    s64 t = Top.load(std::memory_order_acquire);
+    if (b - t >= Capacity)
+        return false;
+
+    Buffer[b & (Capacity - 1)].store(job, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    Bottom.store(b + 1, std::memory_order_relaxed);
+    return true;
+}
+
+JobSystem::Job* JobSystem::WorkDeque::Pop() noexcept
+{
+    s64 b = Bottom.load(std::memory_order_relaxed) - 1;
+    Bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    s64 t = Top.load(std::memory_order_relaxed);
+
+    if (t > b)
+    {
+        // empty
+        Bottom.store(b + 1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* job = Buffer[b & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (t == b)
+    {
+        // last job, race against the thieves for it
+        if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            job = nullptr;
+        Bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+JobSystem::Job* JobSystem::WorkDeque::Steal() noexcept
+{
+    s64 t = Top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    s64 b = Bottom.load(std::memory_order_acquire);
+
+    if (t >= b)
+        return nullptr;
+
+    Job* job = Buffer[t & (Capacity - 1)].load(std::memory_order_relaxed);
+    if (!Top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        return nullptr;
+    return job;
+}
+
+JobSystem::JobSystem(int numWorkers)
+{
+    if (numWorkers <= 0)
+    {
+        // threads waiting for their jobs help running them, so leave them a core
+        numWorkers = (int)std::max(1u, std::thread::hardware_concurrency()) - 1;
+        numWorkers = std::max(numWorkers, 1);
+    }
+
+    SharedQueueLock = Platform::Mutex_Create();
+    Sema_Work = Platform::Semaphore_Create();
+
+    for (int i = 0; i < numWorkers; i++)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->Index = i;
+        Workers.push_back(std::move(worker));
+    }
+
+    // only start the threads once all the deques exist, as they steal from each other
+    for (auto& worker : Workers)
+    {
+        Worker* w = worker.get();
+        w->Thread = Platform::Thread_Create([this, w]() { WorkerFunc(w); });
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    Quit = true;
+    Platform::Semaphore_Post(Sema_Work, (int)Workers.size());
+
+    for (auto& worker : Workers)
+    {
+        Platform::Thread_Wait(worker->Thread);
+        Platform::Thread_Free(worker->Thread);
+    }
+
+    Platform::Semaphore_Free(Sema_Work);
+    Platform::Mutex_Free(SharedQueueLock);
+}
+
+JobSystem& JobSystem::Get()
+{
+    // never destroyed: its threads have to outlive every emulator instance,
+    // including ones torn down by static destructors
+    static JobSystem* shared = new JobSystem();
+    return *shared;
+}
+
+int JobSystem::CurrentWorkerIndex(const JobSystem* jobs) noexcept
+{
+    return (CurrentPool == jobs) ? CurrentIndex : -1;
+}
+
+void JobSystem::Submit(Job* job)
+{
+    int self = CurrentWorkerIndex(this);
+    if (self < 0 || !Workers[self]->Deque.Push(job))
+    {
+        Platform::Mutex_Lock(SharedQueueLock);
+        SharedQueue.push_back(job);
+        SharedQueueSize.fetch_add(1, std::memory_order_relaxed);
+        Platform::Mutex_Unlock(SharedQueueLock);
+    }
+
+    // pairs with the fence in WorkerFunc: either the worker sees the job, or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (NumSleeping.load(std::memory_order_relaxed) > 0)
+        Platform::Semaphore_Post(Sema_Work);
+}
+
+JobSystem::Job* JobSystem::FindJob(int self)
+{
+    if (self >= 0)
+    {
+        if (Job* job = Workers[self]->Deque.Pop())
+            return job;
+    }
+
+    if (SharedQueueSize.load(std::memory_order_relaxed) > 0)
+    {
+        Job* job = nullptr;
+        Platform::Mutex_Lock(SharedQueueLock);
+        if (!SharedQueue.empty())
+        {
+            job = SharedQueue.front();
+            SharedQueue.pop_front();
+            SharedQueueSize.fetch_sub(1, std::memory_order_relaxed);
+        }
+        Platform::Mutex_Unlock(SharedQueueLock);
+        if (job)
+            return job;
+    }
+
+    // steal, starting from the next worker so thieves spread out
+    const int numWorkers = (int)Workers.size();
+    for (int i = 1; i <= numWorkers; i++)
+    {
+        int victim = (self + i) % numWorkers;
+        if (victim < 0) victim += numWorkers;
+        if (victim == self)
+            continue;
+
+        if (Job* job = Workers[victim]->Deque.Steal())
+            return job;
+    }
+
+    return nullptr;
+}
+
+void JobSystem::RunJob(Job* job)
+{
+    job->Func();
+
+    TaskGroup* group = job->Group;
+    delete job;
+    // the group may be gone as soon as this lands
+    group->Pending.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerFunc(Worker* worker)
+{
+    CurrentPool = this;
+    CurrentIndex = worker->Index;
+
+    for (;;)
+    {
+        if (Job* job = FindJob(worker->Index))
+        {
+            RunJob(job);
+            continue;
+        }
+
+        NumSleeping.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        // a job may have been submitted before we announced we're going to sleep
+        if (Job* job = FindJob(worker->Index))
+        {
+            NumSleeping.fetch_sub(1, std::memory_order_relaxed);
+            RunJob(job);
+            continue;
+        }
+
+        if (Quit.load(std::memory_order_relaxed))
+        {
+            NumSleeping.fetch_sub(1, std::memory_order_relaxed);
+            break;
+        }
+
+        Platform::Semaphore_Wait(Sema_Work);
+        NumSleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    CurrentPool = nullptr;
+    CurrentIndex = -1;
+}
+
+void JobSystem::ParallelFor(int begin, int end, int grain, const std::function<void(int, int)>& func)
+{
+    if (end <= begin)
+        return;
+
+    const int count = end - begin;
+    if (grain <= 0)
+        grain = std::max(1, count / ((GetNumWorkers() + 1) * 4));
+
+    if (count <= grain)
+    {
+        func(begin, end);
+        return;
+    }
+
+    TaskGroup group(*this);
+    for (int from = begin; from < end; from += grain)
+    {
+        int to = std::min(end, from + grain);
+        group.Run([&func, from, to]() { func(from, to); });
+    }
+    group.Wait();
+}
+
+void TaskGroup::Run(std::function<void()> func)
+{
+    Pending.fetch_add(1, std::memory_order_relaxed);
+    Jobs.Submit(new JobSystem::Job{std::move(func), this});
+}
+
+void TaskGroup::Wait()
+{
+    const int self = JobSystem::CurrentWorkerIndex(&Jobs);
+
+    while (Pending.load(std::memory_order_acquire) > 0)
+    {
+        // help instead of blocking: this also runs jobs of other groups,
+        // which keeps jobs waiting for jobs from starving the pool
+        if (JobSystem::Job* job = Jobs.FindJob(self))
+            Jobs.RunJob(job);
+        else
+            std::this_thread::yield();
+    }
+}
+
+}
@@ -0,0 +1,142 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+class TaskGroup;
+
+/// A pool of worker threads that run short jobs for the core,
+/// so subsystems that want parallelism share threads instead of each starting their own.
+///
+/// Every worker has its own deque of jobs: it pushes and pops the jobs it spawns at the bottom,
+/// while idle workers steal from the top of the others' deques. Jobs submitted from outside
+/// the pool go to a shared queue. Threads waiting for a TaskGroup run pending jobs in the meantime,
+/// so jobs can spawn and wait for other jobs without deadlocking the pool.
+class JobSystem
+{
+public:
+    /// @param numWorkers Number of worker threads. 0 sizes the pool from the number of host cores.
+    explicit JobSystem(int numWorkers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /// The pool shared by all the emulator instances of the process, started on first use.
+    static JobSystem& Get();
+
+    [[nodiscard]] int GetNumWorkers() const noexcept { return (int)Workers.size(); }
+
+    /// Runs func over [begin, end) split into ranges of at most grain elements,
+    /// and returns when all of them are done. The calling thread runs ranges too.
+    /// @param grain Size of the ranges, 0 picks one that gives every thread a few of them.
+    void ParallelFor(int begin, int end, int grain, const std::function<void(int, int)>& func);
+
+private:
+    friend class TaskGroup;
+
+    struct Job
+    {
+        std::function<void()> Func;
+        TaskGroup* Group;
+    };
+
+    /// Chase-Lev work-stealing deque of a worker.
+    /// Only its owner pushes and pops, any thread can steal.
+    class WorkDeque
+    {
+    public:
+        static constexpr s64 Capacity = 4096;
+
+        bool Push(Job* job) noexcept;
+        Job* Pop() noexcept;
+        Job* Steal() noexcept;
+
+    private:
+        alignas(64) std::atomic<s64> Top = 0;
+        alignas(64) std::atomic<s64> Bottom = 0;
+        std::atomic<Job*> Buffer[Capacity] {};
+    };
+
+    struct Worker
+    {
+        int Index;
+        WorkDeque Deque;
+        Platform::Thread* Thread = nullptr;
+    };
+
+    void Submit(Job* job);
+    Job* FindJob(int self);
+    void RunJob(Job* job);
+    void WorkerFunc(Worker* worker);
+    static int CurrentWorkerIndex(const JobSystem* jobs) noexcept;
+
+    std::vector<std::unique_ptr<Worker>> Workers;
+
+    // jobs submitted from outside the pool
+    Platform::Mutex* SharedQueueLock;
+    std::deque<Job*> SharedQueue;
+    std::atomic_int SharedQueueSize = 0;
+
+    // idle workers sleep on this
+    Platform::Semaphore* Sema_Work;
+    std::atomic_int NumSleeping = 0;
+    std::atomic_bool Quit = false;
+};
+
+/// A set of jobs that can be waited for together.
+/// Waiting threads help running pending jobs of the pool until the group is done.
+class TaskGroup
+{
+public:
+    explicit TaskGroup(JobSystem& jobs = JobSystem::Get()) noexcept : Jobs(jobs) {}
+    ~TaskGroup() { Wait(); }
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /// Queues func to run on the pool.
+    void Run(std::function<void()> func);
+
+    /// Returns once all the jobs queued so far are done.
+    void Wait();
+
+    [[nodiscard]] bool IsDone() const noexcept { return Pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    JobSystem& Jobs;
+    std::atomic_int Pending = 0;
+};
+
+}
+
+#endif // JOBSYSTEM_H
@@ -155,7 +155,9 @@ void Mic::FeedBuffer()
         if ((InputBufferWritePos + thislen) > InputBufferSize)
             thislen = InputBufferSize - InputBufferWritePos;
 
-        int actuallen = Platform::Mic_ReadInput(&InputBuffer[InputBufferWritePos], thislen, NDS.UserData);
+        int actuallen = InputHook
+            ? InputHook(&InputBuffer[InputBufferWritePos], thislen)
+            : Platform::Mic_ReadInput(&InputBuffer[InputBufferWritePos], thislen, NDS.UserData);
         if (!actuallen)
             break;
 
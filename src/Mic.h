@@ -19,6 +19,8 @@
 #ifndef MIC_H
 #define MIC_H
 
+#include <functional>
+
 #include "Savestate.h"
 #include "Platform.h"
 
@@ -48,6 +50,11 @@ public:
     void Advance(u32 cycles);
     s16 ReadSample();
 
+    /// Replaces Platform::Mic_ReadInput as the source of microphone samples.
+    /// Used to record and replay the microphone input of movies.
+    /// Pass an empty function to go back to reading from the platform.
+    void SetInputHook(std::function<int(s16* data, int maxlength)>&& hook) { InputHook = std::move(hook); }
+
 private:
     melonDS::NDS& NDS;
 
@@ -57,6 +64,8 @@ private:
     u32 InputBufferReadPos = 0;
     u32 InputBufferLevel = 0;
 
+    std::function<int(s16* data, int maxlength)> InputHook;
+
     u8 OpenMask;
     u32 CycleCount;
     s16 CurSample;
@@ -0,0 +1,581 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+
+#include <algorithm>
+
+#include "Movie.h"
+#include "NDS.h"
+#include "NDSCart.h"
+#include "GPU.h"
+#include "Savestate.h"
+#include "Platform.h"
+#include "xxhash/xxhash.h"
+
+namespace melonDS
+{
+using Platform::Log;
+using Platform::LogLevel;
+
+// file layout (all values little endian):
+//   header: magic, version, anchor, flags, game code, header CRC, frame count,
+//           input event count, mic read count, RTC state size, savestate size
+//   RTC state, savestate
+//   input events: frame delta (varint), change mask, changed values
+//   mic reads: frame delta (varint), sample count (varint), samples
+//   frame hashes, if flagged
+
+static constexpr char MovieMagic[8] = {'M', 'E', 'L', 'N', 'M', 'O', 'V', 'I'};
+static constexpr u16 MovieVersion = 1;
+
+enum
+{
+    MovieFlag_DirectBoot = (1<<0),
+    MovieFlag_Hashes = (1<<1),
+    MovieFlag_HashesAccelerated = (1<<2),
+};
+
+enum
+{
+    InputChange_Keys = (1<<0),
+    InputChange_Touch = (1<<1),
+    InputChange_Lid = (1<<2),
+    Input_Touching = (1<<6),
+    Input_LidClosed = (1<<7),
+};
+
+namespace
+{
+class MovieWriter
+{
+public:
+    void Data(const void* data, size_t len)
+    {
+        const u8* bytes = (const u8*)data;
+        Buffer.insert(Buffer.end(), bytes, bytes + len);
+    }
+
+    void U8(u8 val) { Buffer.push_back(val); }
+    void U16(u16 val) { U8(val & 0xFF); U8(val >> 8); }
+    void U32(u32 val) { U16(val & 0xFFFF); U16(val >> 16); }
+    void U64(u64 val) { U32(val & 0xFFFFFFFF); U32(val >> 32); }
+
+    void VarInt(u32 val)
+    {
+        while (val >= 0x80)
+        {
+            U8((val & 0x7F) | 0x80);
+            val >>= 7;
+        }
+        U8(val);
+    }
+
+    std::vector<u8> Buffer;
+};
+
+class MovieReader
+{
+public:
+    MovieReader(const u8* data, size_t len) : Data(data), Length(len) {}
+
+    bool Bytes(void* out, size_t len)
+    {
+        if (len > Length - Pos)
+        {
+            Error = true;
+            return false;
+        }
+        memcpy(out, &Data[Pos], len);
+        Pos += len;
+        return true;
+    }
+
+    u8 U8()
+    {
+        if (Pos >= Length)
+        {
+            Error = true;
+            return 0;
+        }
+        return Data[Pos++];
+    }
+    u16 U16() { u16 lo = U8(); return lo | (U8() << 8); }
+    u32 U32() { u32 lo = U16(); return lo | ((u32)U16() << 16); }
+    u64 U64() { u64 lo = U32(); return lo | ((u64)U32() << 32); }
+
+    u32 VarInt()
+    {
+        u32 val = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            u8 b = U8();
+            val |= (u32)(b & 0x7F) << shift;
+            if (!(b & 0x80))
+                return val;
+        }
+        Error = true;
+        return 0;
+    }
+
+    [[nodiscard]] size_t Remaining() const { return Length - Pos; }
+
+    bool Error = false;
+
+private:
+    const u8* Data;
+    size_t Length;
+    size_t Pos = 0;
+};
+}
+
+
+void MovieInput::Apply(NDS& nds) const
+{
+    nds.SetKeyMask(KeyMask);
+
+    if (Touching)
+        nds.TouchScreen(TouchX, TouchY);
+    else
+        nds.ReleaseScreen();
+
+    // only act on changes, as opening the lid raises an IRQ
+    if (LidClosed != nds.IsLidClosed())
+        nds.SetLidClosed(LidClosed);
+}
+
+
+bool Movie::Save(const std::string& path) const
+{
+    MovieWriter out;
+
+    u8 flags = 0;
+    if (DirectBoot) flags |= MovieFlag_DirectBoot;
+    if (!FrameHashes.empty()) flags |= MovieFlag_Hashes;
+    if (HashesAccelerated) flags |= MovieFlag_HashesAccelerated;
+
+    out.Data(MovieMagic, sizeof(MovieMagic));
+    out.U16(MovieVersion);
+    out.U8((u8)StartAnchor);
+    out.U8(flags);
+    out.Data(GameCode, sizeof(GameCode));
+    out.U16(HeaderCRC);
+    out.U32(FrameCount);
+    out.U32(InputEvents.size());
+    out.U32(MicReads.size());
+    out.U32(sizeof(StartRTC));
+    out.U32(StartState.size());
+
+    out.Data(&StartRTC, sizeof(StartRTC));
+    out.Data(StartState.data(), StartState.size());
+
+    MovieInput last;
+    u32 lastframe = 0;
+    for (const InputEvent& ev : InputEvents)
+    {
+        u8 change = 0;
+        if (ev.Input.KeyMask != last.KeyMask) change |= InputChange_Keys;
+        if (ev.Input.Touching != last.Touching ||
+            (ev.Input.Touching && (ev.Input.TouchX != last.TouchX || ev.Input.TouchY != last.TouchY)))
+            change |= InputChange_Touch;
+        if (ev.Input.LidClosed != last.LidClosed) change |= InputChange_Lid;
+        if (ev.Input.Touching) change |= Input_Touching;
+        if (ev.Input.LidClosed) change |= Input_LidClosed;
+
+        out.VarInt(ev.Frame - lastframe);
+        out.U8(change);
+        if (change & InputChange_Keys)
+            out.U16(ev.Input.KeyMask);
+        if ((change & InputChange_Touch) && ev.Input.Touching)
+        {
+            out.U8(ev.Input.TouchX);
+            out.U8(ev.Input.TouchY);
+        }
+
+        last = ev.Input;
+        lastframe = ev.Frame;
+    }
+
+    lastframe = 0;
+    for (const MicRead& read : MicReads)
+    {
+        out.VarInt(read.Frame - lastframe);
+        out.VarInt(read.Samples.size());
+        for (s16 sample : read.Samples)
+            out.U16(sample);
+
+        lastframe = read.Frame;
+    }
+
+    for (u64 hash : FrameHashes)
+        out.U64(hash);
+
+    Platform::FileHandle* file = Platform::OpenFile(path, Platform::FileMode::Write);
+    if (!file)
+    {
+        Log(LogLevel::Error, "Movie: failed to open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    bool ok = Platform::FileWrite(out.Buffer.data(), out.Buffer.size(), 1, file) == 1;
+    Platform::CloseFile(file);
+
+    if (!ok)
+        Log(LogLevel::Error, "Movie: failed to write %s\n", path.c_str());
+    return ok;
+}
+
+std::optional<Movie> Movie::Load(const std::string& path)
+{
+    Platform::FileHandle* file = Platform::OpenFile(path, Platform::FileMode::Read);
+    if (!file)
+    {
+        Log(LogLevel::Error, "Movie: failed to open %s\n", path.c_str());
+        return std::nullopt;
+    }
+
+    u64 len = Platform::FileLength(file);
+    std::vector<u8> data(len);
+    Platform::FileRewind(file);
+    bool ok = len > 0 && Platform::FileRead(data.data(), len, 1, file) == 1;
+    Platform::CloseFile(file);
+
+    if (!ok)
+    {
+        Log(LogLevel::Error, "Movie: failed to read %s\n", path.c_str());
+        return std::nullopt;
+    }
+
+    MovieReader in(data.data(), data.size());
+    Movie movie;
+
+    char magic[8];
+    in.Bytes(magic, sizeof(magic));
+    if (in.Error || memcmp(magic, MovieMagic, sizeof(magic)) != 0)
+    {
+        Log(LogLevel::Error, "Movie: %s is not a movie file\n", path.c_str());
+        return std::nullopt;
+    }
+
+    u16 version = in.U16();
+    if (version != MovieVersion)
+    {
+        Log(LogLevel::Error, "Movie: unsupported movie version %d\n", version);
+        return std::nullopt;
+    }
+
+    u8 anchor = in.U8();
+    u8 flags = in.U8();
+    in.Bytes(movie.GameCode, sizeof(movie.GameCode));
+    movie.HeaderCRC = in.U16();
+    movie.FrameCount = in.U32();
+    u32 numevents = in.U32();
+    u32 nummicreads = in.U32();
+    u32 rtclen = in.U32();
+    u32 statelen = in.U32();
+
+    if (anchor > (u8)Anchor::Savestate || rtclen != sizeof(movie.StartRTC) || statelen > in.Remaining())
+    {
+        Log(LogLevel::Error, "Movie: %s is corrupted\n", path.c_str());
+        return std::nullopt;
+    }
+
+    movie.StartAnchor = (Anchor)anchor;
+    movie.DirectBoot = flags & MovieFlag_DirectBoot;
+    movie.HashesAccelerated = flags & MovieFlag_HashesAccelerated;
+
+    in.Bytes(&movie.StartRTC, sizeof(movie.StartRTC));
+    movie.StartState.resize(statelen);
+    in.Bytes(movie.StartState.data(), statelen);
+
+    // every event takes at least two bytes, don't trust the count blindly
+    if (numevents > in.Remaining() / 2)
+        in.Error = true;
+    else
+        movie.InputEvents.reserve(numevents);
+
+    MovieInput cur;
+    u32 frame = 0;
+    for (u32 i = 0; i < numevents && !in.Error; i++)
+    {
+        frame += in.VarInt();
+        u8 change = in.U8();
+        if (change & InputChange_Keys)
+            cur.KeyMask = in.U16() & 0xFFF;
+        if (change & InputChange_Touch)
+        {
+            cur.Touching = change & Input_Touching;
+            if (cur.Touching)
+            {
+                cur.TouchX = in.U8();
+                cur.TouchY = in.U8();
+            }
+        }
+        if (change & InputChange_Lid)
+            cur.LidClosed = change & Input_LidClosed;
+
+        movie.InputEvents.push_back({frame, cur});
+    }
+
+    frame = 0;
+    for (u32 i = 0; i < nummicreads && !in.Error; i++)
+    {
+        MicRead read;
+        frame += in.VarInt();
+        read.Frame = frame;
+
+        u32 numsamples = in.VarInt();
+        if (numsamples > in.Remaining() / 2)
+        {
+            in.Error = true;
+            break;
+        }
+
+        read.Samples.resize(numsamples);
+        for (u32 j = 0; j < numsamples; j++)
+            read.Samples[j] = (s16)in.U16();
+
+        movie.MicReads.push_back(std::move(read));
+    }
+
+    if ((flags & MovieFlag_Hashes) && !in.Error)
+    {
+        if (movie.FrameCount > in.Remaining() / 8)
+            in.Error = true;
+        else
+        {
+            movie.FrameHashes.resize(movie.FrameCount);
+            for (u32 i = 0; i < movie.FrameCount; i++)
+                movie.FrameHashes[i] = in.U64();
+        }
+    }
+
+    if (in.Error)
+    {
+        Log(LogLevel::Error, "Movie: %s is truncated or corrupted\n", path.c_str());
+        return std::nullopt;
+    }
+
+    return movie;
+}
+
+u64 Movie::HashFrame(const GPU& gpu)
+{
+    int fbsize;
+    if (gpu.GPU3D.IsRendererAccelerated())
+        fbsize = (256*3 + 1) * 192;
+    else
+        fbsize = 256 * 192;
+
+    int buf = gpu.GetFrontBuffer();
+
+    XXH64_state_t* state = XXH64_createState();
+    XXH64_reset(state, 0);
+    XXH64_update(state, gpu.Framebuffer[buf][0].get(), fbsize * 4);
+    XXH64_update(state, gpu.Framebuffer[buf][1].get(), fbsize * 4);
+    u64 hash = XXH64_digest(state);
+    XXH64_freeState(state);
+
+    return hash;
+}
+
+
+MovieRecorder::MovieRecorder(melonDS::NDS& nds, Movie::Anchor anchor, bool directBoot, bool hashFrames) noexcept :
+    NDS(nds),
+    HashFrames(hashFrames)
+{
+    Recording.StartAnchor = anchor;
+    Recording.DirectBoot = directBoot;
+    Recording.HashesAccelerated = NDS.GPU.GPU3D.IsRendererAccelerated();
+
+    if (const NDSCart::CartCommon* cart = NDS.GetNDSCart())
+    {
+        memcpy(Recording.GameCode, cart->GetHeader().GameCode, sizeof(Recording.GameCode));
+        Recording.HeaderCRC = cart->GetHeader().HeaderCRC16;
+    }
+
+    NDS.RTC.GetState(Recording.StartRTC);
+
+    if (anchor == Movie::Anchor::Savestate)
+    {
+        Savestate state;
+        if (NDS.DoSavestate(&state) && !state.Error)
+        {
+            const u8* data = (const u8*)state.Buffer();
+            Recording.StartState.assign(data, data + state.Length());
+        }
+        else
+        {
+            Log(LogLevel::Error, "Movie: failed to save the starting state, recording from power-on instead\n");
+            Recording.StartAnchor = Movie::Anchor::PowerOn;
+        }
+    }
+
+    // the frontend applies its own input before the first frame,
+    // so make sure the first frame always gets an event
+    LastInput.KeyMask = ~0U;
+
+    NDS.Mic.SetInputHook([this](s16* data, int maxlength) -> int
+    {
+        int len = Platform::Mic_ReadInput(data, maxlength, NDS.UserData);
+        Recording.MicReads.push_back({Recording.FrameCount, std::vector<s16>(data, data + len)});
+        return len;
+    });
+}
+
+MovieRecorder::~MovieRecorder() noexcept
+{
+    if (!Finished)
+        NDS.Mic.SetInputHook(nullptr);
+}
+
+void MovieRecorder::BeginFrame(const MovieInput& input)
+{
+    if (input != LastInput)
+    {
+        Recording.InputEvents.push_back({Recording.FrameCount, input});
+        LastInput = input;
+    }
+}
+
+void MovieRecorder::EndFrame()
+{
+    if (HashFrames)
+        Recording.FrameHashes.push_back(Movie::HashFrame(NDS.GPU));
+
+    Recording.FrameCount++;
+}
+
+bool MovieRecorder::Save(const std::string& path)
+{
+    if (!Finished)
+    {
+        NDS.Mic.SetInputHook(nullptr);
+        Finished = true;
+    }
+
+    return Recording.Save(path);
+}
+
+
+MoviePlayer::MoviePlayer(melonDS::NDS& nds, Movie&& movie) noexcept :
+    NDS(nds),
+    Playback(std::move(movie))
+{
+    CheckHashes = !Playback.FrameHashes.empty() &&
+        Playback.HashesAccelerated == NDS.GPU.GPU3D.IsRendererAccelerated();
+}
+
+MoviePlayer::~MoviePlayer() noexcept
+{
+    NDS.Mic.SetInputHook(nullptr);
+}
+
+bool MoviePlayer::Start()
+{
+    if (const NDSCart::CartCommon* cart = NDS.GetNDSCart())
+    {
+        const NDSHeader& header = cart->GetHeader();
+        if (memcmp(header.GameCode, Playback.GameCode, sizeof(Playback.GameCode)) != 0 ||
+            header.HeaderCRC16 != Playback.HeaderCRC)
+        {
+            Log(LogLevel::Error, "Movie: recorded with a different game (%.4s)\n", Playback.GameCode);
+            return false;
+        }
+    }
+
+    if (Playback.StartAnchor == Movie::Anchor::Savestate)
+    {
+        Savestate state(Playback.StartState.data(), Playback.StartState.size(), false);
+        if (state.Error || !NDS.DoSavestate(&state) || state.Error)
+        {
+            Log(LogLevel::Error, "Movie: failed to load the starting state\n");
+            return false;
+        }
+    }
+
+    NDS.RTC.SetState(Playback.StartRTC);
+
+    CurFrame = 0;
+    NextInputEvent = 0;
+    NextMicRead = 0;
+    DivergenceFrame = std::nullopt;
+
+    NDS.Mic.SetInputHook([this](s16* data, int maxlength) { return ReadMic(data, maxlength); });
+    return true;
+}
+
+void MoviePlayer::BeginFrame()
+{
+    while (NextInputEvent < Playback.InputEvents.size() &&
+           Playback.InputEvents[NextInputEvent].Frame <= CurFrame)
+    {
+        Playback.InputEvents[NextInputEvent].Input.Apply(NDS);
+        NextInputEvent++;
+    }
+}
+
+bool MoviePlayer::EndFrame(u64* hash)
+{
+    bool match = true;
+
+    if (hash || CheckHashes)
+    {
+        u64 framehash = Movie::HashFrame(NDS.GPU);
+        if (hash)
+            *hash = framehash;
+
+        if (CheckHashes && CurFrame < Playback.FrameHashes.size() &&
+            framehash != Playback.FrameHashes[CurFrame])
+        {
+            match = false;
+            if (!DivergenceFrame)
+            {
+                DivergenceFrame = CurFrame;
+                Log(LogLevel::Warn, "Movie: replay diverged from the recording at frame %u\n", CurFrame);
+            }
+        }
+    }
+
+    // anything left over from this frame means the console asked for less mic input than when recording
+    while (NextMicRead < Playback.MicReads.size() &&
+           Playback.MicReads[NextMicRead].Frame <= CurFrame)
+    {
+        NextMicRead++;
+        match = false;
+        if (!DivergenceFrame)
+            DivergenceFrame = CurFrame;
+    }
+
+    CurFrame++;
+    return match;
+}
+
+int MoviePlayer::ReadMic(s16* data, int maxlength)
+{
+    if (NextMicRead >= Playback.MicReads.size() ||
+        Playback.MicReads[NextMicRead].Frame != CurFrame)
+        return 0;
+
+    const std::vector<s16>& samples = Playback.MicReads[NextMicRead++].Samples;
+    int len = std::min((int)samples.size(), maxlength);
+    memcpy(data, samples.data(), len * sizeof(s16));
+    return len;
+}
+
+}
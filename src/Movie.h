@@ -0,0 +1,194 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef MOVIE_H
+#define MOVIE_H
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "RTC.h"
+#include "types.h"
+
+namespace melonDS
+{
+class NDS;
+class GPU;
+
+/// The state of all user inputs during one frame.
+struct MovieInput
+{
+    u32 KeyMask = 0xFFF;
+    bool Touching = false;
+    u16 TouchX = 0;
+    u16 TouchY = 0;
+    bool LidClosed = false;
+
+    bool operator==(const MovieInput& other) const
+    {
+        return KeyMask == other.KeyMask
+            && Touching == other.Touching
+            && (!Touching || (TouchX == other.TouchX && TouchY == other.TouchY))
+            && LidClosed == other.LidClosed;
+    }
+    bool operator!=(const MovieInput& other) const { return !(*this == other); }
+
+    /// Feeds this input to the given console.
+    void Apply(NDS& nds) const;
+};
+
+/// A recording of all inputs fed to the emulator over a run,
+/// starting from either power-on or a savestate.
+/// Replaying a movie on the same build reproduces the run bit-for-bit,
+/// which makes it usable for performance and correctness regression runs.
+class Movie
+{
+public:
+    enum class Anchor : u8
+    {
+        /// Recording starts right after the console was reset (and direct booted, if applicable).
+        PowerOn = 0,
+        /// Recording starts from the embedded savestate.
+        Savestate,
+    };
+
+    /// Input change taking effect at the start of the given frame.
+    struct InputEvent
+    {
+        u32 Frame;
+        MovieInput Input;
+    };
+
+    /// Result of one microphone read during the given frame.
+    /// Empty reads are kept too, so the replayed mic feed matches exactly.
+    struct MicRead
+    {
+        u32 Frame;
+        std::vector<s16> Samples;
+    };
+
+    Anchor StartAnchor = Anchor::PowerOn;
+    bool DirectBoot = true;
+    char GameCode[4] {};
+    u16 HeaderCRC = 0;
+
+    RTC::StateData StartRTC {};
+    std::vector<u8> StartState;
+
+    u32 FrameCount = 0;
+    std::vector<InputEvent> InputEvents;
+    std::vector<MicRead> MicReads;
+
+    /// Hash of the output of each frame. Empty if the movie was recorded without hashes.
+    std::vector<u64> FrameHashes;
+    /// Whether the hashes were taken from an accelerated renderer's framebuffers.
+    /// They can only be compared against runs using the same kind of renderer.
+    bool HashesAccelerated = false;
+
+    /// Writes the movie to the given file.
+    /// @returns \c true on success.
+    bool Save(const std::string& path) const;
+
+    /// Reads a movie from the given file.
+    /// @returns The movie, or \c std::nullopt if the file couldn't be read or isn't a valid movie.
+    static std::optional<Movie> Load(const std::string& path);
+
+    /// Hashes the frame the given GPU finished last.
+    /// Must be called from the emulation thread, between frames.
+    static u64 HashFrame(const GPU& gpu);
+};
+
+/// Records the inputs fed to a console into a Movie.
+/// The frontend calls BeginFrame with the input it's about to apply before each NDS::RunFrame,
+/// and EndFrame after it.
+/// While recording, the console's microphone input goes through the recorder.
+class MovieRecorder
+{
+public:
+    /// Starts recording from the console's current state.
+    /// For Movie::Anchor::PowerOn, the console must have just been reset.
+    MovieRecorder(melonDS::NDS& nds, Movie::Anchor anchor, bool directBoot, bool hashFrames) noexcept;
+    ~MovieRecorder() noexcept;
+    MovieRecorder(const MovieRecorder&) = delete;
+    MovieRecorder& operator=(const MovieRecorder&) = delete;
+
+    void BeginFrame(const MovieInput& input);
+    void EndFrame();
+
+    [[nodiscard]] u32 GetFrameCount() const noexcept { return Recording.FrameCount; }
+    [[nodiscard]] const Movie& GetMovie() const noexcept { return Recording; }
+
+    /// Stops recording and writes the movie to the given file.
+    bool Save(const std::string& path);
+
+private:
+    melonDS::NDS& NDS;
+    Movie Recording;
+    MovieInput LastInput;
+    bool HashFrames;
+    bool Finished = false;
+};
+
+/// Replays a Movie on a console.
+/// The frontend calls BeginFrame before each NDS::RunFrame instead of applying its own input,
+/// and EndFrame after it.
+/// While playing, the console's microphone input comes from the movie.
+class MoviePlayer
+{
+public:
+    MoviePlayer(melonDS::NDS& nds, Movie&& movie) noexcept;
+    ~MoviePlayer() noexcept;
+    MoviePlayer(const MoviePlayer&) = delete;
+    MoviePlayer& operator=(const MoviePlayer&) = delete;
+
+    /// Brings the console to the movie's starting point.
+    /// For Movie::Anchor::PowerOn, the console must have just been reset
+    /// and direct booted the same way as when recording.
+    /// @returns \c false if the movie was recorded with a different game, or its savestate failed to load.
+    bool Start();
+
+    void BeginFrame();
+
+    /// Finishes the current frame and checks it against the recorded hash, if there is one.
+    /// @param hash If not null, receives the hash of the frame.
+    /// @returns \c false if the frame doesn't match the recording.
+    bool EndFrame(u64* hash = nullptr);
+
+    [[nodiscard]] bool IsFinished() const noexcept { return CurFrame >= Playback.FrameCount; }
+    [[nodiscard]] u32 GetCurrentFrame() const noexcept { return CurFrame; }
+    [[nodiscard]] const Movie& GetMovie() const noexcept { return Playback; }
+
+    /// Returns the first frame that didn't match the recording, if any.
+    [[nodiscard]] std::optional<u32> GetDivergenceFrame() const noexcept { return DivergenceFrame; }
+
+private:
+    melonDS::NDS& NDS;
+    Movie Playback;
+    u32 CurFrame = 0;
+    size_t NextInputEvent = 0;
+    size_t NextMicRead = 0;
+    bool CheckHashes = false;
+    std::optional<u32> DivergenceFrame;
+
+    int ReadMic(s16* data, int maxlength);
+};
+
+}
+
+#endif // MOVIE_H
@@ -52,6 +52,9 @@ using namespace Platform;
 const s32 kMaxIterationCycles = 64;
 const s32 kIterationCycleMargin = 8;
 
+// the profiler keeps one slot per scheduler event
+static_assert(Profiler::EventSlots == Event_MAX, "Profiler::EventSlots doesn't match Event_MAX");
+
 // timing notes
 //
 // * this implementation is technically wrong for VRAM
@@ -441,6 +444,7 @@ void NDS::Reset()
     // BIOS files are now loaded by the frontend
 
     JIT.Reset();
+    Profiler.Reset();
 
     if (ConsoleType == 1)
     {
@@ -852,7 +856,13 @@ void NDS::RunSystem(u64 timestamp)
                 SchedListMask &= ~(1<<i);
 
                 EventFunc func = evt.Funcs[evt.FuncID];
+#ifdef PROFILER_ENABLED
+                u64 start = melonDS::Profiler::Now();
+                func(evt.That, evt.Param);
+                Profiler.AddEvent(i, melonDS::Profiler::Now() - start);
+#else
                 func(evt.That, evt.Param);
+#endif
             }
         }
 
@@ -924,6 +934,10 @@ u32 NDS::RunFrame()
 {
     Current = this;
 
+#ifdef PROFILER_ENABLED
+    u64 profFrameStart = melonDS::Profiler::Now();
+#endif
+
     FrameStartTimestamp = SysTimestamp;
 
     GPU.TotalScanlines = 0;
@@ -989,6 +1003,7 @@ u32 NDS::RunFrame()
                 }
                 else if (CPUStop & CPUStop_DMA9)
                 {
+                    PROFILE_SCOPE(Profiler, Section_DMA);
                     DMAs[0].Run();
                     if (!(CPUStop & CPUStop_GXStall)) DMAs[1].Run();
                     if (!(CPUStop & CPUStop_GXStall)) DMAs[2].Run();
@@ -1001,11 +1016,18 @@ u32 NDS::RunFrame()
                 }
                 else
                 {
+                    PROFILE_SCOPE(Profiler, Section_ARM9);
                     ARM9.Execute<cpuMode>();
                 }
 
-                RunTimers(0);
-                GPU.GPU3D.Run();
+                {
+                    PROFILE_SCOPE(Profiler, Section_Timers);
+                    RunTimers(0);
+                }
+                {
+                    PROFILE_SCOPE(Profiler, Section_GPU3DCommands);
+                    GPU.GPU3D.Run();
+                }
 
                 target = ARM9Timestamp >> ARM9ClockShift;
                 CurCPU = 1;
@@ -1016,6 +1038,7 @@ u32 NDS::RunFrame()
 
                     if (CPUStop & CPUStop_DMA7)
                     {
+                        PROFILE_SCOPE(Profiler, Section_DMA);
                         DMAs[4].Run();
                         DMAs[5].Run();
                         DMAs[6].Run();
@@ -1028,13 +1051,18 @@ u32 NDS::RunFrame()
                     }
                     else
                     {
+                        PROFILE_SCOPE(Profiler, Section_ARM7);
                         ARM7.Execute<cpuMode>();
                     }
 
+                    PROFILE_SCOPE(Profiler, Section_Timers);
                     RunTimers(1);
                 }
 
-                RunSystem(target);
+                {
+                    PROFILE_SCOPE(Profiler, Section_Scheduler);
+                    RunSystem(target);
+                }
 
                 if (CPUStop & CPUStop_Sleep)
                 {
@@ -1056,8 +1084,13 @@ u32 NDS::RunFrame()
         break;
     }
 
-    // Signal to the SPU that it should read out the buffered audio from blip-buf to a buffer for the frontend to consume
-    SPU.EndFrame();
+    // Write back the storage sectors cached in memory once the software stops writing to them
+    NDSCartSlot.FlushIfIdle();
+    if (ConsoleType == 1)
+    {
+        auto& dsi = dynamic_cast<melonDS::DSi&>(*this);
+        dsi.SDMMC.FlushIfIdle();
+    }
 
     // In the context of TASes, frame count is traditionally the primary measure of emulated time,
     // so it needs to be tracked even if NDS is powered off.
@@ -1065,6 +1098,10 @@ u32 NDS::RunFrame()
     if (LagFrameFlag)
         NumLagFrames++;
 
+#ifdef PROFILER_ENABLED
+    Profiler.EndFrame(profFrameStart);
+#endif
+
     if (Running)
         return GPU.TotalScanlines;
     else
@@ -1084,6 +1121,11 @@ u32 NDS::RunFrame()
         return RunFrame<CPUExecuteMode::InterpreterGDB>();
     } else
 #endif
+    if (EnableCachedInterpreter)
+    {
+        return RunFrame<CPUExecuteMode::CachedInterpreter>();
+    }
+    else
     {
         return RunFrame<CPUExecuteMode::Interpreter>();
     }
@@ -1740,6 +1782,18 @@ void NDS::StopDMAs(u32 cpu, u32 mode)
     DMAs[cpu+3].StopIfNeeded(mode);
 }
 
+DMA* NDS::GetCartWordFeed(u32 cpu)
+{
+    cpu <<= 2;
+    for (u32 i = 0; i < 4; i++)
+    {
+        if (DMAs[cpu+i].IsCartWordFeed())
+            return &DMAs[cpu+i];
+    }
+
+    return nullptr;
+}
+
 
 
 void NDS::DivDone(u32 param)
@@ -43,6 +43,7 @@
 #include "CRC32.h"
 #include "DMA.h"
 #include "FreeBIOS.h"
+#include "Profiler.h"
 
 // when touching the main loop/timing code, pls test a lot of shit
 // with this enabled, to make sure it doesn't desync
@@ -246,6 +247,7 @@ private:
 #ifdef GDBSTUB_ENABLED
     bool EnableGDBStub = false;
 #endif
+    bool EnableCachedInterpreter = false;
 
 public: // TODO: Encapsulate the rest of these members
     void* UserData;
@@ -323,6 +325,7 @@ public: // TODO: Encapsulate the rest of these members
     GBACart::GBACartSlot GBACartSlot;
     melonDS::GPU GPU;
     melonDS::AREngine AREngine;
+    melonDS::Profiler Profiler;
 
     const u32 ARM7WRAMSize = 0x10000;
     u8* ARM7WRAM;
@@ -446,6 +449,8 @@ public: // TODO: Encapsulate the rest of these members
     virtual bool DMAsRunning(u32 cpu) const;
     virtual void CheckDMAs(u32 cpu, u32 mode);
     virtual void StopDMAs(u32 cpu, u32 mode);
+    /// @return The DMA channel of the given CPU that fetches cart ROM data one word at a time, if any.
+    virtual DMA* GetCartWordFeed(u32 cpu);
 
     void RunTimers(u32 cpu);
 
@@ -495,6 +500,14 @@ public: // TODO: Encapsulate the rest of these members
     void SetGdbArgs(std::optional<GDBArgs> args) noexcept {}
 #endif
 
+    /// The cached interpreter decodes blocks of code once and runs them from then on,
+    /// for when the JIT isn't available. It behaves exactly like the interpreter.
+    /// Common ARM data processing, load/store and branch instructions get handlers with
+    /// their operands decoded beforehand, everything else uses the interpreter's handlers.
+    /// The JIT and the GDB stub take precedence over it when they're enabled.
+    [[nodiscard]] bool IsCachedInterpreterEnabled() const noexcept { return EnableCachedInterpreter; }
+    void SetCachedInterpreter(bool enable) noexcept { EnableCachedInterpreter = enable; }
+
 private:
     void InitTimings();
     u32 SchedListMask;
@@ -194,7 +194,7 @@ CartCommon::CartCommon(const u8* rom, u32 len, u32 chipid, bool badDSiDump, ROML
 {
 }
 
-CartCommon::CartCommon(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, melonDS::NDSCart::CartType type, void* userdata) :
+CartCommon::CartCommon(ROMBuffer&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, melonDS::NDSCart::CartType type, void* userdata) :
     ROM(std::move(rom)),
     ROMLength(len),
     ChipID(chipid),
@@ -396,7 +396,7 @@ CartRetail::CartRetail(const u8* rom, u32 len, u32 chipid, bool badDSiDump, ROML
 {
 }
 
-CartRetail::CartRetail(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, melonDS::NDSCart::CartType type) :
+CartRetail::CartRetail(ROMBuffer&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata, melonDS::NDSCart::CartType type) :
     CartCommon(std::move(rom), len, chipid, badDSiDump, romparams, type, userdata)
 {
     u32 savememtype = ROMParams.SaveMemType <= 10 ? ROMParams.SaveMemType : 0;
@@ -859,7 +859,7 @@ CartRetailNAND::CartRetailNAND(const u8* rom, u32 len, u32 chipid, ROMListEntry
 {
 }
 
-CartRetailNAND::CartRetailNAND(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
+CartRetailNAND::CartRetailNAND(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
     CartRetail(std::move(rom), len, chipid, false, romparams, std::move(sram), sramlen, userdata, CartType::RetailNAND)
 {
     BuildSRAMID();
@@ -1092,7 +1092,7 @@ CartRetailIR::CartRetailIR(const u8* rom, u32 len, u32 chipid, u32 irversion, bo
 }
 
 CartRetailIR::CartRetailIR(
-    std::unique_ptr<u8[]>&& rom,
+    ROMBuffer&& rom,
     u32 len,
     u32 chipid,
     u32 irversion,
@@ -1150,7 +1150,7 @@ CartRetailBT::CartRetailBT(const u8* rom, u32 len, u32 chipid, ROMListEntry romp
 {
 }
 
-CartRetailBT::CartRetailBT(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
+CartRetailBT::CartRetailBT(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata) :
     CartRetail(std::move(rom), len, chipid, false, romparams, std::move(sram), sramlen, userdata, CartType::RetailBT)
 {
     Log(LogLevel::Info,"POKETYPE CART\n");
@@ -1177,7 +1177,7 @@ CartSD::CartSD(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void*
     CartSD(CopyToUnique(rom, len), len, chipid, romparams, userdata, std::move(sdcard))
 {}
 
-CartSD::CartSD(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
+CartSD::CartSD(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
     CartCommon(std::move(rom), len, chipid, false, romparams, CartType::Homebrew, userdata),
     SD(std::move(sdcard))
 {
@@ -1188,6 +1188,15 @@ CartSD::CartSD(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry ro
 CartSD::~CartSD() = default;
 // The SD card is destroyed by the optional's destructor
 
+void CartSD::DoSavestate(Savestate* file)
+{
+    CartCommon::DoSavestate(file);
+
+    // the SD card contents aren't part of the state,
+    // but the image should at least match the state being saved
+    if (SD) SD->Flush();
+}
+
 
 void CartSD::ApplyDLDIPatchAt(u8* binary, u32 dldioffset, const u8* patch, u32 patchlen, bool readonly) const
 {
@@ -1333,7 +1342,7 @@ CartHomebrew::CartHomebrew(const u8* rom, u32 len, u32 chipid, ROMListEntry romp
     CartSD(rom, len, chipid, romparams, userdata, std::move(sdcard))
 {}
 
-CartHomebrew::CartHomebrew(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
+CartHomebrew::CartHomebrew(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard) :
     CartSD(std::move(rom), len, chipid, romparams, userdata, std::move(sdcard))
 {}
 
@@ -1590,6 +1599,8 @@ void NDSCartSlot::DecryptSecureArea(u8* out) noexcept
     }
 }
 
+static std::unique_ptr<CartCommon> ParseROM(ROMBuffer&& cartrom, u32 cartromsize, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args);
+
 std::unique_ptr<CartCommon> ParseROM(const u8* romdata, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args)
 {
     return ParseROM(CopyToUnique(romdata, romlen), romlen, userdata, std::move(args));
@@ -1610,7 +1621,23 @@ std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen
     }
 
     auto [cartrom, cartromsize] = PadToPowerOf2(std::move(romdata), romlen);
+    return ParseROM(std::move(cartrom), cartromsize, romlen, userdata, std::move(args));
+}
 
+std::unique_ptr<CartCommon> ParseROM(const SharedROM& rom, void* userdata, std::optional<NDSCartArgs>&& args)
+{
+    ROMBuffer cartrom = rom.Map();
+    if (cartrom == nullptr)
+    {
+        Log(LogLevel::Error, "NDSCart: failed to map shared ROM\n");
+        return nullptr;
+    }
+
+    return ParseROM(std::move(cartrom), rom.GetPaddedLength(), rom.GetLength(), userdata, std::move(args));
+}
+
+static std::unique_ptr<CartCommon> ParseROM(ROMBuffer&& cartrom, u32 cartromsize, u32 romlen, void* userdata, std::optional<NDSCartArgs>&& args)
+{
     NDSHeader header {};
     memcpy(&header, cartrom.get(), sizeof(header));
 
@@ -1817,6 +1844,9 @@ void NDSCartSlot::ROMEndTransfer(u32 param) noexcept
 
 void NDSCartSlot::ROMPrepareData(u32 param) noexcept
 {
+    if (BurstTransfers && TransferDir == 0 && TransferPos == 0 && BurstROMTransfer())
+        return;
+
     if (TransferDir == 0)
     {
         if (TransferPos >= TransferLen)
@@ -1835,6 +1865,26 @@ void NDSCartSlot::ROMPrepareData(u32 param) noexcept
         NDS.CheckDMAs(0, 0x05);
 }
 
+bool NDSCartSlot::BurstROMTransfer() noexcept
+{
+    if (ROMCnt & (1<<30)) return false;
+
+    DMA* feed = NDS.GetCartWordFeed((NDS.ExMemCnt[0] >> 11) & 0x1);
+    if (!feed) return false;
+
+    // hand the whole block over at once, as if the channel had been triggered for every word
+    feed->FeedWords(TransferData.data(), TransferLen);
+    ROMData = *(u32*)&TransferData[TransferLen - 4];
+    TransferPos = TransferLen;
+
+    // the remaining words and the gaps between blocks, as AdvanceROMTransfer() would schedule them
+    u32 xfercycle = (ROMCnt & (1<<27)) ? 8 : 5;
+    u32 delay = ((TransferLen >> 2) - 1) * 4 + ((ROMCnt >> 16) & 0x3F) * ((TransferLen - 4) >> 9);
+
+    NDS.ScheduleEvent(Event_ROMTransfer, false, (xfercycle * delay * BurstTiming) / 100, ROMTransfer_End, 0);
+    return true;
+}
+
 void NDSCartSlot::WriteROMCnt(u32 val) noexcept
 {
     u32 xferstart = (val & ~ROMCnt) & (1<<31);
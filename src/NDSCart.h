@@ -29,6 +29,7 @@
 #include "NDS_Header.h"
 #include "FATStorage.h"
 #include "ROMList.h"
+#include "SharedROM.h"
 
 namespace melonDS
 {
@@ -77,7 +78,7 @@ class CartCommon
 {
 public:
     CartCommon(const u8* rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, CartType type, void* userdata);
-    CartCommon(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, CartType type, void* userdata);
+    CartCommon(ROMBuffer&& rom, u32 len, u32 chipid, bool badDSiDump, ROMListEntry romparams, CartType type, void* userdata);
     virtual ~CartCommon();
 
     [[nodiscard]] u32 Type() const { return CartType; };
@@ -88,6 +89,8 @@ public:
 
     virtual void DoSavestate(Savestate* file);
 
+    /// Writes back the cart's storage if it's not being written to. Called once per frame.
+    virtual void FlushIfIdle() {}
 
     virtual int ROMCommandStart(NDS& nds, NDSCart::NDSCartSlot& cartslot, const u8* cmd, u8* data, u32 len);
     virtual void ROMCommandFinish(const u8* cmd, u8* data, u32 len);
@@ -113,7 +116,7 @@ protected:
 
     void* UserData;
 
-    std::unique_ptr<u8[]> ROM = nullptr;
+    ROMBuffer ROM = nullptr;
     u32 ROMLength = 0;
     u32 ChipID = 0;
     bool IsDSi = false;
@@ -145,7 +148,7 @@ public:
         melonDS::NDSCart::CartType type = CartType::Retail
     );
     CartRetail(
-        std::unique_ptr<u8[]>&& rom,
+        ROMBuffer&& rom,
         u32 len, u32 chipid,
         bool badDSiDump,
         ROMListEntry romparams,
@@ -192,7 +195,7 @@ class CartRetailNAND : public CartRetail
 {
 public:
     CartRetailNAND(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
-    CartRetailNAND(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartRetailNAND(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
     ~CartRetailNAND() override;
 
     void Reset() override;
@@ -221,7 +224,7 @@ class CartRetailIR : public CartRetail
 {
 public:
     CartRetailIR(const u8* rom, u32 len, u32 chipid, u32 irversion, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
-    CartRetailIR(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, u32 irversion, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartRetailIR(ROMBuffer&& rom, u32 len, u32 chipid, u32 irversion, bool badDSiDump, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
     ~CartRetailIR() override;
 
     void Reset() override;
@@ -240,7 +243,7 @@ class CartRetailBT : public CartRetail
 {
 public:
     CartRetailBT(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
-    CartRetailBT(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
+    CartRetailBT(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, std::unique_ptr<u8[]>&& sram, u32 sramlen, void* userdata);
     ~CartRetailBT() override;
 
     u8 SPIWrite(u8 val, u32 pos, bool last) override;
@@ -251,9 +254,12 @@ class CartSD : public CartCommon
 {
 public:
     CartSD(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
-    CartSD(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
+    CartSD(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
     ~CartSD() override;
 
+    void DoSavestate(Savestate* file) override;
+    void FlushIfIdle() override { if (SD) SD->FlushIfIdle(); }
+
     [[nodiscard]] const std::optional<FATStorage>& GetSDCard() const noexcept { return SD; }
     void SetSDCard(FATStorage&& sdcard) noexcept { SD = std::move(sdcard); }
     void SetSDCard(std::optional<FATStorage>&& sdcard) noexcept
@@ -293,7 +299,7 @@ class CartHomebrew : public CartSD
 {
 public:
     CartHomebrew(const u8* rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
-    CartHomebrew(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
+    CartHomebrew(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, void* userdata, std::optional<FATStorage>&& sdcard = std::nullopt);
     ~CartHomebrew() override;
 
     void Reset() override;
@@ -326,7 +332,7 @@ enum CartR4Language
 class CartR4 : public CartSD
 {
 public:
-    CartR4(std::unique_ptr<u8[]>&& rom, u32 len, u32 chipid, ROMListEntry romparams, CartR4Type ctype, CartR4Language clanguage, void* userdata,
+    CartR4(ROMBuffer&& rom, u32 len, u32 chipid, ROMListEntry romparams, CartR4Type ctype, CartR4Language clanguage, void* userdata,
         std::optional<FATStorage>&& sdcard = std::nullopt);
     ~CartR4() override;
 
@@ -386,6 +392,8 @@ public:
 
     void SetupDirectBoot(const std::string& romname) noexcept;
 
+    void FlushIfIdle() noexcept { if (Cart) Cart->FlushIfIdle(); }
+
     /// This function is intended to allow frontends to save and load SRAM
     /// without using melonDS APIs.
     /// Modifying the emulated SRAM for any other reason is strongly discouraged.
@@ -417,6 +425,13 @@ public:
     [[nodiscard]] u32 GetROMCnt() const noexcept { return ROMCnt; }
     [[nodiscard]] u16 GetSPICnt() const noexcept { return SPICnt; }
     void SetSPICnt(u16 val) noexcept { SPICnt = val; }
+
+    /// Whether ROM reads that a DMA channel fetches one word at a time are done in one go.
+    /// The data is the same, but the transfer no longer takes the time it does on hardware.
+    bool BurstTransfers = false;
+
+    /// How long burst transfers take, in percent of the accurate timing.
+    u32 BurstTiming = 25;
 private:
     friend class CartCommon;
     melonDS::NDS& NDS;
@@ -450,6 +465,7 @@ private:
     void Key2_Encrypt(const u8* data, u32 len) noexcept;
     void ROMEndTransfer(u32 param) noexcept;
     void ROMPrepareData(u32 param) noexcept;
+    bool BurstROMTransfer() noexcept;
     void AdvanceROMTransfer() noexcept;
     void SPITransferDone(u32 param) noexcept;
 };
@@ -467,6 +483,13 @@ private:
 /// or \c nullptr if the ROM data couldn't be parsed.
 std::unique_ptr<CartCommon> ParseROM(const u8* romdata, u32 romlen, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
 std::unique_ptr<CartCommon> ParseROM(std::unique_ptr<u8[]>&& romdata, u32 romlen, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
+
+/// Constructs a \c NDSCart::CartCommon subclass from a ROM image shared with other emulator instances.
+/// The cart gets its own copy-on-write view of the image rather than a copy,
+/// so only the parts of the ROM it modifies take up memory of their own.
+/// @returns A \c NDSCart::CartCommon object representing the parsed ROM,
+/// or \c nullptr if the ROM couldn't be mapped or parsed.
+std::unique_ptr<CartCommon> ParseROM(const SharedROM& rom, void* userdata = nullptr, std::optional<NDSCartArgs>&& args = std::nullopt);
 }
 
 #endif
@@ -358,6 +358,19 @@ error:
     return linkingSucess;
 }
 
+bool HasExtension(const char* name)
+{
+    GLint numExtensions = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &numExtensions);
+    for (GLint i = 0; i < numExtensions; i++)
+    {
+        const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+        if (ext && !strcmp(ext, name))
+            return true;
+    }
+    return false;
+}
+
 }
 
 }
\ No newline at end of file
@@ -46,6 +46,9 @@ bool CompileVertexFragmentProgram(GLuint& result,
 
 bool CompileComputeProgram(GLuint& result, const std::string& source, const std::string& name);
 
+/// Whether the current context supports the given extension.
+bool HasExtension(const char* name);
+
 }
 
 #endif // OPENGLSUPPORT_H
@@ -0,0 +1,228 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+
+#include "Profiler.h"
+#include "NDS.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+using Platform::Log;
+using Platform::LogLevel;
+
+static_assert(Profiler::EventSlots == Event_MAX, "profiler event slots out of sync with the scheduler");
+
+static const char* SectionNames[Profiler::Section_MAX] =
+{
+    "frame",
+    "arm9",
+    "arm7",
+    "dma",
+    "timers",
+    "gpu3d_commands",
+    "scheduler",
+    "render2d",
+    "render3d",
+    "spu_mix",
+    "jit_compile",
+};
+
+static const char* EventNames[Profiler::EventSlots] =
+{
+    "lcd",
+    "spu",
+    "wifi",
+    "rtc",
+    "display_fifo",
+    "rom_transfer",
+    "rom_spi_transfer",
+    "spi_transfer",
+    "div",
+    "sqrt",
+    "dsi_sdmmc_transfer",
+    "dsi_sdio_transfer",
+    "dsi_nwifi",
+    "dsi_cam_irq",
+    "dsi_cam_transfer",
+    "dsi_dsp",
+    "dsi_dsp_hle",
+};
+
+
+Profiler::Profiler() noexcept
+{
+    Reset();
+}
+
+void Profiler::Reset() noexcept
+{
+    for (Counter& c : Sections) c = {};
+    for (Counter& c : Events) c = {};
+    memset(BlocksExecuted, 0, sizeof(BlocksExecuted));
+    memset(BlocksCompiled, 0, sizeof(BlocksCompiled));
+    memset(LastFrameTicks, 0, sizeof(LastFrameTicks));
+
+    FrameHistory.clear();
+    NumFrames = 0;
+
+    ResetTick = Now();
+    ResetTime = std::chrono::steady_clock::now();
+}
+
+void Profiler::EndFrame(u64 startTick) noexcept
+{
+    AddSection(Section_Frame, Now() - startTick);
+
+    // the history only holds what was spent during this frame
+    FrameRecord rec;
+    rec.StartTick = startTick;
+    for (int i = 0; i < Section_MAX; i++)
+    {
+        rec.Ticks[i] = Sections[i].Ticks - LastFrameTicks[i];
+        LastFrameTicks[i] = Sections[i].Ticks;
+    }
+
+    if (FrameHistory.size() < FrameHistorySize)
+        FrameHistory.push_back(rec);
+    else
+        FrameHistory[NumFrames % FrameHistorySize] = rec;
+
+    NumFrames++;
+}
+
+std::vector<Profiler::FrameRecord> Profiler::GetFrameHistory() const
+{
+    if (FrameHistory.size() < FrameHistorySize)
+        return FrameHistory;
+
+    // the ring wrapped around, the oldest frame is the one to be overwritten next
+    std::vector<FrameRecord> ret;
+    ret.reserve(FrameHistorySize);
+    u32 oldest = NumFrames % FrameHistorySize;
+    ret.insert(ret.end(), FrameHistory.begin() + oldest, FrameHistory.end());
+    ret.insert(ret.end(), FrameHistory.begin(), FrameHistory.begin() + oldest);
+    return ret;
+}
+
+double Profiler::GetTicksPerSecond() const noexcept
+{
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - ResetTime).count();
+    if (elapsed <= 0)
+        return 1e9;
+
+    return (Now() - ResetTick) / elapsed;
+}
+
+const char* Profiler::GetSectionName(Section section) noexcept
+{
+    return SectionNames[section];
+}
+
+const char* Profiler::GetEventName(int slot) noexcept
+{
+    return EventNames[slot];
+}
+
+bool Profiler::DumpJSON(const std::string& path) const
+{
+    Platform::FileHandle* file = Platform::OpenFile(path, Platform::FileMode::WriteText);
+    if (!file)
+    {
+        Log(LogLevel::Error, "Profiler: failed to open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    double tickrate = GetTicksPerSecond();
+    auto writeCounter = [&](const char* name, const Counter& c, bool last)
+    {
+        Platform::FileWriteFormatted(file, "    \"%s\": {\"calls\": %llu, \"ticks\": %llu, \"ms\": %.3f}%s\n",
+                                     name, (unsigned long long)c.Calls, (unsigned long long)c.Ticks,
+                                     1000.0 * c.Ticks / tickrate, last ? "" : ",");
+    };
+
+    Platform::FileWriteFormatted(file, "{\n");
+    Platform::FileWriteFormatted(file, "  \"enabled\": %s,\n", Enabled ? "true" : "false");
+    Platform::FileWriteFormatted(file, "  \"ticks_per_second\": %.0f,\n", tickrate);
+    Platform::FileWriteFormatted(file, "  \"frames\": %u,\n", NumFrames);
+
+    Platform::FileWriteFormatted(file, "  \"sections\": {\n");
+    for (int i = 0; i < Section_MAX; i++)
+        writeCounter(SectionNames[i], Sections[i], i == Section_MAX-1);
+    Platform::FileWriteFormatted(file, "  },\n");
+
+    Platform::FileWriteFormatted(file, "  \"events\": {\n");
+    for (int i = 0; i < EventSlots; i++)
+        writeCounter(EventNames[i], Events[i], i == EventSlots-1);
+    Platform::FileWriteFormatted(file, "  },\n");
+
+    Platform::FileWriteFormatted(file, "  \"jit\": {\n");
+    Platform::FileWriteFormatted(file, "    \"blocks_compiled\": [%llu, %llu],\n",
+                                 (unsigned long long)BlocksCompiled[0], (unsigned long long)BlocksCompiled[1]);
+    Platform::FileWriteFormatted(file, "    \"blocks_executed\": [%llu, %llu]\n",
+                                 (unsigned long long)BlocksExecuted[0], (unsigned long long)BlocksExecuted[1]);
+    Platform::FileWriteFormatted(file, "  }\n");
+    Platform::FileWriteFormatted(file, "}\n");
+
+    Platform::CloseFile(file);
+    return true;
+}
+
+bool Profiler::DumpChromeTrace(const std::string& path) const
+{
+    Platform::FileHandle* file = Platform::OpenFile(path, Platform::FileMode::WriteText);
+    if (!file)
+    {
+        Log(LogLevel::Error, "Profiler: failed to open %s for writing\n", path.c_str());
+        return false;
+    }
+
+    std::vector<FrameRecord> frames = GetFrameHistory();
+    double tickrate = GetTicksPerSecond();
+    u64 base = frames.empty() ? 0 : frames[0].StartTick;
+    auto toMicro = [&](u64 ticks) { return 1e6 * ticks / tickrate; };
+
+    // every frame is a span on the timeline, with the time spent in each section
+    // as a stacked counter, as the individual section calls are far too many to trace
+    Platform::FileWriteFormatted(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    Platform::FileWriteFormatted(file, "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, \"args\": {\"name\": \"emulation\"}}");
+
+    u32 firstframe = NumFrames - frames.size();
+    for (size_t f = 0; f < frames.size(); f++)
+    {
+        const FrameRecord& rec = frames[f];
+        double ts = toMicro(rec.StartTick - base);
+
+        Platform::FileWriteFormatted(file, ",\n  {\"name\": \"frame %u\", \"cat\": \"frame\", \"ph\": \"X\", \"pid\": 0, \"tid\": 0, "
+                                           "\"ts\": %.3f, \"dur\": %.3f}",
+                                     firstframe + (u32)f, ts, toMicro(rec.Ticks[Section_Frame]));
+
+        Platform::FileWriteFormatted(file, ",\n  {\"name\": \"sections (us)\", \"ph\": \"C\", \"pid\": 0, \"ts\": %.3f, \"args\": {", ts);
+        for (int i = Section_Frame + 1; i < Section_MAX; i++)
+            Platform::FileWriteFormatted(file, "%s\"%s\": %.3f", (i == Section_Frame + 1) ? "" : ", ",
+                                         SectionNames[i], toMicro(rec.Ticks[i]));
+        Platform::FileWriteFormatted(file, "}}");
+    }
+
+    Platform::FileWriteFormatted(file, "\n]}\n");
+    Platform::CloseFile(file);
+    return true;
+}
+
+}
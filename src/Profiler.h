@@ -0,0 +1,192 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "types.h"
+
+// the profiler is compiled in with ENABLE_PROFILER
+// without it, all the PROFILE_* macros expand to nothing and the counters stay at zero
+#ifdef PROFILER_ENABLED
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(profiler, section) \
+    melonDS::Profiler::Scope PROFILE_CONCAT(profScope, __LINE__)((profiler), melonDS::Profiler::section)
+#define PROFILE_COUNT(expr) expr
+#else
+#define PROFILE_SCOPE(profiler, section) do {} while (0)
+#define PROFILE_COUNT(expr) do {} while (0)
+#endif
+
+namespace melonDS
+{
+
+/// Low-overhead profiler recording where host time goes while emulating.
+/// Time is measured in ticks of the cheapest clock available
+/// (the TSC on x86, the virtual counter on ARM64, steady_clock elsewhere).
+/// Sections nest: the time of a section includes all sections opened within it.
+class Profiler
+{
+public:
+#ifdef PROFILER_ENABLED
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+
+    enum Section
+    {
+        Section_Frame = 0,
+        Section_ARM9,
+        Section_ARM7,
+        Section_DMA,
+        Section_Timers,
+        Section_GPU3DCommands,
+        Section_Scheduler,
+        Section_Render2D,
+        Section_Render3D,
+        Section_SPUMix,
+        Section_JITCompile,
+
+        Section_MAX
+    };
+
+    /// Number of scheduler event slots tracked, matches Event_MAX in NDS.h.
+    static constexpr int EventSlots = 17;
+
+    /// Number of past frames kept for the trace dump.
+    static constexpr int FrameHistorySize = 1024;
+
+    struct Counter
+    {
+        u64 Calls = 0;
+        u64 Ticks = 0;
+    };
+
+    struct FrameRecord
+    {
+        u64 StartTick;
+        u64 Ticks[Section_MAX];
+    };
+
+    /// Measures the time spent in the enclosing C++ scope. Use through PROFILE_SCOPE.
+    class Scope
+    {
+    public:
+        Scope(Profiler& profiler, Section section) noexcept :
+            Prof(profiler), Sect(section), Start(Now())
+        {}
+        ~Scope() noexcept { Prof.AddSection(Sect, Now() - Start); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Profiler& Prof;
+        Section Sect;
+        u64 Start;
+    };
+
+    Profiler() noexcept;
+
+    /// Clears all counters and the frame history.
+    void Reset() noexcept;
+
+    static u64 Now() noexcept
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+        u64 val;
+        asm volatile("mrs %0, cntvct_el0" : "=r"(val));
+        return val;
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    void AddSection(Section section, u64 ticks) noexcept
+    {
+        Sections[section].Calls++;
+        Sections[section].Ticks += ticks;
+    }
+
+    void AddEvent(int slot, u64 ticks) noexcept
+    {
+        Events[slot].Calls++;
+        Events[slot].Ticks += ticks;
+    }
+
+    void CountBlockExecuted(u32 cpu) noexcept { BlocksExecuted[cpu]++; }
+    void CountBlockCompiled(u32 cpu) noexcept { BlocksCompiled[cpu]++; }
+
+    /// Closes the frame started at the given tick, and adds it to the history.
+    void EndFrame(u64 startTick) noexcept;
+
+    [[nodiscard]] const Counter& GetSection(Section section) const noexcept { return Sections[section]; }
+    [[nodiscard]] const Counter& GetEvent(int slot) const noexcept { return Events[slot]; }
+    [[nodiscard]] u64 GetBlocksExecuted(u32 cpu) const noexcept { return BlocksExecuted[cpu]; }
+    [[nodiscard]] u64 GetBlocksCompiled(u32 cpu) const noexcept { return BlocksCompiled[cpu]; }
+    [[nodiscard]] u32 GetFrameCount() const noexcept { return NumFrames; }
+
+    /// Returns the recorded frames, oldest first. At most FrameHistorySize frames are kept.
+    [[nodiscard]] std::vector<FrameRecord> GetFrameHistory() const;
+
+    /// Estimates the tick rate by comparing the elapsed ticks and wall time since the last reset.
+    [[nodiscard]] double GetTicksPerSecond() const noexcept;
+
+    static const char* GetSectionName(Section section) noexcept;
+    static const char* GetEventName(int slot) noexcept;
+
+    /// Writes all counters to a JSON file.
+    bool DumpJSON(const std::string& path) const;
+
+    /// Writes the frame history to a file in the Chrome trace event format,
+    /// viewable in chrome://tracing or Perfetto.
+    bool DumpChromeTrace(const std::string& path) const;
+
+private:
+    Counter Sections[Section_MAX];
+    Counter Events[EventSlots];
+    u64 BlocksExecuted[2];
+    u64 BlocksCompiled[2];
+
+    std::vector<FrameRecord> FrameHistory;
+    u32 NumFrames;
+    u64 LastFrameTicks[Section_MAX];
+
+    u64 ResetTick;
+    std::chrono::steady_clock::time_point ResetTime;
+};
+
+}
+
+#endif // PROFILER_H
@@ -24,6 +24,8 @@
 
 namespace melonDS
 {
+class NDS;
+
 class RTC
 {
 public:
@@ -205,9 +205,11 @@ SPU::SPU(melonDS::NDS& nds, AudioBitDepth bitdepth, AudioInterpolation interpola
         SPUCaptureUnit(0, nds),
         SPUCaptureUnit(1, nds),
     },
-    AudioLock(Platform::Mutex_Create()),
     Degrade10Bit(bitdepth == AudioBitDepth::_10Bit || (nds.ConsoleType == 1 && bitdepth == AudioBitDepth::Auto)),
-    OutputSampleRate(outputSampleRate)
+    OutputSampleRate(outputSampleRate),
+    OutputRing(std::make_unique<std::atomic<u64>[]>(OutputRingSize)),
+    OutputRequestRate(outputSampleRate),
+    BlipSampleRate(outputSampleRate)
 {
     NDS.RegisterEventFuncs(Event_SPU, this, {MakeEventThunk(SPU, Mix)});
 
@@ -217,16 +219,11 @@ SPU::SPU(melonDS::NDS& nds, AudioBitDepth bitdepth, AudioInterpolation interpola
     BlipLeft = blip_new(8192);
     BlipRight = blip_new(8192);
 
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-
     SetSampleRate(AudioSampleRate::_32KHz);
 }
 
 SPU::~SPU()
 {
-    Platform::Mutex_Free(AudioLock);
-    AudioLock = nullptr;
     blip_delete(BlipLeft);
     blip_delete(BlipRight);
 
@@ -253,16 +250,7 @@ void SPU::Reset()
 
 void SPU::Stop()
 {
-    Platform::Mutex_Lock(AudioLock);
-    memset(OutputBuffer, 0, 2*OutputBufferSize*2);
-
-    blip_clear(BlipLeft);
-    blip_clear(BlipRight);
-    BlipTimer = 0;
-
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-    Platform::Mutex_Unlock(AudioLock);
+    RequestOutput(OutputRequest_Skip | OutputRequest_Reset, OutputWritePos.load(std::memory_order_relaxed));
 }
 
 void SPU::DoSavestate(Savestate* file)
@@ -851,6 +839,8 @@ void SPUCaptureUnit::Run(u32 cycles, s32 sample)
 
 void SPU::Mix(u32 spucycles)
 {
+    PROFILE_SCOPE(NDS.Profiler, Section_SPUMix);
+
     s32 left = 0, right = 0;
     s32 leftoutput = 0, rightoutput = 0;
 
@@ -999,14 +989,10 @@ void SPU::Mix(u32 spucycles)
         output[1] &= 0xFFC0;
     }
 
-    BlipTimer += spucycles;
-    if (BlipTimer >= 8191 * 512)
-        BlipTimer = 8191 * 512;
-
-    if (output[0] != OutputLastSamples[0])
-        blip_add_delta(BlipLeft, BlipTimer, (int) output[0] - OutputLastSamples[0]);
-    if (output[1] != OutputLastSamples[1])
-        blip_add_delta(BlipRight, BlipTimer, (int) output[1] - OutputLastSamples[1]);
+    u32 writepos = OutputWritePos.load(std::memory_order_relaxed);
+    u64 entry = (u16)output[0] | ((u32)(u16)output[1] << 16) | ((u64)spucycles << 32);
+    OutputRing[writepos & (OutputRingSize-1)].store(entry, std::memory_order_relaxed);
+    OutputWritePos.store(writepos + 1, std::memory_order_release);
 
     OutputLastSamples[0] = output[0];
     OutputLastSamples[1] = output[1];
@@ -1014,103 +1000,56 @@ void SPU::Mix(u32 spucycles)
     NDS.ScheduleEvent(Event_SPU, true, MixInterval, 0, MixInterval >> 1);
 }
 
-void SPU::EndFrame()
+void SPU::RequestOutput(u8 request, u32 skippos)
 {
-    blip_end_frame(BlipLeft, BlipTimer);
-    blip_end_frame(BlipRight, BlipTimer);
-    BlipTimer = 0;
-
-    int avail = blip_samples_avail(BlipLeft);
-    s16 temp[avail * 2];
-    blip_read_samples(BlipLeft, temp, avail, true);
-    blip_read_samples(BlipRight, temp + 1, avail, true);
-
-    Platform::Mutex_Lock(AudioLock);
-    for (int i = 0; i < avail * 2; i += 2)
-    {
-        OutputBuffer[OutputBufferWritePos++] = temp[i];
-        OutputBuffer[OutputBufferWritePos++] = temp[i+1];
-
-        OutputBufferWritePos &= ((2*OutputBufferSize)-1);
-
-        if (OutputBufferWritePos == OutputBufferReadPos)
-        {
-            // advance the read position too, to avoid losing the entire FIFO
-            OutputBufferReadPos += 2;
-            OutputBufferReadPos &= ((2*OutputBufferSize)-1);
-        }
-    }
-    Platform::Mutex_Unlock(AudioLock);
+    OutputSkipPos.store(skippos, std::memory_order_relaxed);
+    OutputRequestRate.store(OutputSampleRate, std::memory_order_relaxed);
+    OutputRequest.fetch_or(request, std::memory_order_release);
 }
 
 void SPU::TrimOutput()
 {
-    Platform::Mutex_Lock(AudioLock);
-    const int halflimit = (OutputBufferSize / 2);
-
-    int readpos = OutputBufferWritePos - (halflimit*2);
-    if (readpos < 0) readpos += (OutputBufferSize*2);
+    // keep half a buffer worth of output
+    const u32 halflimit = (OutputBufferSize / 2);
+    u32 keep = (u32)(halflimit * (INTERNAL_SAMPLE_RATE / OutputSampleRate) / (MixInterval >> 1));
 
-    OutputBufferReadPos = readpos;
-    Platform::Mutex_Unlock(AudioLock);
+    RequestOutput(OutputRequest_Skip, OutputWritePos.load(std::memory_order_relaxed) - keep);
 }
 
 void SPU::DrainOutput()
 {
-    Platform::Mutex_Lock(AudioLock);
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-    Platform::Mutex_Unlock(AudioLock);
+    RequestOutput(OutputRequest_Skip, OutputWritePos.load(std::memory_order_relaxed));
 }
 
 void SPU::InitOutput()
 {
-    Platform::Mutex_Lock(AudioLock);
-
-    blip_set_rates(BlipLeft, INTERNAL_SAMPLE_RATE * OutputSkew, OutputSampleRate);
-    blip_set_rates(BlipRight, INTERNAL_SAMPLE_RATE * OutputSkew, OutputSampleRate);
-
     u32 needSamples = (u32) ceil(INTERNAL_SAMPLE_RATE / 60 / INTERNAL_SAMPLE_RATE * OutputSampleRate);
     u32 newBufferSize = 512;
     while (newBufferSize < needSamples)
         newBufferSize <<= 1;
     newBufferSize <<= 1;
+    OutputBufferSize = newBufferSize;
 
-    if (newBufferSize != OutputBufferSize)
-    {
-        if (OutputBuffer != nullptr)
-            free(OutputBuffer);
-        OutputBuffer = (s16*) malloc(2 * newBufferSize * 2);
-        OutputBufferSize = newBufferSize;
-    }
+    // enough ring entries to fill the output buffer at the 47KHz mixing rate
+    u32 limit = (u32) ceil(OutputBufferSize * (INTERNAL_SAMPLE_RATE / OutputSampleRate) / (704 >> 1));
+    OutputRingLimit.store(std::min(limit, OutputRingSize), std::memory_order_relaxed);
 
-    memset(OutputBuffer, 0, 2*OutputBufferSize*2);
-    OutputBufferReadPos = 0;
-    OutputBufferWritePos = 0;
-    Platform::Mutex_Unlock(AudioLock);
+    RequestOutput(OutputRequest_Skip | OutputRequest_Reset, OutputWritePos.load(std::memory_order_relaxed));
 }
 
 int SPU::GetOutputSize() const
 {
-    Platform::Mutex_Lock(AudioLock);
-
-    int ret;
-    if (OutputBufferWritePos >= OutputBufferReadPos)
-        ret = OutputBufferWritePos - OutputBufferReadPos;
-    else
-        ret = (OutputBufferSize*2) - OutputBufferReadPos + OutputBufferWritePos;
-
-    ret >>= 1;
+    u32 pending = OutputWritePos.load(std::memory_order_relaxed) - OutputReadPos.load(std::memory_order_acquire);
+    pending = std::min(pending, OutputRingLimit.load(std::memory_order_relaxed));
 
-    Platform::Mutex_Unlock(AudioLock);
-    return ret;
+    // the entries that weren't resampled yet are counted at the current mixing rate
+    double cycles = (double)pending * (MixInterval >> 1);
+    return OutputResampled.load(std::memory_order_relaxed) + (int)(cycles * OutputSampleRate / INTERNAL_SAMPLE_RATE);
 }
 
 void SPU::Sync(bool wait)
 {
     // this function is currently not used anywhere
-    // depending on the usage context the thread safety measures could be made
-    // a lot faster
 
     // sync to audio output in case the core is running too fast
     // * wait=true: wait until enough audio data has been played
@@ -1125,41 +1064,86 @@ void SPU::Sync(bool wait)
     }
     else if (GetOutputSize() > halflimit)
     {
-        Platform::Mutex_Lock(AudioLock);
-
-        int readpos = OutputBufferWritePos - (halflimit*2);
-        if (readpos < 0) readpos += (OutputBufferSize*2);
-
-        OutputBufferReadPos = readpos;
-
-        Platform::Mutex_Unlock(AudioLock);
+        TrimOutput();
     }
 }
 
 int SPU::ReadOutput(s16* data, int samples)
 {
-    Platform::Mutex_Lock(AudioLock);
-    if (OutputBufferReadPos == OutputBufferWritePos)
+    // the resampler can't hold more than that
+    samples = std::min(samples, 4096);
+
+    u32 readpos = OutputReadPos.load(std::memory_order_relaxed);
+
+    u8 request = OutputRequest.exchange(0, std::memory_order_acquire);
+    if (request & OutputRequest_Skip)
     {
-        Platform::Mutex_Unlock(AudioLock);
-        return 0;
+        u32 skippos = OutputSkipPos.load(std::memory_order_relaxed);
+        if ((s32)(skippos - readpos) > 0)
+            readpos = skippos;
+    }
+    if (request & OutputRequest_Reset)
+    {
+        BlipSampleRate = OutputRequestRate.load(std::memory_order_relaxed);
+        blip_clear(BlipLeft);
+        blip_clear(BlipRight);
+        blip_set_rates(BlipLeft, INTERNAL_SAMPLE_RATE * OutputSkew, BlipSampleRate);
+        blip_set_rates(BlipRight, INTERNAL_SAMPLE_RATE * OutputSkew, BlipSampleRate);
+        BlipTimer = 0;
+        memset(BlipLastSamples, 0, sizeof(BlipLastSamples));
     }
 
-    for (int i = 0; i < samples; i++)
+    // resample just as much as needed, a thousand SPU samples at a time
+    // to stay well within what the resampler can take in one go
+    while (blip_samples_avail(BlipLeft) < samples)
     {
-        *data++ = OutputBuffer[OutputBufferReadPos++];
-        *data++ = OutputBuffer[OutputBufferReadPos++];
-        OutputBufferReadPos &= ((2*OutputBufferSize)-1);
+        u32 writepos = OutputWritePos.load(std::memory_order_acquire);
+        u32 limit = OutputRingLimit.load(std::memory_order_relaxed);
 
-        if (OutputBufferWritePos == OutputBufferReadPos)
+        // if we fell too far behind, drop the oldest samples
+        if ((writepos - readpos) > limit)
+            readpos = writepos - limit;
+        if (readpos == writepos)
+            break;
+
+        u32 num = std::min(writepos - readpos, 1024u);
+        for (u32 i = 0; i < num; i++)
         {
-            Platform::Mutex_Unlock(AudioLock);
-            return i+1;
+            u64 entry = OutputRing[(readpos + i) & (OutputRingSize-1)].load(std::memory_order_relaxed);
+            s16 left = (s16)entry;
+            s16 right = (s16)(entry >> 16);
+
+            BlipTimer += (u32)(entry >> 32);
+            if (BlipTimer >= 8191 * 512)
+                BlipTimer = 8191 * 512;
+
+            if (left != BlipLastSamples[0])
+                blip_add_delta(BlipLeft, BlipTimer, (int) left - BlipLastSamples[0]);
+            if (right != BlipLastSamples[1])
+                blip_add_delta(BlipRight, BlipTimer, (int) right - BlipLastSamples[1]);
+
+            BlipLastSamples[0] = left;
+            BlipLastSamples[1] = right;
         }
+        readpos += num;
+
+        blip_end_frame(BlipLeft, BlipTimer);
+        blip_end_frame(BlipRight, BlipTimer);
+        BlipTimer = 0;
+    }
+
+    OutputReadPos.store(readpos, std::memory_order_release);
+
+    int avail = blip_samples_avail(BlipLeft);
+    int num = std::min(avail, samples);
+    if (num > 0)
+    {
+        blip_read_samples(BlipLeft, data, num, true);
+        blip_read_samples(BlipRight, data + 1, num, true);
     }
 
-    Platform::Mutex_Unlock(AudioLock);
-    return samples;
+    OutputResampled.store(avail - num, std::memory_order_relaxed);
+    return num;
 }
 
 void SPU::SetOutputSampleRate(double rate)
@@ -1170,8 +1154,8 @@ void SPU::SetOutputSampleRate(double rate)
 
 void SPU::SetOutputSkew(double skew)
 {
-    blip_set_rates(BlipLeft, INTERNAL_SAMPLE_RATE * skew, OutputSampleRate);
-    blip_set_rates(BlipRight, INTERNAL_SAMPLE_RATE * skew, OutputSampleRate);
+    blip_set_rates(BlipLeft, INTERNAL_SAMPLE_RATE * skew, BlipSampleRate);
+    blip_set_rates(BlipRight, INTERNAL_SAMPLE_RATE * skew, BlipSampleRate);
     OutputSkew = skew;
 }
 
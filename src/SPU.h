@@ -19,6 +19,9 @@
 #ifndef SPU_H
 #define SPU_H
 
+#include <atomic>
+#include <memory>
+
 #include "Savestate.h"
 #include "Platform.h"
 
@@ -245,7 +248,13 @@ public:
     void SetApplyBias(bool enable);
 
     void Mix(u32 spucycles);
-    void EndFrame();
+
+    // The mixed samples are passed to the audio output through a lock-free ring, at the SPU's
+    // own rate. They're resampled to the output rate when they're read, so the emulation
+    // thread never waits on the audio output thread.
+    //
+    // ReadOutput() and SetOutputSkew() are to be called from the audio output thread
+    // (only one at a time), everything else from the emulation thread.
 
     void TrimOutput();
     void DrainOutput();
@@ -264,24 +273,47 @@ public:
     void Write32(u32 addr, u32 val);
 
 private:
+    void RequestOutput(u8 request, u32 skippos);
+
+    enum
+    {
+        OutputRequest_Skip = 1<<0,
+        OutputRequest_Reset = 1<<1,
+    };
+
     u32 OutputBufferSize = 0;
     double OutputSampleRate;
-    double OutputSkew = 1.0;
     melonDS::NDS& NDS;
 
+    // each entry holds the left and right samples in the low 32 bits,
+    // and the number of SPU cycles since the previous entry above that
+    static constexpr u32 OutputRingSize = 8192;
+    std::unique_ptr<std::atomic<u64>[]> OutputRing;
+    // free-running, only the writer advances OutputWritePos and only the reader OutputReadPos
+    std::atomic<u32> OutputWritePos = 0;
+    std::atomic<u32> OutputReadPos = 0;
+    // how far the reader can fall behind before the oldest entries are dropped
+    std::atomic<u32> OutputRingLimit = OutputRingSize;
+    // output samples that were resampled but not read yet
+    std::atomic<u32> OutputResampled = 0;
+
+    // requests from the emulation thread, carried out by the reader
+    std::atomic<u8> OutputRequest = 0;
+    std::atomic<u32> OutputSkipPos = 0;
+    std::atomic<double> OutputRequestRate;
+
+    // resampler, owned by the reader
     blip_t* BlipLeft;
     blip_t* BlipRight;
     int BlipTimer = 0;
+    s16 BlipLastSamples[2] {};
+    double BlipSampleRate;
+    double OutputSkew = 1.0;
 
-    s16* OutputBuffer;
-    u32 OutputBufferWritePos = 0;
-    u32 OutputBufferReadPos = 0;
     s16 OutputLastSamples[2];
 
     u32 MixInterval;
 
-    Platform::Mutex* AudioLock;
-
     u16 Cnt = 0;
     u8 MasterVolume = 0;
     u16 Bias = 0;
@@ -266,6 +266,10 @@ void Savestate::Rewind(bool save)
 
     buffer_offset = 0;
     finished = false;
+
+    // the buffer can be reused for a new state
+    if (Saving)
+        WriteSavestateHeader();
 }
 
 void Savestate::CloseCurrentSection()
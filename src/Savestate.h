@@ -79,7 +79,7 @@ public:
 
     void Finish();
 
-    // TODO rewinds the stream
+    // rewinds the stream, to load the state again or to save a new one in its place
     void Rewind(bool save);
 
     bool IsAtLeastVersion(u32 major, u32 minor)
@@ -0,0 +1,373 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+#include <algorithm>
+
+#include "SectorCache.h"
+
+namespace melonDS
+{
+using namespace Platform;
+
+SectorCache::SectorCache(u32 capacity) noexcept :
+    Capacity(capacity)
+{
+}
+
+SectorCache::~SectorCache()
+{
+    Flush();
+}
+
+SectorCache::SectorCache(SectorCache&& other) noexcept :
+    File(other.File),
+    Length(other.Length),
+    NumSectors(other.NumSectors),
+    Capacity(other.Capacity),
+    Data(std::move(other.Data)),
+    Slots(std::move(other.Slots)),
+    Index(std::move(other.Index)),
+    Head(other.Head),
+    Tail(other.Tail),
+    NumUsed(other.NumUsed),
+    NumDirty(other.NumDirty),
+    WrittenSinceIdle(other.WrittenSinceIdle)
+{
+    other.File = nullptr;
+    other.Clear();
+}
+
+SectorCache& SectorCache::operator=(SectorCache&& other) noexcept
+{
+    if (this != &other)
+    {
+        Flush();
+
+        File = other.File;
+        Length = other.Length;
+        NumSectors = other.NumSectors;
+        Capacity = other.Capacity;
+        Data = std::move(other.Data);
+        Slots = std::move(other.Slots);
+        Index = std::move(other.Index);
+        Head = other.Head;
+        Tail = other.Tail;
+        NumUsed = other.NumUsed;
+        NumDirty = other.NumDirty;
+        WrittenSinceIdle = other.WrittenSinceIdle;
+
+        other.File = nullptr;
+        other.Clear();
+    }
+
+    return *this;
+}
+
+void SectorCache::SetFile(FileHandle* file, u64 length)
+{
+    Flush();
+    Clear();
+
+    File = file;
+    Length = length;
+    NumSectors = (length + SectorSize - 1) / SectorSize;
+}
+
+void SectorCache::Clear()
+{
+    Data.clear();
+    Slots.clear();
+    Index.clear();
+    Head = None;
+    Tail = None;
+    NumUsed = 0;
+    NumDirty = 0;
+    WrittenSinceIdle = false;
+}
+
+
+void SectorCache::Unlink(u32 slot)
+{
+    Slot& s = Slots[slot];
+    if (s.Prev != None) Slots[s.Prev].Next = s.Next;
+    else Head = s.Next;
+    if (s.Next != None) Slots[s.Next].Prev = s.Prev;
+    else Tail = s.Prev;
+}
+
+void SectorCache::PushFront(u32 slot)
+{
+    Slot& s = Slots[slot];
+    s.Prev = None;
+    s.Next = Head;
+    if (Head != None) Slots[Head].Prev = slot;
+    Head = slot;
+    if (Tail == None) Tail = slot;
+}
+
+u32 SectorCache::Find(u64 sector)
+{
+    auto it = Index.find(sector);
+    if (it == Index.end())
+        return None;
+
+    u32 slot = it->second;
+    if (slot != Head)
+    {
+        Unlink(slot);
+        PushFront(slot);
+    }
+    return slot;
+}
+
+u32 SectorCache::Insert(u64 sector)
+{
+    if (Data.empty())
+    {
+        Data.resize((size_t)Capacity * SectorSize);
+        Slots.resize(Capacity);
+    }
+
+    u32 slot;
+    if (NumUsed < Capacity)
+    {
+        slot = NumUsed++;
+    }
+    else
+    {
+        slot = Tail;
+
+        // write everything back in one go rather than sector by sector as they get evicted
+        if (Slots[slot].Dirty)
+            Flush();
+
+        Unlink(slot);
+        Index.erase(Slots[slot].Sector);
+    }
+
+    Slots[slot].Sector = sector;
+    Slots[slot].Dirty = false;
+    PushFront(slot);
+    Index[sector] = slot;
+    return slot;
+}
+
+
+u32 SectorCache::ReadFile(u64 sector, u32 num, u8* data)
+{
+    u64 addr = sector * SectorSize;
+    u32 len = num * SectorSize;
+
+    u64 res = 0;
+    if (FileSeek(File, addr, FileSeekOrigin::Start))
+        res = FileRead(data, 1, std::min<u64>(len, Length - addr), File);
+
+    // past the end of the file, e.g. a freshly created image
+    if (res < len)
+        memset(&data[res], 0, len - res);
+
+    return num;
+}
+
+void SectorCache::WriteFile(u64 sector, u32 num, const u8* data)
+{
+    u64 addr = sector * SectorSize;
+    u32 len = (u32)std::min<u64>(num * SectorSize, Length - addr);
+
+    if (FileSeek(File, addr, FileSeekOrigin::Start))
+        FileWrite(data, 1, len, File);
+}
+
+u32 SectorCache::Read(u64 sector, u32 num, u8* data)
+{
+    if (!File || sector >= NumSectors) return 0;
+    num = (u32)std::min<u64>(num, NumSectors - sector);
+
+    if (Capacity == 0)
+        return ReadFile(sector, num, data);
+
+    for (u32 i = 0; i < num; )
+    {
+        u32 slot = Find(sector + i);
+        if (slot != None)
+        {
+            memcpy(&data[i * SectorSize], &Data[(size_t)slot * SectorSize], SectorSize);
+            i++;
+            continue;
+        }
+
+        // read the whole run of missing sectors at once
+        u32 run = 1;
+        while ((i + run) < num && Index.find(sector + i + run) == Index.end())
+            run++;
+
+        u8* out = &data[i * SectorSize];
+        ReadFile(sector + i, run, out);
+
+        if (run <= MaxCachedRead)
+        {
+            for (u32 j = 0; j < run; j++)
+            {
+                slot = Insert(sector + i + j);
+                memcpy(&Data[(size_t)slot * SectorSize], &out[j * SectorSize], SectorSize);
+            }
+        }
+
+        i += run;
+    }
+
+    return num;
+}
+
+u32 SectorCache::Write(u64 sector, u32 num, const u8* data)
+{
+    if (!File || sector >= NumSectors) return 0;
+    num = (u32)std::min<u64>(num, NumSectors - sector);
+
+    if (Capacity == 0)
+    {
+        WriteFile(sector, num, data);
+        return num;
+    }
+
+    for (u32 i = 0; i < num; i++)
+    {
+        u32 slot = Find(sector + i);
+        if (slot == None)
+            slot = Insert(sector + i);
+
+        memcpy(&Data[(size_t)slot * SectorSize], &data[i * SectorSize], SectorSize);
+        if (!Slots[slot].Dirty)
+        {
+            Slots[slot].Dirty = true;
+            NumDirty++;
+        }
+    }
+
+    WrittenSinceIdle = true;
+    return num;
+}
+
+u32 SectorCache::ReadBytes(u64 addr, u32 len, u8* data)
+{
+    u8 buf[SectorSize];
+    u32 done = 0;
+
+    while (done < len)
+    {
+        u64 sector = (addr + done) / SectorSize;
+        u32 offset = (addr + done) % SectorSize;
+        u32 chunk = std::min(len - done, SectorSize - offset);
+
+        if (offset == 0 && chunk == SectorSize)
+        {
+            // whole sectors can be read in one go
+            u32 num = (len - done) / SectorSize;
+            u32 res = Read(sector, num, &data[done]);
+            if (!res) break;
+            done += res * SectorSize;
+            continue;
+        }
+
+        if (!Read(sector, 1, buf)) break;
+        memcpy(&data[done], &buf[offset], chunk);
+        done += chunk;
+    }
+
+    return done;
+}
+
+u32 SectorCache::WriteBytes(u64 addr, u32 len, const u8* data)
+{
+    u8 buf[SectorSize];
+    u32 done = 0;
+
+    while (done < len)
+    {
+        u64 sector = (addr + done) / SectorSize;
+        u32 offset = (addr + done) % SectorSize;
+        u32 chunk = std::min(len - done, SectorSize - offset);
+
+        if (offset == 0 && chunk == SectorSize)
+        {
+            u32 num = (len - done) / SectorSize;
+            u32 res = Write(sector, num, &data[done]);
+            if (!res) break;
+            done += res * SectorSize;
+            continue;
+        }
+
+        // partial sector: read-modify-write
+        if (!Read(sector, 1, buf)) break;
+        memcpy(&buf[offset], &data[done], chunk);
+        Write(sector, 1, buf);
+        done += chunk;
+    }
+
+    return done;
+}
+
+
+void SectorCache::Flush()
+{
+    WrittenSinceIdle = false;
+    if (NumDirty == 0 || !File) return;
+
+    std::vector<u32> dirty;
+    dirty.reserve(NumDirty);
+    for (u32 slot = 0; slot < NumUsed; slot++)
+    {
+        if (Slots[slot].Dirty)
+            dirty.push_back(slot);
+    }
+
+    std::sort(dirty.begin(), dirty.end(), [this](u32 a, u32 b) { return Slots[a].Sector < Slots[b].Sector; });
+
+    // coalesce consecutive sectors into single writes
+    constexpr u32 maxrun = 128;
+    std::vector<u8> buf(maxrun * SectorSize);
+    for (size_t i = 0; i < dirty.size(); )
+    {
+        u64 first = Slots[dirty[i]].Sector;
+        u32 run = 0;
+        while ((i + run) < dirty.size() && run < maxrun && Slots[dirty[i + run]].Sector == first + run)
+        {
+            u32 slot = dirty[i + run];
+            memcpy(&buf[run * SectorSize], &Data[(size_t)slot * SectorSize], SectorSize);
+            Slots[slot].Dirty = false;
+            run++;
+        }
+
+        WriteFile(first, run, buf.data());
+        i += run;
+    }
+
+    NumDirty = 0;
+    FileFlush(File);
+}
+
+void SectorCache::FlushIfIdle()
+{
+    if (!WrittenSinceIdle)
+        Flush();
+
+    WrittenSinceIdle = false;
+}
+
+}
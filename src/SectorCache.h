@@ -0,0 +1,113 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef SECTORCACHE_H
+#define SECTORCACHE_H
+
+#include <unordered_map>
+#include <vector>
+
+#include "Platform.h"
+#include "types.h"
+
+namespace melonDS
+{
+/// In-memory cache of the 512-byte sectors of a disk image file (SD card images, the DSi NAND).
+///
+/// Emulated software keeps going back to the same few FAT and directory sectors,
+/// so recently used sectors are kept, and the least recently used one is evicted when the cache is full.
+/// Writes stay in the cache until Flush(), which writes consecutive dirty sectors back together.
+/// Large reads, which are usually file contents, bypass the cache so they don't evict those sectors.
+class SectorCache
+{
+public:
+    static constexpr u32 SectorSize = 0x200;
+
+    /// 1MB, enough for the FAT and directories of a busy SD card.
+    static constexpr u32 DefaultCapacity = 2048;
+
+    /// @param capacity Number of cached sectors, 0 disables caching.
+    explicit SectorCache(u32 capacity = DefaultCapacity) noexcept;
+    ~SectorCache();
+    SectorCache(const SectorCache&) = delete;
+    SectorCache& operator=(const SectorCache&) = delete;
+    SectorCache(SectorCache&& other) noexcept;
+    SectorCache& operator=(SectorCache&& other) noexcept;
+
+    /// Sets the image file to cache, and drops the cached sectors of the previous one after flushing them.
+    /// The file remains owned by the caller, and must outlive its use by the cache.
+    /// @param length Length of the image in bytes; accesses past it are clipped.
+    void SetFile(Platform::FileHandle* file, u64 length);
+
+    [[nodiscard]] u32 GetCapacity() const noexcept { return Capacity; }
+
+    /// Reads sectors, returns how many were read.
+    u32 Read(u64 sector, u32 num, u8* data);
+
+    /// Writes sectors, returns how many were written.
+    u32 Write(u64 sector, u32 num, const u8* data);
+
+    /// Reads or writes any range of bytes, going through the cached sectors.
+    u32 ReadBytes(u64 addr, u32 len, u8* data);
+    u32 WriteBytes(u64 addr, u32 len, const u8* data);
+
+    /// Writes the dirty sectors back to the file.
+    void Flush();
+
+    /// Flushes the dirty sectors if nothing was written since the previous call.
+    /// Meant to be called periodically, e.g. once per frame.
+    void FlushIfIdle();
+
+private:
+    static constexpr u32 None = 0xFFFFFFFF;
+
+    // reads of more sectors than this go straight to the file
+    static constexpr u32 MaxCachedRead = 64;
+
+    struct Slot
+    {
+        u64 Sector;
+        u32 Prev, Next; // towards the most and least recently used sectors
+        bool Dirty;
+    };
+
+    u32 Find(u64 sector);
+    u32 Insert(u64 sector);
+    void Unlink(u32 slot);
+    void PushFront(u32 slot);
+    void Clear();
+
+    u32 ReadFile(u64 sector, u32 num, u8* data);
+    void WriteFile(u64 sector, u32 num, const u8* data);
+
+    Platform::FileHandle* File = nullptr;
+    u64 Length = 0;
+    u64 NumSectors = 0;
+
+    u32 Capacity;
+    std::vector<u8> Data;
+    std::vector<Slot> Slots;
+    std::unordered_map<u64, u32> Index;
+    u32 Head = None, Tail = None;
+    u32 NumUsed = 0;
+    u32 NumDirty = 0;
+    bool WrittenSinceIdle = false;
+};
+
+}
+#endif // SECTORCACHE_H
@@ -0,0 +1,282 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#if defined(__SWITCH__)
+// no file mappings, ROMs are always loaded into memory
+#elif defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#else
+#include <atomic>
+#include <stdio.h>
+#endif
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "SharedROM.h"
+#include "Platform.h"
+
+namespace melonDS
+{
+using namespace Platform;
+
+static u32 PadLength(u64 len)
+{
+    // cart ROMs are at most 2GB, 0 means the length isn't supported
+    if (len == 0 || len > 0x80000000)
+        return 0;
+
+    u32 padded = 1;
+    while (padded < len)
+        padded <<= 1;
+    return padded;
+}
+
+#if defined(__SWITCH__)
+
+void ROMDeleter::operator()(u8* ptr) const noexcept
+{
+    delete[] ptr;
+}
+
+std::shared_ptr<SharedROM> SharedROM::FromFile(const std::string& path) noexcept
+{
+    return nullptr;
+}
+
+std::shared_ptr<SharedROM> SharedROM::FromBuffer(const u8* data, u32 len) noexcept
+{
+    return nullptr;
+}
+
+SharedROM::~SharedROM() noexcept
+{
+}
+
+ROMBuffer SharedROM::Map() const noexcept
+{
+    return nullptr;
+}
+
+#elif defined(_WIN32)
+
+void ROMDeleter::operator()(u8* ptr) const noexcept
+{
+    if (MappedLength)
+        UnmapViewOfFile(ptr);
+    else
+        delete[] ptr;
+}
+
+std::shared_ptr<SharedROM> SharedROM::FromFile(const std::string& path) noexcept
+{
+    int wlen = MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, nullptr, 0);
+    if (wlen <= 0) return nullptr;
+    std::wstring wpath(wlen, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, path.c_str(), -1, wpath.data(), wlen);
+
+    HANDLE file = CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size))
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // a view can't extend past the end of the file, so it can't be padded
+    u32 padded = PadLength(size.QuadPart);
+    if (padded == 0 || padded != size.QuadPart)
+    {
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) return nullptr;
+
+    std::shared_ptr<SharedROM> rom(new SharedROM());
+    rom->Length = (u32)size.QuadPart;
+    rom->PaddedLength = padded;
+    rom->FileBacked = true;
+    rom->Mapping = mapping;
+    return rom;
+}
+
+std::shared_ptr<SharedROM> SharedROM::FromBuffer(const u8* data, u32 len) noexcept
+{
+    u32 padded = PadLength(len);
+    if (padded == 0) return nullptr;
+
+    HANDLE mapping = CreateFileMapping(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, padded, nullptr);
+    if (!mapping) return nullptr;
+
+    u8* dst = (u8*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, len);
+    if (!dst)
+    {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    memcpy(dst, data, len);
+    UnmapViewOfFile(dst);
+
+    std::shared_ptr<SharedROM> rom(new SharedROM());
+    rom->Length = len;
+    rom->PaddedLength = padded;
+    rom->Mapping = mapping;
+    return rom;
+}
+
+SharedROM::~SharedROM() noexcept
+{
+    if (Mapping)
+        CloseHandle(Mapping);
+}
+
+ROMBuffer SharedROM::Map() const noexcept
+{
+    void* view = MapViewOfFile(Mapping, FILE_MAP_COPY, 0, 0, PaddedLength);
+    if (!view)
+    {
+        Log(LogLevel::Error, "SharedROM: failed to map ROM (%lx)\n", GetLastError());
+        return nullptr;
+    }
+
+    return ROMBuffer((u8*)view, ROMDeleter(PaddedLength));
+}
+
+#else
+
+void ROMDeleter::operator()(u8* ptr) const noexcept
+{
+    if (MappedLength)
+        munmap(ptr, MappedLength);
+    else
+        delete[] ptr;
+}
+
+std::shared_ptr<SharedROM> SharedROM::FromFile(const std::string& path) noexcept
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return nullptr;
+
+    struct stat st;
+    u32 padded = 0;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+        padded = PadLength(st.st_size);
+
+    if (padded == 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<SharedROM> rom(new SharedROM());
+    rom->Length = (u32)st.st_size;
+    rom->PaddedLength = padded;
+    rom->FileBacked = true;
+    rom->File = fd;
+    return rom;
+}
+
+std::shared_ptr<SharedROM> SharedROM::FromBuffer(const u8* data, u32 len) noexcept
+{
+    u32 padded = PadLength(len);
+    if (padded == 0) return nullptr;
+
+#if defined(__linux__)
+    int fd = syscall(SYS_memfd_create, "melondsrom", 1 /* MFD_CLOEXEC */);
+#else
+    static std::atomic<u32> counter = 0;
+    char name[64];
+    snprintf(name, sizeof(name), "/melondsrom%d_%u", (int)getpid(), counter++);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd != -1)
+        shm_unlink(name);
+#endif
+    if (fd == -1) return nullptr;
+
+    if (ftruncate(fd, padded) < 0)
+    {
+        close(fd);
+        return nullptr;
+    }
+
+    void* dst = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (dst == MAP_FAILED)
+    {
+        close(fd);
+        return nullptr;
+    }
+    memcpy(dst, data, len);
+    munmap(dst, len);
+
+    std::shared_ptr<SharedROM> rom(new SharedROM());
+    rom->Length = len;
+    rom->PaddedLength = padded;
+    rom->File = fd;
+    return rom;
+}
+
+SharedROM::~SharedROM() noexcept
+{
+    if (File != -1)
+        close(File);
+}
+
+ROMBuffer SharedROM::Map() const noexcept
+{
+    void* view;
+    if (FileBacked && PaddedLength != Length)
+    {
+        // pages past the end of a file can't be accessed, so the padding is anonymous memory
+        view = mmap(nullptr, PaddedLength, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+        if (view != MAP_FAILED &&
+            mmap(view, Length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, File, 0) == MAP_FAILED)
+        {
+            munmap(view, PaddedLength);
+            view = MAP_FAILED;
+        }
+    }
+    else
+    {
+        view = mmap(nullptr, PaddedLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, File, 0);
+    }
+
+    if (view == MAP_FAILED)
+    {
+        Log(LogLevel::Error, "SharedROM: failed to map ROM (%s)\n", strerror(errno));
+        return nullptr;
+    }
+
+    return ROMBuffer((u8*)view, ROMDeleter(PaddedLength));
+}
+
+#endif
+
+}
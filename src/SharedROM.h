@@ -0,0 +1,94 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef SHAREDROM_H
+#define SHAREDROM_H
+
+#include <memory>
+#include <string>
+
+#include "types.h"
+
+namespace melonDS
+{
+/// Frees a cart ROM buffer, which is either allocated with new[] or mapped from a SharedROM.
+struct ROMDeleter
+{
+    ROMDeleter() noexcept = default;
+    ROMDeleter(std::default_delete<u8[]>) noexcept {}
+    explicit ROMDeleter(u32 mappedlen) noexcept : MappedLength(mappedlen) {}
+
+    void operator()(u8* ptr) const noexcept;
+
+    // 0 if the buffer was allocated with new[]
+    u32 MappedLength = 0;
+};
+
+/// A cart ROM buffer, implicitly constructible from a std::unique_ptr<u8[]>.
+using ROMBuffer = std::unique_ptr<u8[], ROMDeleter>;
+
+/// A cart ROM image that any number of emulator instances can use without each keeping a copy.
+///
+/// The image is kept in a file mapping (the ROM file itself, or shared memory for ROMs
+/// that were loaded some other way), and every cart gets its own copy-on-write view of it.
+/// Pages a cart modifies (re-encrypting the secure area, patching DLDI) become private to it,
+/// the rest is shared by all instances, and with the OS's file cache.
+class SharedROM
+{
+public:
+    /// Maps a ROM file.
+    /// @return The shared image, or \c nullptr if the file can't be mapped on this host;
+    /// the file should then be loaded into memory instead.
+    static std::shared_ptr<SharedROM> FromFile(const std::string& path) noexcept;
+
+    /// Copies a ROM held in memory (e.g. extracted from an archive) to shared memory.
+    /// @return The shared image, or \c nullptr if shared memory isn't available.
+    static std::shared_ptr<SharedROM> FromBuffer(const u8* data, u32 len) noexcept;
+
+    ~SharedROM() noexcept;
+    SharedROM(const SharedROM&) = delete;
+    SharedROM& operator=(const SharedROM&) = delete;
+
+    /// The actual length of the ROM.
+    [[nodiscard]] u32 GetLength() const noexcept { return Length; }
+
+    /// The length of the views, rounded up to a power of two like any cart ROM.
+    [[nodiscard]] u32 GetPaddedLength() const noexcept { return PaddedLength; }
+
+    /// Creates a new writable copy-on-write view of the image, zero-padded to GetPaddedLength().
+    /// @return The view, or \c nullptr if mapping it failed.
+    [[nodiscard]] ROMBuffer Map() const noexcept;
+
+private:
+    SharedROM() noexcept = default;
+
+    u32 Length = 0;
+    u32 PaddedLength = 0;
+
+    // whether the mapping object is only as long as the ROM file
+    bool FileBacked = false;
+
+#ifdef _WIN32
+    void* Mapping = nullptr;
+#else
+    int File = -1;
+#endif
+};
+
+}
+#endif // SHAREDROM_H
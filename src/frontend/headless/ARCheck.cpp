@@ -0,0 +1,612 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Action Replay compiler check.
+// Runs random AR programs both through AREngine, which compiles them, and through
+// the plain interpreter AREngine used before, and compares the memory they leave behind.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "NDS.h"
+#include "Args.h"
+#include "AREngine.h"
+#include "Platform.h"
+
+#include "Headless.h"
+
+using namespace melonDS;
+using Platform::Log;
+using Platform::LogLevel;
+
+namespace Headless
+{
+
+// the AR code interpreter as it was before codes were compiled, kept as the reference
+class ReferenceAREngine
+{
+public:
+    ReferenceAREngine(melonDS::NDS& nds) : NDS(nds) {}
+
+    void RunCheats(const std::vector<ARCode>& cheats)
+    {
+        for (const ARCode& code : cheats)
+        {
+            if (code.Enabled)
+                RunCheat(code);
+        }
+    }
+
+private:
+    void RunCheat(const ARCode& arcode);
+
+    melonDS::NDS& NDS;
+};
+
+#define case16(x) \
+    case ((x)+0x00): case ((x)+0x01): case ((x)+0x02): case ((x)+0x03): \
+    case ((x)+0x04): case ((x)+0x05): case ((x)+0x06): case ((x)+0x07): \
+    case ((x)+0x08): case ((x)+0x09): case ((x)+0x0A): case ((x)+0x0B): \
+    case ((x)+0x0C): case ((x)+0x0D): case ((x)+0x0E): case ((x)+0x0F)
+
+void ReferenceAREngine::RunCheat(const ARCode& arcode)
+{
+    const u32* code = &arcode.Code[0];
+
+    u32 offset = 0;
+    u32 datareg = 0;
+    u32 cond = 1;
+    u32 condstack = 0;
+
+    const u32* loopstart = code;
+    u32 loopcount = 0;
+    u32 loopcond = 1;
+    u32 loopcondstack = 0;
+
+    // TODO: does anything reset this??
+    u32 c5count = 0;
+
+    for (;;)
+    {
+        if (code > &arcode.Code[arcode.Code.size() - 1])
+            // If the instruction pointer is past the end of the cheat code...
+            break;
+
+        u32 a = *code++;
+        u32 b = *code++;
+
+        u8 op = a >> 24;
+
+        if ((op < 0xD0 && op != 0xC5) || op > 0xD2)
+        {
+            if (!cond)
+            {
+                if ((op & 0xF0) == 0xE0)
+                {
+                    for (u32 i = 0; i < b; i += 8)
+                        code += 2;
+                }
+
+                continue;
+            }
+        }
+
+        switch (op)
+        {
+        case16(0x00): // 32-bit write
+            NDS.ARM7Write32((a & 0x0FFFFFFF) + offset, b);
+            break;
+
+        case16(0x10): // 16-bit write
+            NDS.ARM7Write16((a & 0x0FFFFFFF) + offset, b & 0xFFFF);
+            break;
+
+        case16(0x20): // 8-bit write
+            NDS.ARM7Write8((a & 0x0FFFFFFF) + offset, b & 0xFF);
+            break;
+
+        case16(0x30): // IF b > u32[a]
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u32 chk = NDS.ARM7Read32(addr);
+
+                cond = (b > chk) ? 1:0;
+            }
+            break;
+
+        case16(0x40): // IF b < u32[a]
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u32 chk = NDS.ARM7Read32(addr);
+
+                cond = (b < chk) ? 1:0;
+            }
+            break;
+
+        case16(0x50): // IF b == u32[a]
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u32 chk = NDS.ARM7Read32(addr);
+
+                cond = (b == chk) ? 1:0;
+            }
+            break;
+
+        case16(0x60): // IF b != u32[a]
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u32 chk = NDS.ARM7Read32(addr);
+
+                cond = (b != chk) ? 1:0;
+            }
+            break;
+
+        case16(0x70): // IF b.l > ((~b.h) & u16[a])
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u16 val = NDS.ARM7Read16(addr);
+                u16 chk = ~(b >> 16);
+                chk &= val;
+
+                cond = ((b & 0xFFFF) > chk) ? 1:0;
+            }
+            break;
+
+        case16(0x80): // IF b.l < ((~b.h) & u16[a])
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u16 val = NDS.ARM7Read16(addr);
+                u16 chk = ~(b >> 16);
+                chk &= val;
+
+                cond = ((b & 0xFFFF) < chk) ? 1:0;
+            }
+            break;
+
+        case16(0x90): // IF b.l == ((~b.h) & u16[a])
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u16 val = NDS.ARM7Read16(addr);
+                u16 chk = ~(b >> 16);
+                chk &= val;
+
+                cond = ((b & 0xFFFF) == chk) ? 1:0;
+            }
+            break;
+
+        case16(0xA0): // IF b.l != ((~b.h) & u16[a])
+            {
+                condstack <<= 1;
+                condstack |= cond;
+
+                u32 addr = a & 0x0FFFFFFF;
+                if (!addr) addr = offset;
+                u16 val = NDS.ARM7Read16(addr);
+                u16 chk = ~(b >> 16);
+                chk &= val;
+
+                cond = ((b & 0xFFFF) != chk) ? 1:0;
+            }
+            break;
+
+        case16(0xB0): // offset = u32[a + offset]
+            offset = NDS.ARM7Read32((a & 0x0FFFFFFF) + offset);
+            break;
+
+        case 0xC0: // FOR 0..b
+            loopstart = code; // points to the first opcode after the FOR
+            loopcount = b;
+            loopcond = cond;           // checkme
+            loopcondstack = condstack; // (GBAtek is not very clear there)
+            break;
+
+        case 0xC4: // offset = pointer to C4000000 opcode
+            // theoretically used for safe storage, by accessing [offset+4]
+            // in practice could be used for a self-modifying AR code
+            // could be implemented with some hackery, but, does anything even
+            // use it??
+            Log(LogLevel::Error, "AR: !! THE FUCKING C4000000 OPCODE. TELL ARISOTURA.\n");
+            return;
+
+        case 0xC5: // count++ / IF (count & b.l) == b.h
+            {
+                // with weird condition checking, apparently
+                // oh well
+
+                c5count++;
+                if (!cond) break;
+
+                condstack <<= 1;
+                condstack |= cond;
+
+                u16 mask = b & 0xFFFF;
+                u16 chk = b >> 16;
+
+                cond = ((c5count & mask) == chk) ? 1:0;
+            }
+            break;
+
+        case 0xC6: // u32[b] = offset
+            NDS.ARM7Write32(b, offset);
+            break;
+
+        case 0xD0: // ENDIF
+            cond = condstack & 0x1;
+            condstack >>= 1;
+            break;
+
+        case 0xD1: // NEXT
+            if (loopcount > 0)
+            {
+                loopcount--;
+                code = loopstart;
+            }
+            else
+            {
+                cond = loopcond;
+                condstack = loopcondstack;
+            }
+            break;
+
+        case 0xD2: // NEXT+FLUSH
+            if (loopcount > 0)
+            {
+                loopcount--;
+                code = loopstart;
+            }
+            else
+            {
+                offset = 0;
+                datareg = 0;
+                condstack = 0;
+                cond = 1;
+            }
+            break;
+
+        case 0xD3: // offset = b
+            offset = b;
+            break;
+
+        case 0xD4: // datareg += b
+            datareg += b;
+            break;
+
+        case 0xD5: // datareg = b
+            datareg = b;
+            break;
+
+        case 0xD6: // u32[b+offset] = datareg / offset += 4
+            NDS.ARM7Write32(b + offset, datareg);
+            offset += 4;
+            break;
+
+        case 0xD7: // u16[b+offset] = datareg / offset += 2
+            NDS.ARM7Write16(b + offset, datareg & 0xFFFF);
+            offset += 2;
+            break;
+
+        case 0xD8: // u8[b+offset] = datareg / offset += 1
+            NDS.ARM7Write8(b + offset, datareg & 0xFF);
+            offset += 1;
+            break;
+
+        case 0xD9: // datareg = u32[b+offset]
+            datareg = NDS.ARM7Read32(b + offset);
+            break;
+
+        case 0xDA: // datareg = u16[b+offset]
+            datareg = NDS.ARM7Read16(b + offset);
+            break;
+
+        case 0xDB: // datareg = u8[b+offset]
+            datareg = NDS.ARM7Read8(b + offset);
+            break;
+
+        case 0xDC: // offset += b
+            offset += b;
+            break;
+
+        case16(0xE0): // copy b param bytes to address a+offset
+            {
+                // TODO: check for bad alignment of dstaddr
+
+                u32 dstaddr = (a & 0x0FFFFFFF) + offset;
+                u32 bytesleft = b;
+                while (bytesleft >= 8)
+                {
+                    NDS.ARM7Write32(dstaddr, *code++); dstaddr += 4;
+                    NDS.ARM7Write32(dstaddr, *code++); dstaddr += 4;
+                    bytesleft -= 8;
+                }
+                if (bytesleft > 0)
+                {
+                    u8* leftover = (u8*)code;
+                    code += 2;
+                    if (bytesleft >= 4)
+                    {
+                        NDS.ARM7Write32(dstaddr, *(u32*)leftover); dstaddr += 4;
+                        leftover += 4;
+                        bytesleft -= 4;
+                    }
+                    while (bytesleft > 0)
+                    {
+                        NDS.ARM7Write8(dstaddr, *leftover++); dstaddr++;
+                        bytesleft--;
+                    }
+                }
+            }
+            break;
+
+        case16(0xF0): // copy b bytes from address offset to address a
+            {
+                // TODO: check for bad alignment of srcaddr/dstaddr
+
+                u32 srcaddr = offset;
+                u32 dstaddr = (a & 0x0FFFFFFF);
+                u32 bytesleft = b;
+                while (bytesleft >= 4)
+                {
+                    NDS.ARM7Write32(dstaddr, NDS.ARM7Read32(srcaddr));
+                    srcaddr += 4;
+                    dstaddr += 4;
+                    bytesleft -= 4;
+                }
+                while (bytesleft > 0)
+                {
+                    NDS.ARM7Write8(dstaddr, NDS.ARM7Read8(srcaddr));
+                    srcaddr++;
+                    dstaddr++;
+                    bytesleft--;
+                }
+            }
+            break;
+
+        default:
+            Log(LogLevel::Warn, "!! bad AR opcode %08X %08X\n", a, b);
+            return;
+        }
+    }
+}
+
+#undef case16
+
+namespace
+{
+
+// generates random AR programs, biased towards what the compiler folds:
+// offsets and data registers set up and used by the following opcodes,
+// addresses in main RAM, and nested conditions
+struct ARCodeGenerator
+{
+    std::mt19937 Rng;
+
+    explicit ARCodeGenerator(u32 seed) : Rng(seed) {}
+
+    u32 Next() { return (u32)Rng(); }
+    u32 Random(u32 n) { return Next() % n; }
+    u32 RAMAddress() { return 0x02000000 + Random(0x40000); }
+    u32 AddressField() { return Random(3) ? (RAMAddress() & 0x0FFFFFFF) : Random(0x100); }
+
+    std::vector<u32> Generate()
+    {
+        std::vector<u32> code;
+        bool hadloop = false;
+        int len = 1 + Random(40);
+        for (int i = 0; i < len; i++)
+        {
+            u32 kind = Random(100);
+            u32 a, b = Next();
+            if (kind < 30)
+            {
+                // writes
+                a = (Random(3) << 28) | AddressField();
+                if (Random(2)) a |= Random(16) << 24;
+            }
+            else if (kind < 50)
+            {
+                // conditions
+                a = ((3 + Random(8)) << 28) | (Random(4) ? AddressField() : 0);
+                if (Random(2)) b &= 0xFFFF00FF;
+            }
+            else if (kind < 54) a = 0xB0000000 | (Random(2) ? (RAMAddress() & 0x0FFFFFFC) : Random(0x40) * 4);
+            else if (kind < 57 && !hadloop)
+            {
+                hadloop = true;
+                a = 0xC0000000;
+                b = Random(5);
+            }
+            else if (kind < 60)
+            {
+                a = 0xC5000000;
+                b = (Random(4) << 16) | 3;
+            }
+            else if (kind < 62)
+            {
+                a = 0xC6000000;
+                b = RAMAddress();
+            }
+            else if (kind < 70) a = 0xD0000000;
+            else if (kind < 73) a = 0xD1000000;
+            else if (kind < 75) a = 0xD2000000;
+            else if (kind < 79)
+            {
+                a = 0xD3000000;
+                b = Random(2) ? RAMAddress() : Random(0x100);
+            }
+            else if (kind < 81) a = 0xD4000000;
+            else if (kind < 83) a = 0xD5000000;
+            else if (kind < 88)
+            {
+                a = (0xD6 + Random(6)) << 24;
+                b = Random(2) ? RAMAddress() : Random(0x100);
+            }
+            else if (kind < 91)
+            {
+                a = 0xDC000000;
+                b = Random(0x40);
+            }
+            else if (kind < 94)
+            {
+                // E-type patch, followed by its data
+                a = 0xE0000000 | AddressField();
+                b = Random(40);
+                code.push_back(a);
+                code.push_back(b);
+                for (u32 j = 0; j < ((b + 7) / 8) * 2; j++)
+                    code.push_back(Next());
+                continue;
+            }
+            else if (kind < 96)
+            {
+                a = 0xF0000000 | (RAMAddress() & 0x0FFFFFFF);
+                b = Random(20);
+            }
+            else a = 0xDE000000; // C4 is left out, both sides just log an error for it
+
+            code.push_back(a);
+            code.push_back(b);
+        }
+        return code;
+    }
+};
+
+}
+
+int RunARCheck(u32 trials, u32 seed)
+{
+    // the programs log every bad opcode they run into
+    LogLevel threshold = LogThreshold;
+    LogThreshold = LogLevel::Error;
+
+    Runner runner;
+    NDSArgs args {};
+    args.JIT = std::nullopt;
+    auto nds = std::make_unique<NDS>(std::move(args), &runner);
+    nds->Reset();
+
+    ReferenceAREngine reference(*nds);
+    ARCodeGenerator gen(seed);
+
+    // the generated addresses stay in the first 256 KB of main RAM,
+    // but the programs can still write anywhere the ARM7 can
+    constexpr u32 randomSize = 0x40000;
+    const u32 ramsize = nds->MainRAMMask + 1;
+    std::vector<u8> mainram(ramsize), wram(ARM7WRAMSize);
+    std::vector<u8> refmainram(ramsize), refwram(ARM7WRAMSize);
+
+    u32 mismatches = 0;
+    for (u32 trial = 0; trial < trials; trial++)
+    {
+        for (u32 i = 0; i < randomSize; i += 4)
+        {
+            // plenty of pointers for the offset opcodes to follow
+            u32 val = gen.Random(2) ? (gen.RAMAddress() & ~3) : gen.Next();
+            memcpy(&nds->MainRAM[i], &val, 4);
+        }
+        memcpy(mainram.data(), nds->MainRAM, ramsize);
+        memcpy(wram.data(), nds->ARM7WRAM, ARM7WRAMSize);
+
+        std::vector<ARCode> cheats;
+        int numcheats = 1 + gen.Random(4);
+        for (int i = 0; i < numcheats; i++)
+            cheats.push_back({"check", gen.Random(5) != 0, gen.Generate()});
+
+        reference.RunCheats(cheats);
+        memcpy(refmainram.data(), nds->MainRAM, ramsize);
+        memcpy(refwram.data(), nds->ARM7WRAM, ARM7WRAMSize);
+
+        memcpy(nds->MainRAM, mainram.data(), ramsize);
+        memcpy(nds->ARM7WRAM, wram.data(), ARM7WRAMSize);
+        nds->AREngine.SetCheats(cheats);
+        nds->AREngine.RunCheats();
+
+        if (memcmp(refmainram.data(), nds->MainRAM, ramsize) ||
+            memcmp(refwram.data(), nds->ARM7WRAM, ARM7WRAMSize))
+        {
+            if (mismatches++ < 10)
+                printf("trial %u: compiled codes don't match the reference\n", trial);
+        }
+    }
+
+    printf("AR check: %u trials, %u mismatches (seed %u)\n", trials, mismatches, seed);
+
+    // a heavy but typical cheat list: a few hundred conditional RAM writes
+    std::vector<ARCode> heavy;
+    for (int i = 0; i < 300; i++)
+    {
+        heavy.push_back({"bench", true, {
+            0x92000000u | (gen.RAMAddress() & 0xFFFFE), 0xFCFF0000 | gen.Random(0x10000),
+            0x02000000u | (gen.RAMAddress() & 0xFFFFF), gen.Next(),
+            0x22000000u | (gen.RAMAddress() & 0xFFFFF), 0x63,
+            0x02000000u | (gen.RAMAddress() & 0xFFFFF), gen.Next(),
+            0x12000000u | (gen.RAMAddress() & 0xFFFFE), 0x63,
+            0xD2000000, 0}});
+    }
+
+    constexpr int benchFrames = 1000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < benchFrames; i++)
+        reference.RunCheats(heavy);
+    auto t1 = std::chrono::steady_clock::now();
+    nds->AREngine.SetCheats(heavy);
+    for (int i = 0; i < benchFrames; i++)
+        nds->AREngine.RunCheats();
+    auto t2 = std::chrono::steady_clock::now();
+
+    printf("300 codes per frame: reference %.2f us, compiled %.2f us\n",
+        std::chrono::duration<double, std::micro>(t1 - t0).count() / benchFrames,
+        std::chrono::duration<double, std::micro>(t2 - t1).count() / benchFrames);
+
+    LogThreshold = threshold;
+    return mismatches ? 1 : 0;
+}
+
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <optional>
+#include <string>
+
+#include "Platform.h"
+#include "types.h"
+
+namespace Headless
+{
+
+/// Messages logged by the core below this level are dropped.
+extern melonDS::Platform::LogLevel LogThreshold;
+
+enum class RendererKind
+{
+    Software,
+    SoftwareThreaded,
+    /// Software renderer that also renders the 3D scene upscaled (SoftHDRenderer).
+    SoftwareHD,
+};
+
+struct Options
+{
+    std::string ROMPath;
+    std::optional<std::string> ARM9BIOSPath;
+    std::optional<std::string> ARM7BIOSPath;
+    std::optional<std::string> FirmwarePath;
+
+    melonDS::u32 Frames = 3600;
+    bool JIT = true;
+    bool CachedInterpreter = false;
+    bool FastMemory = true;
+    bool IdleLoopSkipping = true;
+    bool BurstCartTransfers = false;
+    melonDS::u32 BurstCartTiming = 25;
+    melonDS::u32 FrameSkip = 0;
+    RendererKind Renderer = RendererKind::Software;
+    /// Resolution multiplier of the upscaled 3D frame, with RendererKind::SoftwareHD.
+    int Scale = 2;
+    /// Number of threads of a pool of its own for the upscaled 3D frame, 0 uses the shared job pool.
+    int RenderThreads = 0;
+    /// Writes the last upscaled 3D frame to a PPM file.
+    std::optional<std::string> HDDumpPath;
+    /// Runs the 2D engines on their own thread.
+    bool Threaded2D = false;
+    bool DirectBoot = true;
+
+    /// Records the run into a movie file, with per-frame hashes.
+    std::optional<std::string> RecordPath;
+    /// Replays a movie file instead of running with no input.
+    /// The run stops at the end of the movie unless fewer frames were requested.
+    std::optional<std::string> ReplayPath;
+    /// Writes the time and output hash of every frame to a CSV file.
+    std::optional<std::string> FrameLogPath;
+    /// Writes the profiler counters to a JSON file. Requires a build with ENABLE_PROFILER.
+    std::optional<std::string> ProfilePath;
+    /// Writes the profiler's frame history as a Chrome trace. Requires a build with ENABLE_PROFILER.
+    std::optional<std::string> TracePath;
+    bool FramesSet = false;
+
+    /// Checks the compiled Action Replay codes against the reference interpreter
+    /// on that many random programs, instead of running a ROM.
+    std::optional<melonDS::u32> ARCheckTrials;
+    melonDS::u32 ARCheckSeed = 1234;
+};
+
+/// Per-run state, passed to the core as the platform userdata.
+struct Runner
+{
+    /// Set when the emulated console stops by itself (power off, fatal error).
+    bool Stopped = false;
+};
+
+/// Runs the Action Replay compiler check, returns the process exit code.
+int RunARCheck(melonDS::u32 trials, melonDS::u32 seed);
+
+}
+
+#endif // HEADLESS_H
@@ -0,0 +1,519 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Platform implementation for the headless runner.
+// Only depends on the C++ standard library, so the runner can be built and
+// used on machines without any display or audio stack.
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+#include "Platform.h"
+#include "Headless.h"
+
+#ifdef __WIN32__
+#define fseek _fseeki64
+#define ftell _ftelli64
+#endif // __WIN32__
+
+namespace melonDS::Platform
+{
+
+static const auto StartTime = std::chrono::steady_clock::now();
+
+void SignalStop(StopReason reason, void* userdata)
+{
+    Headless::Runner* runner = (Headless::Runner*)userdata;
+    if (runner)
+        runner->Stopped = true;
+}
+
+
+static std::string GetModeString(FileMode mode, bool file_exists)
+{
+    std::string modeString;
+
+    if (mode & FileMode::Append)
+        modeString += 'a';
+    else if (!(mode & FileMode::Write))
+        modeString += 'r';
+    else if (mode & FileMode::NoCreate)
+        modeString += 'r';
+    else if ((mode & FileMode::Preserve) && file_exists)
+        modeString += 'r';
+    else
+        modeString += 'w';
+
+    if ((mode & FileMode::ReadWrite) == FileMode::ReadWrite)
+        modeString += '+';
+
+    if (!(mode & FileMode::Text))
+        modeString += 'b';
+
+    return modeString;
+}
+
+FileHandle* OpenFile(const std::string& path, FileMode mode)
+{
+    if ((mode & (FileMode::ReadWrite | FileMode::Append)) == FileMode::None)
+    {
+        Log(LogLevel::Error, "Attempted to open \"%s\" in neither read nor write mode (FileMode 0x%x)\n", path.c_str(), mode);
+        return nullptr;
+    }
+
+    bool exists = false;
+    if (FILE* probe = fopen(path.c_str(), "rb"))
+    {
+        exists = true;
+        fclose(probe);
+    }
+
+    if ((mode & FileMode::NoCreate) && !exists)
+        return nullptr;
+
+    std::string modeString = GetModeString(mode, exists);
+    FILE* file = fopen(path.c_str(), modeString.c_str());
+    if (!file)
+    {
+        Log(LogLevel::Debug, "Failed to open \"%s\" with FileMode 0x%x (effective mode \"%s\")\n", path.c_str(), mode, modeString.c_str());
+        return nullptr;
+    }
+
+    return reinterpret_cast<FileHandle *>(file);
+}
+
+std::string GetLocalFilePath(const std::string& filename)
+{
+    return filename;
+}
+
+FileHandle* OpenLocalFile(const std::string& path, FileMode mode)
+{
+    return OpenFile(GetLocalFilePath(path), mode);
+}
+
+bool CloseFile(FileHandle* file)
+{
+    return fclose(reinterpret_cast<FILE *>(file)) == 0;
+}
+
+bool IsEndOfFile(FileHandle* file)
+{
+    return feof(reinterpret_cast<FILE *>(file)) != 0;
+}
+
+bool FileReadLine(char* str, int count, FileHandle* file)
+{
+    return fgets(str, count, reinterpret_cast<FILE *>(file)) != nullptr;
+}
+
+bool FileExists(const std::string& name)
+{
+    FileHandle* f = OpenFile(name, FileMode::Read);
+    if (!f) return false;
+    CloseFile(f);
+    return true;
+}
+
+bool LocalFileExists(const std::string& name)
+{
+    FileHandle* f = OpenLocalFile(name, FileMode::Read);
+    if (!f) return false;
+    CloseFile(f);
+    return true;
+}
+
+bool CheckFileWritable(const std::string& filepath)
+{
+    FileHandle* file = OpenFile(filepath, FileMode::Append);
+    if (!file) return false;
+    CloseFile(file);
+    return true;
+}
+
+bool CheckLocalFileWritable(const std::string& name)
+{
+    return CheckFileWritable(GetLocalFilePath(name));
+}
+
+bool FileSeek(FileHandle* file, s64 offset, FileSeekOrigin origin)
+{
+    int stdorigin;
+    switch (origin)
+    {
+        case FileSeekOrigin::Start: stdorigin = SEEK_SET; break;
+        case FileSeekOrigin::Current: stdorigin = SEEK_CUR; break;
+        case FileSeekOrigin::End: stdorigin = SEEK_END; break;
+    }
+
+    return fseek(reinterpret_cast<FILE *>(file), offset, stdorigin) == 0;
+}
+
+void FileRewind(FileHandle* file)
+{
+    rewind(reinterpret_cast<FILE *>(file));
+}
+
+u64 FileRead(void* data, u64 size, u64 count, FileHandle* file)
+{
+    return fread(data, size, count, reinterpret_cast<FILE *>(file));
+}
+
+bool FileFlush(FileHandle* file)
+{
+    return fflush(reinterpret_cast<FILE *>(file)) == 0;
+}
+
+u64 FileWrite(const void* data, u64 size, u64 count, FileHandle* file)
+{
+    return fwrite(data, size, count, reinterpret_cast<FILE *>(file));
+}
+
+u64 FileWriteFormatted(FileHandle* file, const char* fmt, ...)
+{
+    if (fmt == nullptr)
+        return 0;
+
+    va_list args;
+    va_start(args, fmt);
+    u64 ret = vfprintf(reinterpret_cast<FILE *>(file), fmt, args);
+    va_end(args);
+    return ret;
+}
+
+u64 FileLength(FileHandle* file)
+{
+    FILE* stdfile = reinterpret_cast<FILE *>(file);
+    long pos = ftell(stdfile);
+    fseek(stdfile, 0, SEEK_END);
+    long len = ftell(stdfile);
+    fseek(stdfile, pos, SEEK_SET);
+    return len;
+}
+
+void Log(LogLevel level, const char* fmt, ...)
+{
+    if (fmt == nullptr)
+        return;
+
+    // the benchmark output goes to stdout, so keep the core's chatter out of it
+    if (level < Headless::LogThreshold)
+        return;
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+}
+
+Thread* Thread_Create(std::function<void()> func)
+{
+    return (Thread*) new std::thread(std::move(func));
+}
+
+void Thread_Free(Thread* thread)
+{
+    std::thread* t = (std::thread*) thread;
+    if (t->joinable())
+        t->detach();
+    delete t;
+}
+
+void Thread_Wait(Thread* thread)
+{
+    std::thread* t = (std::thread*) thread;
+    if (t->joinable())
+        t->join();
+}
+
+struct Semaphore
+{
+    std::mutex Lock;
+    std::condition_variable Cond;
+    int Count = 0;
+};
+
+Semaphore* Semaphore_Create()
+{
+    return new Semaphore();
+}
+
+void Semaphore_Free(Semaphore* sema)
+{
+    delete sema;
+}
+
+void Semaphore_Reset(Semaphore* sema)
+{
+    std::lock_guard<std::mutex> lock(sema->Lock);
+    sema->Count = 0;
+}
+
+void Semaphore_Wait(Semaphore* sema)
+{
+    std::unique_lock<std::mutex> lock(sema->Lock);
+    sema->Cond.wait(lock, [sema] { return sema->Count > 0; });
+    sema->Count--;
+}
+
+bool Semaphore_TryWait(Semaphore* sema, int timeout_ms)
+{
+    std::unique_lock<std::mutex> lock(sema->Lock);
+    if (!sema->Cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), [sema] { return sema->Count > 0; }))
+        return false;
+
+    sema->Count--;
+    return true;
+}
+
+void Semaphore_Post(Semaphore* sema, int count)
+{
+    {
+        std::lock_guard<std::mutex> lock(sema->Lock);
+        sema->Count += count;
+    }
+    sema->Cond.notify_all();
+}
+
+Mutex* Mutex_Create()
+{
+    return (Mutex*) new std::mutex();
+}
+
+void Mutex_Free(Mutex* mutex)
+{
+    delete (std::mutex*) mutex;
+}
+
+void Mutex_Lock(Mutex* mutex)
+{
+    ((std::mutex*) mutex)->lock();
+}
+
+void Mutex_Unlock(Mutex* mutex)
+{
+    ((std::mutex*) mutex)->unlock();
+}
+
+bool Mutex_TryLock(Mutex* mutex)
+{
+    return ((std::mutex*) mutex)->try_lock();
+}
+
+void Sleep(u64 usecs)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(usecs));
+}
+
+u64 GetMSCount()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+u64 GetUSCount()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - StartTime).count();
+}
+
+
+// saves are deliberately never written back, so that every run starts
+// from the same state
+
+void WriteNDSSave(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen, void* userdata)
+{
+}
+
+void WriteGBASave(const u8* savedata, u32 savelen, u32 writeoffset, u32 writelen, void* userdata)
+{
+}
+
+void WriteFirmware(const Firmware& firmware, u32 writeoffset, u32 writelen, void* userdata)
+{
+}
+
+void WriteDateTime(int year, int month, int day, int hour, int minute, int second, void* userdata)
+{
+}
+
+
+void MP_Begin(void* userdata)
+{
+}
+
+void MP_End(void* userdata)
+{
+}
+
+int MP_SendPacket(u8* data, int len, u64 timestamp, void* userdata)
+{
+    return len;
+}
+
+int MP_RecvPacket(u8* data, u64* timestamp, void* userdata)
+{
+    return 0;
+}
+
+int MP_SendCmd(u8* data, int len, u64 timestamp, void* userdata)
+{
+    return len;
+}
+
+int MP_SendReply(u8* data, int len, u64 timestamp, u16 aid, void* userdata)
+{
+    return len;
+}
+
+int MP_SendAck(u8* data, int len, u64 timestamp, void* userdata)
+{
+    return len;
+}
+
+int MP_RecvHostPacket(u8* data, u64* timestamp, void* userdata)
+{
+    return 0;
+}
+
+u16 MP_RecvReplies(u8* data, u64 timestamp, u16 aidmask, void* userdata)
+{
+    return 0;
+}
+
+
+int Net_SendPacket(u8* data, int len, void* userdata)
+{
+    return 0;
+}
+
+int Net_RecvPacket(u8* data, void* userdata)
+{
+    return 0;
+}
+
+
+void Camera_Start(int num, void* userdata)
+{
+}
+
+void Camera_Stop(int num, void* userdata)
+{
+}
+
+void Camera_CaptureFrame(int num, u32* frame, int width, int height, bool yuv, void* userdata)
+{
+    memset(frame, 0, width * height * (yuv ? 2 : 4));
+}
+
+
+void Mic_Start(void* userdata)
+{
+}
+
+void Mic_Stop(void* userdata)
+{
+}
+
+int Mic_ReadInput(s16* data, int maxlength, void* userdata)
+{
+    memset(data, 0, maxlength * sizeof(s16));
+    return maxlength;
+}
+
+
+AACDecoder* AAC_Init()
+{
+    // no AAC decoder in headless builds, DSP HLE will output silence
+    return nullptr;
+}
+
+void AAC_DeInit(AACDecoder* dec)
+{
+}
+
+bool AAC_Configure(AACDecoder* dec, int frequency, int channels)
+{
+    return false;
+}
+
+bool AAC_DecodeFrame(AACDecoder* dec, const void* input, int inputlen, void* output, int outputlen)
+{
+    return false;
+}
+
+
+bool Addon_KeyDown(KeyType type, void* userdata)
+{
+    return false;
+}
+
+void Addon_RumbleStart(u32 len, void* userdata)
+{
+}
+
+void Addon_RumbleStop(void* userdata)
+{
+}
+
+float Addon_MotionQuery(MotionQueryType type, void* userdata)
+{
+    if (type == MotionAccelerationZ)
+        return 9.80665f;
+    return 0;
+}
+
+
+DynamicLibrary* DynamicLibrary_Load(const char* lib)
+{
+#ifdef _WIN32
+    return (DynamicLibrary*) LoadLibraryA(lib);
+#else
+    return (DynamicLibrary*) dlopen(lib, RTLD_NOW | RTLD_LOCAL);
+#endif
+}
+
+void DynamicLibrary_Unload(DynamicLibrary* lib)
+{
+#ifdef _WIN32
+    FreeLibrary((HMODULE) lib);
+#else
+    dlclose(lib);
+#endif
+}
+
+void* DynamicLibrary_LoadFunction(DynamicLibrary* lib, const char* name)
+{
+#ifdef _WIN32
+    return (void*) GetProcAddress((HMODULE) lib, name);
+#else
+    return dlsym(lib, name);
+#endif
+}
+
+}
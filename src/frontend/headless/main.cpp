@@ -0,0 +1,684 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Headless benchmark runner.
+// Boots a ROM, runs a fixed number of frames as fast as possible and prints
+// timing figures along with hashes of the video and audio output, so runs can
+// be compared across builds and machines without a display.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "NDS.h"
+#include "NDSCart.h"
+#include "Args.h"
+#include "GPU.h"
+#include "GPU3D_Soft.h"
+#include "GPU3D_SoftHD.h"
+#include "Movie.h"
+#include "SharedROM.h"
+#include "SPI_Firmware.h"
+#include "Platform.h"
+#include "xxhash/xxhash.h"
+
+#include "Headless.h"
+
+using namespace melonDS;
+using namespace melonDS::Platform;
+
+namespace Headless
+{
+
+LogLevel LogThreshold = LogLevel::Warn;
+
+static void PrintUsage(const char* argv0)
+{
+    printf("usage: %s [options] <rom.nds>\n", argv0);
+    printf("       %s --ar-check <trials> [--ar-seed <n>]\n\n", argv0);
+    printf("options:\n");
+    printf("  -n, --frames <count>     number of frames to run (default: 3600)\n");
+    printf("      --bios9 <path>       ARM9 BIOS image (default: FreeBIOS)\n");
+    printf("      --bios7 <path>       ARM7 BIOS image (default: FreeBIOS)\n");
+    printf("      --firmware <path>    firmware image (default: generated)\n");
+    printf("      --jit                use the JIT recompiler (default if available)\n");
+    printf("      --interpreter        use the interpreter\n");
+    printf("      --cached-interpreter use the interpreter, running pre-decoded blocks of code\n");
+    printf("      --no-idle-skip       don't fast-forward through idle loops in the interpreter\n");
+    printf("      --burst-cart <pct>   do DMA cart ROM reads in one go, taking pct%% of the\n");
+    printf("                           accurate time (default: accurate transfers)\n");
+    printf("      --frame-skip <n>     only render one out of every n+1 frames, the video hash\n");
+    printf("                           only covers the rendered ones (default: 0)\n");
+    printf("      --no-fastmem         don't access memory through the fastmem arena\n");
+    printf("      --renderer <name>    3D renderer: soft, soft-threaded, soft-hd (default: soft)\n");
+    printf("                           soft-hd also renders the 3D scene upscaled, on a thread pool\n");
+    printf("      --scale <n>          resolution multiplier for soft-hd, 1-%d (default: 2)\n", SoftHDRenderer::MaxScale);
+    printf("      --render-threads <n> own threads for soft-hd (default: the shared job pool)\n");
+    printf("      --hd-dump <path>     write the last upscaled 3D frame to a PPM file\n");
+    printf("      --threaded-2d        render the 2D engines on a separate thread\n");
+    printf("      --firmware-boot      boot through the firmware instead of direct boot\n");
+    printf("                           (requires BIOS and firmware images)\n");
+    printf("      --record <path>      record the run into a movie file\n");
+    printf("      --replay <path>      replay a movie file, checking the output against it\n");
+    printf("                           (runs until the end of the movie by default)\n");
+    printf("      --frame-log <path>   write per-frame timings and output hashes to a CSV file\n");
+    printf("      --profile <path>     write per-subsystem profiler counters to a JSON file\n");
+    printf("      --trace <path>       write the profiler's frame history as a Chrome trace\n");
+    printf("                           (both need a build with ENABLE_PROFILER)\n");
+    printf("      --ar-check <trials>  check compiled Action Replay codes against the reference\n");
+    printf("                           interpreter on random programs, no ROM needed\n");
+    printf("      --ar-seed <n>        random seed for --ar-check (default: 1234)\n");
+    printf("  -v, --verbose            show all messages logged by the core\n");
+    printf("  -h, --help               show this help\n");
+}
+
+static bool ParseArgs(int argc, char** argv, Options& opts)
+{
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        auto nextArg = [&]() -> const char*
+        {
+            if (i + 1 >= argc)
+            {
+                fprintf(stderr, "missing value for %s\n", arg);
+                return nullptr;
+            }
+            return argv[++i];
+        };
+
+        if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        {
+            PrintUsage(argv[0]);
+            exit(0);
+        }
+        else if (!strcmp(arg, "-n") || !strcmp(arg, "--frames"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.Frames = strtoul(val, nullptr, 0);
+            opts.FramesSet = true;
+        }
+        else if (!strcmp(arg, "--bios9"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.ARM9BIOSPath = val;
+        }
+        else if (!strcmp(arg, "--bios7"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.ARM7BIOSPath = val;
+        }
+        else if (!strcmp(arg, "--firmware"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.FirmwarePath = val;
+        }
+        else if (!strcmp(arg, "--jit"))
+            opts.JIT = true;
+        else if (!strcmp(arg, "--interpreter"))
+            opts.JIT = false;
+        else if (!strcmp(arg, "--cached-interpreter"))
+        {
+            opts.JIT = false;
+            opts.CachedInterpreter = true;
+        }
+        else if (!strcmp(arg, "--no-idle-skip"))
+            opts.IdleLoopSkipping = false;
+        else if (!strcmp(arg, "--burst-cart"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.BurstCartTransfers = true;
+            opts.BurstCartTiming = strtoul(val, nullptr, 0);
+        }
+        else if (!strcmp(arg, "--frame-skip"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.FrameSkip = strtoul(val, nullptr, 0);
+        }
+        else if (!strcmp(arg, "--no-fastmem"))
+            opts.FastMemory = false;
+        else if (!strcmp(arg, "--threaded-2d"))
+            opts.Threaded2D = true;
+        else if (!strcmp(arg, "--renderer"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+
+            if (!strcmp(val, "soft"))
+                opts.Renderer = RendererKind::Software;
+            else if (!strcmp(val, "soft-threaded"))
+                opts.Renderer = RendererKind::SoftwareThreaded;
+            else if (!strcmp(val, "soft-hd"))
+                opts.Renderer = RendererKind::SoftwareHD;
+            else
+            {
+                fprintf(stderr, "unknown renderer: %s\n", val);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--scale"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.Scale = atoi(val);
+            if (opts.Scale < 1 || opts.Scale > SoftHDRenderer::MaxScale)
+            {
+                fprintf(stderr, "scale must be between 1 and %d\n", SoftHDRenderer::MaxScale);
+                return false;
+            }
+        }
+        else if (!strcmp(arg, "--render-threads"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.RenderThreads = atoi(val);
+        }
+        else if (!strcmp(arg, "--hd-dump"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.HDDumpPath = val;
+        }
+        else if (!strcmp(arg, "--firmware-boot"))
+            opts.DirectBoot = false;
+        else if (!strcmp(arg, "--record"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.RecordPath = val;
+        }
+        else if (!strcmp(arg, "--replay"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.ReplayPath = val;
+        }
+        else if (!strcmp(arg, "--frame-log"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.FrameLogPath = val;
+        }
+        else if (!strcmp(arg, "--profile"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.ProfilePath = val;
+        }
+        else if (!strcmp(arg, "--trace"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.TracePath = val;
+        }
+        else if (!strcmp(arg, "--ar-check"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.ARCheckTrials = strtoul(val, nullptr, 0);
+        }
+        else if (!strcmp(arg, "--ar-seed"))
+        {
+            const char* val = nextArg();
+            if (!val) return false;
+            opts.ARCheckSeed = strtoul(val, nullptr, 0);
+        }
+        else if (!strcmp(arg, "-v") || !strcmp(arg, "--verbose"))
+            LogThreshold = LogLevel::Debug;
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr, "unknown option: %s\n", arg);
+            return false;
+        }
+        else if (opts.ROMPath.empty())
+            opts.ROMPath = arg;
+        else
+        {
+            fprintf(stderr, "unexpected argument: %s\n", arg);
+            return false;
+        }
+    }
+
+    if (opts.ROMPath.empty() && !opts.ARCheckTrials)
+    {
+        fprintf(stderr, "no ROM given\n");
+        return false;
+    }
+
+    if (opts.RecordPath && opts.ReplayPath)
+    {
+        fprintf(stderr, "--record and --replay can't be used together\n");
+        return false;
+    }
+
+    if (opts.HDDumpPath && opts.Renderer != RendererKind::SoftwareHD)
+    {
+        fprintf(stderr, "--hd-dump needs --renderer soft-hd\n");
+        return false;
+    }
+
+    if ((opts.ProfilePath || opts.TracePath) && !Profiler::Enabled)
+        fprintf(stderr, "warning: built without ENABLE_PROFILER, the profile will be empty\n");
+
+    return true;
+}
+
+static std::unique_ptr<u8[]> LoadFile(const std::string& path, u32& len)
+{
+    FileHandle* f = OpenFile(path, FileMode::Read);
+    if (!f)
+    {
+        fprintf(stderr, "failed to open %s\n", path.c_str());
+        return nullptr;
+    }
+
+    len = (u32)FileLength(f);
+    auto data = std::make_unique<u8[]>(len);
+    FileRewind(f);
+    u64 read = FileRead(data.get(), len, 1, f);
+    CloseFile(f);
+
+    if (read != 1)
+    {
+        fprintf(stderr, "failed to read %s\n", path.c_str());
+        return nullptr;
+    }
+
+    return data;
+}
+
+template<size_t N>
+static bool LoadBIOS(const std::string& path, std::array<u8, N>& bios)
+{
+    u32 len = 0;
+    auto data = LoadFile(path, len);
+    if (!data)
+        return false;
+
+    if (len != N)
+    {
+        fprintf(stderr, "%s: expected %zu bytes, got %u\n", path.c_str(), N, len);
+        return false;
+    }
+
+    memcpy(bios.data(), data.get(), N);
+    return true;
+}
+
+static std::string RendererName(const Options& opts, NDS& nds)
+{
+    switch (opts.Renderer)
+    {
+    case RendererKind::SoftwareThreaded:
+        return "soft-threaded";
+    case RendererKind::SoftwareHD:
+    {
+        auto& hdRenderer = static_cast<SoftHDRenderer&>(nds.GPU.GetRenderer3D());
+        return "soft-hd " + std::to_string(hdRenderer.GetScale()) + "x, "
+            + std::to_string(hdRenderer.GetNumThreads()) + " threads";
+    }
+    default:
+        return "soft";
+    }
+}
+
+static bool WriteHDFrame(const std::string& path, SoftHDRenderer& renderer)
+{
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f)
+    {
+        fprintf(stderr, "failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    const int width = renderer.GetWidth(), height = renderer.GetHeight();
+    const u32* frame = renderer.GetFramebuffer();
+    std::vector<u8> rgb((size_t)width * height * 3);
+    for (size_t i = 0; i < (size_t)width * height; i++)
+    {
+        // 6-bit to 8-bit color
+        rgb[i*3 + 0] = ((frame[i] & 0x3F) << 2) | ((frame[i] & 0x3F) >> 4);
+        rgb[i*3 + 1] = (((frame[i] >> 8) & 0x3F) << 2) | (((frame[i] >> 8) & 0x3F) >> 4);
+        rgb[i*3 + 2] = (((frame[i] >> 16) & 0x3F) << 2) | (((frame[i] >> 16) & 0x3F) >> 4);
+    }
+
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    bool ok = fwrite(rgb.data(), rgb.size(), 1, f) == 1;
+    fclose(f);
+    if (!ok)
+        fprintf(stderr, "failed to write %s\n", path.c_str());
+    return ok;
+}
+
+static int Run(const Options& opts)
+{
+    Runner runner;
+
+    NDSArgs args {};
+
+    if (opts.ARM9BIOSPath && !LoadBIOS(*opts.ARM9BIOSPath, *args.ARM9BIOS))
+        return 1;
+    if (opts.ARM7BIOSPath && !LoadBIOS(*opts.ARM7BIOSPath, *args.ARM7BIOS))
+        return 1;
+
+    if (opts.FirmwarePath)
+    {
+        FileHandle* f = OpenFile(*opts.FirmwarePath, FileMode::Read);
+        if (!f)
+        {
+            fprintf(stderr, "failed to open %s\n", opts.FirmwarePath->c_str());
+            return 1;
+        }
+
+        args.Firmware = Firmware(f);
+        CloseFile(f);
+
+        if (!args.Firmware.Buffer())
+        {
+            fprintf(stderr, "failed to load firmware %s\n", opts.FirmwarePath->c_str());
+            return 1;
+        }
+    }
+
+#ifdef JIT_ENABLED
+    if (!opts.JIT)
+        args.JIT = std::nullopt;
+    else
+        args.JIT->FastMemory = opts.FastMemory;
+#else
+    args.JIT = std::nullopt;
+    if (opts.JIT)
+        fprintf(stderr, "JIT not available in this build, using the interpreter\n");
+#endif
+
+    auto nds = std::make_unique<NDS>(std::move(args), &runner);
+
+    // map the ROM file where possible, so parallel runs of the same ROM share its pages
+    std::unique_ptr<NDSCart::CartCommon> cart;
+    if (auto shared = SharedROM::FromFile(opts.ROMPath))
+    {
+        cart = NDSCart::ParseROM(*shared, &runner);
+    }
+    else
+    {
+        u32 romlen = 0;
+        auto romdata = LoadFile(opts.ROMPath, romlen);
+        if (!romdata)
+            return 1;
+
+        cart = NDSCart::ParseROM(std::move(romdata), romlen, &runner);
+    }
+    if (!cart)
+    {
+        fprintf(stderr, "failed to parse ROM %s\n", opts.ROMPath.c_str());
+        return 1;
+    }
+
+    nds->SetNDSCart(std::move(cart));
+    nds->Reset();
+
+    nds->ARM9.IdleLoopSkipping = opts.IdleLoopSkipping;
+    nds->ARM7.IdleLoopSkipping = opts.IdleLoopSkipping;
+    nds->NDSCartSlot.BurstTransfers = opts.BurstCartTransfers;
+    nds->NDSCartSlot.BurstTiming = opts.BurstCartTiming;
+    nds->GPU.SetFrameSkip(opts.FrameSkip);
+    nds->SetCachedInterpreter(opts.CachedInterpreter);
+    nds->JIT.Memory.SetDirectAccess(opts.FastMemory);
+
+    if (opts.Renderer == RendererKind::SoftwareThreaded)
+        static_cast<SoftRenderer&>(nds->GPU.GetRenderer3D()).SetThreaded(true, nds->GPU);
+    else if (opts.Renderer == RendererKind::SoftwareHD)
+        nds->GPU.SetRenderer3D(std::make_unique<SoftHDRenderer>(opts.Scale, opts.RenderThreads));
+    nds->GPU.SetThreaded2D(opts.Threaded2D);
+
+    if (opts.DirectBoot || nds->NeedsDirectBoot())
+    {
+        std::string romname = opts.ROMPath.substr(opts.ROMPath.find_last_of("/\\") + 1);
+        nds->SetupDirectBoot(romname);
+    }
+
+    std::unique_ptr<MovieRecorder> recorder;
+    std::unique_ptr<MoviePlayer> player;
+    u32 numFrames = opts.Frames;
+
+    if (opts.ReplayPath)
+    {
+        std::optional<Movie> movie = Movie::Load(*opts.ReplayPath);
+        if (!movie)
+            return 1;
+
+        if (movie->DirectBoot != (opts.DirectBoot || nds->NeedsDirectBoot()))
+            fprintf(stderr, "warning: movie was recorded with a different boot mode\n");
+        if (!opts.FramesSet || numFrames > movie->FrameCount)
+            numFrames = movie->FrameCount;
+
+        player = std::make_unique<MoviePlayer>(*nds, std::move(*movie));
+        if (!player->Start())
+            return 1;
+    }
+    else if (opts.RecordPath)
+    {
+        recorder = std::make_unique<MovieRecorder>(*nds, Movie::Anchor::PowerOn,
+                                                   opts.DirectBoot || nds->NeedsDirectBoot(), true);
+    }
+
+    FILE* frameLog = nullptr;
+    if (opts.FrameLogPath)
+    {
+        frameLog = fopen(opts.FrameLogPath->c_str(), "w");
+        if (!frameLog)
+        {
+            fprintf(stderr, "failed to open %s\n", opts.FrameLogPath->c_str());
+            return 1;
+        }
+        fprintf(frameLog, "frame,time_us,hash\n");
+    }
+
+    nds->Start();
+
+    XXH64_state_t* frameHash = XXH64_createState();
+    XXH64_state_t* videoHash = XXH64_createState();
+    XXH64_state_t* audioHash = XXH64_createState();
+    XXH64_reset(videoHash, 0);
+    XXH64_reset(audioHash, 0);
+
+    std::unique_ptr<s16[]> audioBuf = std::make_unique<s16[]>(2 * 1024);
+    u64 audioSamples = 0;
+    u64 lastFrameHash = 0;
+
+    using Clock = std::chrono::steady_clock;
+    double emuTime = 0, hostTime = 0;
+    double minFrame = 1e9, maxFrame = 0;
+    u64 totalLines = 0;
+    u32 frames = 0;
+
+    auto runStart = Clock::now();
+
+    for (; frames < numFrames && !runner.Stopped; frames++)
+    {
+        // the runner has no input of its own, a recording only captures the idle input
+        if (player)
+            player->BeginFrame();
+        else if (recorder)
+            recorder->BeginFrame(MovieInput{});
+
+        auto frameStart = Clock::now();
+        totalLines += nds->RunFrame();
+        auto frameEnd = Clock::now();
+
+        if (player)
+            player->EndFrame();
+        else if (recorder)
+            recorder->EndFrame();
+
+        double frameTime = std::chrono::duration<double>(frameEnd - frameStart).count();
+        emuTime += frameTime;
+        minFrame = std::min(minFrame, frameTime);
+        maxFrame = std::max(maxFrame, frameTime);
+
+        // skipped frames aren't presented
+        if (nds->GPU.HasNewFrame())
+        {
+            int buf = nds->GPU.AcquirePresentBuffer();
+            const size_t screenSize = 256 * 192 * sizeof(u32);
+            XXH64_reset(frameHash, 0);
+            XXH64_update(frameHash, nds->GPU.Framebuffer[buf][0].get(), screenSize);
+            XXH64_update(frameHash, nds->GPU.Framebuffer[buf][1].get(), screenSize);
+            lastFrameHash = XXH64_digest(frameHash);
+            XXH64_update(videoHash, &lastFrameHash, sizeof(lastFrameHash));
+
+            if (frameLog)
+                fprintf(frameLog, "%u,%.1f,%016llx\n", frames, 1e6 * frameTime, (unsigned long long)lastFrameHash);
+        }
+
+        // drain the audio output so the SPU buffer never fills up
+        for (;;)
+        {
+            int read = nds->SPU.ReadOutput(audioBuf.get(), 1024);
+            if (read <= 0) break;
+            XXH64_update(audioHash, audioBuf.get(), read * 2 * sizeof(s16));
+            audioSamples += read;
+        }
+
+        hostTime += std::chrono::duration<double>(Clock::now() - frameEnd).count();
+    }
+
+    double wallTime = std::chrono::duration<double>(Clock::now() - runStart).count();
+
+    printf("rom:            %s\n", opts.ROMPath.c_str());
+    printf("cpu:            %s\n", nds->IsJITEnabled() ? "jit" :
+                                    nds->IsCachedInterpreterEnabled() ? "cached interpreter" : "interpreter");
+    printf("renderer:       %s%s\n", RendererName(opts, *nds).c_str(), opts.Threaded2D ? ", threaded 2D" : "");
+    printf("frames:         %u%s\n", frames, runner.Stopped ? " (console stopped)" : "");
+    printf("scanlines:      %llu\n", (unsigned long long)totalLines);
+    printf("wall time:      %.3f s\n", wallTime);
+    if (frames > 0)
+    {
+        printf("fps:            %.2f\n", frames / wallTime);
+        printf("emulation:      %.3f s (%.1f%%), %.3f ms/frame avg, %.3f min, %.3f max\n",
+               emuTime, 100.0 * emuTime / wallTime,
+               1000.0 * emuTime / frames, 1000.0 * minFrame, 1000.0 * maxFrame);
+        printf("output:         %.3f s (%.1f%%)\n", hostTime, 100.0 * hostTime / wallTime);
+    }
+    if (!nds->IsJITEnabled())
+        printf("idle skipped:   %llu arm9 cycles, %llu arm7 cycles\n",
+               (unsigned long long)nds->ARM9.IdleLoopSkippedCycles, (unsigned long long)nds->ARM7.IdleLoopSkippedCycles);
+    printf("last frame:     %016llx\n", (unsigned long long)lastFrameHash);
+    printf("video hash:     %016llx\n", (unsigned long long)XXH64_digest(videoHash));
+    printf("audio hash:     %016llx (%llu samples)\n", (unsigned long long)XXH64_digest(audioHash),
+           (unsigned long long)audioSamples);
+
+    if (opts.Renderer == RendererKind::SoftwareHD)
+    {
+        auto& hdRenderer = static_cast<SoftHDRenderer&>(nds->GPU.GetRenderer3D());
+        const u32* hdFrame = hdRenderer.GetFramebuffer();
+        size_t hdSize = (size_t)hdRenderer.GetWidth() * hdRenderer.GetHeight();
+        printf("hd last frame:  %016llx (%dx%d)\n", (unsigned long long)XXH64(hdFrame, hdSize * sizeof(u32), 0),
+               hdRenderer.GetWidth(), hdRenderer.GetHeight());
+
+        if (opts.HDDumpPath && WriteHDFrame(*opts.HDDumpPath, hdRenderer))
+            printf("hd dump:        %s\n", opts.HDDumpPath->c_str());
+    }
+
+    if (Profiler::Enabled && frames > 0)
+    {
+        const Profiler& prof = nds->Profiler;
+        double tickrate = prof.GetTicksPerSecond();
+        double frameTicks = (double)prof.GetSection(Profiler::Section_Frame).Ticks;
+
+        printf("profile:\n");
+        for (int i = Profiler::Section_Frame + 1; i < Profiler::Section_MAX; i++)
+        {
+            const Profiler::Counter& c = prof.GetSection((Profiler::Section)i);
+            printf("  %-16s %9.3f ms/frame (%5.1f%%), %llu calls\n", Profiler::GetSectionName((Profiler::Section)i),
+                   1000.0 * c.Ticks / tickrate / frames, frameTicks > 0 ? 100.0 * c.Ticks / frameTicks : 0.0,
+                   (unsigned long long)c.Calls);
+        }
+        if (nds->IsJITEnabled())
+            printf("  jit blocks       %llu/%llu compiled, %llu/%llu executed (arm9/arm7)\n",
+                   (unsigned long long)prof.GetBlocksCompiled(0), (unsigned long long)prof.GetBlocksCompiled(1),
+                   (unsigned long long)prof.GetBlocksExecuted(0), (unsigned long long)prof.GetBlocksExecuted(1));
+    }
+
+    if (opts.ProfilePath)
+        nds->Profiler.DumpJSON(*opts.ProfilePath);
+    if (opts.TracePath)
+        nds->Profiler.DumpChromeTrace(*opts.TracePath);
+
+    int ret = 0;
+    if (player)
+    {
+        if (std::optional<u32> divergence = player->GetDivergenceFrame())
+        {
+            printf("replay:         diverged at frame %u\n", *divergence);
+            ret = 2;
+        }
+        else
+            printf("replay:         matches the recording\n");
+    }
+    else if (recorder)
+    {
+        if (recorder->Save(*opts.RecordPath))
+            printf("recorded:       %s\n", opts.RecordPath->c_str());
+        else
+            ret = 1;
+    }
+
+    if (frameLog)
+        fclose(frameLog);
+
+    XXH64_freeState(frameHash);
+    XXH64_freeState(videoHash);
+    XXH64_freeState(audioHash);
+
+    // the movie hooks into the console, so it has to go first
+    player = nullptr;
+    recorder = nullptr;
+
+    nds->Stop();
+    return ret;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    Headless::Options opts;
+    if (!Headless::ParseArgs(argc, argv, opts))
+    {
+        Headless::PrintUsage(argv[0]);
+        return 1;
+    }
+
+    if (opts.ARCheckTrials)
+        return Headless::RunARCheck(*opts.ARCheckTrials, opts.ARCheckSeed);
+
+    return Headless::Run(opts);
+}
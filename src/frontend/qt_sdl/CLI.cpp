@@ -43,6 +43,8 @@ CommandLineOptions* ManageArgs(QApplication& melon)
 
     parser.addOption(QCommandLineOption({"b", "boot"}, "Whether to boot firmware on startup. Defaults to \"auto\" (boot if NDS rom given)", "auto/always/never", "auto"));
     parser.addOption(QCommandLineOption({"f", "fullscreen"}, "Start melonDS in fullscreen mode"));
+    parser.addOption(QCommandLineOption("record-movie", "Record the input into a movie file once the ROM has booted", "file"));
+    parser.addOption(QCommandLineOption("play-movie", "Play back a movie file once the ROM has booted", "file"));
 
 #ifdef ARCHIVE_SUPPORT_ENABLED
     parser.addOption(QCommandLineOption({"a", "archive-file"}, "Specify file to load inside an archive given (NDS)", "rom"));
@@ -55,6 +57,16 @@ CommandLineOptions* ManageArgs(QApplication& melon)
 
     options->fullscreen = parser.isSet("fullscreen");
 
+    if (parser.isSet("record-movie") && parser.isSet("play-movie"))
+    {
+        Log(LogLevel::Error, "ERROR: --record-movie and --play-movie can't be used together\n");
+        exit(1);
+    }
+    if (parser.isSet("record-movie"))
+        options->recordMoviePath = parser.value("record-movie");
+    if (parser.isSet("play-movie"))
+        options->playMoviePath = parser.value("play-movie");
+
     QStringList posargs = parser.positionalArguments();
     switch (posargs.size())
     {
@@ -32,6 +32,8 @@ struct CommandLineOptions
     std::optional<QString> dsRomArchivePath;
     std::optional<QString> gbaRomPath;
     std::optional<QString> gbaRomArchivePath;
+    std::optional<QString> recordMoviePath;
+    std::optional<QString> playMoviePath;
     bool fullscreen;
     bool boot;
 };
@@ -72,6 +72,8 @@ DefaultList<int> DefaultInts =
     {"Instance*.Gdb.ARM9.Port", 3333},
 #endif
     {"LAN.HostNumPlayers", 16},
+    {"DLDI.CacheSectors", 2048},
+    {"DSi.SD.CacheSectors", 2048},
 };
 
 RangeList IntRanges =
@@ -91,6 +93,8 @@ RangeList IntRanges =
     {"Instance*.Window*.ScreenAspectBot", {0, AspectRatiosNum-1}},
     {"MP.AudioMode", {0, 2}},
     {"LAN.HostNumPlayers", {2, 16}},
+    {"DLDI.CacheSectors", {0, 65536}},
+    {"DSi.SD.CacheSectors", {0, 65536}},
 };
 
 DefaultList<bool> DefaultBools =
@@ -111,6 +115,8 @@ DefaultList<bool> DefaultBools =
 #endif
 #endif
     {"DSi.DSP.HLE", true},
+    {"DLDI.FolderVirtual", false},
+    {"DSi.SD.FolderVirtual", false},
 };
 
 DefaultList<std::string> DefaultStrings =
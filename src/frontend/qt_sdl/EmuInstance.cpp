@@ -28,8 +28,11 @@
 #include <utility>
 #include <fstream>
 #include <cstdlib>
+#include <map>
+#include <mutex>
 
 #include <QDateTime>
+#include <QFileInfo>
 
 #include <zstd.h>
 #ifdef ARCHIVE_SUPPORT_ENABLED
@@ -44,6 +47,7 @@
 #include "NDS.h"
 #include "DSi.h"
 #include "SPI.h"
+#include "SharedROM.h"
 #include "RTC.h"
 #include "DSi_I2C.h"
 #include "FreeBIOS.h"
@@ -78,6 +82,8 @@ EmuInstance::EmuInstance(int inst) : deleting(false),
 {
     consoleType = globalCfg.GetInt("Emu.ConsoleType");
 
+    stateManager = std::make_unique<StateManager>();
+
     ndsSave = nullptr;
     cartType = -1;
     baseROMDir = "";
@@ -160,6 +166,8 @@ EmuInstance::EmuInstance(int inst) : deleting(false),
 EmuInstance::~EmuInstance()
 {
     deleting = true;
+    // write any pending savestate while the windows are still around to report it
+    stateManager = nullptr;
     deleteAllWindows();
 
     emuThread->emuExit();
@@ -173,6 +181,12 @@ EmuInstance::~EmuInstance()
 
     if (nds)
     {
+        // don't lose a movie that was still being recorded
+        if (movieRecorder)
+            movieRecorder->Save(moviePath);
+        movieRecorder = nullptr;
+        moviePlayer = nullptr;
+
         saveRTCData();
         delete nds;
     }
@@ -714,54 +728,47 @@ bool EmuInstance::savestateExists(int slot)
 
 bool EmuInstance::loadState(const std::string& filename)
 {
-    Platform::FileHandle* file = Platform::OpenFile(filename, Platform::FileMode::Read);
-    if (file == nullptr)
-    { // If we couldn't open the state file...
-        Platform::Log(Platform::LogLevel::Error, "Failed to open state file \"%s\"\n", filename.c_str());
+    // loading a state breaks the continuity of the movie
+    stopMovie();
+
+    // Usually the file was already read and decompressed by the state manager
+    std::vector<u8> buffer;
+    if (!stateManager->TakeStateFile(filename, buffer))
+    { // If we couldn't read the state file...
+        Platform::Log(Platform::LogLevel::Error, "Failed to read state file \"%s\"\n", filename.c_str());
         return false;
     }
 
-    std::unique_ptr<Savestate> backup = std::make_unique<Savestate>(Savestate::DEFAULT_SIZE);
+    // The backup reuses the memory of earlier snapshots
+    std::unique_ptr<Savestate> backup = stateManager->GetSnapshotBuffer();
     if (backup->Error)
     { // If we couldn't allocate memory for the backup...
         Platform::Log(Platform::LogLevel::Error, "Failed to allocate memory for state backup\n");
-        Platform::CloseFile(file);
         return false;
     }
 
     if (!nds->DoSavestate(backup.get()) || backup->Error)
     { // Back up the emulator's state. If that failed...
         Platform::Log(Platform::LogLevel::Error, "Failed to back up state, aborting load (from \"%s\")\n", filename.c_str());
-        Platform::CloseFile(file);
+        stateManager->ReleaseSnapshotBuffer(std::move(backup));
         return false;
     }
     // We'll store the backup once we're sure that the state was loaded.
     // Now that we know the file and backup are both good, let's load the new state.
 
-    // Get the size of the file that we opened
-    size_t size = Platform::FileLength(file);
-
-    // Allocate exactly as much memory as we need for the savestate
-    std::vector<u8> buffer(size);
-    if (Platform::FileRead(buffer.data(), size, 1, file) == 0)
-    { // Read the state file into the buffer. If that failed...
-        Platform::Log(Platform::LogLevel::Error, "Failed to read %u-byte state file \"%s\"\n", size, filename.c_str());
-        Platform::CloseFile(file);
-        return false;
-    }
-    Platform::CloseFile(file); // done with the file now
-
     // Get ready to load the state from the buffer into the emulator
-    std::unique_ptr<Savestate> state = std::make_unique<Savestate>(buffer.data(), size, false);
+    std::unique_ptr<Savestate> state = std::make_unique<Savestate>(buffer.data(), buffer.size(), false);
 
     if (!nds->DoSavestate(state.get()) || state->Error)
     { // If we couldn't load the savestate from the buffer...
         Platform::Log(Platform::LogLevel::Error, "Failed to load state file \"%s\" into emulator\n", filename.c_str());
+        stateManager->ReleaseSnapshotBuffer(std::move(backup));
         return false;
     }
 
     // The backup was made and the state was loaded, so we can store the backup now.
-    backupState = std::move(backup); // This will clean up any existing backup
+    stateManager->ReleaseSnapshotBuffer(std::move(backupState));
+    backupState = std::move(backup);
     assert(backup == nullptr);
 
     if (globalCfg.GetBool("Savestate.RelocSRAM") && ndsSave)
@@ -779,43 +786,26 @@ bool EmuInstance::loadState(const std::string& filename)
     return true;
 }
 
-bool EmuInstance::saveState(const std::string& filename)
+bool EmuInstance::saveState(const std::string& filename, StateManager::Callback done)
 {
-    Platform::FileHandle* file = Platform::OpenFile(filename, Platform::FileMode::Write);
-
-    if (file == nullptr)
-    { // If the file couldn't be opened...
-        return false;
-    }
-
-    Savestate state;
-    if (state.Error)
+    std::unique_ptr<Savestate> state = stateManager->GetSnapshotBuffer();
+    if (state->Error)
     { // If there was an error creating the state (and allocating its memory)...
-        Platform::CloseFile(file);
         return false;
     }
 
     // Write the savestate to the in-memory buffer
-    nds->DoSavestate(&state);
+    nds->DoSavestate(state.get());
 
-    if (state.Error)
+    if (state->Error)
     {
-        Platform::CloseFile(file);
-        return false;
-    }
-
-    if (Platform::FileWrite(state.Buffer(), state.Length(), 1, file) == 0)
-    { // Write the Savestate buffer to the file. If that fails...
-        Platform::Log(Platform::Error,
-                      "Failed to write %d-byte savestate to %s\n",
-                      state.Length(),
-                      filename.c_str()
-        );
-        Platform::CloseFile(file);
+        stateManager->ReleaseSnapshotBuffer(std::move(state));
         return false;
     }
 
-    Platform::CloseFile(file);
+    // Compressing and writing the file is done in the background,
+    // done is called once it's on disk
+    stateManager->QueueSave(std::move(state), filename, std::move(done));
 
     if (globalCfg.GetBool("Savestate.RelocSRAM") && ndsSave)
     {
@@ -846,10 +836,60 @@ void EmuInstance::undoStateLoad()
 }
 
 
+bool EmuInstance::startMovieRecording(const std::string& filename)
+{
+    stopMovie();
+    if (!nds) return false;
+
+    // the game is already running, so the movie starts from a savestate
+    movieRecorder = std::make_unique<MovieRecorder>(*nds, Movie::Anchor::Savestate, false, true);
+    moviePath = filename;
+    return true;
+}
+
+bool EmuInstance::startMoviePlayback(const std::string& filename)
+{
+    stopMovie();
+    if (!nds) return false;
+
+    std::optional<Movie> movie = Movie::Load(filename);
+    if (!movie) return false;
+
+    if (movie->StartAnchor == Movie::Anchor::PowerOn)
+        reset();
+
+    moviePlayer = std::make_unique<MoviePlayer>(*nds, std::move(*movie));
+    if (!moviePlayer->Start())
+    {
+        moviePlayer = nullptr;
+        return false;
+    }
+
+    moviePath = filename;
+    return true;
+}
+
+void EmuInstance::stopMovie()
+{
+    if (movieRecorder)
+    {
+        u32 frames = movieRecorder->GetFrameCount();
+        if (movieRecorder->Save(moviePath))
+            osdAddMessage(0, "Movie saved (%u frames)", frames);
+        else
+            osdAddMessage(0xFFA0A0, "Failed to save movie");
+    }
+
+    movieRecorder = nullptr;
+    moviePlayer = nullptr;
+    moviePath.clear();
+}
+
+
 void EmuInstance::unloadCheats()
 {
     cheatFile = nullptr; // cleaned up by unique_ptr
-    nds->AREngine.Cheats.clear();
+    nds->AREngine.SetCheats({});
 }
 
 void EmuInstance::loadCheats()
@@ -863,11 +903,11 @@ void EmuInstance::loadCheats()
 
     if (cheatsOn)
     {
-        nds->AREngine.Cheats = cheatFile->GetCodes();
+        nds->AREngine.SetCheats(cheatFile->GetCodes());
     }
     else
     {
-        nds->AREngine.Cheats.clear();
+        nds->AREngine.SetCheats({});
     }
 }
 
@@ -1169,7 +1209,9 @@ std::optional<FATStorageArgs> EmuInstance::getSDCardArgs(const string& key) noex
             sdopt.GetString("ImagePath"),
             imgsizes[sdopt.GetInt("ImageSize")],
             sdopt.GetBool("ReadOnly"),
-            sdopt.GetBool("FolderSync") ? std::make_optional(sdopt.GetString("FolderPath")) : std::nullopt
+            sdopt.GetBool("FolderSync") ? std::make_optional(sdopt.GetString("FolderPath")) : std::nullopt,
+            sdopt.GetBool("FolderVirtual"),
+            (u32)sdopt.GetInt("CacheSectors")
     };
 }
 
@@ -1186,9 +1228,9 @@ void EmuInstance::enableCheats(bool enable)
 {
     cheatsOn = enable;
     if (cheatsOn && cheatFile)
-        nds->AREngine.Cheats = cheatFile->GetCodes();
+        nds->AREngine.SetCheats(cheatFile->GetCodes());
     else
-        nds->AREngine.Cheats.clear();
+        nds->AREngine.SetCheats({});
 }
 
 ARCodeFile* EmuInstance::getCheatFile()
@@ -1245,6 +1287,9 @@ void EmuInstance::setDateTime()
 
 bool EmuInstance::updateConsole() noexcept
 {
+    // the movie is tied to the console, which may be about to go away
+    stopMovie();
+
     // update the console type
     consoleType = globalCfg.GetInt("Emu.ConsoleType");
 
@@ -1405,6 +1450,16 @@ bool EmuInstance::updateConsole() noexcept
         }
     }
 
+    // the interpreter only takes the JIT's shortcuts when they're enabled for the JIT
+#ifdef JIT_ENABLED
+    bool idleloopskip = jitopt.GetBool("BranchOptimisations") && !gdbargs;
+    nds->JIT.Memory.SetDirectAccess(jitopt.GetBool("FastMemory"));
+#else
+    bool idleloopskip = false;
+#endif
+    nds->ARM9.IdleLoopSkipping = idleloopskip;
+    nds->ARM7.IdleLoopSkipping = idleloopskip;
+
     // loads the carts later -- to be sure that everything else is initialized
     nds->SetNDSCart(std::move(nextndscart));
     if (consoleType == 1)
@@ -1859,6 +1914,37 @@ bool EmuInstance::loadROMData(const QStringList& filepath, std::unique_ptr<u8[]>
         return false;
 }
 
+// ROM images shared by the instances running the same game
+static std::mutex sharedROMsLock;
+static std::map<std::string, std::weak_ptr<SharedROM>> sharedROMs;
+
+static std::shared_ptr<SharedROM> getSharedROM(const QStringList& filepath, const u8* data, u32 len)
+{
+    // the timestamp tells apart different versions of the same file
+    std::string key = filepath.join('|').toStdString() + "|" + std::to_string(len) + "|"
+        + std::to_string(QFileInfo(filepath.at(0)).lastModified().toMSecsSinceEpoch());
+
+    std::lock_guard lock(sharedROMsLock);
+
+    for (auto it = sharedROMs.begin(); it != sharedROMs.end(); )
+    {
+        if (it->second.expired())
+            it = sharedROMs.erase(it);
+        else
+            it++;
+    }
+
+    std::shared_ptr<SharedROM> rom = sharedROMs[key].lock();
+    if (!rom)
+    {
+        rom = SharedROM::FromBuffer(data, len);
+        if (rom)
+            sharedROMs[key] = rom;
+    }
+
+    return rom;
+}
+
 QString EmuInstance::getSavErrorString(std::string& filepath, bool gba)
 {
     std::string console = gba ? "GBA" : "DS";
@@ -1903,6 +1989,11 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset, QString& errorstr)
         cfg.enableReplace = cfgReplace;
         if (const char* dd = std::getenv("MELONDS_DUMP_DIR")) cfg.dumpDir = dd;
         if (const char* ld = std::getenv("MELONDS_LOAD_DIR")) cfg.loadDir = ld;
+        if (const char* t = std::getenv("MELONDS_TEX_DUMP_THREADS")) cfg.dumpThreads = (unsigned)std::strtoul(t, nullptr, 10);
+        if (const char* pk = std::getenv("MELONDS_TEX_DUMP_PACK")) cfg.packArchive = (*pk != '0');
+        if (const char* rle = std::getenv("MELONDS_TEX_DUMP_RLE")) cfg.tgaRLE = (*rle != '0');
+        if (const char* vk = std::getenv("MELONDS_TEX_VRAM_KEYS")) cfg.vramKeys = (*vk != '0');
+        if (const char* pf = std::getenv("MELONDS_TEX_PREFETCH")) cfg.prefetch = (*pf != '0');
 
         std::string romPath;
         if (!basepath.empty()) romPath = basepath + "/" + romname;
@@ -1988,7 +2079,18 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset, QString& errorstr)
             .SRAMLength = savelen,
     };
 
-    auto cart = NDSCart::ParseROM(std::move(filedata), filelen, this, std::move(cartargs));
+    // instances running the same game map one copy of the ROM
+    // (the cart's view of it is copy-on-write), instead of each holding its own
+    std::unique_ptr<NDSCart::CartCommon> cart;
+    auto shared = getSharedROM(filepath, filedata.get(), filelen);
+    if (shared)
+    {
+        filedata = nullptr;
+        cart = NDSCart::ParseROM(*shared, this, std::move(cartargs));
+    }
+    else
+        cart = NDSCart::ParseROM(std::move(filedata), filelen, this, std::move(cartargs));
+
     if (!cart)
     {
         // If we couldn't parse the ROM...
@@ -1996,6 +2098,8 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset, QString& errorstr)
         return false;
     }
 
+    sharedROM = std::move(shared);
+
     if (reset)
     {
         nextCart = std::move(cart);
@@ -2041,6 +2145,7 @@ bool EmuInstance::loadROM(QStringList filepath, bool reset, QString& errorstr)
 void EmuInstance::ejectCart()
 {
     ndsSave = nullptr;
+    sharedROM = nullptr;
 
     // Shutdown hires texture system when game is ejected
     #ifdef OGLRENDERER_ENABLED
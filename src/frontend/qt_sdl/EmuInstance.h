@@ -24,10 +24,12 @@
 #include "Platform.h"
 #include "main.h"
 #include "NDS.h"
+#include "Movie.h"
 #include "EmuThread.h"
 #include "Window.h"
 #include "Config.h"
 #include "SaveManager.h"
+#include "StateManager.h"
 
 const int kMaxWindows = 4;
 
@@ -182,8 +184,11 @@ private:
     std::string getSavestateName(int slot);
     bool savestateExists(int slot);
     bool loadState(const std::string& filename);
-    bool saveState(const std::string& filename);
+    bool saveState(const std::string& filename, StateManager::Callback done);
     void undoStateLoad();
+    bool startMovieRecording(const std::string& filename);
+    bool startMoviePlayback(const std::string& filename);
+    void stopMovie();
     void unloadCheats();
     void loadCheats();
     std::unique_ptr<melonDS::ARM9BIOSImage> loadARM9BIOS() noexcept;
@@ -278,6 +283,7 @@ private:
     std::string baseAssetName;
     bool changeCart;
     std::unique_ptr<melonDS::NDSCart::CartCommon> nextCart;
+    std::shared_ptr<melonDS::SharedROM> sharedROM;
 
     int gbaCartType;
     std::string baseGBAROMDir;
@@ -292,6 +298,9 @@ public:
     std::unique_ptr<SaveManager> gbaSave;
     std::unique_ptr<SaveManager> firmwareSave;
 
+    std::unique_ptr<melonDS::MovieRecorder> movieRecorder;
+    std::unique_ptr<melonDS::MoviePlayer> moviePlayer;
+
     bool doLimitFPS;
     double curFPS;
     double targetFPS;
@@ -302,10 +311,13 @@ public:
     bool doAudioSync;
 private:
 
+    std::unique_ptr<StateManager> stateManager;
     std::unique_ptr<melonDS::Savestate> backupState;
     bool savestateLoaded;
     std::string previousSaveFile;
 
+    std::string moviePath;
+
     std::unique_ptr<melonDS::ARCodeFile> cheatFile;
     bool cheatsOn;
 
@@ -157,10 +157,10 @@ void EmuInstance::audioCallback(void* data, Uint8* stream, int len)
 
     int len_in = inst->audioGetNumSamplesOut(len);
     if (len_in > inst->audioBufSize) len_in = inst->audioBufSize;
-    s16 buf_in[inst->audioBufSize*2];
 
-    SDL_LockMutex(inst->audioSyncLock);
+    // the output ring is lock-free, the lock is only needed to wake up audioSync()
     int num_in = inst->nds->SPU.ReadOutput((s16*) stream, len_in);
+    SDL_LockMutex(inst->audioSyncLock);
     SDL_CondSignal(inst->audioSyncCond);
     SDL_UnlockMutex(inst->audioSyncLock);
 
@@ -138,6 +138,7 @@ EmuSettingsDialog::EmuSettingsDialog(QWidget* parent) : QDialog(parent), ui(new
     ui->cbDLDIReadOnly->setChecked(cfg.GetBool("DLDI.ReadOnly"));
     ui->cbDLDIFolder->setChecked(cfg.GetBool("DLDI.FolderSync"));
     ui->txtDLDIFolder->setText(cfg.GetQString("DLDI.FolderPath"));
+    ui->cbDLDIFolderVirtual->setChecked(cfg.GetBool("DLDI.FolderVirtual"));
     on_cbDLDIEnable_toggled();
 
     ui->cbDSiFullBIOSBoot->setChecked(cfg.GetBool("DSi.FullBIOSBoot"));
@@ -149,6 +150,7 @@ EmuSettingsDialog::EmuSettingsDialog(QWidget* parent) : QDialog(parent), ui(new
     ui->cbDSiSDReadOnly->setChecked(cfg.GetBool("DSi.SD.ReadOnly"));
     ui->cbDSiSDFolder->setChecked(cfg.GetBool("DSi.SD.FolderSync"));
     ui->txtDSiSDFolder->setText(cfg.GetQString("DSi.SD.FolderPath"));
+    ui->cbDSiSDFolderVirtual->setChecked(cfg.GetBool("DSi.SD.FolderVirtual"));
     on_cbDSiSDEnable_toggled();
 
 #define SET_ORIGVAL(type, val) \
@@ -269,6 +271,7 @@ void EmuSettingsDialog::done(int r)
             cfg.SetBool("DLDI.ReadOnly", ui->cbDLDIReadOnly->isChecked());
             cfg.SetBool("DLDI.FolderSync", ui->cbDLDIFolder->isChecked());
             cfg.SetQString("DLDI.FolderPath", ui->txtDLDIFolder->text());
+            cfg.SetBool("DLDI.FolderVirtual", ui->cbDLDIFolderVirtual->isChecked());
 
             cfg.SetQString("DSi.BIOS9Path", ui->txtDSiBIOS9Path->text());
             cfg.SetQString("DSi.BIOS7Path", ui->txtDSiBIOS7Path->text());
@@ -284,6 +287,7 @@ void EmuSettingsDialog::done(int r)
             cfg.SetBool("DSi.SD.ReadOnly", ui->cbDSiSDReadOnly->isChecked());
             cfg.SetBool("DSi.SD.FolderSync", ui->cbDSiSDFolder->isChecked());
             cfg.SetQString("DSi.SD.FolderPath", ui->txtDSiSDFolder->text());
+            cfg.SetBool("DSi.SD.FolderVirtual", ui->cbDSiSDFolderVirtual->isChecked());
 
 #ifdef JIT_ENABLED
             cfg.SetBool("JIT.Enable", ui->chkEnableJIT->isChecked());
@@ -402,6 +406,7 @@ void EmuSettingsDialog::on_cbDLDIEnable_toggled()
     if (!disabled) disabled = !ui->cbDLDIFolder->isChecked();
     ui->txtDLDIFolder->setDisabled(disabled);
     ui->btnDLDIFolderBrowse->setDisabled(disabled);
+    ui->cbDLDIFolderVirtual->setDisabled(disabled);
 }
 
 void EmuSettingsDialog::on_btnDLDISDBrowse_clicked()
@@ -429,6 +434,7 @@ void EmuSettingsDialog::on_cbDLDIFolder_toggled()
     bool disabled = !ui->cbDLDIFolder->isChecked();
     ui->txtDLDIFolder->setDisabled(disabled);
     ui->btnDLDIFolderBrowse->setDisabled(disabled);
+    ui->cbDLDIFolderVirtual->setDisabled(disabled);
 }
 
 void EmuSettingsDialog::on_btnDLDIFolderBrowse_clicked()
@@ -496,6 +502,7 @@ void EmuSettingsDialog::on_cbDSiSDEnable_toggled()
     if (!disabled) disabled = !ui->cbDSiSDFolder->isChecked();
     ui->txtDSiSDFolder->setDisabled(disabled);
     ui->btnDSiSDFolderBrowse->setDisabled(disabled);
+    ui->cbDSiSDFolderVirtual->setDisabled(disabled);
 }
 
 void EmuSettingsDialog::on_btnDSiSDBrowse_clicked()
@@ -523,6 +530,7 @@ void EmuSettingsDialog::on_cbDSiSDFolder_toggled()
     bool disabled = !ui->cbDSiSDFolder->isChecked();
     ui->txtDSiSDFolder->setDisabled(disabled);
     ui->btnDSiSDFolderBrowse->setDisabled(disabled);
+    ui->cbDSiSDFolderVirtual->setDisabled(disabled);
 }
 
 void EmuSettingsDialog::on_btnDSiSDFolderBrowse_clicked()
@@ -253,18 +253,37 @@ void EmuThread::run()
             }
 
             // process input and hotkeys
-            emuInstance->nds->SetKeyMask(emuInstance->inputMask);
-
-            if (emuInstance->isTouching)
-                emuInstance->nds->TouchScreen(emuInstance->touchX, emuInstance->touchY);
+            // a movie being played back takes over all of the input
+            if (emuInstance->moviePlayer)
+            {
+                emuInstance->moviePlayer->BeginFrame();
+            }
             else
-                emuInstance->nds->ReleaseScreen();
-
-            if (emuInstance->hotkeyPressed(HK_Lid))
             {
-                bool lid = !emuInstance->nds->IsLidClosed();
-                emuInstance->nds->SetLidClosed(lid);
-                emuInstance->osdAddMessage(0, lid ? "Lid closed" : "Lid opened");
+                emuInstance->nds->SetKeyMask(emuInstance->inputMask);
+
+                if (emuInstance->isTouching)
+                    emuInstance->nds->TouchScreen(emuInstance->touchX, emuInstance->touchY);
+                else
+                    emuInstance->nds->ReleaseScreen();
+
+                if (emuInstance->hotkeyPressed(HK_Lid))
+                {
+                    bool lid = !emuInstance->nds->IsLidClosed();
+                    emuInstance->nds->SetLidClosed(lid);
+                    emuInstance->osdAddMessage(0, lid ? "Lid closed" : "Lid opened");
+                }
+
+                if (emuInstance->movieRecorder)
+                {
+                    MovieInput input;
+                    input.KeyMask = emuInstance->inputMask;
+                    input.Touching = emuInstance->isTouching;
+                    input.TouchX = emuInstance->touchX;
+                    input.TouchY = emuInstance->touchY;
+                    input.LidClosed = emuInstance->nds->IsLidClosed();
+                    emuInstance->movieRecorder->BeginFrame(input);
+                }
             }
 
             // auto screen layout
@@ -307,6 +326,21 @@ void EmuThread::run()
             else
             {
                 nlines = emuInstance->nds->RunFrame();
+
+                if (emuInstance->moviePlayer)
+                {
+                    if (!emuInstance->moviePlayer->EndFrame() &&
+                        emuInstance->moviePlayer->GetDivergenceFrame() == emuInstance->moviePlayer->GetCurrentFrame() - 1)
+                        emuInstance->osdAddMessage(0xFFA0A0, "Movie desynced at frame %u", *emuInstance->moviePlayer->GetDivergenceFrame());
+
+                    if (emuInstance->moviePlayer->IsFinished())
+                    {
+                        emuInstance->stopMovie();
+                        emuInstance->osdAddMessage(0, "Movie playback finished");
+                    }
+                }
+                else if (emuInstance->movieRecorder)
+                    emuInstance->movieRecorder->EndFrame();
             }
 
             if (emuInstance->ndsSave)
@@ -318,15 +352,12 @@ void EmuThread::run()
             if (emuInstance->firmwareSave)
                 emuInstance->firmwareSave->CheckFlush();
 
-            if (!useOpenGL)
-            {
-                frontBufferLock.lock();
-                frontBuffer = emuInstance->nds->GPU.FrontBuffer;
-                frontBufferLock.unlock();
-            }
-            else
+            // without OpenGL, the UI thread picks up the newest frame by itself
+            // when painting, so there is nothing to hand over here
+            // frames skipped while fast-forwarding don't need to be drawn again
+            if (useOpenGL && (emuInstance->nds->GPU.HasNewFrame() || !fastforward))
             {
-                frontBuffer = emuInstance->nds->GPU.FrontBuffer;
+                frontBuffer = emuInstance->nds->GPU.AcquirePresentBuffer();
                 emuInstance->drawScreenGL();
             }
 
@@ -363,6 +394,9 @@ void EmuThread::run()
             fastforward = enablefastforward;
             slowmo = enableslowmo;
 
+            if (!fastforward)
+                emuInstance->nds->GPU.SetFrameSkip(0);
+
             if (slowmo) emuInstance->curFPS = emuInstance->slowmoFPS;
             else if (fastforward) emuInstance->curFPS = emuInstance->fastForwardFPS;
             else if (!emuInstance->doLimitFPS && !emuInstance->doAudioSync) emuInstance->curFPS = 1000.0;
@@ -424,6 +458,10 @@ void EmuThread::run()
                 winUpdateFreq = fps / (u32)round(fpstarget);
                 if (winUpdateFreq < 1)
                     winUpdateFreq = 1;
+
+                // while fast-forwarding, only render about as many frames as the screen can show
+                if (fastforward)
+                    emuInstance->nds->GPU.SetFrameSkip(std::clamp<u32>(fps / 60, 1, 10) - 1);
                     
                 double actualfps = (59.8261 * 263.0) / nlines;
                 snprintf(melontitle, sizeof(melontitle), "[%d/%.0f] melonDSHD " MELONDS_VERSION, fps, actualfps);
@@ -625,7 +663,8 @@ void EmuThread::handleMessages()
             break;
 
         case msg_SaveState:
-            msgResult = emuInstance->saveState(msg.param.value<QString>().toStdString());
+            msgResult = emuInstance->saveState(msg.param.value<QString>().toStdString(), std::move(msgStateCallback));
+            msgStateCallback = nullptr;
             break;
 
         case msg_LoadState:
@@ -660,6 +699,24 @@ void EmuThread::handleMessages()
         case msg_EnableCheats:
             emuInstance->enableCheats(msg.param.value<bool>());
             break;
+
+        case msg_StartMovieRecording:
+            msgResult = emuInstance->startMovieRecording(msg.param.value<QString>().toStdString());
+            if (msgResult)
+                emuInstance->osdAddMessage(0, "Recording movie");
+            break;
+
+        case msg_StartMoviePlayback:
+            msgResult = emuInstance->startMoviePlayback(msg.param.value<QString>().toStdString());
+            if (msgResult)
+                emuInstance->osdAddMessage(0, "Playing movie");
+            else
+                emuInstance->osdAddMessage(0xFFA0A0, "Failed to play movie");
+            break;
+
+        case msg_StopMovie:
+            emuInstance->stopMovie();
+            break;
         }
 
         msgSemaphore.release();
@@ -828,8 +885,9 @@ int EmuThread::insertGBAAddon(int type, QString& errorstr)
     return msgResult;
 }
 
-int EmuThread::saveState(const QString& filename)
+int EmuThread::saveState(const QString& filename, StateManager::Callback done)
 {
+    msgStateCallback = std::move(done);
     sendMessage({.type = msg_SaveState, .param = filename});
     waitMessage();
     return msgResult;
@@ -863,6 +921,26 @@ void EmuThread::enableCheats(bool enable)
     waitMessage();
 }
 
+int EmuThread::startMovieRecording(const QString& filename)
+{
+    sendMessage({.type = msg_StartMovieRecording, .param = filename});
+    waitMessage();
+    return msgResult;
+}
+
+int EmuThread::startMoviePlayback(const QString& filename)
+{
+    sendMessage({.type = msg_StartMoviePlayback, .param = filename});
+    waitMessage();
+    return msgResult;
+}
+
+void EmuThread::stopMovie()
+{
+    sendMessage(msg_StopMovie);
+    waitMessage();
+}
+
 void EmuThread::updateRenderer()
 {
     if (videoRenderer != lastVideoRenderer)
@@ -903,6 +981,9 @@ void EmuThread::updateRenderer()
             break;
         default: __builtin_unreachable();
     }
+
+    // off unless asked for, until the 2D render thread has been timed on multi-core hosts
+    emuInstance->nds->GPU.SetThreaded2D(videoRenderer == renderer3D_Software && cfg.GetBool("2D.Threaded"));
 }
 
 void EmuThread::compileShaders()
@@ -33,6 +33,7 @@
 
 #include "NDSCart.h"
 #include "GBACart.h"
+#include "StateManager.h"
 
 namespace melonDS
 {
@@ -84,6 +85,10 @@ public:
         msg_ImportSavefile,
 
         msg_EnableCheats,
+
+        msg_StartMovieRecording,
+        msg_StartMoviePlayback,
+        msg_StopMovie,
     };
 
     struct Message
@@ -119,7 +124,8 @@ public:
     void ejectCart(bool gba);
     int insertGBAAddon(int type, QString& errorstr);
 
-    int saveState(const QString& filename);
+    // only takes the snapshot, done is called once the file is written
+    int saveState(const QString& filename, StateManager::Callback done);
     int loadState(const QString& filename);
     int undoStateLoad();
 
@@ -127,6 +133,10 @@ public:
 
     void enableCheats(bool enable);
 
+    int startMovieRecording(const QString& filename);
+    int startMoviePlayback(const QString& filename);
+    void stopMovie();
+
     bool emuIsRunning();
     bool emuIsActive();
 
@@ -137,8 +147,8 @@ public:
     void updateVideoSettings() { videoSettingsDirty = true; }
     void updateVideoRenderer() { videoSettingsDirty = true; lastVideoRenderer = -1; }
 
+    // framebuffer slot being displayed, only used with OpenGL
     int frontBuffer = 0;
-    QMutex frontBufferLock;
 
     QWaitCondition glBorrowCond;
     QMutex glBorrowMutex;
@@ -187,6 +197,8 @@ private:
 
     int msgResult = 0;
     QString msgError;
+    // passed along with msg_SaveState
+    StateManager::Callback msgStateCallback;
 
     QMutex msgMutex;
     QSemaphore msgSemaphore;
@@ -748,9 +748,6 @@ void ScreenPanel::calcSplashLayout()
 
 ScreenPanelNative::ScreenPanelNative(QWidget* parent) : ScreenPanel(parent)
 {
-    screen[0] = QImage(256, 192, QImage::Format_RGB32);
-    screen[1] = QImage(256, 192, QImage::Format_RGB32);
-
     screenTrans[0].reset();
     screenTrans[1].reset();
 }
@@ -787,24 +784,24 @@ void ScreenPanelNative::paintEvent(QPaintEvent* event)
         auto nds = emuInstance->getNDS();
 
         assert(nds != nullptr);
-        emuThread->frontBufferLock.lock();
-        int frontbuf = emuThread->frontBuffer;
-        if (!nds->GPU.Framebuffer[frontbuf][0] || !nds->GPU.Framebuffer[frontbuf][1])
-        {
-            emuThread->frontBufferLock.unlock();
-            return;
-        }
 
-        memcpy(screen[0].scanLine(0), nds->GPU.Framebuffer[frontbuf][0].get(), 256 * 192 * 4);
-        memcpy(screen[1].scanLine(0), nds->GPU.Framebuffer[frontbuf][1].get(), 256 * 192 * 4);
-        emuThread->frontBufferLock.unlock();
+        // the acquired slot is left alone by the emulator until we acquire
+        // another one, so we can draw straight from it
+        int frontbuf = nds->GPU.AcquirePresentBuffer();
+        if (nds->GPU.Framebuffer[frontbuf][0] && nds->GPU.Framebuffer[frontbuf][1])
+        {
+            const QImage screen[2] = {
+                QImage((const uchar*)nds->GPU.Framebuffer[frontbuf][0].get(), 256, 192, QImage::Format_RGB32),
+                QImage((const uchar*)nds->GPU.Framebuffer[frontbuf][1].get(), 256, 192, QImage::Format_RGB32),
+            };
 
-        QRect screenrc(0, 0, 256, 192);
+            QRect screenrc(0, 0, 256, 192);
 
-        for (int i = 0; i < numScreens; i++)
-        {
-            painter.setTransform(screenTrans[i]);
-            painter.drawImage(screenrc, screen[screenKind[i]]);
+            for (int i = 0; i < numScreens; i++)
+            {
+                painter.setTransform(screenTrans[i]);
+                painter.drawImage(screenrc, screen[screenKind[i]]);
+            }
         }
         emuInstance->renderLock.unlock();
     }
@@ -167,7 +167,6 @@ protected:
 private:
     void setupScreenLayout() override;
 
-    QImage screen[2];
     QTransform screenTrans[kMaxScreenTransforms];
 };
 
@@ -0,0 +1,265 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#include <string.h>
+#include <zstd.h>
+
+#include "StateManager.h"
+#include "Platform.h"
+
+using namespace melonDS;
+using namespace melonDS::Platform;
+
+// fast enough to not hold up a save for more than a few frames, still halves the size of most states
+const int kCompressionLevel = 1;
+
+// snapshot buffers kept around for reuse
+const size_t kMaxFreeBuffers = 2;
+
+StateManager::StateManager() : QThread()
+{
+    Busy = false;
+    Running = true;
+    start();
+}
+
+StateManager::~StateManager()
+{
+    // don't lose any state that was already saved, but don't bother with loads
+    Lock.lock();
+    for (auto it = Jobs.begin(); it != Jobs.end();)
+    {
+        if (it->State) it++;
+        else it = Jobs.erase(it);
+    }
+    Running = false;
+    JobsQueued.wakeAll();
+    Lock.unlock();
+
+    wait();
+}
+
+std::unique_ptr<Savestate> StateManager::GetSnapshotBuffer()
+{
+    Lock.lock();
+    if (FreeBuffers.empty())
+    {
+        Lock.unlock();
+        return std::make_unique<Savestate>();
+    }
+
+    std::unique_ptr<Savestate> state = std::move(FreeBuffers.back());
+    FreeBuffers.pop_back();
+    Lock.unlock();
+
+    state->Rewind(true);
+    return state;
+}
+
+void StateManager::ReleaseSnapshotBuffer(std::unique_ptr<Savestate> state)
+{
+    if (!state) return;
+
+    Lock.lock();
+    if (FreeBuffers.size() < kMaxFreeBuffers)
+        FreeBuffers.push_back(std::move(state));
+    Lock.unlock();
+}
+
+void StateManager::QueueSave(std::unique_ptr<Savestate> state, const std::string& path, Callback done)
+{
+    Lock.lock();
+    if (PrefetchedPath == path)
+    {
+        Prefetched.clear();
+        PrefetchedPath.clear();
+    }
+    Jobs.push_back({std::move(state), path, std::move(done)});
+    JobsQueued.wakeAll();
+    Lock.unlock();
+}
+
+void StateManager::QueueLoad(const std::string& path, Callback done)
+{
+    Lock.lock();
+    Jobs.push_back({nullptr, path, std::move(done)});
+    JobsQueued.wakeAll();
+    Lock.unlock();
+}
+
+bool StateManager::TakeStateFile(const std::string& path, std::vector<u8>& out)
+{
+    Lock.lock();
+    if (PrefetchedPath == path && !Prefetched.empty())
+    {
+        out = std::move(Prefetched);
+        Prefetched.clear();
+        PrefetchedPath.clear();
+        Lock.unlock();
+        return true;
+    }
+    Lock.unlock();
+
+    // the file might still be being written
+    Flush();
+    return ReadStateFile(path, out);
+}
+
+void StateManager::Flush()
+{
+    Lock.lock();
+    while (Busy || !Jobs.empty())
+        JobsDone.wait(&Lock);
+    Lock.unlock();
+}
+
+void StateManager::Complete(Callback& done, bool res)
+{
+    if (!done) return;
+
+    QMetaObject::invokeMethod(this, [done = std::move(done), res]() { done(res); }, Qt::QueuedConnection);
+}
+
+void StateManager::run()
+{
+    for (;;)
+    {
+        Lock.lock();
+        while (Running && Jobs.empty())
+            JobsQueued.wait(&Lock);
+
+        if (Jobs.empty())
+        {
+            Lock.unlock();
+            return;
+        }
+
+        Job job = std::move(Jobs.front());
+        Jobs.pop_front();
+        Busy = true;
+        Lock.unlock();
+
+        if (job.State)
+        {
+            bool res = WriteStateFile(*job.State, job.Path);
+            ReleaseSnapshotBuffer(std::move(job.State));
+            Complete(job.Done, res);
+        }
+        else
+        {
+            std::vector<u8> data;
+            bool res = ReadStateFile(job.Path, data);
+
+            Lock.lock();
+            // if the file is about to be overwritten, it has to be read again
+            bool keep = res;
+            for (const Job& next : Jobs)
+            {
+                if (next.State && next.Path == job.Path)
+                    keep = false;
+            }
+            PrefetchedPath = keep ? job.Path : "";
+            Prefetched = keep ? std::move(data) : std::vector<u8>();
+            Lock.unlock();
+
+            Complete(job.Done, res);
+        }
+
+        Lock.lock();
+        Busy = false;
+        JobsDone.wakeAll();
+        Lock.unlock();
+    }
+}
+
+bool StateManager::WriteStateFile(const Savestate& state, const std::string& path)
+{
+    size_t bound = ZSTD_compressBound(state.Length());
+    if (CompressBuffer.size() < bound)
+        CompressBuffer.resize(bound);
+
+    size_t len = ZSTD_compress(CompressBuffer.data(), bound, state.Buffer(), state.Length(), kCompressionLevel);
+    if (ZSTD_isError(len))
+    {
+        Log(LogLevel::Error, "StateManager: failed to compress state (%s)\n", ZSTD_getErrorName(len));
+        return false;
+    }
+
+    FileHandle* file = OpenFile(path, FileMode::Write);
+    if (!file)
+    {
+        Log(LogLevel::Error, "StateManager: failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    bool res = FileWrite(CompressBuffer.data(), len, 1, file) == 1;
+    CloseFile(file);
+
+    if (res)
+        Log(LogLevel::Info, "StateManager: wrote %u-byte state (%zu compressed) to %s\n", state.Length(), len, path.c_str());
+    else
+        Log(LogLevel::Error, "StateManager: failed to write %zu bytes to %s\n", len, path.c_str());
+
+    return res;
+}
+
+bool StateManager::ReadStateFile(const std::string& path, std::vector<u8>& out)
+{
+    FileHandle* file = OpenFile(path, FileMode::Read);
+    if (!file)
+    {
+        Log(LogLevel::Error, "StateManager: failed to open %s\n", path.c_str());
+        return false;
+    }
+
+    u64 len = FileLength(file);
+    std::vector<u8> data(len);
+    bool res = len > 0 && FileRead(data.data(), len, 1, file) == 1;
+    CloseFile(file);
+
+    if (!res)
+    {
+        Log(LogLevel::Error, "StateManager: failed to read %s\n", path.c_str());
+        return false;
+    }
+
+    // states from older versions aren't compressed
+    if (len < 4 || memcmp(data.data(), "MELN", 4) == 0)
+    {
+        out = std::move(data);
+        return true;
+    }
+
+    u64 statelen = ZSTD_getFrameContentSize(data.data(), len);
+    if (statelen == ZSTD_CONTENTSIZE_ERROR || statelen == ZSTD_CONTENTSIZE_UNKNOWN || statelen > 0x80000000)
+    {
+        Log(LogLevel::Error, "StateManager: %s is not a savestate\n", path.c_str());
+        return false;
+    }
+
+    out.resize(statelen);
+    size_t decompressed = ZSTD_decompress(out.data(), statelen, data.data(), len);
+    if (ZSTD_isError(decompressed) || decompressed != statelen)
+    {
+        Log(LogLevel::Error, "StateManager: failed to decompress %s\n", path.c_str());
+        out.clear();
+        return false;
+    }
+
+    return true;
+}
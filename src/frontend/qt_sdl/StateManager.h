@@ -0,0 +1,94 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef STATEMANAGER_H
+#define STATEMANAGER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "types.h"
+#include "Savestate.h"
+
+// Writes and reads savestate files on a worker thread, so the emulation thread
+// only has to take a snapshot into memory (or restore one) when savestating.
+// Files are compressed with zstd, uncompressed ones from older versions can still be loaded.
+class StateManager : public QThread
+{
+    Q_OBJECT
+    void run() override;
+
+public:
+    // called on the thread the manager was created on, once the job is done
+    using Callback = std::function<void(bool)>;
+
+    StateManager();
+    ~StateManager();
+
+    // returns an empty buffer to take a snapshot into, reusing the memory of earlier ones
+    std::unique_ptr<melonDS::Savestate> GetSnapshotBuffer();
+    // hands a snapshot buffer back once it's no longer needed
+    void ReleaseSnapshotBuffer(std::unique_ptr<melonDS::Savestate> state);
+
+    // compresses the snapshot and writes it to the file
+    void QueueSave(std::unique_ptr<melonDS::Savestate> state, const std::string& path, Callback done);
+    // reads and decompresses the file ahead of time, for TakePrefetched()
+    void QueueLoad(const std::string& path, Callback done);
+
+    // returns the contents of the file if QueueLoad() prefetched it, otherwise reads it right away
+    bool TakeStateFile(const std::string& path, std::vector<melonDS::u8>& out);
+
+    // waits for all queued jobs to be done
+    void Flush();
+
+    static bool ReadStateFile(const std::string& path, std::vector<melonDS::u8>& out);
+
+private:
+    struct Job
+    {
+        std::unique_ptr<melonDS::Savestate> State; // null for loads
+        std::string Path;
+        Callback Done;
+    };
+
+    bool WriteStateFile(const melonDS::Savestate& state, const std::string& path);
+    void Complete(Callback& done, bool res);
+
+    QMutex Lock;
+    QWaitCondition JobsQueued;
+    QWaitCondition JobsDone;
+    std::deque<Job> Jobs;
+    bool Busy;
+    bool Running;
+
+    std::vector<std::unique_ptr<melonDS::Savestate>> FreeBuffers;
+
+    std::string PrefetchedPath;
+    std::vector<melonDS::u8> Prefetched;
+
+    // reused between saves
+    std::vector<melonDS::u8> CompressBuffer;
+};
+
+#endif // STATEMANAGER_H
@@ -41,6 +41,7 @@
 #include <QVector>
 #include <QCommandLineParser>
 #include <QDesktopServices>
+#include <QPointer>
 #ifndef _WIN32
 #include <QGuiApplication>
 #include <QSocketNotifier>
@@ -1589,14 +1590,24 @@ void MainWindow::onSaveState()
             return;
     }
 
-    if (emuThread->saveState(filename))
+    // the emulator only stops to take a snapshot, the file is written in the background
+    QPointer<MainWindow> win = this;
+    EmuInstance* inst = emuInstance;
+    auto done = [win, inst, slot](bool res)
     {
-        if (slot > 0) emuInstance->osdAddMessage(0, "State saved to slot %d", slot);
-        else          emuInstance->osdAddMessage(0, "State saved to file");
+        if (!res)
+        {
+            inst->osdAddMessage(0xFFA0A0, "State save failed");
+            return;
+        }
 
-        actLoadState[slot]->setEnabled(true);
-    }
-    else
+        if (slot > 0) inst->osdAddMessage(0, "State saved to slot %d", slot);
+        else          inst->osdAddMessage(0, "State saved to file");
+
+        if (win) win->actLoadState[slot]->setEnabled(true);
+    };
+
+    if (!emuThread->saveState(filename, done))
     {
         emuInstance->osdAddMessage(0xFFA0A0, "State save failed");
     }
@@ -1624,7 +1635,19 @@ void MainWindow::onLoadState()
             return;
     }
 
-    if (!Platform::FileExists(filename.toStdString()))
+    // the file is read and decompressed in the background, after any save to it still in progress,
+    // the emulator only stops once it's ready to be loaded
+    QPointer<MainWindow> win = this;
+    emuInstance->stateManager->QueueLoad(filename.toStdString(), [win, slot, filename](bool res)
+    {
+        if (!win) return;
+        win->finishLoadState(slot, filename, res);
+    });
+}
+
+void MainWindow::finishLoadState(int slot, const QString& filename, bool prefetched)
+{
+    if (!prefetched && !Platform::FileExists(filename.toStdString()))
     {
         if (slot > 0) emuInstance->osdAddMessage(0xFFA0A0, "State slot %d is empty", slot);
         else          emuInstance->osdAddMessage(0xFFA0A0, "State file does not exist");
@@ -1632,7 +1655,7 @@ void MainWindow::onLoadState()
         return;
     }
 
-    if (emuThread->loadState(filename))
+    if (prefetched && emuThread->loadState(filename))
     {
         if (slot > 0) emuInstance->osdAddMessage(0, "State loaded from slot %d", slot);
         else          emuInstance->osdAddMessage(0, "State loaded from file");
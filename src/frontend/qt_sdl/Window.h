@@ -254,6 +254,7 @@ private:
     QString pickFileFromArchive(QString archiveFileName);
     QStringList pickROM(bool gba);
     void updateCartInserted(bool gba);
+    void finishLoadState(int slot, const QString& filename, bool prefetched);
 
     void createScreenPanel();
 
@@ -397,7 +397,14 @@ int main(int argc, char** argv)
 
         if (memberSyntaxUsed) printf("Warning: use the a.zip|b.nds format at your own risk!\n");
 
-        win->preloadROMs(dsfile, gbafile, options->boot);
+        if (win->preloadROMs(dsfile, gbafile, options->boot))
+        {
+            EmuThread* emuThread = emuInstances[0]->getEmuThread();
+            if (options->playMoviePath)
+                emuThread->startMoviePlayback(*options->playMoviePath);
+            else if (options->recordMoviePath)
+                emuThread->startMovieRecording(*options->recordMoviePath);
+        }
 
         if (options->fullscreen)
             win->toggleFullscreen();
@@ -0,0 +1,278 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+#include "BlockTex.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace fs = std::filesystem;
+namespace melonDS::hires {
+
+static inline size_t block_bytes(BlockFormat fmt) { return fmt == BlockFormat::BC1 ? 8 : 16; }
+
+size_t BlockCompressedSize(BlockFormat fmt, uint32_t w, uint32_t h) {
+    return size_t(std::max(1u, (w + 3) / 4)) * std::max(1u, (h + 3) / 4) * block_bytes(fmt);
+}
+
+// ----------- Decoding -----------------
+static inline void expand565(uint16_t c, uint8_t* out) {
+    const uint8_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+    out[0] = uint8_t((r << 3) | (r >> 2));
+    out[1] = uint8_t((g << 2) | (g >> 4));
+    out[2] = uint8_t((b << 3) | (b >> 2));
+    out[3] = 255;
+}
+
+// Palette of a color block. BC1 blocks with c0 <= c1 have three colors and transparent black,
+// the color part of BC3 blocks always has four.
+static void color_palette(uint16_t c0, uint16_t c1, bool bc1, uint8_t pal[4][4]) {
+    expand565(c0, pal[0]);
+    expand565(c1, pal[1]);
+    if (!bc1 || c0 > c1) {
+        for (int k = 0; k < 3; ++k) {
+            pal[2][k] = uint8_t((2*pal[0][k] + pal[1][k]) / 3);
+            pal[3][k] = uint8_t((pal[0][k] + 2*pal[1][k]) / 3);
+        }
+        pal[2][3] = pal[3][3] = 255;
+    } else {
+        for (int k = 0; k < 3; ++k) pal[2][k] = uint8_t((pal[0][k] + pal[1][k]) / 2);
+        pal[2][3] = 255;
+        pal[3][0] = pal[3][1] = pal[3][2] = pal[3][3] = 0;
+    }
+}
+
+static void alpha_palette(uint8_t a0, uint8_t a1, uint8_t pal[8]) {
+    pal[0] = a0; pal[1] = a1;
+    if (a0 > a1) {
+        for (int i = 1; i < 7; ++i) pal[i+1] = uint8_t(((7-i)*a0 + i*a1) / 7);
+    } else {
+        for (int i = 1; i < 5; ++i) pal[i+1] = uint8_t(((5-i)*a0 + i*a1) / 5);
+        pal[6] = 0; pal[7] = 255;
+    }
+}
+
+static void decode_color(const uint8_t* b, bool bc1, uint8_t out[16][4]) {
+    const uint16_t c0 = uint16_t(b[0] | (b[1] << 8)), c1 = uint16_t(b[2] | (b[3] << 8));
+    const uint32_t idx = b[4] | (b[5] << 8) | (b[6] << 16) | (uint32_t(b[7]) << 24);
+    uint8_t pal[4][4];
+    color_palette(c0, c1, bc1, pal);
+    for (int i = 0; i < 16; ++i) std::memcpy(out[i], pal[(idx >> (2*i)) & 3], 4);
+}
+
+static void decode_alpha(const uint8_t* b, uint8_t out[16][4]) {
+    uint8_t pal[8];
+    alpha_palette(b[0], b[1], pal);
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i) bits |= uint64_t(b[2+i]) << (8*i);
+    for (int i = 0; i < 16; ++i) out[i][3] = pal[(bits >> (3*i)) & 7];
+}
+
+void DecodeBlocks(BlockFormat fmt, const uint8_t* src, uint32_t w, uint32_t h, uint8_t* rgbaOut) {
+    const size_t bsize = block_bytes(fmt);
+    uint8_t px[16][4];
+    for (uint32_t by = 0; by < h; by += 4) {
+        for (uint32_t bx = 0; bx < w; bx += 4, src += bsize) {
+            if (fmt == BlockFormat::BC1) {
+                decode_color(src, true, px);
+            } else {
+                decode_color(src + 8, false, px);
+                decode_alpha(src, px);
+            }
+            for (uint32_t y = 0; y < 4 && by + y < h; ++y)
+                for (uint32_t x = 0; x < 4 && bx + x < w; ++x)
+                    std::memcpy(rgbaOut + (size_t(by + y)*w + bx + x)*4, px[y*4 + x], 4);
+        }
+    }
+}
+
+// ----------- Encoding -----------------
+static inline uint16_t pack565(const float* c) {
+    auto q = [](float v, int maxv) { return int(std::clamp(v, 0.f, 255.f) * maxv / 255.f + 0.5f); };
+    return uint16_t((q(c[0], 31) << 11) | (q(c[1], 63) << 5) | q(c[2], 31));
+}
+
+static void encode_color(const uint8_t px[16][4], bool bc1, uint8_t* out) {
+    // BC1 blocks with transparent texels need the three color mode
+    bool used[16];
+    bool transparent = false;
+    int n = 0;
+    float mean[3] = {};
+    for (int i = 0; i < 16; ++i) {
+        used[i] = !bc1 || px[i][3] >= 128;
+        if (!used[i]) { transparent = true; continue; }
+        for (int k = 0; k < 3; ++k) mean[k] += px[i][k];
+        ++n;
+    }
+
+    uint16_t c0 = 0, c1 = 0;
+    if (n) {
+        for (int k = 0; k < 3; ++k) mean[k] /= n;
+        float cov[6] = {};
+        for (int i = 0; i < 16; ++i) {
+            if (!used[i]) continue;
+            const float d[3] = { px[i][0] - mean[0], px[i][1] - mean[1], px[i][2] - mean[2] };
+            cov[0] += d[0]*d[0]; cov[1] += d[0]*d[1]; cov[2] += d[0]*d[2];
+            cov[3] += d[1]*d[1]; cov[4] += d[1]*d[2]; cov[5] += d[2]*d[2];
+        }
+        // principal axis by power iteration
+        float axis[3] = { 1.f, 1.f, 1.f };
+        for (int it = 0; it < 8; ++it) {
+            const float v[3] = {
+                cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2],
+                cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2],
+                cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2],
+            };
+            const float len = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+            if (len < 1e-6f) break;
+            for (int k = 0; k < 3; ++k) axis[k] = v[k] / len;
+        }
+        float tmin = 1e9f, tmax = -1e9f;
+        for (int i = 0; i < 16; ++i) {
+            if (!used[i]) continue;
+            const float t = (px[i][0] - mean[0])*axis[0] + (px[i][1] - mean[1])*axis[1] + (px[i][2] - mean[2])*axis[2];
+            tmin = std::min(tmin, t);
+            tmax = std::max(tmax, t);
+        }
+        float e0[3], e1[3];
+        for (int k = 0; k < 3; ++k) {
+            e0[k] = mean[k] + axis[k]*tmax;
+            e1[k] = mean[k] + axis[k]*tmin;
+        }
+        c0 = pack565(e0);
+        c1 = pack565(e1);
+    }
+    // the order of the endpoints selects the mode
+    if ((transparent && c0 > c1) || (!transparent && c0 < c1)) std::swap(c0, c1);
+
+    uint8_t pal[4][4];
+    color_palette(c0, c1, bc1, pal);
+    const bool threeColor = bc1 && c0 <= c1;
+    uint32_t idx = 0;
+    for (int i = 0; i < 16; ++i) {
+        uint32_t best = 3;
+        if (used[i]) {
+            int bestErr = 1 << 30;
+            for (uint32_t j = 0; j < (threeColor ? 3u : 4u); ++j) {
+                int err = 0;
+                for (int k = 0; k < 3; ++k) { const int d = int(px[i][k]) - pal[j][k]; err += d*d; }
+                if (err < bestErr) { bestErr = err; best = j; }
+            }
+        }
+        idx |= best << (2*i);
+    }
+    out[0] = uint8_t(c0); out[1] = uint8_t(c0 >> 8);
+    out[2] = uint8_t(c1); out[3] = uint8_t(c1 >> 8);
+    for (int i = 0; i < 4; ++i) out[4+i] = uint8_t(idx >> (8*i));
+}
+
+static void encode_alpha(const uint8_t px[16][4], uint8_t* out) {
+    uint8_t amin = 255, amax = 0;
+    for (int i = 0; i < 16; ++i) {
+        amin = std::min(amin, px[i][3]);
+        amax = std::max(amax, px[i][3]);
+    }
+    uint8_t pal[8];
+    alpha_palette(amax, amin, pal);
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i) {
+        uint64_t best = 0;
+        int bestErr = 1 << 30;
+        for (uint64_t j = 0; j < 8; ++j) {
+            const int err = std::abs(int(px[i][3]) - pal[j]);
+            if (err < bestErr) { bestErr = err; best = j; }
+        }
+        bits |= best << (3*i);
+    }
+    out[0] = amax; out[1] = amin;
+    for (int i = 0; i < 6; ++i) out[2+i] = uint8_t(bits >> (8*i));
+}
+
+void EncodeBlocks(BlockFormat fmt, const uint8_t* rgba, uint32_t w, uint32_t h, std::vector<uint8_t>& out) {
+    out.resize(BlockCompressedSize(fmt, w, h));
+    uint8_t* dst = out.data();
+    uint8_t px[16][4];
+    for (uint32_t by = 0; by < h; by += 4) {
+        for (uint32_t bx = 0; bx < w; bx += 4) {
+            // edge blocks repeat the last row/column
+            for (uint32_t y = 0; y < 4; ++y)
+                for (uint32_t x = 0; x < 4; ++x)
+                    std::memcpy(px[y*4 + x], rgba + (size_t(std::min(by + y, h - 1))*w + std::min(bx + x, w - 1))*4, 4);
+            if (fmt == BlockFormat::BC1) {
+                encode_color(px, true, dst);
+                dst += 8;
+            } else {
+                encode_alpha(px, dst);
+                encode_color(px, false, dst + 8);
+                dst += 16;
+            }
+        }
+    }
+}
+
+// ----------- DDS container -----------------
+static constexpr uint32_t kDDSMagic = 0x20534444;   // "DDS "
+static constexpr uint32_t kFourCC_DXT1 = 0x31545844;
+static constexpr uint32_t kFourCC_DXT5 = 0x35545844;
+static constexpr uint32_t kFourCC_DX10 = 0x30315844;
+static constexpr uint32_t kDDPF_FourCC = 0x4;
+
+static inline uint32_t rd32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24); }
+static inline void wr32(uint8_t* p, uint32_t v) { p[0] = uint8_t(v); p[1] = uint8_t(v >> 8); p[2] = uint8_t(v >> 16); p[3] = uint8_t(v >> 24); }
+
+bool ReadDDS(const fs::path& path, BlockFormat& fmt, uint32_t& w, uint32_t& h, std::vector<uint8_t>& data) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    uint8_t hdr[128];
+    if (!f.read(reinterpret_cast<char*>(hdr), sizeof(hdr))) return false;
+    if (rd32(hdr) != kDDSMagic || rd32(hdr + 4) != 124) return false;
+    h = rd32(hdr + 12);
+    w = rd32(hdr + 16);
+    if (!w || !h || w > 16384 || h > 16384) return false;
+    if (!(rd32(hdr + 80) & kDDPF_FourCC)) return false;
+
+    const uint32_t fourCC = rd32(hdr + 84);
+    if (fourCC == kFourCC_DXT1) {
+        fmt = BlockFormat::BC1;
+    } else if (fourCC == kFourCC_DXT5) {
+        fmt = BlockFormat::BC3;
+    } else if (fourCC == kFourCC_DX10) {
+        uint8_t ext[20];
+        if (!f.read(reinterpret_cast<char*>(ext), sizeof(ext))) return false;
+        switch (rd32(ext)) {
+            case 71: case 72: fmt = BlockFormat::BC1; break; // DXGI_FORMAT_BC1_UNORM(_SRGB)
+            case 77: case 78: fmt = BlockFormat::BC3; break; // DXGI_FORMAT_BC3_UNORM(_SRGB)
+            default: return false;
+        }
+    } else {
+        return false;
+    }
+
+    data.resize(BlockCompressedSize(fmt, w, h));
+    return bool(f.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size())));
+}
+
+bool WriteDDS(const fs::path& path, BlockFormat fmt, uint32_t w, uint32_t h, const uint8_t* data) {
+    uint8_t hdr[128] = {};
+    const size_t size = BlockCompressedSize(fmt, w, h);
+    wr32(hdr, kDDSMagic);
+    wr32(hdr + 4, 124);
+    wr32(hdr + 8, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000); // caps, height, width, pixelformat, linearsize
+    wr32(hdr + 12, h);
+    wr32(hdr + 16, w);
+    wr32(hdr + 20, uint32_t(size));
+    wr32(hdr + 28, 1);
+    wr32(hdr + 76, 32);
+    wr32(hdr + 80, kDDPF_FourCC);
+    wr32(hdr + 84, fmt == BlockFormat::BC1 ? kFourCC_DXT1 : kFourCC_DXT5);
+    wr32(hdr + 108, 0x1000); // DDSCAPS_TEXTURE
+
+    FILE* f = std::fopen(path.string().c_str(), "wb");
+    if (!f) return false;
+    const bool ok = std::fwrite(hdr, 1, sizeof(hdr), f) == sizeof(hdr)
+                 && std::fwrite(data, 1, size, f) == size;
+    std::fclose(f);
+    return ok;
+}
+
+} // namespace melonDS::hires
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+// Part of melonDS – block-compressed (BC1/BC3) replacement textures in DDS files.
+
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace melonDS::hires {
+
+enum class BlockFormat : uint8_t {
+    BC1 = 0, // DXT1: RGB + 1-bit alpha, 8 bytes per 4x4 block
+    BC3 = 1, // DXT5: RGBA, 16 bytes per 4x4 block
+};
+
+// Size in bytes of a w*h image in the given format.
+size_t BlockCompressedSize(BlockFormat fmt, uint32_t w, uint32_t h);
+
+// Decode blocks to RGBA8 (w*h*4 bytes).
+void DecodeBlocks(BlockFormat fmt, const uint8_t* src, uint32_t w, uint32_t h, uint8_t* rgbaOut);
+
+// Encode RGBA8 to blocks. Endpoints are fit along the principal axis of each block, which
+// is good enough for offline pack building; out is resized to BlockCompressedSize().
+void EncodeBlocks(BlockFormat fmt, const uint8_t* rgba, uint32_t w, uint32_t h, std::vector<uint8_t>& out);
+
+// DDS container, first mip level only. Accepts DXT1/DXT5 FourCCs and the
+// equivalent DX10 header formats.
+bool ReadDDS(const std::filesystem::path& path, BlockFormat& fmt, uint32_t& w, uint32_t& h, std::vector<uint8_t>& data);
+bool WriteDDS(const std::filesystem::path& path, BlockFormat fmt, uint32_t w, uint32_t h, const uint8_t* data);
+
+} // namespace melonDS::hires
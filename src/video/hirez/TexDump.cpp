@@ -8,9 +8,13 @@
 #include <optional>
 #include <sstream>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <deque>
+#include <condition_variable>
+#include <thread>
 
 #if TEXDUMP_WITH_STB
   // Provide your local path to stb if needed; these are single-header public domain libraries.
@@ -51,35 +55,66 @@ static inline const char* fmt_name(DsiTexFmt f) {
         default: return "unk";
     }
 }
-// Minimal TGA writer/reader (uncompressed BGRA32), trivial and fast.
-static bool write_tga(const fs::path& p, const uint8_t* rgba, uint32_t w, uint32_t h) {
-    std::vector<uint8_t> buf;
-    buf.reserve(18 + size_t(w)*h*4);
+// Minimal TGA writer/reader (BGRA32, uncompressed or RLE), trivial and fast.
+static void encode_tga(const uint8_t* rgba, uint32_t w, uint32_t h, bool rle, std::vector<uint8_t>& buf) {
+    const size_t N = size_t(w)*h;
+    buf.clear();
+    buf.reserve(18 + N*4);
     uint8_t hdr[18] = {};
-    hdr[2] = 2; // uncompressed true-color
+    hdr[2] = rle ? 10 : 2; // (RLE) true-color
     hdr[12] = uint8_t(w & 0xFF);
     hdr[13] = uint8_t((w >> 8) & 0xFF);
     hdr[14] = uint8_t(h & 0xFF);
     hdr[15] = uint8_t((h >> 8) & 0xFF);
     hdr[16] = 32; // bpp
     hdr[17] = 8;  // alpha bits
-    buf.insert(buf.end(), hdr, hdr + 18);
     // TGA expects BGRA, bottom-to-top by default; set origin to top-left by flipping bit 5
-    buf[17] |= 0x20;
-    // Convert RGBA->BGRA, keep row order (top-down)
-    const size_t N = size_t(w)*h;
-    buf.resize(18 + N*4);
-    uint8_t* out = buf.data() + 18;
-    for (size_t i = 0; i < N; ++i) {
-        out[i*4+0] = rgba[i*4+2];
-        out[i*4+1] = rgba[i*4+1];
-        out[i*4+2] = rgba[i*4+0];
-        out[i*4+3] = rgba[i*4+3];
-    }
-    std::error_code ec; fs::create_directories(p.parent_path(), ec);
+    hdr[17] |= 0x20;
+    buf.insert(buf.end(), hdr, hdr + 18);
+    auto pixel = [&](size_t i) {
+        uint32_t px;
+        std::memcpy(&px, rgba + i*4, 4);
+        return px;
+    };
+    auto putPixel = [&](size_t i) {
+        const uint8_t* p = rgba + i*4;
+        const uint8_t bgra[4] = { p[2], p[1], p[0], p[3] };
+        buf.insert(buf.end(), bgra, bgra + 4);
+    };
+    if (!rle) {
+        for (size_t i = 0; i < N; ++i) putPixel(i);
+        return;
+    }
+    // packets never cross scanlines, some readers don't support that
+    for (uint32_t y = 0; y < h; ++y) {
+        const size_t row = size_t(y)*w;
+        uint32_t x = 0;
+        while (x < w) {
+            uint32_t run = 1;
+            while (x + run < w && run < 128 && pixel(row + x + run) == pixel(row + x)) ++run;
+            if (run >= 2) {
+                buf.push_back(uint8_t(0x80 | (run - 1)));
+                putPixel(row + x);
+                x += run;
+                continue;
+            }
+            // raw packet up to the next run of identical pixels
+            uint32_t n = 1;
+            while (x + n < w && n < 128 && !(x + n + 1 < w && pixel(row + x + n) == pixel(row + x + n + 1))) ++n;
+            buf.push_back(uint8_t(n - 1));
+            for (uint32_t i = 0; i < n; ++i) putPixel(row + x + i);
+            x += n;
+        }
+    }
+}
+static bool write_file(const fs::path& p, const uint8_t* data, size_t len) {
     FILE* f = std::fopen(p.string().c_str(), "wb");
-    if (!f) return false;
-    const bool ok = std::fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    if (!f) {
+        std::error_code ec; fs::create_directories(p.parent_path(), ec);
+        f = std::fopen(p.string().c_str(), "wb");
+        if (!f) return false;
+    }
+    const bool ok = std::fwrite(data, 1, len, f) == len;
     std::fclose(f);
     return ok;
 }
@@ -188,67 +223,268 @@ struct DumpJob {
     fs::path paletteIndexPath;
     std::vector<uint8_t> paletteIndices;
 };
-static std::mutex Qmtx;
-static std::condition_variable Qcv;
-static std::deque<DumpJob> Q;
-static std::thread Qthread;
-
-static std::mutex SeenMtx;
-static std::unordered_set<std::string> Seen; // filenames we already dumped this session (kept ≤ budget)
-static std::mutex SeenPaletteMtx;
-static std::unordered_set<std::string> SeenPalette;
-static std::mutex SeenPaletteIndexMtx;
-static std::unordered_set<std::string> SeenPaletteIndex;
-
-struct CacheEntry { std::vector<uint8_t> rgba; uint32_t w=0, h=0; size_t size() const { return rgba.size(); } };
+
+// Bounded multi-producer/multi-consumer queue (Vyukov's), dumps can come from
+// the emu and GL threads at once. A full queue drops the job.
+class JobQueue {
+public:
+    void reset(size_t capacity) {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        cells = std::make_unique<Cell[]>(cap);
+        for (size_t i = 0; i < cap; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+        mask = cap - 1;
+        enqueuePos.store(0, std::memory_order_relaxed);
+        dequeuePos.store(0, std::memory_order_relaxed);
+    }
+    bool push(std::unique_ptr<DumpJob>& job) {
+        if (!cells) return false;
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t dif = intptr_t(seq) - intptr_t(pos);
+            if (dif == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->job = job.release();
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    std::unique_ptr<DumpJob> pop() {
+        if (!cells) return nullptr;
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->seq.load(std::memory_order_acquire);
+            const intptr_t dif = intptr_t(seq) - intptr_t(pos + 1);
+            if (dif == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (dif < 0) {
+                return nullptr;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        std::unique_ptr<DumpJob> job(cell->job);
+        cell->seq.store(pos + mask + 1, std::memory_order_release);
+        return job;
+    }
+    void clear() { while (pop()) {} }
+private:
+    struct Cell {
+        std::atomic<size_t> seq{0};
+        DumpJob* job = nullptr;
+    };
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+};
+static JobQueue Q;
+// jobs pushed but not popped yet, and workers sleeping, for waking them up only when needed
+static std::atomic<size_t> QPending{0};
+static std::atomic<int> IdleWorkers{0};
+static std::mutex IdleMtx;
+static std::condition_variable IdleCv;
+static std::vector<std::thread> Workers;
+
+// Sets of 64-bit ids of what was already queued for dumping this session (kept ≤ budget).
+struct DedupSet {
+    std::mutex mtx;
+    std::unordered_set<uint64_t> ids;
+
+    // returns true if the id wasn't in the set yet
+    bool insert(uint64_t id) {
+        std::lock_guard<std::mutex> lk(mtx);
+        if (ids.count(id)) return false;
+        if (ids.size() >= G.inMemoryDedupBudget) {
+            size_t n = G.inMemoryDedupBudget / 2;
+            auto it = ids.begin();
+            for (size_t i = 0; i < n && it != ids.end(); ++i)
+                it = ids.erase(it);
+        }
+        ids.insert(id);
+        return true;
+    }
+    void clear() {
+        std::lock_guard<std::mutex> lk(mtx);
+        ids.clear();
+    }
+};
+static DedupSet Seen;
+static DedupSet SeenPalette;
+static DedupSet SeenPaletteIndex;
+static uint64_t GGameIdHash = 0;
+
+// Archive output: the magic "MDSTXPK1", then for each file a little-endian u32 name length,
+// u32 data length, the file name and its contents. Workers batch their files and append
+// them in one go, the names already in the archive are skipped like existing files.
+static constexpr char kArchiveMagic[8] = { 'M','D','S','T','X','P','K','1' };
+static constexpr size_t kArchiveBatchBytes = 4u << 20;
+static std::mutex ArchiveMtx;
+static FILE* Archive = nullptr;
+static std::unordered_set<uint64_t> ArchiveNames;
+
+struct CacheEntry {
+    ReplacementImage img;
+    bool prefetched = false; // loaded ahead of time and not used yet
+    size_t size() const { return img.data.size(); }
+};
 static std::mutex CacheMtx;
 static std::unordered_map<std::string, CacheEntry> Cache;
 static size_t CacheBytes = 0;
 
-// -------------- worker --------------
-static void worker() {
-    while (GRunning.load(std::memory_order_acquire)) {
-        DumpJob job;
+static fs::path GameDumpDir();
+static fs::path GameLoadDir();
+static void start_prefetch();
+static void stop_prefetch();
+
+static uint64_t name_id(const std::string& name) { return fnv1a64(name.data(), name.size()); }
+
+static void open_archive() {
+    const fs::path path = GameDumpDir().string() + ".texpack";
+    std::error_code ec; fs::create_directories(path.parent_path(), ec);
+
+    ArchiveNames.clear();
+    if (FILE* f = std::fopen(path.string().c_str(), "rb")) {
+        char magic[8];
+        if (std::fread(magic, 1, 8, f) == 8 && !std::memcmp(magic, kArchiveMagic, 8)) {
+            uint8_t hdr[8];
+            std::string name;
+            while (std::fread(hdr, 1, 8, f) == 8) {
+                const uint32_t nameLen = hdr[0] | (hdr[1] << 8) | (hdr[2] << 16) | (uint32_t(hdr[3]) << 24);
+                const uint32_t dataLen = hdr[4] | (hdr[5] << 8) | (hdr[6] << 16) | (uint32_t(hdr[7]) << 24);
+                name.resize(nameLen);
+                if (std::fread(name.data(), 1, nameLen, f) != nameLen) break;
+                if (std::fseek(f, long(dataLen), SEEK_CUR) != 0) break;
+                ArchiveNames.insert(name_id(name));
+            }
+        }
+        std::fclose(f);
+    }
+
+    Archive = std::fopen(path.string().c_str(), "ab");
+    if (!Archive) {
+        std::fprintf(stderr, "[tex] failed to open dump archive %s\n", path.string().c_str());
+        return;
+    }
+    std::fseek(Archive, 0, SEEK_END);
+    if (std::ftell(Archive) == 0)
+        std::fwrite(kArchiveMagic, 1, 8, Archive);
+}
+
+static void close_archive() {
+    std::lock_guard<std::mutex> lk(ArchiveMtx);
+    if (Archive) std::fclose(Archive);
+    Archive = nullptr;
+    ArchiveNames.clear();
+}
+
+struct ArchiveBatch {
+    std::vector<uint8_t> bytes;
+    std::vector<uint64_t> names;
+
+    void add(const std::string& name, const uint8_t* data, size_t len) {
+        auto put32 = [&](uint32_t v) {
+            const uint8_t b[4] = { uint8_t(v), uint8_t(v >> 8), uint8_t(v >> 16), uint8_t(v >> 24) };
+            bytes.insert(bytes.end(), b, b + 4);
+        };
+        put32(uint32_t(name.size()));
+        put32(uint32_t(len));
+        bytes.insert(bytes.end(), name.begin(), name.end());
+        bytes.insert(bytes.end(), data, data + len);
+        names.push_back(name_id(name));
+    }
+    void flush() {
+        if (bytes.empty()) return;
+        {
+            std::lock_guard<std::mutex> lk(ArchiveMtx);
+            if (Archive) {
+                std::fwrite(bytes.data(), 1, bytes.size(), Archive);
+                std::fflush(Archive);
+            }
+        }
+        bytes.clear();
+        names.clear();
+    }
+};
+
+// Writes one output file of a job, unless it was dumped already.
+// The contents are only encoded if they're actually written.
+template <typename Encode>
+static void emit_file(const fs::path& path, ArchiveBatch& batch, Encode&& encode) {
+    std::vector<uint8_t> data;
+    if (G.packArchive) {
+        const std::string name = path.filename().string();
         {
-            std::unique_lock<std::mutex> lk(Qmtx);
-            Qcv.wait(lk, []{ return !GRunning.load(std::memory_order_acquire) || !Q.empty(); });
-            if (!GRunning.load(std::memory_order_acquire) && Q.empty()) break;
-            job = std::move(Q.front());
-            Q.pop_front();
+            std::lock_guard<std::mutex> lk(ArchiveMtx);
+            if (!ArchiveNames.insert(name_id(name)).second) return;
         }
-        std::error_code ec;
-        const bool alreadyExists = fs::exists(job.path, ec);
+        encode(data);
+        batch.add(name, data.data(), data.size());
+        return;
+    }
+    std::error_code ec;
+    if (fs::exists(path, ec)) return;
+    encode(data);
+    write_file(path, data.data(), data.size());
+}
+
+static void process_job(DumpJob& job, ArchiveBatch& batch) {
+    if (job.writeBase) {
+        emit_file(job.path, batch, [&](std::vector<uint8_t>& out) {
 #if TEXDUMP_WITH_STB
-        if (job.writeBase && !alreadyExists) {
             if (job.png) {
-                fs::create_directories(job.path.parent_path(), ec);
-                stbi_write_png(job.path.string().c_str(), job.w, job.h, 4, job.rgba.data(), int(job.w*4));
-            } else {
-                write_tga(job.path, job.rgba.data(), job.w, job.h);
+                stbi_write_png_to_func([](void* ctx, void* data, int size) {
+                    auto* v = static_cast<std::vector<uint8_t>*>(ctx);
+                    v->insert(v->end(), static_cast<uint8_t*>(data), static_cast<uint8_t*>(data) + size);
+                }, &out, job.w, job.h, 4, job.rgba.data(), int(job.w*4));
+                return;
             }
-        }
-#else
-        if (job.writeBase && !alreadyExists) {
-            write_tga(job.path, job.rgba.data(), job.w, job.h);
-        }
 #endif
-        if (job.hasPalette) {
-            if (!fs::exists(job.paletteInfoPath, ec)) {
-                fs::create_directories(job.paletteInfoPath.parent_path(), ec);
-                std::ofstream pal(job.paletteInfoPath);
-                if (pal)
-                    pal << job.paletteInfo;
-            }
-        }
-        if (job.hasPaletteIndexMap) {
-            if (!fs::exists(job.paletteIndexPath, ec)) {
-                fs::create_directories(job.paletteIndexPath.parent_path(), ec);
-                std::ofstream idx(job.paletteIndexPath, std::ios::binary);
-                if (idx)
-                    idx.write(reinterpret_cast<const char*>(job.paletteIndices.data()), std::streamsize(job.paletteIndices.size()));
-            }
+            encode_tga(job.rgba.data(), job.w, job.h, G.tgaRLE, out);
+        });
+    }
+    if (job.hasPalette) {
+        emit_file(job.paletteInfoPath, batch, [&](std::vector<uint8_t>& out) {
+            out.assign(job.paletteInfo.begin(), job.paletteInfo.end());
+        });
+    }
+    if (job.hasPaletteIndexMap) {
+        emit_file(job.paletteIndexPath, batch, [&](std::vector<uint8_t>& out) {
+            out = std::move(job.paletteIndices);
+        });
+    }
+}
+
+// -------------- workers --------------
+static void worker() {
+    ArchiveBatch batch;
+    while (GRunning.load(std::memory_order_acquire)) {
+        std::unique_ptr<DumpJob> job = Q.pop();
+        if (!job) {
+            // out of work: write out the batch and sleep until more is queued
+            batch.flush();
+            std::unique_lock<std::mutex> lk(IdleMtx);
+            IdleWorkers.fetch_add(1);
+            IdleCv.wait(lk, []{ return !GRunning.load(std::memory_order_acquire) || QPending.load() > 0; });
+            IdleWorkers.fetch_sub(1);
+            continue;
         }
+        QPending.fetch_sub(1);
+        process_job(*job, batch);
+        if (batch.bytes.size() >= kArchiveBatchBytes)
+            batch.flush();
     }
+    batch.flush();
 }
 
 // -------------- API --------------
@@ -256,42 +492,49 @@ void Init(const TexDumpConfig& cfg, const std::string& gameId) {
     Shutdown();
     G = cfg;
     SetGameId(gameId);
-    Seen.clear(); Seen.reserve(G.inMemoryDedupBudget);
+    Seen.clear();
     SeenPalette.clear();
     SeenPaletteIndex.clear();
     Cache.clear(); CacheBytes = 0;
+    if (G.enableReplace && G.prefetch) start_prefetch();
     if (G.enableDump) {
+        Q.reset(std::max<size_t>(G.ioQueueCap, 2));
+        QPending.store(0);
+        if (G.packArchive) open_archive();
+
+        unsigned threads = G.dumpThreads;
+        if (threads == 0)
+            threads = std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
         GRunning.store(true, std::memory_order_release);
-        Qthread = std::thread(worker);
+        for (unsigned i = 0; i < threads; ++i)
+            Workers.emplace_back(worker);
     }
 }
 void Shutdown() {
     if (GRunning.exchange(false, std::memory_order_acq_rel)) {
-        Qcv.notify_all();
-        if (Qthread.joinable()) Qthread.join();
-    }
-    {
-        std::lock_guard<std::mutex> lk(Qmtx);
-        Q.clear();
+        {
+            std::lock_guard<std::mutex> lk(IdleMtx);
+        }
+        IdleCv.notify_all();
+        for (auto& t : Workers) t.join();
+        Workers.clear();
     }
+    Q.clear();
+    QPending.store(0);
+    close_archive();
+    stop_prefetch();
     {
         std::lock_guard<std::mutex> lk(CacheMtx);
         Cache.clear(); CacheBytes = 0;
     }
-    {
-        std::lock_guard<std::mutex> lk(SeenMtx);
-        Seen.clear();
-    }
-    {
-        std::lock_guard<std::mutex> lk(SeenPaletteMtx);
-        SeenPalette.clear();
-    }
-    {
-        std::lock_guard<std::mutex> lk(SeenPaletteIndexMtx);
-        SeenPaletteIndex.clear();
-    }
+    Seen.clear();
+    SeenPalette.clear();
+    SeenPaletteIndex.clear();
+}
+void SetGameId(const std::string& gameId) {
+    GGameId = gameId;
+    GGameIdHash = fnv1a64(gameId.data(), gameId.size());
 }
-void SetGameId(const std::string& gameId) { GGameId = gameId; }
 
 TextureKey MakeKey(const uint8_t* rgba, uint32_t w, uint32_t h, bool hasMips,
                    bool pal0Transparent, DsiTexFmt fmt,
@@ -391,30 +634,30 @@ void DumpIfEnabled(const TextureKey& key, const uint8_t* rgba, uint32_t w, uint3
                    std::optional<uint64_t> paletteHash, const uint32_t* paletteRGBA,
                    uint32_t paletteCount, PaletteIndexGenerator paletteIndexGenerator) {
     if (!G.enableDump) return;
+    // Dedup by key before building any path. Whether the files already exist
+    // is checked by the workers, to keep filesystem access off the calling thread.
+    uint64_t id = fnv1a64(&key.hash64, sizeof(key.hash64), GGameIdHash);
+    id = fnv1a64(&key.width, sizeof(key.width), id);
+    id = fnv1a64(&key.height, sizeof(key.height), id);
+    id = fnv1a64(&key.flags, sizeof(key.flags), id);
+    id = fnv1a64(&key.fmt, sizeof(key.fmt), id);
+    const bool writeBase = Seen.insert(id);
+
+    bool enqueuePalette = false;
+    bool enqueuePaletteIndex = false;
+    if (paletteHash && paletteRGBA && paletteCount) {
+        const uint64_t palId = fnv1a64(&*paletteHash, sizeof(uint64_t), id);
+        enqueuePalette = SeenPalette.insert(palId);
+        if (paletteIndexGenerator)
+            enqueuePaletteIndex = SeenPaletteIndex.insert(palId);
+    }
+
+    if (!writeBase && !enqueuePalette && !enqueuePaletteIndex)
+        return;
+
     // Build filename
     const bool png = G.writePNG;
     fs::path dst = GameDumpDir() / KeyToFilename(key, png);
-    bool writeBase = false;
-    std::vector<uint8_t> copy;
-    {
-        std::lock_guard<std::mutex> lk(SeenMtx);
-        auto str = dst.string();
-        if (Seen.find(str) == Seen.end()) {
-            std::error_code ec;
-            if (!fs::exists(dst, ec)) {
-                if (Seen.size() >= G.inMemoryDedupBudget) {
-                    size_t n = G.inMemoryDedupBudget / 2;
-                    auto it = Seen.begin();
-                    for (size_t i = 0; i < n && it != Seen.end(); ++i)
-                        it = Seen.erase(it);
-                }
-                Seen.insert(str);
-                writeBase = true;
-            } else {
-                Seen.insert(str);
-            }
-        }
-    }
 
     fs::path paletteInfoPath;
     std::string paletteInfo;
@@ -422,46 +665,18 @@ void DumpIfEnabled(const TextureKey& key, const uint8_t* rgba, uint32_t w, uint3
     bool hasPaletteIndexMap = false;
     fs::path paletteIndexPath;
     std::vector<uint8_t> paletteIndexData;
-    if (paletteHash && paletteRGBA && paletteCount) {
+    if (enqueuePalette || enqueuePaletteIndex) {
         std::string palHex = to_hex(*paletteHash);
         fs::path palImagePath = add_palette_suffix(dst, palHex);
         paletteInfoPath = palImagePath;
         paletteInfoPath.replace_extension(".pal.json");
         fs::path palIndexPath = palImagePath;
         palIndexPath.replace_extension(".pal.idx");
-        bool enqueuePalette = false;
-        bool enqueuePaletteIndex = false;
         std::string paletteIndexRelPath;
         std::string paletteIndexFormatStr;
         std::string paletteIndexEncodingStr;
-        {
-            std::lock_guard<std::mutex> lk(SeenPaletteMtx);
-            std::string palStr = paletteInfoPath.string();
-            if (SeenPalette.find(palStr) == SeenPalette.end()) {
-                std::error_code ec;
-                if (!fs::exists(paletteInfoPath, ec)) {
-                    SeenPalette.insert(palStr);
-                    enqueuePalette = true;
-                } else {
-                    SeenPalette.insert(palStr);
-                }
-            }
-        }
         if (paletteIndexGenerator) {
-            std::lock_guard<std::mutex> lk(SeenPaletteIndexMtx);
-            std::string idxStr = palIndexPath.string();
-            if (SeenPaletteIndex.find(idxStr) == SeenPaletteIndex.end()) {
-                std::error_code ec;
-                if (!fs::exists(palIndexPath, ec)) {
-                    SeenPaletteIndex.insert(idxStr);
-                    enqueuePaletteIndex = true;
-                } else {
-                    SeenPaletteIndex.insert(idxStr);
-                }
-            }
             paletteIndexRelPath = palIndexPath.filename().string();
-        }
-        if ((enqueuePalette || enqueuePaletteIndex) && paletteIndexGenerator) {
             std::vector<uint8_t> generated;
             if (paletteIndexGenerator(generated, paletteIndexFormatStr, paletteIndexEncodingStr) && !generated.empty()) {
                 paletteIndexData = std::move(generated);
@@ -472,8 +687,6 @@ void DumpIfEnabled(const TextureKey& key, const uint8_t* rgba, uint32_t w, uint3
                 paletteIndexEncodingStr.clear();
                 paletteIndexData.clear();
             }
-        } else if (!enqueuePaletteIndex) {
-            paletteIndexRelPath.clear();
         }
         if (enqueuePalette) {
             paletteInfo = build_palette_info(palHex, palImagePath.filename().string(), paletteRGBA, paletteCount,
@@ -489,39 +702,253 @@ void DumpIfEnabled(const TextureKey& key, const uint8_t* rgba, uint32_t w, uint3
     if (!writeBase && !hasPalette && !hasPaletteIndexMap)
         return;
 
-    if (writeBase) {
-        copy.assign(rgba, rgba + size_t(w) * h * 4);
+    auto job = std::make_unique<DumpJob>();
+    job->path = std::move(dst);
+    if (writeBase)
+        job->rgba.assign(rgba, rgba + size_t(w) * h * 4);
+    job->w = w;
+    job->h = h;
+    job->png = png;
+    job->writeBase = writeBase;
+    job->hasPalette = hasPalette;
+    job->paletteInfoPath = std::move(paletteInfoPath);
+    job->paletteInfo = std::move(paletteInfo);
+    job->hasPaletteIndexMap = hasPaletteIndexMap;
+    job->paletteIndexPath = std::move(paletteIndexPath);
+    job->paletteIndices = std::move(paletteIndexData);
+
+    if (!Q.push(job)) return;
+    QPending.fetch_add(1);
+    if (IdleWorkers.load() > 0) {
+        std::lock_guard<std::mutex> lk(IdleMtx);
+        IdleCv.notify_one();
+    }
+}
+
+bool ReadImage(const fs::path& p, std::vector<uint8_t>& rgbaOut, uint32_t& outW, uint32_t& outH) {
+#if TEXDUMP_WITH_STB
+    if (p.extension() == ".png") {
+        int W,H,Comp;
+        unsigned char* data = stbi_load(p.string().c_str(), &W, &H, &Comp, 4);
+        if (!data) return false;
+        rgbaOut.assign(data, data + size_t(W)*H*4);
+        stbi_image_free(data);
+        outW = uint32_t(W); outH = uint32_t(H);
+        return true;
+    }
+#endif
+    return read_tga(p, rgbaOut, outW, outH);
+}
+
+static bool load_image(const fs::path& p, ReplacementImage& img) {
+    const std::string k = p.string();
+    std::error_code ec;
+    if (!fs::exists(p, ec)) {
+        if (GVerbose) std::fprintf(stderr, "[tex] not found: %s\n", k.c_str());
+        return false;
+    }
+    if (p.extension() == ".dds") {
+        // block-compressed packs stay compressed in the cache
+        img.compressed = true;
+        if (!ReadDDS(p, img.format, img.width, img.height, img.data)) {
+            if (GVerbose) std::fprintf(stderr, "[tex] dds load failed: %s\n", k.c_str());
+            return false;
+        }
+    } else if (!ReadImage(p, img.data, img.width, img.height)) {
+        if (GVerbose) std::fprintf(stderr, "[tex] image load failed: %s\n", k.c_str());
+        return false;
+    }
+    if (GVerbose) std::fprintf(stderr, "[tex] loaded: %s (%ux%u)\n", k.c_str(), img.width, img.height);
+    return true;
+}
+
+// Insert to cache with LRU-bytes cap. Prefetched images never evict anything.
+static bool cache_insert(const std::string& k, ReplacementImage img, bool prefetched) {
+    std::lock_guard<std::mutex> lk(CacheMtx);
+    const size_t add = img.data.size();
+    if (prefetched && (Cache.count(k) || CacheBytes + add > G.replacementCacheBudgetBytes))
+        return false;
+    while (CacheBytes + add > G.replacementCacheBudgetBytes && !Cache.empty()) {
+        // Arbitrary eviction (not precise LRU to keep it tiny)
+        auto it = Cache.begin();
+        CacheBytes -= it->second.size();
+        Cache.erase(it);
+    }
+    auto it = Cache.find(k);
+    if (it != Cache.end()) CacheBytes -= it->second.size();
+    Cache[k] = CacheEntry{ std::move(img), prefetched };
+    CacheBytes += add;
+    return true;
+}
+
+// -------------- prefetch --------------
+// The replacements used in a session are recorded in the order they're first used, and the
+// last sessions are kept next to the pack in prefetch.log (one file name per line, sessions
+// separated by empty lines). When a replacement is first used, the ones that followed it in
+// past sessions are loaded into the cache in the background, so they're ready by the time
+// the game samples them instead of showing the native texture for a few frames.
+static constexpr size_t kPrefetchSessions = 16;
+static std::mutex HistoryMtx;
+static std::vector<std::vector<std::string>> PastSessions;
+static std::vector<std::string> CurSession;
+static std::unordered_set<std::string> CurSessionSeen;
+static std::unordered_map<std::string, std::vector<std::string>> Successors;
+
+static std::mutex PrefetchMtx;
+static std::condition_variable PrefetchCv;
+static std::deque<std::string> PrefetchQueue;
+static std::unordered_set<std::string> PrefetchQueued;
+static std::thread PrefetchThread;
+static bool PrefetchRunning = false;
+
+static std::atomic<uint64_t> StatDemandLoads{0};
+static std::atomic<uint64_t> StatPrefetched{0};
+static std::atomic<uint64_t> StatPrefetchHits{0};
+
+static fs::path history_path() { return GameLoadDir() / "prefetch.log"; }
+
+static void load_history() {
+    PastSessions.clear();
+    Successors.clear();
+    std::ifstream f(history_path());
+    std::string line;
+    std::vector<std::string> session;
+    while (std::getline(f, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty()) {
+            if (!session.empty()) PastSessions.push_back(std::move(session));
+            session.clear();
+        } else {
+            session.push_back(line);
+        }
+    }
+    if (!session.empty()) PastSessions.push_back(std::move(session));
+    if (PastSessions.size() > kPrefetchSessions)
+        PastSessions.erase(PastSessions.begin(), PastSessions.end() - kPrefetchSessions);
+
+    // successors of a file: the ones first used right after it, most recent sessions first
+    for (auto s = PastSessions.rbegin(); s != PastSessions.rend(); ++s) {
+        for (size_t i = 0; i < s->size(); ++i) {
+            auto& next = Successors[(*s)[i]];
+            for (size_t j = i + 1; j < s->size() && j <= i + G.prefetchDepth; ++j) {
+                if (next.size() >= G.prefetchDepth) break;
+                if (std::find(next.begin(), next.end(), (*s)[j]) == next.end())
+                    next.push_back((*s)[j]);
+            }
+        }
+    }
+}
+
+static void save_history() {
+    if (CurSession.empty()) return;
+    std::ofstream f(history_path(), std::ios::trunc);
+    if (!f) return;
+    const size_t keep = std::min(PastSessions.size(), kPrefetchSessions - 1);
+    for (size_t i = PastSessions.size() - keep; i < PastSessions.size(); ++i) {
+        for (const auto& name : PastSessions[i]) f << name << '\n';
+        f << '\n';
+    }
+    for (const auto& name : CurSession) f << name << '\n';
+}
+
+static void prefetch_worker() {
+    for (;;) {
+        std::string name;
+        {
+            std::unique_lock<std::mutex> lk(PrefetchMtx);
+            PrefetchCv.wait(lk, []{ return !PrefetchRunning || !PrefetchQueue.empty(); });
+            if (!PrefetchRunning) return;
+            name = std::move(PrefetchQueue.front());
+            PrefetchQueue.pop_front();
+        }
+        const fs::path p = GameLoadDir() / name;
+        const std::string k = p.string();
+        {
+            std::lock_guard<std::mutex> lk(CacheMtx);
+            if (Cache.count(k)) continue;
+        }
+        ReplacementImage img;
+        if (load_image(p, img) && cache_insert(k, std::move(img), true))
+            StatPrefetched.fetch_add(1, std::memory_order_relaxed);
     }
+}
 
-    DumpJob job;
-    job.path = std::move(dst);
-    job.rgba = std::move(copy);
-    job.w = w;
-    job.h = h;
-    job.png = png;
-    job.writeBase = writeBase;
-    job.hasPalette = hasPalette;
-    job.paletteInfoPath = std::move(paletteInfoPath);
-    job.paletteInfo = std::move(paletteInfo);
-    job.hasPaletteIndexMap = hasPaletteIndexMap;
-    job.paletteIndexPath = std::move(paletteIndexPath);
-    job.paletteIndices = std::move(paletteIndexData);
+static void start_prefetch() {
+    {
+        std::lock_guard<std::mutex> lk(HistoryMtx);
+        load_history();
+        CurSession.clear();
+        CurSessionSeen.clear();
+    }
+    StatDemandLoads.store(0);
+    StatPrefetched.store(0);
+    StatPrefetchHits.store(0);
+    PrefetchRunning = true;
+    PrefetchThread = std::thread(prefetch_worker);
+}
 
+static void stop_prefetch() {
+    if (!PrefetchThread.joinable()) return;
     {
-        std::lock_guard<std::mutex> lk(Qmtx);
-        if (Q.size() >= G.ioQueueCap) return;
-        Q.push_back(std::move(job));
+        std::lock_guard<std::mutex> lk(PrefetchMtx);
+        PrefetchRunning = false;
+        PrefetchQueue.clear();
+        PrefetchQueued.clear();
     }
-    Qcv.notify_one();
+    PrefetchCv.notify_all();
+    PrefetchThread.join();
+
+    std::lock_guard<std::mutex> lk(HistoryMtx);
+    save_history();
+    const ReplacementStats st = GetReplacementStats();
+    if (st.demandLoads || st.prefetched)
+        std::fprintf(stderr, "[tex] replacements: %llu loaded on demand, %llu prefetched, %llu prefetch hits (%.1f%% hit rate)\n",
+                     (unsigned long long)st.demandLoads, (unsigned long long)st.prefetched,
+                     (unsigned long long)st.prefetchHits, st.HitRate() * 100.0);
+    PastSessions.clear();
+    Successors.clear();
+    CurSession.clear();
+    CurSessionSeen.clear();
 }
 
-bool TryLoadReplacement(const TextureKey& key, std::vector<uint8_t>& rgbaOut, uint32_t& outW, uint32_t& outH,
-                        std::optional<uint64_t> paletteHash, std::string* usedFilename) {
+// Records the first use of a replacement in this session, and queues what usually follows it.
+static void note_used(const std::string& name) {
+    if (!PrefetchThread.joinable()) return;
+    std::vector<std::string> next;
+    {
+        std::lock_guard<std::mutex> lk(HistoryMtx);
+        if (!CurSessionSeen.insert(name).second) return;
+        CurSession.push_back(name);
+        auto it = Successors.find(name);
+        if (it == Successors.end()) return;
+        for (const auto& n : it->second)
+            if (!CurSessionSeen.count(n)) next.push_back(n);
+    }
+    if (next.empty()) return;
+    {
+        std::lock_guard<std::mutex> lk(PrefetchMtx);
+        for (auto& n : next)
+            if (PrefetchQueued.insert(n).second) PrefetchQueue.push_back(std::move(n));
+    }
+    PrefetchCv.notify_one();
+}
+
+ReplacementStats GetReplacementStats() {
+    ReplacementStats st;
+    st.demandLoads = StatDemandLoads.load(std::memory_order_relaxed);
+    st.prefetched = StatPrefetched.load(std::memory_order_relaxed);
+    st.prefetchHits = StatPrefetchHits.load(std::memory_order_relaxed);
+    return st;
+}
+
+bool TryLoadReplacementImage(const TextureKey& key, ReplacementImage& out,
+                             std::optional<uint64_t> paletteHash, std::string* usedFilename) {
     if (!G.enableReplace) return false;
     const bool png = G.writePNG;
     fs::path base = GameLoadDir();
     fs::path pPng = base / KeyToFilename(key, true);
     fs::path pTga = base / KeyToFilename(key, false);
+    fs::path pDds = fs::path(pTga).replace_extension(".dds");
 
     auto tryFile = [&](const fs::path& p)->bool {
         // Cache by absolute filename
@@ -530,73 +957,65 @@ bool TryLoadReplacement(const TextureKey& key, std::vector<uint8_t>& rgbaOut, ui
             std::lock_guard<std::mutex> lk(CacheMtx);
             auto it = Cache.find(k);
             if (it != Cache.end()) {
-                if (GVerbose) std::fprintf(stderr, "[tex] cache hit: %s (%ux%u)\n", k.c_str(), it->second.w, it->second.h);
-                rgbaOut = it->second.rgba; outW = it->second.w; outH = it->second.h;
+                if (GVerbose) std::fprintf(stderr, "[tex] cache hit: %s (%ux%u)\n", k.c_str(), it->second.img.width, it->second.img.height);
+                if (it->second.prefetched) {
+                    it->second.prefetched = false;
+                    StatPrefetchHits.fetch_add(1, std::memory_order_relaxed);
+                }
+                out = it->second.img;
                 return true;
             }
         }
         // load
-        std::error_code ec;
-        if (!fs::exists(p, ec)) {
-            if (GVerbose) std::fprintf(stderr, "[tex] not found: %s\n", k.c_str());
-            return false;
-        }
-
-        uint32_t w=0,h=0; std::vector<uint8_t> tmp;
-#if TEXDUMP_WITH_STB
-        if (p.extension() == ".png") {
-            int W,H,Comp;
-            unsigned char* data = stbi_load(p.string().c_str(), &W, &H, &Comp, 4);
-            if (!data) return false;
-            tmp.assign(data, data + size_t(W)*H*4);
-            stbi_image_free(data);
-            w = uint32_t(W); h = uint32_t(H);
-        } else
-#endif
-        {
-            if (!read_tga(p, tmp, w, h)) {
-                if (GVerbose) std::fprintf(stderr, "[tex] tga load failed: %s\n", k.c_str());
-                return false;
-            }
-        }
-        // Insert to cache with LRU-bytes cap
-        {
-            std::lock_guard<std::mutex> lk(CacheMtx);
-            const size_t add = tmp.size();
-            while (CacheBytes + add > G.replacementCacheBudgetBytes && !Cache.empty()) {
-                // Arbitrary eviction (not precise LRU to keep it tiny)
-                auto it = Cache.begin();
-                CacheBytes -= it->second.size();
-                Cache.erase(it);
-            }
-            Cache[k] = CacheEntry{ std::move(tmp), w, h };
-            CacheBytes += Cache[k].size();
-            if (GVerbose) std::fprintf(stderr, "[tex] loaded: %s (%ux%u)\n", k.c_str(), w, h);
-            rgbaOut = Cache[k].rgba; outW = w; outH = h;
-        }
+        ReplacementImage img;
+        if (!load_image(p, img)) return false;
+        StatDemandLoads.fetch_add(1, std::memory_order_relaxed);
+        out = img;
+        cache_insert(k, std::move(img), false);
         return true;
     };
 
     std::vector<fs::path> candidates;
     if (paletteHash) {
         std::string palHex = to_hex(*paletteHash);
+        candidates.push_back(add_palette_suffix(pDds, palHex));
         candidates.push_back(add_palette_suffix(pPng, palHex));
         candidates.push_back(add_palette_suffix(pTga, palHex));
     }
+    candidates.push_back(pDds);
     if (png) candidates.push_back(pPng);
     candidates.push_back(pTga);
     if (!png) candidates.push_back(pPng);
 
     for (const auto& cand : candidates) {
         if (tryFile(cand)) {
+            std::string name = cand.filename().string();
+            note_used(name);
             if (usedFilename)
-                *usedFilename = cand.filename().string();
+                *usedFilename = std::move(name);
             return true;
         }
     }
     return false;
 }
 
+const std::vector<uint8_t>& ReplacementRGBA(const ReplacementImage& img, std::vector<uint8_t>& scratch) {
+    if (!img.compressed) return img.data;
+    scratch.resize(size_t(img.width)*img.height*4);
+    DecodeBlocks(img.format, img.data.data(), img.width, img.height, scratch.data());
+    return scratch;
+}
+
+bool TryLoadReplacement(const TextureKey& key, std::vector<uint8_t>& rgbaOut, uint32_t& outW, uint32_t& outH,
+                        std::optional<uint64_t> paletteHash, std::string* usedFilename) {
+    ReplacementImage img;
+    if (!TryLoadReplacementImage(key, img, paletteHash, usedFilename)) return false;
+    outW = img.width; outH = img.height;
+    if (img.compressed) ReplacementRGBA(img, rgbaOut);
+    else rgbaOut = std::move(img.data);
+    return true;
+}
+
 std::string ExtractNdsGameCodeFromRom(const fs::path& romPath) {
     std::ifstream f(romPath, std::ios::binary);
     if (!f) return {};
@@ -612,5 +1031,6 @@ std::string ExtractNdsGameCodeFromRom(const fs::path& romPath) {
 
 bool DumpEnabled() { return G.enableDump; }
 bool ReplaceEnabled() { return G.enableReplace; }
+bool VRAMKeysEnabled() { return G.vramKeys; }
 
 } // namespace melonDS::hires
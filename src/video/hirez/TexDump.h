@@ -16,6 +16,8 @@
 #include <optional>
 #include <functional>
 
+#include "BlockTex.h"
+
 // If you have stb available, set these to 1 to dump/load PNG.
 // Otherwise, we’ll use our built-in tiny TGA writer/reader.
 #ifndef TEXDUMP_WITH_STB
@@ -68,8 +70,23 @@ struct TexDumpConfig {
     size_t inMemoryDedupBudget = 64'000;
     // Replacement image cache (compressed CPU RGBA) – bytes
     size_t replacementCacheBudgetBytes = 128ull * 1024ull * 1024ull;
-    // Max pending I/O jobs
+    // Max pending I/O jobs (rounded up to a power of two)
     size_t ioQueueCap = 4096;
+    // Number of dump worker threads, 0 picks a count from the number of cores
+    unsigned dumpThreads = 0;
+    // Append all dumps of a game to a single archive, <dumpDir>/<gameId>.texpack,
+    // instead of creating one file per texture
+    bool packArchive = false;
+    // Run-length encode dumped TGAs
+    bool tgaRLE = false;
+    // Key every texture on its raw VRAM contents (+ palette), so lookups never decode it.
+    // Direct color textures then get different names than in packs dumped without it.
+    bool vramKeys = false;
+    // Load the replacements that usually come next in the background, from the order
+    // they were first used in past sessions (kept in <loadDir>/<gameId>/prefetch.log)
+    bool prefetch = true;
+    // Max number of replacements prefetched after one
+    size_t prefetchDepth = 32;
     // File format preference
 #if TEXDUMP_WITH_STB
     bool writePNG = true;  // PNG via stb_image_write
@@ -92,6 +109,7 @@ TextureKey MakeKey(const uint8_t* rgba, uint32_t w, uint32_t h, bool hasMips,
                    std::optional<uint64_t> paletteInvariantHash = std::nullopt);
 
 // Enqueue a dump (non-blocking). Safe to call on GL/emu thread.
+// Encoding and file writes happen on the dump worker pool; jobs are dropped when the queue is full.
 using PaletteIndexGenerator = std::function<bool(std::vector<uint8_t>&, std::string&, std::string&)>;
 
 void DumpIfEnabled(const TextureKey& key, const uint8_t* rgba, uint32_t w, uint32_t h,
@@ -99,6 +117,36 @@ void DumpIfEnabled(const TextureKey& key, const uint8_t* rgba, uint32_t w, uint3
                    const uint32_t* paletteRGBA = nullptr, uint32_t paletteCount = 0,
                    PaletteIndexGenerator paletteIndexGenerator = {});
 
+// A replacement image as stored in the pack: RGBA8, or BC1/BC3 blocks from a .dds file.
+struct ReplacementImage {
+    bool compressed = false;
+    BlockFormat format = BlockFormat::BC1; // if compressed
+    uint32_t width = 0, height = 0;
+    std::vector<uint8_t> data;
+};
+
+// Try to synchronously load a replacement, keeping block-compressed images compressed
+// so they can be uploaded as is. .dds files are looked up before .png/.tga ones.
+bool TryLoadReplacementImage(const TextureKey& key, ReplacementImage& out,
+                             std::optional<uint64_t> paletteHash = std::nullopt,
+                             std::string* usedFilename = nullptr);
+
+// Counters of the replacement loads since Init, to check how well prefetching works.
+struct ReplacementStats {
+    uint64_t demandLoads = 0;  // loaded from disk when first sampled
+    uint64_t prefetched = 0;   // loaded ahead of time from the residency history
+    uint64_t prefetchHits = 0; // first sampled after being prefetched
+    // share of the first uses that didn't have to wait for the disk
+    double HitRate() const {
+        const uint64_t total = demandLoads + prefetchHits;
+        return total ? double(prefetchHits) / double(total) : 0.0;
+    }
+};
+ReplacementStats GetReplacementStats();
+
+// RGBA8 pixels of a replacement: its data, or the blocks decoded into scratch.
+const std::vector<uint8_t>& ReplacementRGBA(const ReplacementImage& img, std::vector<uint8_t>& scratch);
+
 // Try to synchronously load a replacement (CPU only). GL upload happens at call site.
 // If found, returns true and fills rgbaOut (RGBA8) and outW/outH.
 // Guaranteed non-blocking on GL thread except for filesystem stat/read; heavy decoding is avoided unless present.
@@ -106,6 +154,9 @@ bool TryLoadReplacement(const TextureKey& key, std::vector<uint8_t>& rgbaOut, ui
                         std::optional<uint64_t> paletteHash = std::nullopt,
                         std::string* usedFilename = nullptr);
 
+// Read a .tga (or .png with TEXDUMP_WITH_STB) to RGBA8.
+bool ReadImage(const std::filesystem::path& path, std::vector<uint8_t>& rgbaOut, uint32_t& outW, uint32_t& outH);
+
 // Utility helpers for naming.
 std::string KeyToFilename(const TextureKey& key, bool pngExt);
 
@@ -116,5 +167,6 @@ std::string ExtractNdsGameCodeFromRom(const std::filesystem::path& romPath);
 // Query current enable flags (for fast-path guards in callers)
 bool DumpEnabled();
 bool ReplaceEnabled();
+bool VRAMKeysEnabled();
 
 } // namespace melonDS::hires
@@ -0,0 +1,180 @@
+/*
+    Copyright 2016-2025 melonDS team
+
+    This file is part of melonDS.
+
+    melonDS is free software: you can redistribute it and/or modify it under
+    the terms of the GNU General Public License as published by the Free
+    Software Foundation, either version 3 of the License, or (at your option)
+    any later version.
+
+    melonDS is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with melonDS. If not, see http://www.gnu.org/licenses/.
+*/
+
+// Texture pack compression tool.
+// Converts the .tga/.png replacement textures of a pack to block-compressed .dds files,
+// which the hi-res texture loader picks up before the uncompressed ones.
+// They take 4x (BC3) to 8x (BC1) less memory in the replacement cache and to upload.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "video/hirez/TexDump.h"
+
+namespace fs = std::filesystem;
+using namespace melonDS::hires;
+
+enum class Mode
+{
+    Auto,
+    BC1,
+    BC3,
+};
+
+static void PrintUsage(const char* argv0)
+{
+    printf("usage: %s [options] <input dir> [output dir]\n\n", argv0);
+    printf("Converts all .tga/.png files under the input directory to .dds, keeping the\n");
+    printf("directory layout. Without an output directory, they're written next to the inputs.\n\n");
+    printf("options:\n");
+    printf("      --bc1        always use BC1 (RGB, 1-bit alpha)\n");
+    printf("      --bc3        always use BC3 (RGBA)\n");
+    printf("                   by default, BC1 is used for images whose alpha is only 0 or 255\n");
+    printf("      --force      overwrite existing .dds files\n");
+    printf("      --delete     delete the source images after converting them\n");
+    printf("  -v, --verbose    print every converted file\n");
+    printf("  -h, --help       show this help\n");
+}
+
+static bool HasSmoothAlpha(const std::vector<uint8_t>& rgba)
+{
+    for (size_t i = 3; i < rgba.size(); i += 4)
+    {
+        if (rgba[i] != 0 && rgba[i] != 255)
+            return true;
+    }
+    return false;
+}
+
+int main(int argc, char** argv)
+{
+    Mode mode = Mode::Auto;
+    bool force = false;
+    bool deleteSources = false;
+    bool verbose = false;
+    std::vector<fs::path> dirs;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char* arg = argv[i];
+        if (!strcmp(arg, "--bc1"))
+            mode = Mode::BC1;
+        else if (!strcmp(arg, "--bc3"))
+            mode = Mode::BC3;
+        else if (!strcmp(arg, "--force"))
+            force = true;
+        else if (!strcmp(arg, "--delete"))
+            deleteSources = true;
+        else if (!strcmp(arg, "-v") || !strcmp(arg, "--verbose"))
+            verbose = true;
+        else if (!strcmp(arg, "-h") || !strcmp(arg, "--help"))
+        {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+        else if (arg[0] == '-')
+        {
+            fprintf(stderr, "unknown option: %s\n", arg);
+            PrintUsage(argv[0]);
+            return 1;
+        }
+        else
+            dirs.push_back(arg);
+    }
+
+    if (dirs.empty() || dirs.size() > 2)
+    {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    const fs::path input = dirs[0];
+    const fs::path output = dirs.size() > 1 ? dirs[1] : dirs[0];
+    std::error_code ec;
+    if (!fs::is_directory(input, ec))
+    {
+        fprintf(stderr, "%s is not a directory\n", input.string().c_str());
+        return 1;
+    }
+
+    uint64_t srcBytes = 0, dstBytes = 0;
+    int converted = 0, skipped = 0, failed = 0;
+    std::vector<uint8_t> rgba, blocks;
+
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input, ec))
+    {
+        if (!entry.is_regular_file())
+            continue;
+        const fs::path& src = entry.path();
+        const std::string ext = src.extension().string();
+        if (ext != ".tga" && ext != ".png")
+            continue;
+
+        fs::path dst = output / fs::relative(src, input, ec);
+        dst.replace_extension(".dds");
+        if (!force && fs::exists(dst, ec))
+        {
+            skipped++;
+            continue;
+        }
+
+        uint32_t w, h;
+        if (!ReadImage(src, rgba, w, h))
+        {
+            fprintf(stderr, "failed to read %s\n", src.string().c_str());
+            failed++;
+            continue;
+        }
+
+        BlockFormat fmt;
+        switch (mode)
+        {
+        case Mode::BC1: fmt = BlockFormat::BC1; break;
+        case Mode::BC3: fmt = BlockFormat::BC3; break;
+        default: fmt = HasSmoothAlpha(rgba) ? BlockFormat::BC3 : BlockFormat::BC1; break;
+        }
+
+        EncodeBlocks(fmt, rgba.data(), w, h, blocks);
+        fs::create_directories(dst.parent_path(), ec);
+        if (!WriteDDS(dst, fmt, w, h, blocks.data()))
+        {
+            fprintf(stderr, "failed to write %s\n", dst.string().c_str());
+            failed++;
+            continue;
+        }
+
+        srcBytes += rgba.size();
+        dstBytes += blocks.size();
+        converted++;
+        if (verbose)
+            printf("%s -> %s (%ux%u, %s)\n", src.string().c_str(), dst.string().c_str(), w, h,
+                   fmt == BlockFormat::BC1 ? "BC1" : "BC3");
+
+        if (deleteSources)
+            fs::remove(src, ec);
+    }
+
+    printf("converted %d images, %d already converted, %d failed\n", converted, skipped, failed);
+    if (converted)
+        printf("texel data: %.1f MB RGBA8 -> %.1f MB compressed\n", srcBytes / 1048576.0, dstBytes / 1048576.0);
+    return failed ? 1 : 0;
+}